@@ -0,0 +1,7 @@
+# Writes the SHA-256 of SOURCE to OUTPUT, run by ShaderRefresh next to every prebuilt module so a configure without
+# glslc can tell when a shader changed after its SPIR-V was last refreshed. Line endings are normalized first, so a
+# checkout with CRLF line endings hashes the same.
+file(READ ${SOURCE} source)
+string(REPLACE "\r\n" "\n" source "${source}")
+string(SHA256 hash "${source}")
+file(WRITE ${OUTPUT} "${hash}\n")
@@ -0,0 +1,30 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Draws the quad spanning each culled object's bounding sphere, the cull shader makes the instance the object index
+struct Object {
+    vec4 sphere;
+    vec4 color;
+    uint indexCount;
+    uint firstIndex;
+    int vertexOffset;
+    uint padding;
+};
+
+layout(set = 0, binding = 1) buffer Objects {
+    Object objects[];
+} objectBuffers[];
+
+layout(push_constant) uniform Push {
+    mat4 viewProjection;
+    uint objectBuffer;
+};
+
+layout(location = 0) out vec4 color;
+
+void main() {
+    vec4 sphere = objectBuffers[objectBuffer].objects[gl_InstanceIndex].sphere;
+    color       = objectBuffers[objectBuffer].objects[gl_InstanceIndex].color;
+    vec2 corner = vec2(gl_VertexIndex & 1, gl_VertexIndex >> 1) * 2.0 - vec2(1.0);
+    gl_Position = viewProjection * vec4(sphere.xy + corner * sphere.w, sphere.z, 1.0);
+}
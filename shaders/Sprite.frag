@@ -0,0 +1,22 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(set = 0, binding = 0) uniform texture2D textures[];
+layout(set = 0, binding = 2) uniform sampler samplers[];
+
+layout(push_constant) uniform Push {
+    vec2 scale;
+    vec2 offset;
+    uint spriteBuffer;
+    uint samplerIndex;
+};
+
+layout(location = 0) in vec2 uv;
+layout(location = 1) in vec4 color;
+layout(location = 2) flat in uint textureIndex;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    outColor = texture(sampler2D(textures[nonuniformEXT(textureIndex)], samplers[samplerIndex]), uv) * color;
+}
@@ -0,0 +1,37 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Pulls sprites out of the instance buffer with six vertices each, without any vertex input
+struct Sprite {
+    vec4 rect;
+    uint uv0;
+    uint uv1;
+    uint color;
+    uint textureIndex;
+};
+
+layout(set = 0, binding = 1) readonly buffer Sprites {
+    Sprite sprites[];
+} spriteBuffers[];
+
+layout(push_constant) uniform Push {
+    vec2 scale;
+    vec2 offset;
+    uint spriteBuffer;
+    uint samplerIndex;
+};
+
+layout(location = 0) out vec2 uv;
+layout(location = 1) out vec4 color;
+layout(location = 2) flat out uint textureIndex;
+
+void main() {
+    Sprite sprite = spriteBuffers[spriteBuffer].sprites[gl_VertexIndex / 6];
+    // The two triangles use corners 0 1 2 and 2 1 3
+    int cornerIndex = gl_VertexIndex % 6;
+    vec2 corner     = vec2((0x32 >> cornerIndex) & 1, (0x2C >> cornerIndex) & 1);
+    uv              = mix(unpackUnorm2x16(sprite.uv0), unpackUnorm2x16(sprite.uv1), corner);
+    color           = unpackUnorm4x8(sprite.color);
+    textureIndex    = sprite.textureIndex;
+    gl_Position     = vec4((sprite.rect.xy + corner * sprite.rect.zw) * scale + offset, 0.0, 1.0);
+}
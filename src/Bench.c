@@ -0,0 +1,402 @@
+#include "Common.h"
+#include "System.h"
+
+// Runs the release renderer headless once per scenario, collects the result each run writes with --bench-out
+// into one JSON file and optionally compares it against a stored baseline, failing if any scenario got worse
+// by more than the threshold. Every run is a separate process so peak memory is measured per scenario.
+
+typedef struct BenchScenario {
+    const char* Name;
+    const char* Arguments;
+} BenchScenario;
+
+// Record items stand in for draws, each one is a few state commands in a secondary command buffer
+static const BenchScenario BenchScenarios[] = {
+    {"clear-1", "--frames-in-flight 1"},
+    {"clear-2", "--frames-in-flight 2"},
+    {"clear-3", "--frames-in-flight 3"},
+    {"draw-20k-1", "--frames-in-flight 1 --record-threads 4 --record-items 20000"},
+    {"draw-20k-2", "--frames-in-flight 2 --record-threads 4 --record-items 20000"},
+    {"draw-20k-3", "--frames-in-flight 3 --record-threads 4 --record-items 20000"},
+    {"upload-256mb-2", "--frames-in-flight 2 --upload-megabytes 256"},
+    {"upload-256mb-3", "--frames-in-flight 3 --upload-megabytes 256"},
+    {"compute-64k-2", "--frames-in-flight 2 --compute-items 65536"},
+};
+#define BenchScenarioCount (sizeof(BenchScenarios) / sizeof(BenchScenarios[0]))
+
+typedef enum BenchDirection {
+    BenchDirection_None,
+    BenchDirection_HigherIsBetter,
+    BenchDirection_LowerIsBetter,
+} BenchDirection;
+
+typedef enum BenchMetricId {
+    BenchMetric_FramesPerSecond,
+    BenchMetric_CpuWaitMean,
+    BenchMetric_CpuWaitP95,
+    BenchMetric_CpuAcquireMean,
+    BenchMetric_CpuAcquireP95,
+    BenchMetric_CpuRecordMean,
+    BenchMetric_CpuRecordP95,
+    BenchMetric_CpuSubmitMean,
+    BenchMetric_CpuSubmitP95,
+    BenchMetric_CpuPresentMean,
+    BenchMetric_CpuPresentP95,
+    BenchMetric_CpuFrameMean,
+    BenchMetric_CpuFrameP95,
+    BenchMetric_CpuLatencyMean,
+    BenchMetric_CpuLatencyP95,
+    BenchMetric_ShaderBytes,
+    BenchMetric_ShaderModuleTime,
+    BenchMetric_PeakProcessBytes,
+    BenchMetric_PeakHostBytes,
+    BenchMetric_PeakDeviceBytes,
+    BenchMetric_Count,
+} BenchMetricId;
+
+typedef struct BenchMetric {
+    const char* Key;
+    BenchDirection Direction;
+} BenchMetric;
+
+// Only the metrics with a direction are compared against the baseline, the per-phase means and the smaller
+// phases are too noisy on a software ICD to gate on
+static const BenchMetric BenchMetrics[BenchMetric_Count] = {
+    [BenchMetric_FramesPerSecond]  = {"frames_per_second", BenchDirection_HigherIsBetter},
+    [BenchMetric_CpuWaitMean]      = {"cpu_wait_mean_ns", BenchDirection_None},
+    [BenchMetric_CpuWaitP95]       = {"cpu_wait_p95_ns", BenchDirection_None},
+    [BenchMetric_CpuAcquireMean]   = {"cpu_acquire_mean_ns", BenchDirection_None},
+    [BenchMetric_CpuAcquireP95]    = {"cpu_acquire_p95_ns", BenchDirection_None},
+    [BenchMetric_CpuRecordMean]    = {"cpu_record_mean_ns", BenchDirection_None},
+    [BenchMetric_CpuRecordP95]     = {"cpu_record_p95_ns", BenchDirection_None},
+    [BenchMetric_CpuSubmitMean]    = {"cpu_submit_mean_ns", BenchDirection_None},
+    [BenchMetric_CpuSubmitP95]     = {"cpu_submit_p95_ns", BenchDirection_None},
+    [BenchMetric_CpuPresentMean]   = {"cpu_present_mean_ns", BenchDirection_None},
+    [BenchMetric_CpuPresentP95]    = {"cpu_present_p95_ns", BenchDirection_None},
+    [BenchMetric_CpuFrameMean]     = {"cpu_frame_mean_ns", BenchDirection_None},
+    [BenchMetric_CpuFrameP95]      = {"cpu_frame_p95_ns", BenchDirection_LowerIsBetter},
+    [BenchMetric_CpuLatencyMean]   = {"cpu_latency_mean_ns", BenchDirection_None},
+    [BenchMetric_CpuLatencyP95]    = {"cpu_latency_p95_ns", BenchDirection_LowerIsBetter},
+    [BenchMetric_ShaderBytes]      = {"shader_bytes", BenchDirection_LowerIsBetter},
+    [BenchMetric_ShaderModuleTime] = {"shader_module_ns", BenchDirection_None},
+    [BenchMetric_PeakProcessBytes] = {"peak_process_bytes", BenchDirection_LowerIsBetter},
+    [BenchMetric_PeakHostBytes]    = {"peak_host_bytes", BenchDirection_None},
+    [BenchMetric_PeakDeviceBytes]  = {"peak_device_bytes", BenchDirection_LowerIsBetter},
+};
+
+typedef struct BenchResult {
+    bool Succeeded;
+    double Values[BenchMetric_Count];
+} BenchResult;
+
+// Returns a NUL terminated copy of the whole file, NULL if it couldn't be read
+static char* BenchReadFile(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    size_t capacity = 4096;
+    size_t size     = 0;
+    char* data      = malloc(capacity);
+    while (data) {
+        size += fread(data + size, 1, capacity - size - 1, file);
+        if (size < capacity - 1) {
+            break;
+        }
+        capacity *= 2;
+        char* grown = realloc(data, capacity);
+        if (grown == NULL) {
+            free(data);
+        }
+        data = grown;
+    }
+    bool failed = ferror(file) != 0;
+    fclose(file);
+    if (data == NULL || failed) {
+        free(data);
+        return NULL;
+    }
+    data[size] = '\0';
+    return data;
+}
+
+// Both the renderer and this driver write flat objects, so a value is the number after its key before the
+// end of the object
+static bool BenchFindValue(const char* object, const char* objectEnd, const char* key, double* value) {
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    const char* found = strstr(object, pattern);
+    if (found == NULL || found >= objectEnd) {
+        return false;
+    }
+    char* end = NULL;
+    *value    = strtod(found + strlen(pattern), &end);
+    return end != found + strlen(pattern);
+}
+
+// Returns the start of the scenario's object and sets end to its closing brace, NULL if it isn't there
+static const char* BenchFindScenario(const char* json, const char* name, const char** end) {
+    char pattern[96];
+    snprintf(pattern, sizeof(pattern), "\"name\": \"%s\"", name);
+    const char* found = strstr(json, pattern);
+    if (found == NULL) {
+        return NULL;
+    }
+    *end = strchr(found, '}');
+    if (*end == NULL) {
+        *end = found + strlen(found);
+    }
+    return found;
+}
+
+static BenchResult BenchRun(const char* renderer, const BenchScenario* scenario, uint64_t frames) {
+    BenchResult result = {};
+    char resultPath[128];
+    char logPath[128];
+    char command[1024];
+    snprintf(resultPath, sizeof(resultPath), "bench-%s.json", scenario->Name);
+    snprintf(logPath, sizeof(logPath), "bench-%s.log", scenario->Name);
+    remove(resultPath);
+
+    // cmd.exe strips the outer pair of quotes when the command starts with one, so the whole line gets another pair
+#if defined(_WIN32)
+    const char* quote = "\"";
+#else
+    const char* quote = "";
+#endif
+    snprintf(command,
+             sizeof(command),
+             "%s\"%s\" --headless --frames %llu --pipeline-cache bench-pipeline-cache.bin --bench-out %s %s > %s 2>&1%s",
+             quote,
+             renderer,
+             cast(unsigned long long) frames,
+             resultPath,
+             scenario->Arguments,
+             logPath,
+             quote);
+    int exitCode = system(command);
+    if (exitCode != 0) {
+        fflush(stdout);
+        fprintf(stderr, "Scenario '%s' failed with exit code %d, see '%s'!\n", scenario->Name, exitCode, logPath);
+        return result;
+    }
+
+    char* json = BenchReadFile(resultPath);
+    if (json == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Scenario '%s' didn't write '%s', see '%s'!\n", scenario->Name, resultPath, logPath);
+        return result;
+    }
+    const char* jsonEnd = json + strlen(json);
+    result.Succeeded    = true;
+    for (uint32_t i = 0; i < BenchMetric_Count; i++) {
+        if (!BenchFindValue(json, jsonEnd, BenchMetrics[i].Key, &result.Values[i])) {
+            fflush(stdout);
+            fprintf(stderr, "Scenario '%s' is missing '%s' in '%s'!\n", scenario->Name, BenchMetrics[i].Key, resultPath);
+            result.Succeeded = false;
+        }
+    }
+    free(json);
+    return result;
+}
+
+static bool BenchWriteResults(const char* path,
+                              const char* renderer,
+                              uint64_t frames,
+                              const bool* selected,
+                              const BenchResult* results) {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to open '%s' for writing the benchmark results!\n", path);
+        return false;
+    }
+    fprintf(file, "{\n  \"renderer\": \"%s\",\n  \"frames\": %llu,\n  \"scenarios\": [", renderer, cast(unsigned long long) frames);
+    bool first = true;
+    for (uint32_t i = 0; i < BenchScenarioCount; i++) {
+        if (!selected[i] || !results[i].Succeeded) {
+            continue;
+        }
+        fprintf(file, "%s\n    {\"name\": \"%s\"", first ? "" : ",", BenchScenarios[i].Name);
+        for (uint32_t metric = 0; metric < BenchMetric_Count; metric++) {
+            fprintf(file, ", \"%s\": %.3f", BenchMetrics[metric].Key, results[i].Values[metric]);
+        }
+        fprintf(file, "}");
+        first = false;
+    }
+    fprintf(file, "\n  ]\n}\n");
+
+    bool success = ferror(file) == 0;
+    success      = fclose(file) == 0 && success;
+    if (!success) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to write the benchmark results to '%s'!\n", path);
+    }
+    return success;
+}
+
+// Returns the number of regressions, scenarios and metrics missing from the baseline are reported but not counted
+static uint32_t BenchCompare(const char* baseline, const bool* selected, const BenchResult* results, double threshold) {
+    uint32_t regressions = 0;
+    printf("%-16s %-20s %14s %14s %9s\n", "Scenario", "Metric", "Baseline", "Current", "Change");
+    for (uint32_t i = 0; i < BenchScenarioCount; i++) {
+        if (!selected[i] || !results[i].Succeeded) {
+            continue;
+        }
+        const char* objectEnd = NULL;
+        const char* object    = BenchFindScenario(baseline, BenchScenarios[i].Name, &objectEnd);
+        if (object == NULL) {
+            printf("%-16s not in the baseline\n", BenchScenarios[i].Name);
+            continue;
+        }
+        for (uint32_t metric = 0; metric < BenchMetric_Count; metric++) {
+            BenchDirection direction = BenchMetrics[metric].Direction;
+            double expected          = 0.0;
+            if (direction == BenchDirection_None || !BenchFindValue(object, objectEnd, BenchMetrics[metric].Key, &expected) ||
+                expected <= 0.0) {
+                continue;
+            }
+            double current   = results[i].Values[metric];
+            double change    = (current - expected) / expected * 100.0;
+            double worsening = direction == BenchDirection_HigherIsBetter ? -change : change;
+            bool regressed   = worsening > threshold;
+            printf("%-16s %-20s %14.1f %14.1f %+8.1f%%%s\n",
+                   BenchScenarios[i].Name,
+                   BenchMetrics[metric].Key,
+                   expected,
+                   current,
+                   change,
+                   regressed ? "  REGRESSED" : "");
+            if (regressed) {
+                regressions++;
+            }
+        }
+    }
+    return regressions;
+}
+
+int main(int argc, char** argv) {
+#if defined(VULKAN_BENCH_RENDERER)
+    const char* renderer = VULKAN_BENCH_RENDERER;
+#else
+    const char* renderer = NULL;
+#endif
+    uint64_t frames          = 300;
+    uint32_t repeat          = 1;
+    const char* outputPath   = "bench.json";
+    const char* baselinePath = NULL;
+    double threshold         = 10.0;
+    bool selected[BenchScenarioCount];
+    bool filtered = false;
+    for (uint32_t i = 0; i < BenchScenarioCount; i++) {
+        selected[i] = true;
+    }
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--renderer") == 0 && i + 1 < argc) {
+            renderer = argv[++i];
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = cast(uint32_t) atoi(argv[++i]);
+            if (repeat < 1) {
+                repeat = 1;
+            }
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            threshold = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--icd") == 0 && i + 1 < argc) {
+            // The loader reads the older name, newer loaders prefer the other one
+            const char* icd = argv[++i];
+            SystemSetEnvironmentVariable("VK_ICD_FILENAMES", icd);
+            SystemSetEnvironmentVariable("VK_DRIVER_FILES", icd);
+        } else if (strcmp(argv[i], "--scenario") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            if (!filtered) {
+                memset(selected, 0, sizeof(selected));
+                filtered = true;
+            }
+            bool known = false;
+            for (uint32_t scenario = 0; scenario < BenchScenarioCount; scenario++) {
+                if (strcmp(BenchScenarios[scenario].Name, name) == 0) {
+                    selected[scenario] = true;
+                    known              = true;
+                }
+            }
+            if (!known) {
+                fflush(stdout);
+                fprintf(stderr, "Unknown scenario '%s'!\n", name);
+                exit(1);
+            }
+        } else {
+            fflush(stdout);
+            fprintf(stderr, "Unknown argument '%s'!\n", argv[i]);
+            exit(1);
+        }
+    }
+    if (renderer == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "No renderer to benchmark, pass --renderer!\n");
+        exit(1);
+    }
+
+    char* baseline = NULL;
+    if (baselinePath) {
+        baseline = BenchReadFile(baselinePath);
+        if (baseline == NULL) {
+            fflush(stdout);
+            fprintf(stderr, "Failed to read the baseline '%s'!\n", baselinePath);
+            exit(1);
+        }
+    }
+
+    // Repeats keep the fastest run, slower ones are other processes getting in the way rather than the renderer
+    BenchResult results[BenchScenarioCount] = {};
+    uint32_t failures                       = 0;
+    for (uint32_t i = 0; i < BenchScenarioCount; i++) {
+        if (!selected[i]) {
+            continue;
+        }
+        for (uint32_t run = 0; run < repeat; run++) {
+            BenchResult result = BenchRun(renderer, &BenchScenarios[i], frames);
+            if (!result.Succeeded) {
+                results[i].Succeeded = false;
+                break;
+            }
+            if (run == 0 || result.Values[BenchMetric_FramesPerSecond] > results[i].Values[BenchMetric_FramesPerSecond]) {
+                results[i] = result;
+            }
+        }
+        if (!results[i].Succeeded) {
+            failures++;
+            continue;
+        }
+        printf("%-16s %10.1f frames/s, %8.3fms p95 frame, %6.1f MB peak process memory\n",
+               BenchScenarios[i].Name,
+               results[i].Values[BenchMetric_FramesPerSecond],
+               results[i].Values[BenchMetric_CpuFrameP95] / 1e6,
+               results[i].Values[BenchMetric_PeakProcessBytes] / (1024.0 * 1024.0));
+    }
+
+    if (!BenchWriteResults(outputPath, renderer, frames, selected, results)) {
+        failures++;
+    } else {
+        printf("Wrote the benchmark results to '%s'!\n", outputPath);
+    }
+
+    uint32_t regressions = 0;
+    if (baseline) {
+        regressions = BenchCompare(baseline, selected, results, threshold);
+        free(baseline);
+        if (regressions > 0) {
+            fflush(stdout);
+            fprintf(stderr, "%d metrics regressed by more than %.1f%% against '%s'!\n", regressions, threshold, baselinePath);
+        } else {
+            printf("No regressions over %.1f%% against '%s'!\n", threshold, baselinePath);
+        }
+    }
+
+    return failures > 0 || regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,316 @@
+#include "Bindless.h"
+#include "DebugUtils.h"
+
+bool BindlessIsSupported(VkPhysicalDevice physicalDevice) {
+    VkPhysicalDeviceVulkan12Features features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+    };
+    vkGetPhysicalDeviceFeatures2(physicalDevice,
+                                 &(VkPhysicalDeviceFeatures2){
+                                     .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+                                     .pNext = &features,
+                                 });
+    return features.runtimeDescriptorArray && features.descriptorBindingPartiallyBound &&
+           features.descriptorBindingUpdateUnusedWhilePending && features.descriptorBindingSampledImageUpdateAfterBind &&
+           features.descriptorBindingStorageBufferUpdateAfterBind && features.shaderSampledImageArrayNonUniformIndexing &&
+           features.shaderStorageBufferArrayNonUniformIndexing;
+}
+
+void BindlessEnableFeatures(VkPhysicalDeviceVulkan12Features* features) {
+    features->runtimeDescriptorArray                        = VK_TRUE;
+    features->descriptorBindingPartiallyBound               = VK_TRUE;
+    features->descriptorBindingUpdateUnusedWhilePending     = VK_TRUE;
+    features->descriptorBindingSampledImageUpdateAfterBind  = VK_TRUE;
+    features->descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+    features->shaderSampledImageArrayNonUniformIndexing     = VK_TRUE;
+    features->shaderStorageBufferArrayNonUniformIndexing    = VK_TRUE;
+}
+
+static uint32_t BindlessMin(uint32_t a, uint32_t b) {
+    return a < b ? a : b;
+}
+
+Bindless* BindlessCreate(VkDevice device, VkPhysicalDevice physicalDevice, Timeline* graphicsTimeline, const VkAllocationCallbacks* allocator) {
+    Bindless* bindless = calloc(1, sizeof(Bindless));
+    if (bindless == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate the bindless descriptors!\n");
+        exit(1);
+    }
+    bindless->Device    = device;
+    bindless->Allocator = allocator;
+    bindless->Timeline  = graphicsTimeline;
+
+    VkPhysicalDeviceVulkan12Properties limits = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES,
+    };
+    vkGetPhysicalDeviceProperties2(physicalDevice,
+                                   &(VkPhysicalDeviceProperties2){
+                                       .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+                                       .pNext = &limits,
+                                   });
+    // Every array is visible to every stage, so the per stage limits apply to all of them together as well
+    uint32_t capacities[BindlessTypeCount] = {
+        [BindlessType_SampledImage]  = BindlessMin(BindlessMaxSampledImages,
+                                                   BindlessMin(limits.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                                                               limits.maxDescriptorSetUpdateAfterBindSampledImages)),
+        [BindlessType_StorageBuffer] = BindlessMin(BindlessMaxStorageBuffers,
+                                                   BindlessMin(limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+                                                               limits.maxDescriptorSetUpdateAfterBindStorageBuffers)),
+        [BindlessType_Sampler]       = BindlessMin(
+            BindlessMaxSamplers,
+            BindlessMin(limits.maxPerStageDescriptorUpdateAfterBindSamplers, limits.maxDescriptorSetUpdateAfterBindSamplers)),
+    };
+    uint32_t resourceCount =
+        capacities[BindlessType_SampledImage] + capacities[BindlessType_StorageBuffer] + capacities[BindlessType_Sampler];
+    if (resourceCount > limits.maxPerStageUpdateAfterBindResources) {
+        // Samplers are few, the images and buffers split what's left
+        uint32_t remaining                     = limits.maxPerStageUpdateAfterBindResources - capacities[BindlessType_Sampler];
+        capacities[BindlessType_SampledImage]  = BindlessMin(capacities[BindlessType_SampledImage], remaining / 2);
+        capacities[BindlessType_StorageBuffer] = BindlessMin(capacities[BindlessType_StorageBuffer], remaining / 2);
+    }
+
+    static const VkDescriptorType DescriptorTypes[BindlessTypeCount] = {
+        [BindlessType_SampledImage]  = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+        [BindlessType_StorageBuffer] = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        [BindlessType_Sampler]       = VK_DESCRIPTOR_TYPE_SAMPLER,
+    };
+    VkDescriptorSetLayoutBinding bindings[BindlessTypeCount];
+    VkDescriptorBindingFlags bindingFlags[BindlessTypeCount];
+    VkDescriptorPoolSize poolSizes[BindlessTypeCount];
+    for (uint32_t i = 0; i < BindlessTypeCount; i++) {
+        BindlessArray* array  = &bindless->Arrays[i];
+        array->DescriptorType = DescriptorTypes[i];
+        array->Capacity       = capacities[i];
+        array->FreeIndices    = malloc(capacities[i] * sizeof(uint32_t));
+        array->Pending        = malloc(capacities[i] * sizeof(BindlessPendingFree));
+        if (array->FreeIndices == NULL || array->Pending == NULL) {
+            fflush(stdout);
+            fprintf(stderr, "Failed to allocate the bindless free lists!\n");
+            exit(1);
+        }
+
+        bindings[i] = (VkDescriptorSetLayoutBinding){
+            .binding         = i,
+            .descriptorType  = DescriptorTypes[i],
+            .descriptorCount = capacities[i],
+            .stageFlags      = VK_SHADER_STAGE_ALL,
+        };
+        // Unused entries may hold anything, and entries no pending command buffer uses can be written at any time
+        bindingFlags[i] = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                          VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+        poolSizes[i] = (VkDescriptorPoolSize){
+            .type            = DescriptorTypes[i],
+            .descriptorCount = capacities[i],
+        };
+    }
+
+    VkResult setLayoutCreateResult =
+        vkCreateDescriptorSetLayout(device,
+                                    &(VkDescriptorSetLayoutCreateInfo){
+                                        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+                                        .pNext =
+                                            &(VkDescriptorSetLayoutBindingFlagsCreateInfo){
+                                                .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+                                                .bindingCount  = BindlessTypeCount,
+                                                .pBindingFlags = bindingFlags,
+                                            },
+                                        .flags        = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+                                        .bindingCount = BindlessTypeCount,
+                                        .pBindings    = bindings,
+                                    },
+                                    allocator,
+                                    &bindless->SetLayout);
+    if (setLayoutCreateResult != VK_SUCCESS) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to create the bindless descriptor set layout! %x\n", setLayoutCreateResult);
+        exit(1);
+    }
+    VkCheck(vkCreateDescriptorPool(device,
+                                   &(VkDescriptorPoolCreateInfo){
+                                       .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+                                       .flags         = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+                                       .maxSets       = 1,
+                                       .poolSizeCount = BindlessTypeCount,
+                                       .pPoolSizes    = poolSizes,
+                                   },
+                                   allocator,
+                                   &bindless->Pool));
+    VkCheck(vkAllocateDescriptorSets(device,
+                                     &(VkDescriptorSetAllocateInfo){
+                                         .sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+                                         .descriptorPool     = bindless->Pool,
+                                         .descriptorSetCount = 1,
+                                         .pSetLayouts        = &bindless->SetLayout,
+                                     },
+                                     &bindless->Set));
+    VkCheck(vkCreatePipelineLayout(device,
+                                   &(VkPipelineLayoutCreateInfo){
+                                       .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+                                       .setLayoutCount         = 1,
+                                       .pSetLayouts            = &bindless->SetLayout,
+                                       .pushConstantRangeCount = 1,
+                                       .pPushConstantRanges =
+                                           &(VkPushConstantRange){
+                                               .stageFlags = VK_SHADER_STAGE_ALL,
+                                               .offset     = 0,
+                                               .size       = BindlessPushConstantSize,
+                                           },
+                                   },
+                                   allocator,
+                                   &bindless->PipelineLayout));
+    DebugUtilsSetObjectName(device, VK_OBJECT_TYPE_DESCRIPTOR_SET, cast(uint64_t) bindless->Set, "Bindless");
+
+    return bindless;
+}
+
+void BindlessDestroy(Bindless* bindless) {
+    vkDestroyPipelineLayout(bindless->Device, bindless->PipelineLayout, bindless->Allocator);
+    vkDestroyDescriptorPool(bindless->Device, bindless->Pool, bindless->Allocator);
+    vkDestroyDescriptorSetLayout(bindless->Device, bindless->SetLayout, bindless->Allocator);
+    for (uint32_t i = 0; i < BindlessTypeCount; i++) {
+        free(bindless->Arrays[i].FreeIndices);
+        free(bindless->Arrays[i].Pending);
+    }
+    free(bindless);
+}
+
+void BindlessBeginFrame(Bindless* bindless) {
+    uint64_t completedValue = TimelineGetCompletedValue(bindless->Timeline);
+    for (uint32_t i = 0; i < BindlessTypeCount; i++) {
+        BindlessArray* array = &bindless->Arrays[i];
+        uint32_t kept        = 0;
+        for (uint32_t j = 0; j < array->PendingCount; j++) {
+            if (array->Pending[j].Value <= completedValue) {
+                array->FreeIndices[array->FreeCount++] = array->Pending[j].Index;
+            } else {
+                array->Pending[kept++] = array->Pending[j];
+            }
+        }
+        array->PendingCount = kept;
+    }
+}
+
+static uint32_t BindlessAllocateIndex(Bindless* bindless, BindlessType type) {
+    BindlessArray* array = &bindless->Arrays[type];
+    uint32_t index       = 0;
+    if (array->FreeCount > 0) {
+        index = array->FreeIndices[--array->FreeCount];
+    } else if (array->HighWater < array->Capacity) {
+        index = array->HighWater++;
+    } else {
+        fflush(stdout);
+        fprintf(stderr, "Ran out of bindless descriptors, all %d of binding %d are in use!\n", array->Capacity, type);
+        exit(1);
+    }
+    array->LiveCount++;
+    if (array->LiveCount > array->PeakCount) {
+        array->PeakCount = array->LiveCount;
+    }
+    return index;
+}
+
+static void BindlessWrite(Bindless* bindless,
+                          BindlessType type,
+                          uint32_t index,
+                          const VkDescriptorImageInfo* image,
+                          const VkDescriptorBufferInfo* buffer) {
+    vkUpdateDescriptorSets(bindless->Device,
+                           1,
+                           &(VkWriteDescriptorSet){
+                               .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                               .dstSet          = bindless->Set,
+                               .dstBinding      = type,
+                               .dstArrayElement = index,
+                               .descriptorCount = 1,
+                               .descriptorType  = bindless->Arrays[type].DescriptorType,
+                               .pImageInfo      = image,
+                               .pBufferInfo     = buffer,
+                           },
+                           0,
+                           NULL);
+    bindless->WriteCount++;
+}
+
+uint32_t BindlessAddSampledImage(Bindless* bindless, VkImageView view, VkImageLayout layout) {
+    uint32_t index = BindlessAllocateIndex(bindless, BindlessType_SampledImage);
+    BindlessWrite(bindless,
+                  BindlessType_SampledImage,
+                  index,
+                  &(VkDescriptorImageInfo){
+                      .imageView   = view,
+                      .imageLayout = layout,
+                  },
+                  NULL);
+    return index;
+}
+
+uint32_t BindlessAddStorageBuffer(Bindless* bindless, const VkDescriptorBufferInfo* buffer) {
+    uint32_t index = BindlessAllocateIndex(bindless, BindlessType_StorageBuffer);
+    BindlessWrite(bindless, BindlessType_StorageBuffer, index, NULL, buffer);
+    return index;
+}
+
+uint32_t BindlessAddSampler(Bindless* bindless, VkSampler sampler) {
+    uint32_t index = BindlessAllocateIndex(bindless, BindlessType_Sampler);
+    BindlessWrite(bindless,
+                  BindlessType_Sampler,
+                  index,
+                  &(VkDescriptorImageInfo){
+                      .sampler = sampler,
+                  },
+                  NULL);
+    return index;
+}
+
+void BindlessRemove(Bindless* bindless, BindlessType type, uint32_t index) {
+    BindlessArray* array = &bindless->Arrays[type];
+    assert(index < array->HighWater && array->LiveCount > 0 && array->PendingCount < array->Capacity);
+    // The next submission may be the frame being recorded right now, which can still use the index
+    array->Pending[array->PendingCount++] = (BindlessPendingFree){
+        .Index = index,
+        .Value = bindless->Timeline->LastSubmittedValue + 1,
+    };
+    array->LiveCount--;
+}
+
+void BindlessBind(const Bindless* bindless, VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint) {
+    vkCmdBindDescriptorSets(commandBuffer, bindPoint, bindless->PipelineLayout, 0, 1, &bindless->Set, 0, NULL);
+}
+
+void BindlessPushConstants(const Bindless* bindless, VkCommandBuffer commandBuffer, const void* data, uint32_t size) {
+    assert(size <= BindlessPushConstantSize);
+    vkCmdPushConstants(commandBuffer, bindless->PipelineLayout, VK_SHADER_STAGE_ALL, 0, size, data);
+}
+
+bool BindlessSupportsShader(const Bindless* bindless, ShaderId shader) {
+    const ShaderInfo* info = &Shaders[shader];
+    if (info->PushConstantSize > BindlessPushConstantSize) {
+        return false;
+    }
+    for (uint32_t i = 0; i < info->BindingCount; i++) {
+        const ShaderBinding* binding = &info->Bindings[i];
+        if (binding->Set != 0 || binding->Binding >= BindlessTypeCount) {
+            return false;
+        }
+        const BindlessArray* array = &bindless->Arrays[binding->Binding];
+        if (binding->Type != array->DescriptorType || binding->Count > array->Capacity) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void BindlessPrintStats(const Bindless* bindless) {
+    static const char* const TypeNames[BindlessTypeCount] = {
+        [BindlessType_SampledImage]  = "SampledImage",
+        [BindlessType_StorageBuffer] = "StorageBuffer",
+        [BindlessType_Sampler]       = "Sampler",
+    };
+    printf("%-14s %10s %10s %10s %10s\n", "Binding", "Capacity", "Live", "Peak", "Pending");
+    for (uint32_t i = 0; i < BindlessTypeCount; i++) {
+        const BindlessArray* array = &bindless->Arrays[i];
+        printf("%-14s %10u %10u %10u %10u\n", TypeNames[i], array->Capacity, array->LiveCount, array->PeakCount, array->PendingCount);
+    }
+    printf("Wrote %d bindless descriptors in total!\n", bindless->WriteCount);
+}
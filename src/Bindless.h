@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Common.h"
+#include "Timeline.h"
+#include "Shader.h"
+
+// How many descriptors of each type are asked for, clamped to the device's update after bind limits
+#define BindlessMaxSampledImages  16384
+#define BindlessMaxStorageBuffers 16384
+#define BindlessMaxSamplers       256
+// The minimum every device supports, shaders get their descriptor indices and any other per draw data through it
+#define BindlessPushConstantSize 128
+
+// Also the binding of the type's array in set 0
+typedef enum BindlessType {
+    BindlessType_SampledImage,
+    BindlessType_StorageBuffer,
+    BindlessType_Sampler,
+    BindlessTypeCount,
+} BindlessType;
+
+typedef struct BindlessPendingFree {
+    uint32_t Index;
+    // Graphics timeline value after which nothing can use the index anymore
+    uint64_t Value;
+} BindlessPendingFree;
+
+// One descriptor array with a free list of indices, indices are handed out from the top of the free list first
+// and only then from the never used part of the array
+typedef struct BindlessArray {
+    VkDescriptorType DescriptorType;
+    uint32_t Capacity;
+    uint32_t HighWater;
+    uint32_t FreeCount;
+    uint32_t* FreeIndices;
+    uint32_t PendingCount;
+    BindlessPendingFree* Pending;
+    uint32_t LiveCount;
+    uint32_t PeakCount;
+} BindlessArray;
+
+// One update after bind, partially bound descriptor set holding an array per BindlessType, shared by every
+// pipeline through a single pipeline layout. It's bound once per command buffer and shaders index into the
+// arrays with indices from push constants, so draws and dispatches never allocate or bind descriptor sets.
+// Indices are stable for as long as the resource lives. A removed index is only reused once the graphics
+// timeline shows every frame that could have used it has finished, work on other queues using the set has to
+// be waited on by the graphics queue for that to hold. Only to be used from one thread.
+typedef struct Bindless {
+    VkDevice Device;
+    const VkAllocationCallbacks* Allocator;
+    Timeline* Timeline;
+    VkDescriptorSetLayout SetLayout;
+    VkDescriptorPool Pool;
+    VkDescriptorSet Set;
+    VkPipelineLayout PipelineLayout;
+    BindlessArray Arrays[BindlessTypeCount];
+    uint32_t WriteCount;
+} Bindless;
+
+// Whether the device has every descriptor indexing feature the set needs, the same ones BindlessEnableFeatures sets
+bool BindlessIsSupported(VkPhysicalDevice physicalDevice);
+void BindlessEnableFeatures(VkPhysicalDeviceVulkan12Features* features);
+
+Bindless* BindlessCreate(VkDevice device, VkPhysicalDevice physicalDevice, Timeline* graphicsTimeline, const VkAllocationCallbacks* allocator);
+// The device must be idle
+void BindlessDestroy(Bindless* bindless);
+
+// Makes indices removed by frames that have finished available again
+void BindlessBeginFrame(Bindless* bindless);
+uint32_t BindlessAddSampledImage(Bindless* bindless, VkImageView view, VkImageLayout layout);
+uint32_t BindlessAddStorageBuffer(Bindless* bindless, const VkDescriptorBufferInfo* buffer);
+uint32_t BindlessAddSampler(Bindless* bindless, VkSampler sampler);
+// The resource can be destroyed once the frames that could use it have finished, the same as without bindless
+void BindlessRemove(Bindless* bindless, BindlessType type, uint32_t index);
+
+// Binds the set for every later pipeline of the bind point in the command buffer, pipelines have to be created
+// with Bindless->PipelineLayout
+void BindlessBind(const Bindless* bindless, VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint);
+void BindlessPushConstants(const Bindless* bindless, VkCommandBuffer commandBuffer, const void* data, uint32_t size);
+// Whether every descriptor the shader declares, going by its reflection, is one of the set's arrays with a matching
+// type, and its push constants fit
+bool BindlessSupportsShader(const Bindless* bindless, ShaderId shader);
+
+void BindlessPrintStats(const Bindless* bindless);
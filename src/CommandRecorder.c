@@ -0,0 +1,203 @@
+#include "CommandRecorder.h"
+
+// A render pass or a dynamic rendering instance the secondary command buffers continue
+static bool CommandRecorderContinuesRendering(const VkCommandBufferInheritanceInfo* inheritance) {
+    if (inheritance->renderPass != VK_NULL_HANDLE) {
+        return true;
+    }
+    for (const VkBaseInStructure* next = inheritance->pNext; next != NULL; next = next->pNext) {
+        if (next->sType == VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void CommandRecorderRecordJob(CommandRecorder* recorder, CommandRecorderWorker* worker) {
+    uint32_t slot = recorder->CurrentSlot;
+    if (worker->UsedCommandBuffers[slot] >= CommandRecorderMaxBatchesPerFrame) {
+        fflush(stdout);
+        fprintf(stderr, "More than %d command recorder batches in one frame!\n", CommandRecorderMaxBatchesPerFrame);
+        exit(1);
+    }
+    VkCommandBuffer commandBuffer = worker->CommandBuffers[slot][worker->UsedCommandBuffers[slot]++];
+
+    VkCheck(vkBeginCommandBuffer(commandBuffer,
+                                 &(VkCommandBufferBeginInfo){
+                                     .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                                     .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+                                              (CommandRecorderContinuesRendering(recorder->Inheritance)
+                                                   ? VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT
+                                                   : 0),
+                                     .pInheritanceInfo = recorder->Inheritance,
+                                 }));
+    recorder->Callback(commandBuffer, worker->FirstItem, worker->ItemCount, recorder->UserData);
+    VkCheck(vkEndCommandBuffer(commandBuffer));
+    worker->RecordedCommandBuffer = commandBuffer;
+}
+
+static void CommandRecorderWorkerMain(void* userData) {
+    CommandRecorderWorker* worker = userData;
+    CommandRecorder* recorder     = worker->Recorder;
+
+    uint64_t seenGeneration = 0;
+    SystemMutexLock(&recorder->Mutex);
+    while (true) {
+        while (recorder->Generation == seenGeneration && !recorder->ShuttingDown) {
+            SystemConditionVariableWait(&recorder->WorkAvailable, &recorder->Mutex);
+        }
+        if (recorder->ShuttingDown) {
+            break;
+        }
+        seenGeneration = recorder->Generation;
+        if (worker->Index >= recorder->JobCount) {
+            continue;
+        }
+
+        SystemMutexUnlock(&recorder->Mutex);
+        CommandRecorderRecordJob(recorder, worker);
+        SystemMutexLock(&recorder->Mutex);
+
+        if (--recorder->PendingJobs == 0) {
+            SystemConditionVariableSignal(&recorder->WorkDone);
+        }
+    }
+    SystemMutexUnlock(&recorder->Mutex);
+}
+
+CommandRecorder* CommandRecorderCreate(VkDevice device,
+                                       uint32_t queueFamilyIndex,
+                                       uint32_t workerCount,
+                                       uint32_t framesInFlight,
+                                       const VkAllocationCallbacks* allocator) {
+    assert(framesInFlight <= MaxFramesInFlight);
+    if (workerCount > CommandRecorderMaxWorkers) {
+        workerCount = CommandRecorderMaxWorkers;
+    }
+
+    CommandRecorder* recorder = calloc(1, sizeof(CommandRecorder));
+    if (recorder == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate the command recorder!\n");
+        exit(1);
+    }
+    recorder->Device         = device;
+    recorder->Allocator      = allocator;
+    recorder->FramesInFlight = framesInFlight;
+    recorder->WorkerCount    = workerCount;
+    SystemMutexInit(&recorder->Mutex);
+    SystemConditionVariableInit(&recorder->WorkAvailable);
+    SystemConditionVariableInit(&recorder->WorkDone);
+
+    for (uint32_t i = 0; i < workerCount; i++) {
+        CommandRecorderWorker* worker = &recorder->Workers[i];
+        worker->Recorder              = recorder;
+        worker->Index                 = i;
+        for (uint32_t slot = 0; slot < framesInFlight; slot++) {
+            VkResult commandPoolCreateResult = vkCreateCommandPool(device,
+                                                                   &(VkCommandPoolCreateInfo){
+                                                                       .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                                                                       .flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+                                                                       .queueFamilyIndex = queueFamilyIndex,
+                                                                   },
+                                                                   allocator,
+                                                                   &worker->CommandPools[slot]);
+            if (commandPoolCreateResult != VK_SUCCESS || worker->CommandPools[slot] == VK_NULL_HANDLE) {
+                fflush(stdout);
+                fprintf(stderr, "Failed to create command pool %d for recording worker %d! %x\n", slot, i, commandPoolCreateResult);
+                exit(1);
+            }
+            VkCheck(vkAllocateCommandBuffers(device,
+                                             &(VkCommandBufferAllocateInfo){
+                                                 .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                                                 .commandPool        = worker->CommandPools[slot],
+                                                 .level              = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+                                                 .commandBufferCount = CommandRecorderMaxBatchesPerFrame,
+                                             },
+                                             worker->CommandBuffers[slot]));
+        }
+        SystemThreadCreate(&worker->Thread, CommandRecorderWorkerMain, worker);
+    }
+
+    return recorder;
+}
+
+void CommandRecorderDestroy(CommandRecorder* recorder) {
+    SystemMutexLock(&recorder->Mutex);
+    recorder->ShuttingDown = true;
+    SystemConditionVariableBroadcast(&recorder->WorkAvailable);
+    SystemMutexUnlock(&recorder->Mutex);
+
+    for (uint32_t i = 0; i < recorder->WorkerCount; i++) {
+        CommandRecorderWorker* worker = &recorder->Workers[i];
+        SystemThreadJoin(&worker->Thread);
+        for (uint32_t slot = 0; slot < recorder->FramesInFlight; slot++) {
+            vkDestroyCommandPool(recorder->Device, worker->CommandPools[slot], recorder->Allocator);
+        }
+    }
+
+    SystemConditionVariableDestroy(&recorder->WorkDone);
+    SystemConditionVariableDestroy(&recorder->WorkAvailable);
+    SystemMutexDestroy(&recorder->Mutex);
+    free(recorder);
+}
+
+void CommandRecorderBeginFrame(CommandRecorder* recorder, uint32_t frameSlot) {
+    assert(frameSlot < recorder->FramesInFlight);
+    recorder->CurrentSlot = frameSlot;
+    for (uint32_t i = 0; i < recorder->WorkerCount; i++) {
+        CommandRecorderWorker* worker = &recorder->Workers[i];
+        VkCheck(vkResetCommandPool(recorder->Device, worker->CommandPools[frameSlot], 0));
+        worker->UsedCommandBuffers[frameSlot] = 0;
+    }
+}
+
+void CommandRecorderRecord(CommandRecorder* recorder,
+                           VkCommandBuffer primaryCommandBuffer,
+                           const VkCommandBufferInheritanceInfo* inheritance,
+                           uint32_t itemCount,
+                           CommandRecorderCallback callback,
+                           void* userData) {
+    if (itemCount == 0) {
+        return;
+    }
+    uint32_t jobCount = (itemCount + CommandRecorderMinItemsPerJob - 1) / CommandRecorderMinItemsPerJob;
+    if (jobCount > recorder->WorkerCount) {
+        jobCount = recorder->WorkerCount;
+    }
+    if (jobCount <= 1 && !CommandRecorderContinuesRendering(inheritance)) {
+        callback(primaryCommandBuffer, 0, itemCount, userData);
+        return;
+    }
+    if (jobCount == 0) {
+        fflush(stdout);
+        fprintf(stderr, "Recording secondary command buffers inside a render pass needs at least one recording worker!\n");
+        exit(1);
+    }
+
+    SystemMutexLock(&recorder->Mutex);
+    for (uint32_t i = 0; i < jobCount; i++) {
+        // Item ranges are spread evenly so no worker gets more than one item more than any other
+        uint32_t firstItem             = cast(uint32_t)(cast(uint64_t) itemCount * i / jobCount);
+        uint32_t endItem               = cast(uint32_t)(cast(uint64_t) itemCount * (i + 1) / jobCount);
+        recorder->Workers[i].FirstItem = firstItem;
+        recorder->Workers[i].ItemCount = endItem - firstItem;
+    }
+    recorder->Callback    = callback;
+    recorder->UserData    = userData;
+    recorder->Inheritance = inheritance;
+    recorder->JobCount    = jobCount;
+    recorder->PendingJobs = jobCount;
+    recorder->Generation++;
+    SystemConditionVariableBroadcast(&recorder->WorkAvailable);
+    while (recorder->PendingJobs > 0) {
+        SystemConditionVariableWait(&recorder->WorkDone, &recorder->Mutex);
+    }
+    SystemMutexUnlock(&recorder->Mutex);
+
+    VkCommandBuffer commandBuffers[CommandRecorderMaxWorkers];
+    for (uint32_t i = 0; i < jobCount; i++) {
+        commandBuffers[i] = recorder->Workers[i].RecordedCommandBuffer;
+    }
+    vkCmdExecuteCommands(primaryCommandBuffer, jobCount, commandBuffers);
+}
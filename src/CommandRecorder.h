@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Common.h"
+#include "System.h"
+
+#define CommandRecorderMaxWorkers         16
+#define CommandRecorderMaxBatchesPerFrame 8
+// Splitting fewer items than this across threads costs more in overhead than it saves
+#define CommandRecorderMinItemsPerJob     64
+
+// Records items [firstItem, firstItem + itemCount) into the command buffer, called from worker threads
+typedef void (*CommandRecorderCallback)(VkCommandBuffer commandBuffer, uint32_t firstItem, uint32_t itemCount, void* userData);
+
+typedef struct CommandRecorder CommandRecorder;
+
+typedef struct CommandRecorderWorker {
+    CommandRecorder* Recorder;
+    uint32_t Index;
+    SystemThread Thread;
+    VkCommandPool CommandPools[MaxFramesInFlight];
+    VkCommandBuffer CommandBuffers[MaxFramesInFlight][CommandRecorderMaxBatchesPerFrame];
+    uint32_t UsedCommandBuffers[MaxFramesInFlight];
+    uint32_t FirstItem;
+    uint32_t ItemCount;
+    VkCommandBuffer RecordedCommandBuffer;
+} CommandRecorderWorker;
+
+// A fixed set of worker threads that record secondary command buffers. Each worker owns a command pool per
+// frame slot, so recording never needs a lock on the pool and a slot's pools are reset together once its
+// fence has signaled. The calling thread waits for the workers and stitches their command buffers into the
+// primary one in item order with vkCmdExecuteCommands.
+struct CommandRecorder {
+    VkDevice Device;
+    const VkAllocationCallbacks* Allocator;
+    uint32_t FramesInFlight;
+    uint32_t CurrentSlot;
+    uint32_t WorkerCount;
+    CommandRecorderWorker Workers[CommandRecorderMaxWorkers];
+
+    SystemMutex Mutex;
+    SystemConditionVariable WorkAvailable;
+    SystemConditionVariable WorkDone;
+    uint64_t Generation;
+    uint32_t JobCount;
+    uint32_t PendingJobs;
+    bool ShuttingDown;
+    CommandRecorderCallback Callback;
+    void* UserData;
+    const VkCommandBufferInheritanceInfo* Inheritance;
+};
+
+// workerCount can be 0, everything is then recorded directly on the calling thread
+CommandRecorder* CommandRecorderCreate(VkDevice device,
+                                       uint32_t queueFamilyIndex,
+                                       uint32_t workerCount,
+                                       uint32_t framesInFlight,
+                                       const VkAllocationCallbacks* allocator);
+void CommandRecorderDestroy(CommandRecorder* recorder);
+
+// Must be called after the slot's fence has been waited on, resets every worker's pool for the slot
+void CommandRecorderBeginFrame(CommandRecorder* recorder, uint32_t frameSlot);
+
+// Splits the items across the workers and waits for them, without items nothing is recorded. Inside a render pass
+// the inheritance info must name it and the pass must have been begun with
+// VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS, inside dynamic rendering it must chain a
+// VkCommandBufferInheritanceRenderingInfoKHR and rendering must have been begun with
+// VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR. Outside of both, small batches are recorded straight into
+// the primary command buffer instead.
+void CommandRecorderRecord(CommandRecorder* recorder,
+                           VkCommandBuffer primaryCommandBuffer,
+                           const VkCommandBufferInheritanceInfo* inheritance,
+                           uint32_t itemCount,
+                           CommandRecorderCallback callback,
+                           void* userData);
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+// Functions are loaded at runtime, see Loader.h
+#define VK_NO_PROTOTYPES
+#include <vulkan/vulkan.h>
+#include "Loader.h"
+
+#define cast(type) (type)
+
+#define MaxFramesInFlight 3
+
+// Release builds report where the call was instead of its whole text, which keeps every checked call's source out
+// of the binary
+#if defined(VULKAN_DEBUG)
+    #define VkCheck(result)                                        \
+        do {                                                       \
+            VkResult _result = result;                             \
+            if (_result != VK_SUCCESS) {                           \
+                fflush(stdout);                                    \
+                fprintf(stderr, #result " failed! %x\n", _result); \
+                exit(1);                                           \
+            }                                                      \
+        } while (0)
+#else
+    #define VkCheck(result)                                                                        \
+        do {                                                                                       \
+            VkResult _result = result;                                                             \
+            if (_result != VK_SUCCESS) {                                                           \
+                fflush(stdout);                                                                    \
+                fprintf(stderr, "Vulkan call at %s:%d failed! %x\n", __FILE__, __LINE__, _result); \
+                exit(1);                                                                           \
+            }                                                                                      \
+        } while (0)
+#endif
@@ -0,0 +1,327 @@
+#include "Compute.h"
+
+Compute* ComputeCreate(VkDevice device,
+                       VkPipelineCache pipelineCache,
+                       VkQueue queue,
+                       uint32_t queueFamilyIndex,
+                       VkQueue graphicsQueue,
+                       uint32_t graphicsQueueFamilyIndex,
+                       uint32_t framesInFlight,
+                       const VkAllocationCallbacks* allocator) {
+    assert(framesInFlight <= MaxFramesInFlight);
+    Compute* compute = calloc(1, sizeof(Compute));
+    if (compute == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate the compute context!\n");
+        exit(1);
+    }
+    compute->Device                = device;
+    compute->Allocator             = allocator;
+    compute->PipelineCache         = pipelineCache;
+    compute->Queue                 = queue;
+    compute->Timeline              = TimelineCreate(device, allocator);
+    compute->Async                 = queue != graphicsQueue;
+    compute->QueueFamilyIndices[0] = queueFamilyIndex;
+    compute->QueueFamilyIndices[1] = graphicsQueueFamilyIndex;
+    compute->QueueFamilyIndexCount = queueFamilyIndex == graphicsQueueFamilyIndex ? 1 : 2;
+    compute->FramesInFlight        = framesInFlight;
+
+    for (uint32_t slot = 0; slot < framesInFlight; slot++) {
+        ComputeFrame* frame              = &compute->Frames[slot];
+        VkResult commandPoolCreateResult = vkCreateCommandPool(device,
+                                                               &(VkCommandPoolCreateInfo){
+                                                                   .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                                                                   .flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+                                                                   .queueFamilyIndex = queueFamilyIndex,
+                                                               },
+                                                               allocator,
+                                                               &frame->CommandPool);
+        if (commandPoolCreateResult != VK_SUCCESS || frame->CommandPool == VK_NULL_HANDLE) {
+            fflush(stdout);
+            fprintf(stderr, "Failed to create compute command pool %d! %x\n", slot, commandPoolCreateResult);
+            exit(1);
+        }
+        VkCheck(vkAllocateCommandBuffers(device,
+                                         &(VkCommandBufferAllocateInfo){
+                                             .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                                             .commandPool        = frame->CommandPool,
+                                             .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                                             .commandBufferCount = 1,
+                                         },
+                                         &frame->CommandBuffer));
+        VkCheck(vkCreateDescriptorPool(device,
+                                       &(VkDescriptorPoolCreateInfo){
+                                           .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+                                           .maxSets       = ComputeMaxDispatchesPerFrame,
+                                           .poolSizeCount = 1,
+                                           .pPoolSizes =
+                                               &(VkDescriptorPoolSize){
+                                                   .type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                                   .descriptorCount = ComputeMaxDispatchesPerFrame * ComputeMaxBindings,
+                                               },
+                                       },
+                                       allocator,
+                                       &frame->DescriptorPool));
+    }
+
+    return compute;
+}
+
+void ComputeDestroy(Compute* compute) {
+    for (uint32_t slot = 0; slot < compute->FramesInFlight; slot++) {
+        ComputeFrame* frame = &compute->Frames[slot];
+        vkDestroyDescriptorPool(compute->Device, frame->DescriptorPool, compute->Allocator);
+        vkDestroyCommandPool(compute->Device, frame->CommandPool, compute->Allocator);
+    }
+    TimelineDestroy(compute->Timeline);
+    free(compute);
+}
+
+// Creates pipeline->Pipeline with pipeline->PipelineLayout, local_size_x comes from specialization constant 0 and
+// specConstants from the ones after it
+static void ComputeCreatePipeline(Compute* compute,
+                                  ComputePipeline* pipeline,
+                                  ShaderId shader,
+                                  const uint32_t* specConstants,
+                                  uint32_t specConstantCount) {
+    assert(Shaders[shader].Stage == VK_SHADER_STAGE_COMPUTE_BIT);
+    assert(specConstantCount < ShaderMaxSpecConstants);
+    uint32_t values[ShaderMaxSpecConstants] = { pipeline->LocalSizeX };
+    for (uint32_t i = 0; i < specConstantCount; i++) {
+        values[i + 1] = specConstants[i];
+    }
+    ShaderSpecialization specialization;
+    VkPipelineShaderStageCreateInfo stage = {
+        .sType               = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+        .stage               = VK_SHADER_STAGE_COMPUTE_BIT,
+        .module              = ShaderCreateModule(compute->Device, shader, compute->Allocator),
+        .pName               = "main",
+        .pSpecializationInfo = ShaderSpecialize(shader, values, specConstantCount + 1, &specialization),
+    };
+    VkResult pipelineCreateResult = vkCreateComputePipelines(compute->Device,
+                                                             compute->PipelineCache,
+                                                             1,
+                                                             &(VkComputePipelineCreateInfo){
+                                                                 .sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+                                                                 .stage  = stage,
+                                                                 .layout = pipeline->PipelineLayout,
+                                                             },
+                                                             compute->Allocator,
+                                                             &pipeline->Pipeline);
+    vkDestroyShaderModule(compute->Device, stage.module, compute->Allocator);
+    if (pipelineCreateResult != VK_SUCCESS) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to create the compute pipeline for %s! %x\n", Shaders[shader].Name, pipelineCreateResult);
+        exit(1);
+    }
+}
+
+ComputePipeline* ComputePipelineCreate(Compute* compute, ShaderId shader, uint32_t localSizeX) {
+    const ShaderInfo* info    = &Shaders[shader];
+    uint32_t bindingCount     = info->BindingCount;
+    uint32_t pushConstantSize = info->PushConstantSize;
+    assert(bindingCount <= ComputeMaxBindings);
+    for (uint32_t i = 0; i < bindingCount; i++) {
+        assert(info->Bindings[i].Set == 0 && info->Bindings[i].Binding == i);
+        assert(info->Bindings[i].Type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER && info->Bindings[i].Count == 1);
+    }
+    ComputePipeline* pipeline = calloc(1, sizeof(ComputePipeline));
+    if (pipeline == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate a compute pipeline!\n");
+        exit(1);
+    }
+    pipeline->BindingCount     = bindingCount;
+    pipeline->PushConstantSize = pushConstantSize;
+    pipeline->LocalSizeX       = localSizeX;
+
+    VkDescriptorSetLayoutBinding bindings[ComputeMaxBindings];
+    for (uint32_t i = 0; i < bindingCount; i++) {
+        bindings[i] = (VkDescriptorSetLayoutBinding){
+            .binding         = i,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT,
+        };
+    }
+    VkCheck(vkCreateDescriptorSetLayout(compute->Device,
+                                        &(VkDescriptorSetLayoutCreateInfo){
+                                            .sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+                                            .bindingCount = bindingCount,
+                                            .pBindings    = bindings,
+                                        },
+                                        compute->Allocator,
+                                        &pipeline->DescriptorSetLayout));
+    VkCheck(vkCreatePipelineLayout(compute->Device,
+                                   &(VkPipelineLayoutCreateInfo){
+                                       .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+                                       .setLayoutCount         = 1,
+                                       .pSetLayouts            = &pipeline->DescriptorSetLayout,
+                                       .pushConstantRangeCount = pushConstantSize > 0 ? 1 : 0,
+                                       .pPushConstantRanges =
+                                           &(VkPushConstantRange){
+                                               .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                                               .offset     = 0,
+                                               .size       = pushConstantSize,
+                                           },
+                                   },
+                                   compute->Allocator,
+                                   &pipeline->PipelineLayout));
+    ComputeCreatePipeline(compute, pipeline, shader, NULL, 0);
+
+    return pipeline;
+}
+
+ComputePipeline* ComputePipelineCreateBindless(Compute* compute,
+                                               const Bindless* bindless,
+                                               ShaderId shader,
+                                               uint32_t localSizeX,
+                                               const uint32_t* specConstants,
+                                               uint32_t specConstantCount) {
+    assert(BindlessSupportsShader(bindless, shader));
+    ComputePipeline* pipeline = calloc(1, sizeof(ComputePipeline));
+    if (pipeline == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate a compute pipeline!\n");
+        exit(1);
+    }
+    pipeline->PipelineLayout   = bindless->PipelineLayout;
+    pipeline->Bindless         = true;
+    pipeline->PushConstantSize = Shaders[shader].PushConstantSize;
+    pipeline->LocalSizeX       = localSizeX;
+    ComputeCreatePipeline(compute, pipeline, shader, specConstants, specConstantCount);
+    return pipeline;
+}
+
+void ComputePipelineDestroy(Compute* compute, ComputePipeline* pipeline) {
+    vkDestroyPipeline(compute->Device, pipeline->Pipeline, compute->Allocator);
+    if (!pipeline->Bindless) {
+        vkDestroyPipelineLayout(compute->Device, pipeline->PipelineLayout, compute->Allocator);
+        vkDestroyDescriptorSetLayout(compute->Device, pipeline->DescriptorSetLayout, compute->Allocator);
+    }
+    free(pipeline);
+}
+
+uint32_t ComputeGroupCount(const ComputePipeline* pipeline, uint32_t itemCount) {
+    return (itemCount + pipeline->LocalSizeX - 1) / pipeline->LocalSizeX;
+}
+
+void ComputeBeginFrame(Compute* compute, uint32_t frameSlot) {
+    assert(frameSlot < compute->FramesInFlight);
+    compute->CurrentSlot = frameSlot;
+    ComputeFrame* frame  = &compute->Frames[frameSlot];
+    TimelineWait(compute->Timeline, frame->SubmittedValue);
+    VkCheck(vkResetCommandPool(compute->Device, frame->CommandPool, 0));
+    VkCheck(vkResetDescriptorPool(compute->Device, frame->DescriptorPool, 0));
+}
+
+VkCommandBuffer ComputeGetCommandBuffer(Compute* compute) {
+    ComputeFrame* frame = &compute->Frames[compute->CurrentSlot];
+    if (!frame->Recording) {
+        VkCheck(vkBeginCommandBuffer(frame->CommandBuffer,
+                                     &(VkCommandBufferBeginInfo){
+                                         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                                         .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+                                     }));
+        frame->Recording     = true;
+        frame->BindlessBound = false;
+    }
+    return frame->CommandBuffer;
+}
+
+void ComputeDispatch(Compute* compute,
+                     const ComputePipeline* pipeline,
+                     const VkDescriptorBufferInfo* buffers,
+                     const void* pushConstants,
+                     uint32_t groupCountX,
+                     uint32_t groupCountY,
+                     uint32_t groupCountZ) {
+    ComputeFrame* frame           = &compute->Frames[compute->CurrentSlot];
+    VkCommandBuffer commandBuffer = ComputeGetCommandBuffer(compute);
+
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    VkResult allocateResult =
+        vkAllocateDescriptorSets(compute->Device,
+                                 &(VkDescriptorSetAllocateInfo){
+                                     .sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+                                     .descriptorPool     = frame->DescriptorPool,
+                                     .descriptorSetCount = 1,
+                                     .pSetLayouts        = &pipeline->DescriptorSetLayout,
+                                 },
+                                 &descriptorSet);
+    if (allocateResult != VK_SUCCESS) {
+        fflush(stdout);
+        fprintf(stderr, "More than %d compute dispatches in one frame! %x\n", ComputeMaxDispatchesPerFrame, allocateResult);
+        exit(1);
+    }
+    VkWriteDescriptorSet writes[ComputeMaxBindings];
+    for (uint32_t i = 0; i < pipeline->BindingCount; i++) {
+        writes[i] = (VkWriteDescriptorSet){
+            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet          = descriptorSet,
+            .dstBinding      = i,
+            .descriptorCount = 1,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo     = &buffers[i],
+        };
+    }
+    vkUpdateDescriptorSets(compute->Device, pipeline->BindingCount, writes, 0, NULL);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->Pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->PipelineLayout, 0, 1, &descriptorSet, 0, NULL);
+    if (pipeline->PushConstantSize > 0) {
+        vkCmdPushConstants(
+            commandBuffer, pipeline->PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, pipeline->PushConstantSize, pushConstants);
+    }
+    vkCmdDispatch(commandBuffer, groupCountX, groupCountY, groupCountZ);
+}
+
+void ComputeDispatchBindless(Compute* compute,
+                             const ComputePipeline* pipeline,
+                             const Bindless* bindless,
+                             const void* pushConstants,
+                             uint32_t groupCountX,
+                             uint32_t groupCountY,
+                             uint32_t groupCountZ) {
+    assert(pipeline->Bindless);
+    ComputeFrame* frame           = &compute->Frames[compute->CurrentSlot];
+    VkCommandBuffer commandBuffer = ComputeGetCommandBuffer(compute);
+    // The set stays bound across pipeline changes because every bindless pipeline shares the layout
+    if (!frame->BindlessBound) {
+        BindlessBind(bindless, commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE);
+        frame->BindlessBound = true;
+    }
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->Pipeline);
+    if (pipeline->PushConstantSize > 0) {
+        BindlessPushConstants(bindless, commandBuffer, pushConstants, pipeline->PushConstantSize);
+    }
+    vkCmdDispatch(commandBuffer, groupCountX, groupCountY, groupCountZ);
+}
+
+uint64_t ComputeSubmit(Compute* compute) {
+    ComputeFrame* frame = &compute->Frames[compute->CurrentSlot];
+    if (!frame->Recording) {
+        return 0;
+    }
+    frame->Recording = false;
+    VkCheck(vkEndCommandBuffer(frame->CommandBuffer));
+
+    frame->SubmittedValue = TimelineNextValue(compute->Timeline);
+    VkCheck(vkQueueSubmit(compute->Queue,
+                          1,
+                          &(VkSubmitInfo){
+                              .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                              .pNext =
+                                  &(VkTimelineSemaphoreSubmitInfo){
+                                      .sType                     = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+                                      .signalSemaphoreValueCount = 1,
+                                      .pSignalSemaphoreValues    = &frame->SubmittedValue,
+                                  },
+                              .commandBufferCount   = 1,
+                              .pCommandBuffers      = &frame->CommandBuffer,
+                              .signalSemaphoreCount = 1,
+                              .pSignalSemaphores    = &compute->Timeline->Semaphore,
+                          },
+                          VK_NULL_HANDLE));
+    return frame->SubmittedValue;
+}
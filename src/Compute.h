@@ -0,0 +1,96 @@
+#pragma once
+
+#include "Common.h"
+#include "Timeline.h"
+#include "Bindless.h"
+#include "Shader.h"
+
+#define ComputeMaxBindings           8
+#define ComputeMaxDispatchesPerFrame 64
+
+typedef struct ComputePipeline {
+    VkDescriptorSetLayout DescriptorSetLayout;
+    VkPipelineLayout PipelineLayout;
+    VkPipeline Pipeline;
+    uint32_t BindingCount;
+    uint32_t PushConstantSize;
+    uint32_t LocalSizeX;
+    // Uses the bindless pipeline layout, which it doesn't own, and has no set layout of its own
+    bool Bindless;
+} ComputePipeline;
+
+typedef struct ComputeFrame {
+    VkCommandPool CommandPool;
+    VkCommandBuffer CommandBuffer;
+    VkDescriptorPool DescriptorPool;
+    // The compute timeline value the slot's last submission signals
+    uint64_t SubmittedValue;
+    bool Recording;
+    bool BindlessBound;
+} ComputeFrame;
+
+// Records compute work into its own command buffer per frame slot and submits it to the compute queue ahead of
+// the graphics submission, which waits on the compute timeline only at the stage that consumes the results.
+// On devices with a separate compute family that lets the dispatches overlap with the previous frame's graphics
+// work, otherwise the compute queue is the graphics queue and the work simply runs first. Buffers shared between
+// the two queues are created concurrent over QueueFamilyIndices, so no ownership transfers are needed.
+typedef struct Compute {
+    VkDevice Device;
+    const VkAllocationCallbacks* Allocator;
+    VkPipelineCache PipelineCache;
+    VkQueue Queue;
+    Timeline* Timeline;
+    bool Async;
+    uint32_t QueueFamilyIndices[2];
+    uint32_t QueueFamilyIndexCount;
+    uint32_t FramesInFlight;
+    uint32_t CurrentSlot;
+    ComputeFrame Frames[MaxFramesInFlight];
+} Compute;
+
+Compute* ComputeCreate(VkDevice device,
+                       VkPipelineCache pipelineCache,
+                       VkQueue queue,
+                       uint32_t queueFamilyIndex,
+                       VkQueue graphicsQueue,
+                       uint32_t graphicsQueueFamilyIndex,
+                       uint32_t framesInFlight,
+                       const VkAllocationCallbacks* allocator);
+// The device must be idle
+void ComputeDestroy(Compute* compute);
+
+// Every binding the shader declares has to be a single storage buffer in set 0, numbered from 0, its push constant
+// size comes from the reflection. The shader's local_size_x must come from specialization constant 0.
+ComputePipeline* ComputePipelineCreate(Compute* compute, ShaderId shader, uint32_t localSizeX);
+// Reads its resources from the bindless set with the indices it gets in its push constants. specConstants are the
+// values of specialization constants 1 onwards.
+ComputePipeline* ComputePipelineCreateBindless(Compute* compute,
+                                               const Bindless* bindless,
+                                               ShaderId shader,
+                                               uint32_t localSizeX,
+                                               const uint32_t* specConstants,
+                                               uint32_t specConstantCount);
+void ComputePipelineDestroy(Compute* compute, ComputePipeline* pipeline);
+uint32_t ComputeGroupCount(const ComputePipeline* pipeline, uint32_t itemCount);
+
+// Waits for the slot's previous compute work, which the graphics frame using the slot has already waited for
+void ComputeBeginFrame(Compute* compute, uint32_t frameSlot);
+// Begins the slot's command buffer on first use, for recording barriers or copies between dispatches
+VkCommandBuffer ComputeGetCommandBuffer(Compute* compute);
+void ComputeDispatch(Compute* compute,
+                     const ComputePipeline* pipeline,
+                     const VkDescriptorBufferInfo* buffers,
+                     const void* pushConstants,
+                     uint32_t groupCountX,
+                     uint32_t groupCountY,
+                     uint32_t groupCountZ);
+// Binds the bindless set once per command buffer, nothing is allocated per dispatch
+void ComputeDispatchBindless(Compute* compute,
+                             const ComputePipeline* pipeline,
+                             const Bindless* bindless,
+                             const void* pushConstants,
+                             uint32_t groupCountX,
+                             uint32_t groupCountY,
+                             uint32_t groupCountZ);
+// Returns the value of compute->Timeline the graphics submission has to wait for, or 0 if nothing was recorded
+uint64_t ComputeSubmit(Compute* compute);
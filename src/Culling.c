@@ -0,0 +1,586 @@
+#include "Culling.h"
+#include "DebugUtils.h"
+#include <math.h>
+
+static_assert(sizeof(CullingObject) == 48, "CullingObject must match the shaders' std430 layout");
+static_assert(sizeof(VkDrawIndexedIndirectCommand) == 20, "The cull shader writes draws with a stride of 20 bytes");
+
+typedef struct CullingCullPushConstants {
+    float Planes[6][4];
+    uint32_t ObjectCount;
+    uint32_t ObjectBuffer;
+    uint32_t DrawBuffer;
+    uint32_t CountBuffer;
+} CullingCullPushConstants;
+
+typedef struct CullingDrawPushConstants {
+    float ViewProjection[16];
+    uint32_t ObjectBuffer;
+} CullingDrawPushConstants;
+
+// Corners are numbered x + 2y, the vertex shader turns the index back into the corner
+static const uint16_t CullingQuadIndices[CullingQuadIndexCount] = { 0, 1, 2, 2, 1, 3 };
+
+static const VkBufferUsageFlags CullingObjectUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+static const VkBufferUsageFlags CullingIndexUsage  = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+static VkResult CullingBuildDrawPipeline(VkDevice device,
+                                         VkPipelineCache pipelineCache,
+                                         const VkShaderModule* modules,
+                                         uint32_t variant,
+                                         void* userData,
+                                         VkPipeline* pipeline) {
+    (void)variant;
+    const Culling* culling = userData;
+    const VkDynamicState DynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    return vkCreateGraphicsPipelines(device,
+                                     pipelineCache,
+                                     1,
+                                     &(VkGraphicsPipelineCreateInfo){
+                                         .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+                                         .pNext =
+                                             &(VkPipelineRenderingCreateInfoKHR){
+                                                 .sType                   = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR,
+                                                 .colorAttachmentCount    = 1,
+                                                 .pColorAttachmentFormats = &culling->ColorFormat,
+                                             },
+                                         .stageCount = 2,
+                                         .pStages =
+                                             (VkPipelineShaderStageCreateInfo[]){
+                                                 {
+                                                     .sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                                                     .stage  = VK_SHADER_STAGE_VERTEX_BIT,
+                                                     .module = modules[0],
+                                                     .pName  = "main",
+                                                 },
+                                                 {
+                                                     .sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                                                     .stage  = VK_SHADER_STAGE_FRAGMENT_BIT,
+                                                     .module = modules[1],
+                                                     .pName  = "main",
+                                                 },
+                                             },
+                                         // Vertices come out of the object buffer, there are no vertex attributes
+                                         .pVertexInputState =
+                                             &(VkPipelineVertexInputStateCreateInfo){
+                                                 .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+                                             },
+                                         .pInputAssemblyState =
+                                             &(VkPipelineInputAssemblyStateCreateInfo){
+                                                 .sType    = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+                                                 .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+                                             },
+                                         .pViewportState =
+                                             &(VkPipelineViewportStateCreateInfo){
+                                                 .sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+                                                 .viewportCount = 1,
+                                                 .scissorCount  = 1,
+                                             },
+                                         .pRasterizationState =
+                                             &(VkPipelineRasterizationStateCreateInfo){
+                                                 .sType       = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+                                                 .polygonMode = VK_POLYGON_MODE_FILL,
+                                                 .cullMode    = VK_CULL_MODE_NONE,
+                                                 .frontFace   = VK_FRONT_FACE_COUNTER_CLOCKWISE,
+                                                 .lineWidth   = 1.0f,
+                                             },
+                                         .pMultisampleState =
+                                             &(VkPipelineMultisampleStateCreateInfo){
+                                                 .sType                = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+                                                 .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+                                             },
+                                         .pColorBlendState =
+                                             &(VkPipelineColorBlendStateCreateInfo){
+                                                 .sType           = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+                                                 .attachmentCount = 1,
+                                                 .pAttachments =
+                                                     &(VkPipelineColorBlendAttachmentState){
+                                                         .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                                                                           VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
+                                                     },
+                                             },
+                                         .pDynamicState =
+                                             &(VkPipelineDynamicStateCreateInfo){
+                                                 .sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+                                                 .dynamicStateCount = sizeof(DynamicStates) / sizeof(DynamicStates[0]),
+                                                 .pDynamicStates    = DynamicStates,
+                                             },
+                                         .layout = culling->Bindless->PipelineLayout,
+                                     },
+                                     culling->Allocator,
+                                     pipeline);
+}
+
+static VkBuffer CullingCreateBuffer(Culling* culling,
+                                    VkDeviceSize size,
+                                    VkBufferUsageFlags usage,
+                                    VkMemoryPropertyFlags requiredFlags,
+                                    VkMemoryPropertyFlags preferredFlags,
+                                    DeviceAllocation** allocation,
+                                    const char* name) {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkResult bufferCreateResult =
+        DeviceAllocatorCreateBuffer(culling->DeviceAllocator,
+                                    &(VkBufferCreateInfo){
+                                        .sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+                                        .size        = size,
+                                        .usage       = usage,
+                                        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                                    },
+                                    requiredFlags,
+                                    preferredFlags,
+                                    &buffer,
+                                    allocation);
+    if (bufferCreateResult != VK_SUCCESS) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to create the culling %s buffer! %x\n", name, bufferCreateResult);
+        exit(1);
+    }
+    return buffer;
+}
+
+static uint32_t CullingAddStorageBuffer(Culling* culling, VkBuffer buffer) {
+    return BindlessAddStorageBuffer(culling->Bindless,
+                                    &(VkDescriptorBufferInfo){
+                                        .buffer = buffer,
+                                        .range  = VK_WHOLE_SIZE,
+                                    });
+}
+
+Culling* CullingCreate(VkDevice device,
+                       PipelineManager* pipelineManager,
+                       DeviceAllocator* deviceAllocator,
+                       Uploader* uploader,
+                       Bindless* bindless,
+                       Profiler* profiler,
+                       VkFormat colorFormat,
+                       bool drawIndirectCount,
+                       CommandRecorder* recorder,
+                       const CullingObject* objects,
+                       uint32_t objectCount,
+                       uint32_t framesInFlight,
+                       const VkAllocationCallbacks* allocator) {
+    assert(objectCount > 0);
+    Culling* culling = calloc(1, sizeof(Culling));
+    if (culling == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate the culling state!\n");
+        exit(1);
+    }
+    culling->Device            = device;
+    culling->Allocator         = allocator;
+    culling->DeviceAllocator   = deviceAllocator;
+    culling->PipelineManager   = pipelineManager;
+    culling->Bindless          = bindless;
+    culling->Profiler          = profiler;
+    culling->CullPhase         = ProfilerRegisterGpuPass(profiler, "Cull");
+    culling->DrawPhase         = ProfilerRegisterGpuPass(profiler, "Draw");
+    culling->CmdBeginRendering = cast(PFN_vkCmdBeginRenderingKHR) vkGetDeviceProcAddr(device, "vkCmdBeginRenderingKHR");
+    culling->CmdEndRendering   = cast(PFN_vkCmdEndRenderingKHR) vkGetDeviceProcAddr(device, "vkCmdEndRenderingKHR");
+    culling->DrawIndirectCount = drawIndirectCount;
+    culling->ColorFormat       = colorFormat;
+    culling->Recorder          = recorder;
+    culling->ObjectCount       = objectCount;
+    culling->FramesInFlight    = framesInFlight;
+    assert(culling->CmdBeginRendering && culling->CmdEndRendering);
+    assert(recorder == NULL || recorder->WorkerCount > 0);
+    SystemMutexInit(&culling->Mutex);
+    if (recorder) {
+        culling->Objects = malloc(objectCount * sizeof(CullingObject));
+        if (culling->Objects == NULL) {
+            fflush(stdout);
+            fprintf(stderr, "Failed to allocate the CPU copy of the culling objects!\n");
+            exit(1);
+        }
+        memcpy(culling->Objects, objects, objectCount * sizeof(CullingObject));
+    }
+
+    // The Compact specialization constant packs visible objects' draws at the front of the buffer, otherwise every
+    // object has its own draw and culled ones draw no instances
+    const uint32_t CullSpecConstants[] = { CullingGroupSize, drawIndirectCount };
+    const ShaderId DrawShaders[]       = { ShaderId_CullDrawVert, ShaderId_CullDrawFrag };
+    assert(BindlessSupportsShader(bindless, ShaderId_CullComp) && BindlessSupportsShader(bindless, ShaderId_CullDrawVert));
+    assert(Shaders[ShaderId_CullComp].PushConstantSize == sizeof(CullingCullPushConstants));
+    assert(Shaders[ShaderId_CullDrawVert].PushConstantSize == sizeof(CullingDrawPushConstants));
+    culling->CullPipeline = PipelineManagerAddCompute(pipelineManager, "Cull", ShaderId_CullComp, bindless->PipelineLayout, CullSpecConstants, 2);
+    culling->DrawPipeline = PipelineManagerAddGraphics(pipelineManager, "CullingDraw", DrawShaders, 2, CullingBuildDrawPipeline, 0, culling);
+
+    VkDeviceSize objectsSize = cast(VkDeviceSize) objectCount * sizeof(CullingObject);
+    culling->ObjectBuffer    = CullingCreateBuffer(culling,
+                                                objectsSize,
+                                                CullingObjectUsage,
+                                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                                0,
+                                                &culling->ObjectAllocation,
+                                                "objects");
+    culling->ObjectIndex = CullingAddStorageBuffer(culling, culling->ObjectBuffer);
+    DebugUtilsSetObjectName(device, VK_OBJECT_TYPE_BUFFER, cast(uint64_t) culling->ObjectBuffer, "Culling objects");
+
+    culling->IndexBuffer = CullingCreateBuffer(culling,
+                                               sizeof(CullingQuadIndices),
+                                               CullingIndexUsage,
+                                               VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                               0,
+                                               &culling->IndexAllocation,
+                                               "indices");
+    DebugUtilsSetObjectName(device, VK_OBJECT_TYPE_BUFFER, cast(uint64_t) culling->IndexBuffer, "Culling indices");
+
+    UploaderUploadBuffer(uploader, culling->ObjectBuffer, 0, objects, objectsSize);
+    UploaderUploadBuffer(uploader, culling->IndexBuffer, 0, CullingQuadIndices, sizeof(CullingQuadIndices));
+    UploaderFlush(uploader);
+    // Acquires only pick up finished uploads, so without the wait the first frames would draw garbage
+    TimelineWait(uploader->Timeline, uploader->Timeline->LastSubmittedValue);
+    // Neither is written again, so defragmentation is free to move them
+    DeviceAllocatorSetMovable(deviceAllocator, culling->ObjectAllocation);
+    DeviceAllocatorSetMovable(deviceAllocator, culling->IndexAllocation);
+
+    VkDeviceSize drawsSize = cast(VkDeviceSize) objectCount * sizeof(VkDrawIndexedIndirectCommand);
+    for (uint32_t i = 0; i < framesInFlight; i++) {
+        CullingFrame* frame = &culling->Frames[i];
+        frame->DrawBuffer   = CullingCreateBuffer(culling,
+                                                drawsSize,
+                                                VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                                0,
+                                                &frame->DrawAllocation,
+                                                "draws");
+        frame->DrawIndex = CullingAddStorageBuffer(culling, frame->DrawBuffer);
+        DebugUtilsSetObjectName(device, VK_OBJECT_TYPE_BUFFER, cast(uint64_t) frame->DrawBuffer, "Culling draws %u", i);
+
+        frame->CountBuffer = CullingCreateBuffer(culling,
+                                                 sizeof(uint32_t),
+                                                 VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                                     VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                                 0,
+                                                 &frame->CountAllocation,
+                                                 "count");
+        frame->CountIndex = CullingAddStorageBuffer(culling, frame->CountBuffer);
+        DebugUtilsSetObjectName(device, VK_OBJECT_TYPE_BUFFER, cast(uint64_t) frame->CountBuffer, "Culling count %u", i);
+
+        frame->ReadbackBuffer = CullingCreateBuffer(culling,
+                                                    sizeof(uint32_t),
+                                                    VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+                                                    VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+                                                    &frame->ReadbackAllocation,
+                                                    "readback");
+        DebugUtilsSetObjectName(device, VK_OBJECT_TYPE_BUFFER, cast(uint64_t) frame->ReadbackBuffer, "Culling readback %u", i);
+    }
+    return culling;
+}
+
+void CullingDestroy(Culling* culling) {
+    for (uint32_t i = 0; i < culling->RetiredBufferCount; i++) {
+        vkDestroyBuffer(culling->Device, culling->RetiredBuffers[i], culling->Allocator);
+    }
+    for (uint32_t i = 0; i < culling->FramesInFlight; i++) {
+        CullingFrame* frame = &culling->Frames[i];
+        BindlessRemove(culling->Bindless, BindlessType_StorageBuffer, frame->DrawIndex);
+        BindlessRemove(culling->Bindless, BindlessType_StorageBuffer, frame->CountIndex);
+        vkDestroyBuffer(culling->Device, frame->DrawBuffer, culling->Allocator);
+        vkDestroyBuffer(culling->Device, frame->CountBuffer, culling->Allocator);
+        vkDestroyBuffer(culling->Device, frame->ReadbackBuffer, culling->Allocator);
+        DeviceAllocatorFree(culling->DeviceAllocator, frame->DrawAllocation);
+        DeviceAllocatorFree(culling->DeviceAllocator, frame->CountAllocation);
+        DeviceAllocatorFree(culling->DeviceAllocator, frame->ReadbackAllocation);
+    }
+    BindlessRemove(culling->Bindless, BindlessType_StorageBuffer, culling->ObjectIndex);
+    vkDestroyBuffer(culling->Device, culling->ObjectBuffer, culling->Allocator);
+    vkDestroyBuffer(culling->Device, culling->IndexBuffer, culling->Allocator);
+    DeviceAllocatorFree(culling->DeviceAllocator, culling->ObjectAllocation);
+    DeviceAllocatorFree(culling->DeviceAllocator, culling->IndexAllocation);
+    PipelineManagerRemove(culling->PipelineManager, culling->DrawPipeline);
+    PipelineManagerRemove(culling->PipelineManager, culling->CullPipeline);
+    SystemMutexDestroy(&culling->Mutex);
+    free(culling->Objects);
+    free(culling);
+}
+
+// The new handle takes over right away, the old one stays bound to the old range for the frames already submitted
+static void CullingRebindBuffer(Culling* culling,
+                                VkBuffer* buffer,
+                                const DeviceAllocation* allocation,
+                                VkDeviceSize size,
+                                VkBufferUsageFlags usage,
+                                const char* name) {
+    VkBuffer moved        = VK_NULL_HANDLE;
+    VkResult rebindResult = DeviceAllocatorRebindBuffer(culling->DeviceAllocator,
+                                                        &(VkBufferCreateInfo){
+                                                            .sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+                                                            .size        = size,
+                                                            .usage       = usage,
+                                                            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                                                        },
+                                                        allocation,
+                                                        &moved);
+    if (rebindResult != VK_SUCCESS) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to rebind the culling %s buffer! %x\n", name, rebindResult);
+        exit(1);
+    }
+    culling->RetiredBuffers[culling->RetiredBufferCount++] = *buffer;
+    *buffer                                                = moved;
+    DebugUtilsSetObjectName(culling->Device, VK_OBJECT_TYPE_BUFFER, cast(uint64_t) moved, "Culling %s", name);
+}
+
+void CullingRebind(Culling* culling) {
+    // Defragmentation only starts again once the last one ended, by then nothing uses the buffers it replaced
+    TimelineWait(culling->Bindless->Timeline, culling->RetiredValue);
+    for (uint32_t i = 0; i < culling->RetiredBufferCount; i++) {
+        vkDestroyBuffer(culling->Device, culling->RetiredBuffers[i], culling->Allocator);
+    }
+    culling->RetiredBufferCount = 0;
+    culling->RetiredValue       = culling->Bindless->Timeline->LastSubmittedValue + 1;
+
+    if (culling->ObjectAllocation->Moved) {
+        VkDeviceSize objectsSize = cast(VkDeviceSize) culling->ObjectCount * sizeof(CullingObject);
+        CullingRebindBuffer(culling, &culling->ObjectBuffer, culling->ObjectAllocation, objectsSize, CullingObjectUsage, "objects");
+        BindlessRemove(culling->Bindless, BindlessType_StorageBuffer, culling->ObjectIndex);
+        culling->ObjectIndex = CullingAddStorageBuffer(culling, culling->ObjectBuffer);
+    }
+    if (culling->IndexAllocation->Moved) {
+        CullingRebindBuffer(culling, &culling->IndexBuffer, culling->IndexAllocation, sizeof(CullingQuadIndices), CullingIndexUsage, "indices");
+    }
+}
+
+static void CullingRecordResetPass(VkCommandBuffer commandBuffer, RenderGraph* graph, void* userData) {
+    const CullingFrame* frame = userData;
+    vkCmdFillBuffer(commandBuffer, RenderGraphGetBuffer(graph, frame->Count), 0, sizeof(uint32_t), 0);
+}
+
+static void CullingRecordCullPass(VkCommandBuffer commandBuffer, RenderGraph* graph, void* userData) {
+    (void)graph;
+    Culling* culling          = userData;
+    const CullingFrame* frame = &culling->Frames[culling->CurrentSlot];
+
+    CullingCullPushConstants pushConstants = {
+        .ObjectCount  = culling->ObjectCount,
+        .ObjectBuffer = culling->ObjectIndex,
+        .DrawBuffer   = frame->DrawIndex,
+        .CountBuffer  = frame->CountIndex,
+    };
+    memcpy(pushConstants.Planes, frame->Planes, sizeof(pushConstants.Planes));
+
+    ProfilerBeginGpuPass(culling->Profiler, commandBuffer, culling->CullPhase);
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, frame->CullPipeline);
+    BindlessBind(culling->Bindless, commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE);
+    BindlessPushConstants(culling->Bindless, commandBuffer, &pushConstants, sizeof(pushConstants));
+    vkCmdDispatch(commandBuffer, (culling->ObjectCount + CullingGroupSize - 1) / CullingGroupSize, 1, 1);
+    ProfilerEndGpuPass(culling->Profiler, commandBuffer, culling->CullPhase);
+}
+
+// Secondary command buffers inherit none of it, so every worker's has to set it again
+static void CullingBindDrawState(const Culling* culling, const CullingFrame* frame, VkCommandBuffer commandBuffer) {
+    CullingDrawPushConstants pushConstants = {
+        .ObjectBuffer = culling->ObjectIndex,
+    };
+    memcpy(pushConstants.ViewProjection, frame->ViewProjection, sizeof(pushConstants.ViewProjection));
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, frame->DrawPipeline);
+    BindlessBind(culling->Bindless, commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS);
+    BindlessPushConstants(culling->Bindless, commandBuffer, &pushConstants, sizeof(pushConstants));
+    vkCmdSetViewport(commandBuffer,
+                     0,
+                     1,
+                     &(VkViewport){
+                         .width    = cast(float) frame->Extent.width,
+                         .height   = cast(float) frame->Extent.height,
+                         .maxDepth = 1.0f,
+                     });
+    vkCmdSetScissor(commandBuffer,
+                    0,
+                    1,
+                    &(VkRect2D){
+                        .extent = frame->Extent,
+                    });
+    vkCmdBindIndexBuffer(commandBuffer, culling->IndexBuffer, 0, VK_INDEX_TYPE_UINT16);
+}
+
+// Runs on the recorder's workers, the instance is the object index just like in the draws the cull shader writes
+static void CullingRecordObjects(VkCommandBuffer commandBuffer, uint32_t firstItem, uint32_t itemCount, void* userData) {
+    Culling* culling    = userData;
+    CullingFrame* frame = &culling->Frames[culling->CurrentSlot];
+
+    CullingBindDrawState(culling, frame, commandBuffer);
+    uint32_t visibleCount = 0;
+    for (uint32_t i = firstItem; i < firstItem + itemCount; i++) {
+        const CullingObject* object = &culling->Objects[i];
+        if (CullingIsVisible(frame->Planes, object)) {
+            vkCmdDrawIndexed(commandBuffer, object->IndexCount, 1, object->FirstIndex, object->VertexOffset, i);
+            visibleCount++;
+        }
+    }
+
+    SystemMutexLock(&culling->Mutex);
+    frame->VisibleCount += visibleCount;
+    SystemMutexUnlock(&culling->Mutex);
+}
+
+static void CullingRecordDrawPass(VkCommandBuffer commandBuffer, RenderGraph* graph, void* userData) {
+    Culling* culling    = userData;
+    CullingFrame* frame = &culling->Frames[culling->CurrentSlot];
+
+    ProfilerBeginGpuPass(culling->Profiler, commandBuffer, culling->DrawPhase);
+    culling->CmdBeginRendering(commandBuffer,
+                               &(VkRenderingInfoKHR){
+                                   .sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR,
+                                   .flags = culling->Recorder ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR : 0,
+                                   .renderArea =
+                                       (VkRect2D){
+                                           .extent = frame->Extent,
+                                       },
+                                   .layerCount           = 1,
+                                   .colorAttachmentCount = 1,
+                                   .pColorAttachments =
+                                       &(VkRenderingAttachmentInfoKHR){
+                                           .sType       = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR,
+                                           .imageView   = RenderGraphGetImageView(graph, frame->Target),
+                                           .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                                           .loadOp      = VK_ATTACHMENT_LOAD_OP_LOAD,
+                                           .storeOp     = VK_ATTACHMENT_STORE_OP_STORE,
+                                       },
+                               });
+    if (culling->Recorder) {
+        frame->VisibleCount = 0;
+        CommandRecorderRecord(culling->Recorder,
+                              commandBuffer,
+                              &(VkCommandBufferInheritanceInfo){
+                                  .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+                                  .pNext =
+                                      &(VkCommandBufferInheritanceRenderingInfoKHR){
+                                          .sType                   = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR,
+                                          .colorAttachmentCount    = 1,
+                                          .pColorAttachmentFormats = &culling->ColorFormat,
+                                          .rasterizationSamples    = VK_SAMPLE_COUNT_1_BIT,
+                                      },
+                              },
+                              culling->ObjectCount,
+                              CullingRecordObjects,
+                              culling);
+    } else if (culling->DrawIndirectCount) {
+        CullingBindDrawState(culling, frame, commandBuffer);
+        vkCmdDrawIndexedIndirectCount(commandBuffer,
+                                      RenderGraphGetBuffer(graph, frame->Draws),
+                                      0,
+                                      RenderGraphGetBuffer(graph, frame->Count),
+                                      0,
+                                      culling->ObjectCount,
+                                      sizeof(VkDrawIndexedIndirectCommand));
+    } else {
+        CullingBindDrawState(culling, frame, commandBuffer);
+        vkCmdDrawIndexedIndirect(commandBuffer,
+                                 RenderGraphGetBuffer(graph, frame->Draws),
+                                 0,
+                                 culling->ObjectCount,
+                                 sizeof(VkDrawIndexedIndirectCommand));
+    }
+    culling->CmdEndRendering(commandBuffer);
+    ProfilerEndGpuPass(culling->Profiler, commandBuffer, culling->DrawPhase);
+}
+
+static void CullingRecordReadbackPass(VkCommandBuffer commandBuffer, RenderGraph* graph, void* userData) {
+    const CullingFrame* frame = userData;
+    vkCmdCopyBuffer(commandBuffer,
+                    RenderGraphGetBuffer(graph, frame->Count),
+                    RenderGraphGetBuffer(graph, frame->Readback),
+                    1,
+                    &(VkBufferCopy){
+                        .size = sizeof(uint32_t),
+                    });
+}
+
+bool CullingAddPasses(Culling* culling,
+                      RenderGraph* graph,
+                      uint32_t frameSlot,
+                      RenderGraphResource target,
+                      VkExtent2D extent,
+                      const float viewProjection[16]) {
+    CullingFrame* frame  = &culling->Frames[frameSlot];
+    culling->CurrentSlot = frameSlot;
+    // Nothing is drawn until both pipelines are built
+    frame->CullPipeline = PipelineManagerGet(culling->PipelineManager, culling->CullPipeline);
+    frame->DrawPipeline = PipelineManagerGet(culling->PipelineManager, culling->DrawPipeline);
+    if (frame->CullPipeline == VK_NULL_HANDLE || frame->DrawPipeline == VK_NULL_HANDLE) {
+        return false;
+    }
+    memcpy(frame->ViewProjection, viewProjection, sizeof(frame->ViewProjection));
+    CullingExtractPlanes(viewProjection, frame->Planes);
+    frame->Extent = extent;
+    frame->Target = target;
+
+    // Culling happens while the graph executes, as the workers record the draw pass
+    if (culling->Recorder) {
+        uint32_t pass = RenderGraphAddPass(graph, "CullingDraw", CullingRecordDrawPass, culling);
+        RenderGraphUse(graph, pass, target, RenderGraphUsage_ColorAttachment);
+        return true;
+    }
+
+    // The previous frame using the slot has finished, so nothing has to be waited for before writing these
+    frame->Draws    = RenderGraphImportBuffer(graph, "CullingDraws", frame->DrawBuffer, RenderGraphUsage_IndirectRead);
+    frame->Count    = RenderGraphImportBuffer(graph, "CullingCount", frame->CountBuffer, RenderGraphUsage_TransferSrc);
+    frame->Readback = RenderGraphImportBuffer(graph, "CullingReadback", frame->ReadbackBuffer, RenderGraphUsage_HostRead);
+
+    uint32_t pass = RenderGraphAddPass(graph, "CullingReset", CullingRecordResetPass, frame);
+    RenderGraphUse(graph, pass, frame->Count, RenderGraphUsage_TransferDst);
+
+    pass = RenderGraphAddPass(graph, "Cull", CullingRecordCullPass, culling);
+    RenderGraphUse(graph, pass, frame->Draws, RenderGraphUsage_ComputeStorageWrite);
+    RenderGraphUse(graph, pass, frame->Count, RenderGraphUsage_ComputeStorageWrite);
+
+    pass = RenderGraphAddPass(graph, "CullingDraw", CullingRecordDrawPass, culling);
+    RenderGraphUse(graph, pass, frame->Draws, RenderGraphUsage_IndirectRead);
+    if (culling->DrawIndirectCount) {
+        RenderGraphUse(graph, pass, frame->Count, RenderGraphUsage_IndirectRead);
+    }
+    RenderGraphUse(graph, pass, target, RenderGraphUsage_ColorAttachment);
+
+    pass = RenderGraphAddPass(graph, "CullingReadback", CullingRecordReadbackPass, frame);
+    RenderGraphUse(graph, pass, frame->Count, RenderGraphUsage_TransferSrc);
+    RenderGraphUse(graph, pass, frame->Readback, RenderGraphUsage_TransferDst);
+    return true;
+}
+
+uint32_t CullingGetVisibleCount(Culling* culling, uint32_t frameSlot) {
+    if (culling->Recorder) {
+        return culling->Frames[frameSlot].VisibleCount;
+    }
+    DeviceAllocation* readback = culling->Frames[frameSlot].ReadbackAllocation;
+    VkCheck(DeviceAllocatorInvalidate(culling->DeviceAllocator, readback, 0, sizeof(uint32_t)));
+    return *cast(const uint32_t*) readback->Mapped;
+}
+
+void CullingExtractPlanes(const float viewProjection[16], float planes[6][4]) {
+    // Row i of the matrix is viewProjection[i], viewProjection[4 + i] and so on
+    for (uint32_t i = 0; i < 4; i++) {
+        float row0 = viewProjection[i * 4 + 0];
+        float row1 = viewProjection[i * 4 + 1];
+        float row2 = viewProjection[i * 4 + 2];
+        float row3 = viewProjection[i * 4 + 3];
+        planes[0][i] = row3 + row0;
+        planes[1][i] = row3 - row0;
+        planes[2][i] = row3 + row1;
+        planes[3][i] = row3 - row1;
+        planes[4][i] = row2;
+        planes[5][i] = row3 - row2;
+    }
+    for (uint32_t i = 0; i < 6; i++) {
+        float length = sqrtf(planes[i][0] * planes[i][0] + planes[i][1] * planes[i][1] + planes[i][2] * planes[i][2]);
+        if (length > 0.0f) {
+            for (uint32_t j = 0; j < 4; j++) {
+                planes[i][j] /= length;
+            }
+        }
+    }
+}
+
+bool CullingIsVisible(const float planes[6][4], const CullingObject* object) {
+    for (uint32_t i = 0; i < 6; i++) {
+        float distance = planes[i][0] * object->Sphere[0] + planes[i][1] * object->Sphere[1] + planes[i][2] * object->Sphere[2] +
+                         planes[i][3];
+        if (distance < -object->Sphere[3]) {
+            return false;
+        }
+    }
+    return true;
+}
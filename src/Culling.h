@@ -0,0 +1,142 @@
+#pragma once
+
+#include "Common.h"
+#include "Bindless.h"
+#include "CommandRecorder.h"
+#include "DeviceAllocator.h"
+#include "PipelineManager.h"
+#include "Profiler.h"
+#include "RenderGraph.h"
+#include "Uploader.h"
+
+// Workgroup size of the cull shader
+#define CullingGroupSize 64
+
+// Matches the std430 layout the shaders read, objects index into the shared index buffer which for now only holds
+// CullingQuadIndexCount indices of one quad spanning the sphere's bounds
+typedef struct CullingObject {
+    // Center in xyz, radius in w
+    float Sphere[4];
+    float Color[4];
+    uint32_t IndexCount;
+    uint32_t FirstIndex;
+    int32_t VertexOffset;
+    uint32_t Padding;
+} CullingObject;
+
+#define CullingQuadIndexCount 6
+
+typedef struct CullingFrame {
+    VkBuffer DrawBuffer;
+    DeviceAllocation* DrawAllocation;
+    uint32_t DrawIndex;
+    VkBuffer CountBuffer;
+    DeviceAllocation* CountAllocation;
+    uint32_t CountIndex;
+    // Host visible copy of the count, so the CPU can check what the GPU kept
+    VkBuffer ReadbackBuffer;
+    DeviceAllocation* ReadbackAllocation;
+
+    // What the frame's passes were added with, the callbacks read it while the graph executes
+    VkPipeline CullPipeline;
+    VkPipeline DrawPipeline;
+    float ViewProjection[16];
+    float Planes[6][4];
+    VkExtent2D Extent;
+    RenderGraphResource Target;
+    RenderGraphResource Draws;
+    RenderGraphResource Count;
+    RenderGraphResource Readback;
+    // What the workers kept when culling on the CPU
+    uint32_t VisibleCount;
+} CullingFrame;
+
+// GPU-driven drawing of a static set of objects. Every frame a compute pass on the graphics queue tests each
+// object's bounding sphere against the frustum and appends a draw command for every visible one, then a single
+// vkCmdDrawIndexedIndirectCount draws them all with the count the shader left behind, so the CPU cost no longer
+// grows with the number of objects. Without drawIndirectCount every object keeps its own draw, culled ones with no
+// instances, and one vkCmdDrawIndexedIndirect covers all of them. Objects, draws and the count all live in the
+// bindless storage buffer array. Draws render straight into the target with dynamic rendering, without depth testing.
+// Given a command recorder, objects are culled on the CPU instead, the recorder's workers each test a range of them
+// and record a draw per visible one into a secondary command buffer, which is what the GPU path is measured against.
+typedef struct Culling {
+    VkDevice Device;
+    const VkAllocationCallbacks* Allocator;
+    DeviceAllocator* DeviceAllocator;
+    PipelineManager* PipelineManager;
+    Bindless* Bindless;
+    Profiler* Profiler;
+    uint32_t CullPhase;
+    uint32_t DrawPhase;
+    PFN_vkCmdBeginRenderingKHR CmdBeginRendering;
+    PFN_vkCmdEndRenderingKHR CmdEndRendering;
+    bool DrawIndirectCount;
+    VkFormat ColorFormat;
+    // Only set when culling on the CPU, which tests its own copy of the objects
+    CommandRecorder* Recorder;
+    CullingObject* Objects;
+    // Guards the frames' visible counts against the workers
+    SystemMutex Mutex;
+
+    // Pipeline manager indices
+    uint32_t CullPipeline;
+    uint32_t DrawPipeline;
+
+    uint32_t ObjectCount;
+    VkBuffer ObjectBuffer;
+    DeviceAllocation* ObjectAllocation;
+    uint32_t ObjectIndex;
+    VkBuffer IndexBuffer;
+    DeviceAllocation* IndexAllocation;
+    // Handles the last rebind replaced, and the graphics timeline value after which nothing uses them
+    VkBuffer RetiredBuffers[2];
+    uint32_t RetiredBufferCount;
+    uint64_t RetiredValue;
+
+    uint32_t FramesInFlight;
+    // The slot CullingAddPasses was last called for, which the pass callbacks record
+    uint32_t CurrentSlot;
+    CullingFrame Frames[MaxFramesInFlight];
+} Culling;
+
+// The device needs VK_KHR_dynamic_rendering, multiDrawIndirect and drawIndirectFirstInstance, drawIndirectCount
+// only if it's passed as true. recorder culls on the CPU when not NULL, it needs at least one worker. The objects are
+// uploaded right away and are ready once the uploader's next acquire.
+Culling* CullingCreate(VkDevice device,
+                       PipelineManager* pipelineManager,
+                       DeviceAllocator* deviceAllocator,
+                       Uploader* uploader,
+                       Bindless* bindless,
+                       Profiler* profiler,
+                       VkFormat colorFormat,
+                       bool drawIndirectCount,
+                       CommandRecorder* recorder,
+                       const CullingObject* objects,
+                       uint32_t objectCount,
+                       uint32_t framesInFlight,
+                       const VkAllocationCallbacks* allocator);
+// The device must be idle
+void CullingDestroy(Culling* culling);
+
+// The objects and indices are movable, this recreates whichever of them the last DeviceAllocatorDefragment moved.
+// Call it once after every defragmentation that moved anything, before adding the passes.
+void CullingRebind(Culling* culling);
+
+// Adds the passes that reset the count, cull, draw into target and copy the count back, or only the draw when culling
+// on the CPU, in which case the recorder's frame must have begun. target has to be a color attachment of the format
+// the pipeline was created for. Adds nothing and returns false while the pipeline manager is still building the
+// pipelines.
+bool CullingAddPasses(Culling* culling,
+                      RenderGraph* graph,
+                      uint32_t frameSlot,
+                      RenderGraphResource target,
+                      VkExtent2D extent,
+                      const float viewProjection[16]);
+// How many objects the slot's last frame drew, valid once that frame has finished
+uint32_t CullingGetVisibleCount(Culling* culling, uint32_t frameSlot);
+
+// Normalized left, right, bottom, top, near and far planes of a column major view projection with 0 to 1 depth,
+// pointing inwards
+void CullingExtractPlanes(const float viewProjection[16], float planes[6][4]);
+// The test the cull shader does
+bool CullingIsVisible(const float planes[6][4], const CullingObject* object);
@@ -0,0 +1,26 @@
+#include "DebugUtils.h"
+
+#include <stdarg.h>
+
+static PFN_vkSetDebugUtilsObjectNameEXT DebugUtilsSetObjectNameFunction = NULL;
+
+void DebugUtilsInit(VkInstance instance) {
+    DebugUtilsSetObjectNameFunction =
+        cast(PFN_vkSetDebugUtilsObjectNameEXT) vkGetInstanceProcAddr(instance, "vkSetDebugUtilsObjectNameEXT");
+    assert(DebugUtilsSetObjectNameFunction);
+}
+
+void DebugUtilsSetObjectName(VkDevice device, VkObjectType type, uint64_t handle, const char* format, ...) {
+    char name[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(name, sizeof(name), format, args);
+    va_end(args);
+    VkCheck(DebugUtilsSetObjectNameFunction(device,
+                                            &(VkDebugUtilsObjectNameInfoEXT){
+                                                .sType        = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT,
+                                                .objectType   = type,
+                                                .objectHandle = handle,
+                                                .pObjectName  = name,
+                                            }));
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "Common.h"
+
+// Names show up in validation messages and in capture tools. Only debug builds enable the debug utils extension,
+// release builds compile the calls away together with their arguments.
+#if defined(VULKAN_DEBUG)
+void DebugUtilsInit(VkInstance instance);
+// The name is printf formatted
+void DebugUtilsSetObjectName(VkDevice device, VkObjectType type, uint64_t handle, const char* format, ...);
+#else
+    #define DebugUtilsInit(instance)                           ((void)0)
+    #define DebugUtilsSetObjectName(device, type, handle, ...) ((void)0)
+#endif
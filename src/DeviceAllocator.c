@@ -0,0 +1,771 @@
+#include "DeviceAllocator.h"
+
+static VkDeviceSize DeviceAllocatorAlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static uint32_t DeviceAllocatorNodeLevel(uint32_t node) {
+    return 31 - cast(uint32_t) __builtin_clz(node);
+}
+
+static VkDeviceSize DeviceAllocatorNodeSize(const DeviceMemoryBlock* block, uint32_t node) {
+    return block->Size >> DeviceAllocatorNodeLevel(node);
+}
+
+static VkDeviceSize DeviceAllocatorNodeOffset(const DeviceMemoryBlock* block, uint32_t node) {
+    uint32_t level = DeviceAllocatorNodeLevel(node);
+    return cast(VkDeviceSize)(node - (1u << level)) * (block->Size >> level);
+}
+
+static void DeviceAllocatorPushFree(DeviceMemoryBlock* block, uint32_t level, uint32_t node) {
+    DeviceMemoryNode* nodes = block->Nodes;
+    nodes[node].State       = DeviceMemoryNodeState_Free;
+    nodes[node].Prev        = 0;
+    nodes[node].Next        = block->FreeLists[level];
+    if (block->FreeLists[level] != 0) {
+        nodes[block->FreeLists[level]].Prev = node;
+    }
+    block->FreeLists[level] = node;
+}
+
+static void DeviceAllocatorRemoveFree(DeviceMemoryBlock* block, uint32_t level, uint32_t node) {
+    DeviceMemoryNode* nodes = block->Nodes;
+    if (nodes[node].Prev != 0) {
+        nodes[nodes[node].Prev].Next = nodes[node].Next;
+    } else {
+        block->FreeLists[level] = nodes[node].Next;
+    }
+    if (nodes[node].Next != 0) {
+        nodes[nodes[node].Next].Prev = nodes[node].Prev;
+    }
+    nodes[node].State = DeviceMemoryNodeState_Unused;
+}
+
+// Returns 0 if the block has no free range at the given level
+static uint32_t DeviceAllocatorBuddyAllocate(DeviceMemoryBlock* block, uint32_t level) {
+    uint32_t freeLevel = level + 1;
+    while (freeLevel-- > 0) {
+        if (block->FreeLists[freeLevel] != 0) {
+            break;
+        }
+    }
+    if (freeLevel > level) {
+        return 0;
+    }
+
+    uint32_t node = block->FreeLists[freeLevel];
+    DeviceAllocatorRemoveFree(block, freeLevel, node);
+    for (; freeLevel < level; freeLevel++) {
+        block->Nodes[node].State = DeviceMemoryNodeState_Split;
+        DeviceAllocatorPushFree(block, freeLevel + 1, node * 2 + 1);
+        node = node * 2;
+    }
+    block->Nodes[node].State = DeviceMemoryNodeState_Allocated;
+    block->UsedBytes += DeviceAllocatorNodeSize(block, node);
+    return node;
+}
+
+static void DeviceAllocatorBuddyFree(DeviceMemoryBlock* block, uint32_t node) {
+    assert(block->Nodes[node].State == DeviceMemoryNodeState_Allocated);
+    block->UsedBytes -= DeviceAllocatorNodeSize(block, node);
+    uint32_t level = DeviceAllocatorNodeLevel(node);
+    while (level > 0 && block->Nodes[node ^ 1].State == DeviceMemoryNodeState_Free) {
+        DeviceAllocatorRemoveFree(block, level, node ^ 1);
+        block->Nodes[node].State = DeviceMemoryNodeState_Unused;
+        node >>= 1;
+        level--;
+    }
+    DeviceAllocatorPushFree(block, level, node);
+}
+
+static VkResult DeviceAllocatorCreateBlock(DeviceAllocator* deviceAllocator,
+                                           uint32_t memoryTypeIndex,
+                                           VkDeviceSize size,
+                                           bool dedicated,
+                                           DeviceMemoryBlock** createdBlock) {
+    if (deviceAllocator->MemoryAllocationCount >= deviceAllocator->MaxMemoryAllocationCount) {
+        return VK_ERROR_TOO_MANY_OBJECTS;
+    }
+
+    DeviceMemoryBlock* block = calloc(1, sizeof(DeviceMemoryBlock));
+    if (block == NULL) {
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+    block->Size            = size;
+    block->MemoryTypeIndex = memoryTypeIndex;
+    block->Dedicated       = dedicated;
+
+    VkResult result = vkAllocateMemory(deviceAllocator->Device,
+                                       &(VkMemoryAllocateInfo){
+                                           .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+                                           .allocationSize  = size,
+                                           .memoryTypeIndex = memoryTypeIndex,
+                                       },
+                                       deviceAllocator->Allocator,
+                                       &block->Memory);
+    if (result != VK_SUCCESS) {
+        free(block);
+        return result;
+    }
+    deviceAllocator->MemoryAllocationCount++;
+    deviceAllocator->MemoryBytes += size;
+    if (deviceAllocator->MemoryBytes > deviceAllocator->PeakMemoryBytes) {
+        deviceAllocator->PeakMemoryBytes = deviceAllocator->MemoryBytes;
+    }
+
+    VkMemoryPropertyFlags propertyFlags = deviceAllocator->MemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+    if (propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        result = vkMapMemory(deviceAllocator->Device, block->Memory, 0, VK_WHOLE_SIZE, 0, cast(void**) &block->Mapped);
+        if (result != VK_SUCCESS) {
+            vkFreeMemory(deviceAllocator->Device, block->Memory, deviceAllocator->Allocator);
+            deviceAllocator->MemoryAllocationCount--;
+            deviceAllocator->MemoryBytes -= size;
+            free(block);
+            return result;
+        }
+    }
+
+    if (!dedicated) {
+        block->LevelCount = 1;
+        while ((size >> block->LevelCount) >= DeviceAllocatorMinAllocationSize && block->LevelCount < DeviceAllocatorMaxLevels) {
+            block->LevelCount++;
+        }
+        block->Nodes = calloc(cast(size_t) 1 << block->LevelCount, sizeof(DeviceMemoryNode));
+        if (block->Nodes == NULL) {
+            vkFreeMemory(deviceAllocator->Device, block->Memory, deviceAllocator->Allocator);
+            deviceAllocator->MemoryAllocationCount--;
+            deviceAllocator->MemoryBytes -= size;
+            free(block);
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+        DeviceAllocatorPushFree(block, 0, 1);
+
+        // Not every memory type can back a transfer buffer, blocks that can't simply never take part in defragmentation
+        VkBuffer copyBuffer = VK_NULL_HANDLE;
+        if (vkCreateBuffer(deviceAllocator->Device,
+                           &(VkBufferCreateInfo){
+                               .sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+                               .size        = size,
+                               .usage       = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                               .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                           },
+                           deviceAllocator->Allocator,
+                           &copyBuffer) == VK_SUCCESS) {
+            VkMemoryRequirements requirements = {};
+            vkGetBufferMemoryRequirements(deviceAllocator->Device, copyBuffer, &requirements);
+            if ((requirements.memoryTypeBits & (1u << memoryTypeIndex)) && requirements.size <= size &&
+                vkBindBufferMemory(deviceAllocator->Device, copyBuffer, block->Memory, 0) == VK_SUCCESS) {
+                block->CopyBuffer = copyBuffer;
+            } else {
+                vkDestroyBuffer(deviceAllocator->Device, copyBuffer, deviceAllocator->Allocator);
+            }
+        }
+    }
+
+    block->Next                              = deviceAllocator->Blocks[memoryTypeIndex];
+    deviceAllocator->Blocks[memoryTypeIndex] = block;
+    *createdBlock                            = block;
+    return VK_SUCCESS;
+}
+
+static void DeviceAllocatorDestroyBlock(DeviceAllocator* deviceAllocator, DeviceMemoryBlock* block) {
+    DeviceMemoryBlock** link = &deviceAllocator->Blocks[block->MemoryTypeIndex];
+    while (*link != block) {
+        link = &(*link)->Next;
+    }
+    *link = block->Next;
+
+    if (block->CopyBuffer != VK_NULL_HANDLE) {
+        vkDestroyBuffer(deviceAllocator->Device, block->CopyBuffer, deviceAllocator->Allocator);
+    }
+    // Freeing memory implicitly unmaps it
+    vkFreeMemory(deviceAllocator->Device, block->Memory, deviceAllocator->Allocator);
+    deviceAllocator->MemoryAllocationCount--;
+    deviceAllocator->MemoryBytes -= block->Size;
+    free(block->Nodes);
+    free(block);
+}
+
+// Empty blocks are returned to the driver, except for the last block of a memory type so that
+// allocating and freeing a single resource every frame doesn't hit vkAllocateMemory every time
+static void DeviceAllocatorReleaseIfEmpty(DeviceAllocator* deviceAllocator, DeviceMemoryBlock* block) {
+    if (block->UsedBytes != 0) {
+        return;
+    }
+    uint32_t heapIndex = deviceAllocator->MemoryProperties.memoryTypes[block->MemoryTypeIndex].heapIndex;
+    if (!block->Dedicated && !deviceAllocator->Pressured[heapIndex]) {
+        uint32_t sharedBlockCount = 0;
+        for (DeviceMemoryBlock* other = deviceAllocator->Blocks[block->MemoryTypeIndex]; other != NULL; other = other->Next) {
+            sharedBlockCount += !other->Dedicated;
+        }
+        if (sharedBlockCount <= 1) {
+            return;
+        }
+    }
+    DeviceAllocatorDestroyBlock(deviceAllocator, block);
+}
+
+// Returns whether any memory was given back
+static bool DeviceAllocatorReleaseEmptyBlocks(DeviceAllocator* deviceAllocator, uint32_t heapIndex) {
+    bool released = false;
+    for (uint32_t i = 0; i < deviceAllocator->MemoryProperties.memoryTypeCount; i++) {
+        if (deviceAllocator->MemoryProperties.memoryTypes[i].heapIndex != heapIndex) {
+            continue;
+        }
+        DeviceMemoryBlock* block = deviceAllocator->Blocks[i];
+        while (block != NULL) {
+            DeviceMemoryBlock* next = block->Next;
+            if (block->UsedBytes == 0) {
+                DeviceAllocatorDestroyBlock(deviceAllocator, block);
+                released = true;
+            }
+            block = next;
+        }
+    }
+    return released;
+}
+
+// Another memory type of the heap may be sitting on an empty block the driver can hand out again
+static VkResult DeviceAllocatorCreateBlockOrRecover(DeviceAllocator* deviceAllocator,
+                                                    uint32_t memoryTypeIndex,
+                                                    VkDeviceSize size,
+                                                    bool dedicated,
+                                                    DeviceMemoryBlock** createdBlock) {
+    uint32_t heapIndex = deviceAllocator->MemoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+    VkResult result    = DeviceAllocatorCreateBlock(deviceAllocator, memoryTypeIndex, size, dedicated, createdBlock);
+    if (result == VK_ERROR_OUT_OF_DEVICE_MEMORY && DeviceAllocatorReleaseEmptyBlocks(deviceAllocator, heapIndex)) {
+        result = DeviceAllocatorCreateBlock(deviceAllocator, memoryTypeIndex, size, dedicated, createdBlock);
+        deviceAllocator->OutOfMemoryRecoveries += result == VK_SUCCESS ? 1 : 0;
+    }
+    return result;
+}
+
+static void DeviceAllocatorLink(DeviceAllocation* allocation, DeviceMemoryBlock* block, uint32_t node) {
+    allocation->Block  = block;
+    allocation->Node   = node;
+    allocation->Memory = block->Memory;
+    allocation->Offset = block->Dedicated ? 0 : DeviceAllocatorNodeOffset(block, node);
+    allocation->Mapped = block->Mapped ? block->Mapped + allocation->Offset : NULL;
+    allocation->Prev   = NULL;
+    allocation->Next   = block->Allocations;
+    if (block->Allocations != NULL) {
+        block->Allocations->Prev = allocation;
+    }
+    block->Allocations = allocation;
+    block->AllocationCount++;
+}
+
+static void DeviceAllocatorUnlink(DeviceAllocation* allocation) {
+    DeviceMemoryBlock* block = allocation->Block;
+    if (allocation->Prev != NULL) {
+        allocation->Prev->Next = allocation->Next;
+    } else {
+        block->Allocations = allocation->Next;
+    }
+    if (allocation->Next != NULL) {
+        allocation->Next->Prev = allocation->Prev;
+    }
+    block->AllocationCount--;
+}
+
+static VkResult DeviceAllocatorAllocateFromType(DeviceAllocator* deviceAllocator,
+                                                uint32_t memoryTypeIndex,
+                                                VkDeviceSize size,
+                                                DeviceAllocation* allocation) {
+    uint32_t heapIndex     = deviceAllocator->MemoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+    VkDeviceSize blockSize = deviceAllocator->BlockSizes[heapIndex];
+
+    if (size > blockSize / 2) {
+        DeviceMemoryBlock* block = NULL;
+        VkResult result          = DeviceAllocatorCreateBlockOrRecover(deviceAllocator, memoryTypeIndex, size, true, &block);
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+        block->UsedBytes = size;
+        DeviceAllocatorLink(allocation, block, 0);
+        return VK_SUCCESS;
+    }
+
+    uint32_t level = 0;
+    while ((blockSize >> (level + 1)) >= size && (blockSize >> (level + 1)) >= DeviceAllocatorMinAllocationSize) {
+        level++;
+    }
+
+    for (DeviceMemoryBlock* block = deviceAllocator->Blocks[memoryTypeIndex]; block != NULL; block = block->Next) {
+        if (block->Dedicated) {
+            continue;
+        }
+        uint32_t node = DeviceAllocatorBuddyAllocate(block, level);
+        if (node != 0) {
+            DeviceAllocatorLink(allocation, block, node);
+            return VK_SUCCESS;
+        }
+    }
+
+    DeviceMemoryBlock* block = NULL;
+    VkResult result          = DeviceAllocatorCreateBlockOrRecover(deviceAllocator, memoryTypeIndex, blockSize, false, &block);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+    uint32_t node = DeviceAllocatorBuddyAllocate(block, level);
+    assert(node != 0);
+    DeviceAllocatorLink(allocation, block, node);
+    return VK_SUCCESS;
+}
+
+DeviceAllocator* DeviceAllocatorCreate(VkDevice device, VkPhysicalDevice physicalDevice, const VkAllocationCallbacks* allocator) {
+    DeviceAllocator* deviceAllocator = calloc(1, sizeof(DeviceAllocator));
+    if (deviceAllocator == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate the device allocator!\n");
+        exit(1);
+    }
+    deviceAllocator->Device    = device;
+    deviceAllocator->Allocator = allocator;
+    SystemMutexInit(&deviceAllocator->Mutex);
+
+    VkPhysicalDeviceProperties properties = {};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    deviceAllocator->BufferImageGranularity   = properties.limits.bufferImageGranularity;
+    deviceAllocator->NonCoherentAtomSize      = properties.limits.nonCoherentAtomSize;
+    deviceAllocator->MaxMemoryAllocationCount = properties.limits.maxMemoryAllocationCount;
+
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &deviceAllocator->MemoryProperties);
+    for (uint32_t i = 0; i < deviceAllocator->MemoryProperties.memoryHeapCount; i++) {
+        // Small heaps, like the 256MB device local and host visible one on some discrete GPUs, get smaller blocks
+        VkDeviceSize blockSize = DeviceAllocatorBlockSize;
+        while (blockSize > DeviceAllocatorMinAllocationSize * 256 && blockSize > deviceAllocator->MemoryProperties.memoryHeaps[i].size / 8) {
+            blockSize >>= 1;
+        }
+        deviceAllocator->BlockSizes[i] = blockSize;
+    }
+
+    return deviceAllocator;
+}
+
+void DeviceAllocatorDestroy(DeviceAllocator* deviceAllocator) {
+    for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; i++) {
+        while (deviceAllocator->Blocks[i] != NULL) {
+            if (deviceAllocator->Blocks[i]->AllocationCount > 0) {
+                fflush(stdout);
+                fprintf(stderr,
+                        "Device allocator destroyed with %u allocations still alive in memory type %u!\n",
+                        deviceAllocator->Blocks[i]->AllocationCount,
+                        i);
+            }
+            DeviceAllocatorDestroyBlock(deviceAllocator, deviceAllocator->Blocks[i]);
+        }
+    }
+    while (deviceAllocator->DeferredFrees != NULL) {
+        DeviceAllocation* allocation   = deviceAllocator->DeferredFrees;
+        deviceAllocator->DeferredFrees = allocation->Next;
+        free(allocation);
+    }
+    SystemMutexDestroy(&deviceAllocator->Mutex);
+    free(deviceAllocator);
+}
+
+VkResult DeviceAllocatorAllocate(DeviceAllocator* deviceAllocator,
+                                 const VkMemoryRequirements* requirements,
+                                 VkMemoryPropertyFlags requiredFlags,
+                                 VkMemoryPropertyFlags preferredFlags,
+                                 DeviceAllocationKind kind,
+                                 DeviceAllocation** allocation) {
+    *allocation = NULL;
+
+    // Buddy ranges are aligned to their own size, so asking for at least the alignment is enough
+    VkDeviceSize size = requirements->size > requirements->alignment ? requirements->size : requirements->alignment;
+    if (kind == DeviceAllocationKind_Optimal && deviceAllocator->BufferImageGranularity > 1) {
+        size = DeviceAllocatorAlignUp(size, deviceAllocator->BufferImageGranularity);
+    }
+
+    DeviceAllocation* result = calloc(1, sizeof(DeviceAllocation));
+    if (result == NULL) {
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+    result->Size = requirements->size;
+    result->Kind = kind;
+
+    SystemMutexLock(&deviceAllocator->Mutex);
+    VkResult allocateResult = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    bool triedType[VK_MAX_MEMORY_TYPES] = {};
+    for (uint32_t pass = 0; pass < 2 && allocateResult != VK_SUCCESS; pass++) {
+        VkMemoryPropertyFlags flags = pass == 0 ? requiredFlags | preferredFlags : requiredFlags;
+        for (uint32_t i = 0; i < deviceAllocator->MemoryProperties.memoryTypeCount; i++) {
+            if (!(requirements->memoryTypeBits & (1u << i)) || triedType[i] ||
+                (deviceAllocator->MemoryProperties.memoryTypes[i].propertyFlags & flags) != flags) {
+                continue;
+            }
+            triedType[i]   = true;
+            allocateResult = DeviceAllocatorAllocateFromType(deviceAllocator, i, size, result);
+            if (allocateResult == VK_SUCCESS) {
+                result->MemoryTypeIndex = i;
+                break;
+            }
+        }
+    }
+    SystemMutexUnlock(&deviceAllocator->Mutex);
+
+    if (allocateResult != VK_SUCCESS) {
+        free(result);
+        return allocateResult;
+    }
+    *allocation = result;
+    return VK_SUCCESS;
+}
+
+void DeviceAllocatorFree(DeviceAllocator* deviceAllocator, DeviceAllocation* allocation) {
+    if (allocation == NULL) {
+        return;
+    }
+    SystemMutexLock(&deviceAllocator->Mutex);
+    DeviceMemoryBlock* block = allocation->Block;
+    DeviceAllocatorUnlink(allocation);
+    if (allocation->Moved) {
+        // The copy may still be reading the old range and writing the new one, both stay reserved until the
+        // defragmentation ends
+        allocation->Prev               = NULL;
+        allocation->Next               = deviceAllocator->DeferredFrees;
+        deviceAllocator->DeferredFrees = allocation;
+        SystemMutexUnlock(&deviceAllocator->Mutex);
+        return;
+    }
+    if (block->Dedicated) {
+        block->UsedBytes = 0;
+    } else {
+        DeviceAllocatorBuddyFree(block, allocation->Node);
+    }
+    DeviceAllocatorReleaseIfEmpty(deviceAllocator, block);
+    SystemMutexUnlock(&deviceAllocator->Mutex);
+    free(allocation);
+}
+
+VkResult DeviceAllocatorCreateBuffer(DeviceAllocator* deviceAllocator,
+                                     const VkBufferCreateInfo* createInfo,
+                                     VkMemoryPropertyFlags requiredFlags,
+                                     VkMemoryPropertyFlags preferredFlags,
+                                     VkBuffer* buffer,
+                                     DeviceAllocation** allocation) {
+    *buffer     = VK_NULL_HANDLE;
+    *allocation = NULL;
+
+    VkBuffer result       = VK_NULL_HANDLE;
+    VkResult createResult = vkCreateBuffer(deviceAllocator->Device, createInfo, deviceAllocator->Allocator, &result);
+    if (createResult != VK_SUCCESS) {
+        return createResult;
+    }
+
+    VkMemoryRequirements requirements = {};
+    vkGetBufferMemoryRequirements(deviceAllocator->Device, result, &requirements);
+    DeviceAllocation* resultAllocation = NULL;
+    createResult =
+        DeviceAllocatorAllocate(deviceAllocator, &requirements, requiredFlags, preferredFlags, DeviceAllocationKind_Linear, &resultAllocation);
+    if (createResult == VK_SUCCESS) {
+        createResult = vkBindBufferMemory(deviceAllocator->Device, result, resultAllocation->Memory, resultAllocation->Offset);
+    }
+    if (createResult != VK_SUCCESS) {
+        DeviceAllocatorFree(deviceAllocator, resultAllocation);
+        vkDestroyBuffer(deviceAllocator->Device, result, deviceAllocator->Allocator);
+        return createResult;
+    }
+
+    *buffer     = result;
+    *allocation = resultAllocation;
+    return VK_SUCCESS;
+}
+
+VkResult DeviceAllocatorCreateImage(DeviceAllocator* deviceAllocator,
+                                    const VkImageCreateInfo* createInfo,
+                                    VkMemoryPropertyFlags requiredFlags,
+                                    VkMemoryPropertyFlags preferredFlags,
+                                    VkImage* image,
+                                    DeviceAllocation** allocation) {
+    *image      = VK_NULL_HANDLE;
+    *allocation = NULL;
+
+    VkImage result        = VK_NULL_HANDLE;
+    VkResult createResult = vkCreateImage(deviceAllocator->Device, createInfo, deviceAllocator->Allocator, &result);
+    if (createResult != VK_SUCCESS) {
+        return createResult;
+    }
+
+    VkMemoryRequirements requirements = {};
+    vkGetImageMemoryRequirements(deviceAllocator->Device, result, &requirements);
+    DeviceAllocationKind kind = createInfo->tiling == VK_IMAGE_TILING_LINEAR ? DeviceAllocationKind_Linear : DeviceAllocationKind_Optimal;
+    DeviceAllocation* resultAllocation = NULL;
+    createResult = DeviceAllocatorAllocate(deviceAllocator, &requirements, requiredFlags, preferredFlags, kind, &resultAllocation);
+    if (createResult == VK_SUCCESS) {
+        // Images can't be moved by a buffer copy, their contents are undefined once bound somewhere else
+        resultAllocation->Kind = DeviceAllocationKind_Optimal;
+        createResult = vkBindImageMemory(deviceAllocator->Device, result, resultAllocation->Memory, resultAllocation->Offset);
+    }
+    if (createResult != VK_SUCCESS) {
+        DeviceAllocatorFree(deviceAllocator, resultAllocation);
+        vkDestroyImage(deviceAllocator->Device, result, deviceAllocator->Allocator);
+        return createResult;
+    }
+
+    *image      = result;
+    *allocation = resultAllocation;
+    return VK_SUCCESS;
+}
+
+static VkMappedMemoryRange DeviceAllocatorGetRange(DeviceAllocator* deviceAllocator,
+                                                   DeviceAllocation* allocation,
+                                                   VkDeviceSize offset,
+                                                   VkDeviceSize size) {
+    if (size == VK_WHOLE_SIZE) {
+        size = allocation->Size - offset;
+    }
+    VkDeviceSize atomSize = deviceAllocator->NonCoherentAtomSize;
+    VkDeviceSize begin    = (allocation->Offset + offset) / atomSize * atomSize;
+    VkDeviceSize end      = DeviceAllocatorAlignUp(allocation->Offset + offset + size, atomSize);
+    if (end > allocation->Block->Size) {
+        end = allocation->Block->Size;
+    }
+    return (VkMappedMemoryRange){
+        .sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+        .memory = allocation->Memory,
+        .offset = begin,
+        .size   = end - begin,
+    };
+}
+
+VkResult DeviceAllocatorFlush(DeviceAllocator* deviceAllocator, DeviceAllocation* allocation, VkDeviceSize offset, VkDeviceSize size) {
+    if (deviceAllocator->MemoryProperties.memoryTypes[allocation->MemoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) {
+        return VK_SUCCESS;
+    }
+    VkMappedMemoryRange range = DeviceAllocatorGetRange(deviceAllocator, allocation, offset, size);
+    return vkFlushMappedMemoryRanges(deviceAllocator->Device, 1, &range);
+}
+
+VkResult DeviceAllocatorInvalidate(DeviceAllocator* deviceAllocator, DeviceAllocation* allocation, VkDeviceSize offset, VkDeviceSize size) {
+    if (deviceAllocator->MemoryProperties.memoryTypes[allocation->MemoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) {
+        return VK_SUCCESS;
+    }
+    VkMappedMemoryRange range = DeviceAllocatorGetRange(deviceAllocator, allocation, offset, size);
+    return vkInvalidateMappedMemoryRanges(deviceAllocator->Device, 1, &range);
+}
+
+void DeviceAllocatorSetMovable(DeviceAllocator* deviceAllocator, DeviceAllocation* allocation) {
+    SystemMutexLock(&deviceAllocator->Mutex);
+    assert(allocation->Kind == DeviceAllocationKind_Linear);
+    allocation->Kind = DeviceAllocationKind_Movable;
+    SystemMutexUnlock(&deviceAllocator->Mutex);
+}
+
+VkResult DeviceAllocatorRebindBuffer(DeviceAllocator* deviceAllocator,
+                                     const VkBufferCreateInfo* createInfo,
+                                     const DeviceAllocation* allocation,
+                                     VkBuffer* buffer) {
+    *buffer = VK_NULL_HANDLE;
+
+    VkBuffer result       = VK_NULL_HANDLE;
+    VkResult createResult = vkCreateBuffer(deviceAllocator->Device, createInfo, deviceAllocator->Allocator, &result);
+    if (createResult != VK_SUCCESS) {
+        return createResult;
+    }
+    createResult = vkBindBufferMemory(deviceAllocator->Device, result, allocation->Memory, allocation->Offset);
+    if (createResult != VK_SUCCESS) {
+        vkDestroyBuffer(deviceAllocator->Device, result, deviceAllocator->Allocator);
+        return createResult;
+    }
+    *buffer = result;
+    return VK_SUCCESS;
+}
+
+uint32_t DeviceAllocatorDefragment(DeviceAllocator* deviceAllocator, VkCommandBuffer commandBuffer, VkDeviceSize maxBytesToMove) {
+    SystemMutexLock(&deviceAllocator->Mutex);
+    uint32_t moveCount      = 0;
+    VkDeviceSize movedBytes = 0;
+    bool recordedBarrier    = false;
+    for (uint32_t memoryTypeIndex = 0; memoryTypeIndex < deviceAllocator->MemoryProperties.memoryTypeCount; memoryTypeIndex++) {
+        uint32_t blockCount = 0;
+        for (DeviceMemoryBlock* block = deviceAllocator->Blocks[memoryTypeIndex]; block != NULL; block = block->Next) {
+            blockCount += !block->Dedicated && block->CopyBuffer != VK_NULL_HANDLE;
+        }
+        if (blockCount < 2) {
+            continue;
+        }
+
+        // Fullest blocks first, allocations only ever move towards the front
+        DeviceMemoryBlock* blocks[blockCount];
+        uint32_t sortedCount = 0;
+        for (DeviceMemoryBlock* block = deviceAllocator->Blocks[memoryTypeIndex]; block != NULL; block = block->Next) {
+            if (block->Dedicated || block->CopyBuffer == VK_NULL_HANDLE) {
+                continue;
+            }
+            uint32_t i = sortedCount++;
+            for (; i > 0 && blocks[i - 1]->UsedBytes < block->UsedBytes; i--) {
+                blocks[i] = blocks[i - 1];
+            }
+            blocks[i] = block;
+        }
+
+        for (uint32_t source = blockCount; source-- > 1;) {
+            DeviceAllocation* next = NULL;
+            for (DeviceAllocation* allocation = blocks[source]->Allocations; allocation != NULL; allocation = next) {
+                next = allocation->Next;
+                if (allocation->Kind != DeviceAllocationKind_Movable || allocation->Moved) {
+                    continue;
+                }
+                VkDeviceSize nodeSize = DeviceAllocatorNodeSize(blocks[source], allocation->Node);
+                if (movedBytes + nodeSize > maxBytesToMove) {
+                    continue;
+                }
+
+                uint32_t level = DeviceAllocatorNodeLevel(allocation->Node);
+                for (uint32_t destination = 0; destination < source; destination++) {
+                    uint32_t node = DeviceAllocatorBuddyAllocate(blocks[destination], level);
+                    if (node == 0) {
+                        continue;
+                    }
+
+                    if (!recordedBarrier) {
+                        // Earlier writes to anything that is about to move must land before it is copied
+                        vkCmdPipelineBarrier(commandBuffer,
+                                             VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                             0,
+                                             1,
+                                             &(VkMemoryBarrier){
+                                                 .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                                                 .srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
+                                                 .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+                                             },
+                                             0,
+                                             NULL,
+                                             0,
+                                             NULL);
+                        recordedBarrier = true;
+                    }
+
+                    VkDeviceSize sourceOffset = allocation->Offset;
+                    allocation->PreviousBlock = blocks[source];
+                    allocation->PreviousNode  = allocation->Node;
+                    allocation->Moved         = true;
+                    DeviceAllocatorUnlink(allocation);
+                    DeviceAllocatorLink(allocation, blocks[destination], node);
+                    vkCmdCopyBuffer(commandBuffer,
+                                    blocks[source]->CopyBuffer,
+                                    blocks[destination]->CopyBuffer,
+                                    1,
+                                    &(VkBufferCopy){
+                                        .srcOffset = sourceOffset,
+                                        .dstOffset = allocation->Offset,
+                                        .size      = allocation->Size,
+                                    });
+                    movedBytes += nodeSize;
+                    moveCount++;
+                    break;
+                }
+            }
+        }
+    }
+
+    if (recordedBarrier) {
+        vkCmdPipelineBarrier(commandBuffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                             0,
+                             1,
+                             &(VkMemoryBarrier){
+                                 .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                                 .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                                 .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+                             },
+                             0,
+                             NULL,
+                             0,
+                             NULL);
+        deviceAllocator->DefragmentCount++;
+        deviceAllocator->DefragmentMoves += moveCount;
+        deviceAllocator->DefragmentBytes += movedBytes;
+    }
+    SystemMutexUnlock(&deviceAllocator->Mutex);
+    return moveCount;
+}
+
+void DeviceAllocatorEndDefragment(DeviceAllocator* deviceAllocator) {
+    SystemMutexLock(&deviceAllocator->Mutex);
+    while (deviceAllocator->DeferredFrees != NULL) {
+        DeviceAllocation* allocation   = deviceAllocator->DeferredFrees;
+        deviceAllocator->DeferredFrees = allocation->Next;
+        DeviceAllocatorBuddyFree(allocation->Block, allocation->Node);
+        DeviceAllocatorBuddyFree(allocation->PreviousBlock, allocation->PreviousNode);
+        free(allocation);
+    }
+    for (uint32_t memoryTypeIndex = 0; memoryTypeIndex < deviceAllocator->MemoryProperties.memoryTypeCount; memoryTypeIndex++) {
+        for (DeviceMemoryBlock* block = deviceAllocator->Blocks[memoryTypeIndex]; block != NULL; block = block->Next) {
+            for (DeviceAllocation* allocation = block->Allocations; allocation != NULL; allocation = allocation->Next) {
+                if (allocation->Moved) {
+                    DeviceAllocatorBuddyFree(allocation->PreviousBlock, allocation->PreviousNode);
+                    allocation->Moved         = false;
+                    allocation->PreviousBlock = NULL;
+                    allocation->PreviousNode  = 0;
+                }
+            }
+        }
+
+        DeviceMemoryBlock* next = NULL;
+        for (DeviceMemoryBlock* block = deviceAllocator->Blocks[memoryTypeIndex]; block != NULL; block = next) {
+            next = block->Next;
+            DeviceAllocatorReleaseIfEmpty(deviceAllocator, block);
+        }
+    }
+    SystemMutexUnlock(&deviceAllocator->Mutex);
+}
+
+void DeviceAllocatorSetHeapPressured(DeviceAllocator* deviceAllocator, uint32_t heapIndex, bool pressured) {
+    SystemMutexLock(&deviceAllocator->Mutex);
+    deviceAllocator->Pressured[heapIndex] = pressured;
+    if (pressured) {
+        DeviceAllocatorReleaseEmptyBlocks(deviceAllocator, heapIndex);
+    }
+    SystemMutexUnlock(&deviceAllocator->Mutex);
+}
+
+DeviceHeapStats DeviceAllocatorGetHeapStats(DeviceAllocator* deviceAllocator, uint32_t heapIndex) {
+    DeviceHeapStats stats = {
+        .HeapSize = deviceAllocator->MemoryProperties.memoryHeaps[heapIndex].size,
+    };
+    SystemMutexLock(&deviceAllocator->Mutex);
+    for (uint32_t i = 0; i < deviceAllocator->MemoryProperties.memoryTypeCount; i++) {
+        if (deviceAllocator->MemoryProperties.memoryTypes[i].heapIndex != heapIndex) {
+            continue;
+        }
+        for (DeviceMemoryBlock* block = deviceAllocator->Blocks[i]; block != NULL; block = block->Next) {
+            stats.BlockCount++;
+            stats.BlockBytes += block->Size;
+            stats.UsedBytes += block->UsedBytes;
+            stats.AllocationCount += block->AllocationCount;
+        }
+    }
+    SystemMutexUnlock(&deviceAllocator->Mutex);
+    return stats;
+}
+
+void DeviceAllocatorPrintStats(DeviceAllocator* deviceAllocator) {
+    printf("%-6s %-12s %12s %8s %12s %12s %12s\n", "Heap", "Flags", "Size(MB)", "Blocks", "Blocks(MB)", "Used(MB)", "Allocations");
+    for (uint32_t i = 0; i < deviceAllocator->MemoryProperties.memoryHeapCount; i++) {
+        DeviceHeapStats stats = DeviceAllocatorGetHeapStats(deviceAllocator, i);
+        printf("%-6u %-12s %12.1f %8u %12.1f %12.1f %12u\n",
+               i,
+               (deviceAllocator->MemoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? "DeviceLocal" : "Host",
+               cast(double) stats.HeapSize / (1024.0 * 1024.0),
+               stats.BlockCount,
+               cast(double) stats.BlockBytes / (1024.0 * 1024.0),
+               cast(double) stats.UsedBytes / (1024.0 * 1024.0),
+               stats.AllocationCount);
+    }
+    if (deviceAllocator->OutOfMemoryRecoveries > 0) {
+        printf("Recovered from running out of device memory %llu times by releasing empty blocks!\n",
+               cast(unsigned long long) deviceAllocator->OutOfMemoryRecoveries);
+    }
+    if (deviceAllocator->DefragmentCount > 0) {
+        printf("Defragmentation moved %llu allocations, %.1fMB in total, over %llu passes!\n",
+               cast(unsigned long long) deviceAllocator->DefragmentMoves,
+               cast(double) deviceAllocator->DefragmentBytes / (1024.0 * 1024.0),
+               cast(unsigned long long) deviceAllocator->DefragmentCount);
+    }
+}
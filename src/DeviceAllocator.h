@@ -0,0 +1,166 @@
+#pragma once
+
+#include "Common.h"
+#include "System.h"
+
+// Blocks are carved into power of two ranges between DeviceAllocatorMinAllocationSize and the block size
+#define DeviceAllocatorBlockSize         (64ull * 1024 * 1024)
+#define DeviceAllocatorMinAllocationSize (4ull * 1024)
+#define DeviceAllocatorMaxLevels         32
+
+typedef enum DeviceAllocationKind {
+    // Buffers and linear images
+    DeviceAllocationKind_Linear,
+    // Optimal tiling images, padded out to bufferImageGranularity so they never share a page with linear resources
+    DeviceAllocationKind_Optimal,
+    // Buffers defragmentation may move, their owners rebind them whenever it does
+    DeviceAllocationKind_Movable,
+} DeviceAllocationKind;
+
+typedef enum DeviceMemoryNodeState {
+    DeviceMemoryNodeState_Unused,
+    DeviceMemoryNodeState_Free,
+    DeviceMemoryNodeState_Split,
+    DeviceMemoryNodeState_Allocated,
+} DeviceMemoryNodeState;
+
+// Nodes of the buddy tree, node 1 is the whole block and the children of node n are 2n and 2n + 1.
+// Free nodes are linked into a list per level, 0 terminates the list.
+typedef struct DeviceMemoryNode {
+    uint32_t Next;
+    uint32_t Prev;
+    uint8_t State;
+} DeviceMemoryNode;
+
+typedef struct DeviceAllocation DeviceAllocation;
+
+typedef struct DeviceMemoryBlock {
+    struct DeviceMemoryBlock* Next;
+    VkDeviceMemory Memory;
+    VkDeviceSize Size;
+    uint32_t MemoryTypeIndex;
+    bool Dedicated;
+    uint8_t* Mapped;
+    // Bound over the whole block so defragmentation can copy between blocks, VK_NULL_HANDLE if unsupported
+    VkBuffer CopyBuffer;
+    VkDeviceSize UsedBytes;
+    uint32_t AllocationCount;
+    DeviceAllocation* Allocations;
+    uint32_t LevelCount;
+    DeviceMemoryNode* Nodes;
+    uint32_t FreeLists[DeviceAllocatorMaxLevels];
+} DeviceMemoryBlock;
+
+struct DeviceAllocation {
+    VkDeviceMemory Memory;
+    VkDeviceSize Offset;
+    VkDeviceSize Size;
+    // Persistently mapped pointer for host visible memory, NULL otherwise
+    void* Mapped;
+    uint32_t MemoryTypeIndex;
+    DeviceAllocationKind Kind;
+    // Set by DeviceAllocatorDefragment until DeviceAllocatorEndDefragment, the resource using this allocation
+    // must be recreated and bound to the new Memory and Offset
+    bool Moved;
+
+    DeviceMemoryBlock* Block;
+    uint32_t Node;
+    DeviceMemoryBlock* PreviousBlock;
+    uint32_t PreviousNode;
+    DeviceAllocation* Next;
+    DeviceAllocation* Prev;
+};
+
+typedef struct DeviceHeapStats {
+    VkDeviceSize HeapSize;
+    VkDeviceSize BlockBytes;
+    VkDeviceSize UsedBytes;
+    uint32_t BlockCount;
+    uint32_t AllocationCount;
+} DeviceHeapStats;
+
+// Sub-allocates buffers and images out of large VkDeviceMemory blocks, one list of blocks per memory type.
+// Host visible blocks are mapped once when they are created and stay mapped until they are freed.
+// Allocations bigger than half a block get a dedicated VkDeviceMemory of their own.
+typedef struct DeviceAllocator {
+    VkDevice Device;
+    const VkAllocationCallbacks* Allocator;
+    SystemMutex Mutex;
+    VkPhysicalDeviceMemoryProperties MemoryProperties;
+    VkDeviceSize BufferImageGranularity;
+    VkDeviceSize NonCoherentAtomSize;
+    uint32_t MaxMemoryAllocationCount;
+    uint32_t MemoryAllocationCount;
+    // Bytes of VkDeviceMemory currently allocated from the driver and the most there ever were
+    VkDeviceSize MemoryBytes;
+    VkDeviceSize PeakMemoryBytes;
+    VkDeviceSize BlockSizes[VK_MAX_MEMORY_HEAPS];
+    // Heaps short on memory don't keep an empty block around for the next allocation
+    bool Pressured[VK_MAX_MEMORY_HEAPS];
+    // Allocations the driver refused until empty blocks of the heap were released
+    uint64_t OutOfMemoryRecoveries;
+    // Defragmentations that moved anything, and how much they moved
+    uint64_t DefragmentCount;
+    uint64_t DefragmentMoves;
+    VkDeviceSize DefragmentBytes;
+    DeviceMemoryBlock* Blocks[VK_MAX_MEMORY_TYPES];
+    // Moved allocations freed before DeviceAllocatorEndDefragment, linked through Next with both ranges reserved
+    DeviceAllocation* DeferredFrees;
+} DeviceAllocator;
+
+DeviceAllocator* DeviceAllocatorCreate(VkDevice device, VkPhysicalDevice physicalDevice, const VkAllocationCallbacks* allocator);
+// All allocations must be freed first
+void DeviceAllocatorDestroy(DeviceAllocator* deviceAllocator);
+
+// Picks the first memory type with all of the required flags, preferring ones that also have the preferred flags,
+// and falls back to the other candidates if a type is out of memory
+VkResult DeviceAllocatorAllocate(DeviceAllocator* deviceAllocator,
+                                 const VkMemoryRequirements* requirements,
+                                 VkMemoryPropertyFlags requiredFlags,
+                                 VkMemoryPropertyFlags preferredFlags,
+                                 DeviceAllocationKind kind,
+                                 DeviceAllocation** allocation);
+void DeviceAllocatorFree(DeviceAllocator* deviceAllocator, DeviceAllocation* allocation);
+
+// Create the resource, allocate memory for it and bind it, on failure nothing is left behind
+VkResult DeviceAllocatorCreateBuffer(DeviceAllocator* deviceAllocator,
+                                     const VkBufferCreateInfo* createInfo,
+                                     VkMemoryPropertyFlags requiredFlags,
+                                     VkMemoryPropertyFlags preferredFlags,
+                                     VkBuffer* buffer,
+                                     DeviceAllocation** allocation);
+VkResult DeviceAllocatorCreateImage(DeviceAllocator* deviceAllocator,
+                                    const VkImageCreateInfo* createInfo,
+                                    VkMemoryPropertyFlags requiredFlags,
+                                    VkMemoryPropertyFlags preferredFlags,
+                                    VkImage* image,
+                                    DeviceAllocation** allocation);
+
+// No-ops on host coherent memory, ranges are widened to nonCoherentAtomSize
+VkResult DeviceAllocatorFlush(DeviceAllocator* deviceAllocator, DeviceAllocation* allocation, VkDeviceSize offset, VkDeviceSize size);
+VkResult DeviceAllocatorInvalidate(DeviceAllocator* deviceAllocator, DeviceAllocation* allocation, VkDeviceSize offset, VkDeviceSize size);
+
+// Only buffers whose owner can recreate them should be movable, and only once nothing writes to them from another
+// queue anymore. After every defragmentation that moved a movable allocation its owner has to rebind it with
+// DeviceAllocatorRebindBuffer before recording anything else that uses it.
+void DeviceAllocatorSetMovable(DeviceAllocator* deviceAllocator, DeviceAllocation* allocation);
+// Creates a buffer like the original one bound to where the moved allocation is now, the original stays usable by
+// work recorded before the defragmentation until DeviceAllocatorEndDefragment
+VkResult DeviceAllocatorRebindBuffer(DeviceAllocator* deviceAllocator,
+                                     const VkBufferCreateInfo* createInfo,
+                                     const DeviceAllocation* allocation,
+                                     VkBuffer* buffer);
+
+// Records copies that move movable allocations out of the emptiest blocks into free space in fuller ones, up
+// to maxBytesToMove. Moved allocations are flagged and keep their old range reserved, so resources bound to
+// it stay valid until the command buffer has finished and DeviceAllocatorEndDefragment has been called. Freeing a
+// moved allocation before then keeps both of its ranges reserved until the end.
+// Returns the number of allocations that were moved.
+uint32_t DeviceAllocatorDefragment(DeviceAllocator* deviceAllocator, VkCommandBuffer commandBuffer, VkDeviceSize maxBytesToMove);
+void DeviceAllocatorEndDefragment(DeviceAllocator* deviceAllocator);
+
+// Releases the heap's empty blocks right away while pressured, instead of keeping one per memory type
+void DeviceAllocatorSetHeapPressured(DeviceAllocator* deviceAllocator, uint32_t heapIndex, bool pressured);
+
+DeviceHeapStats DeviceAllocatorGetHeapStats(DeviceAllocator* deviceAllocator, uint32_t heapIndex);
+void DeviceAllocatorPrintStats(DeviceAllocator* deviceAllocator);
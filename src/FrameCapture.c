@@ -0,0 +1,450 @@
+#include "FrameCapture.h"
+#include "DebugUtils.h"
+
+// Stored deflate blocks hold at most this many bytes each
+#define FrameCaptureMaxStoredBlock 65535
+
+static uint32_t FrameCaptureCrcTable[256];
+
+static void FrameCaptureInitCrcTable(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (uint32_t bit = 0; bit < 8; bit++) {
+            crc = crc & 1 ? 0xEDB88320u ^ crc >> 1 : crc >> 1;
+        }
+        FrameCaptureCrcTable[i] = crc;
+    }
+}
+
+// Start with 0xFFFFFFFF and invert the result
+static uint32_t FrameCaptureCrc(uint32_t crc, const uint8_t* data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        crc = FrameCaptureCrcTable[(crc ^ data[i]) & 0xFF] ^ crc >> 8;
+    }
+    return crc;
+}
+
+static void FrameCaptureStoreBigEndian(uint8_t* out, uint32_t value) {
+    out[0] = cast(uint8_t)(value >> 24);
+    out[1] = cast(uint8_t)(value >> 16);
+    out[2] = cast(uint8_t)(value >> 8);
+    out[3] = cast(uint8_t) value;
+}
+
+static bool FrameCaptureWriteChunk(FILE* file, const char* type, const uint8_t* data, uint32_t size) {
+    uint8_t header[8];
+    FrameCaptureStoreBigEndian(header, size);
+    memcpy(header + 4, type, 4);
+    uint8_t crc[4];
+    FrameCaptureStoreBigEndian(crc, ~FrameCaptureCrc(FrameCaptureCrc(0xFFFFFFFFu, header + 4, 4), data, size));
+    // Empty chunks like IEND have no data to write, and fwrite mustn't be given a null pointer
+    return fwrite(header, 1, sizeof(header), file) == sizeof(header) && (size == 0 || fwrite(data, 1, size, file) == size) &&
+           fwrite(crc, 1, sizeof(crc), file) == sizeof(crc);
+}
+
+static bool FrameCaptureReserveScratch(FrameCapture* capture, size_t size) {
+    if (capture->ScratchSize >= size) {
+        return true;
+    }
+    uint8_t* scratch = realloc(capture->Scratch, size);
+    if (scratch == NULL) {
+        return false;
+    }
+    capture->Scratch     = scratch;
+    capture->ScratchSize = size;
+    return true;
+}
+
+static void FrameCaptureLoadPixel(const FrameCapture* capture, const uint8_t* texel, int32_t rgb[3]) {
+    rgb[0] = texel[capture->Bgra ? 2 : 0];
+    rgb[1] = texel[1];
+    rgb[2] = texel[capture->Bgra ? 0 : 2];
+}
+
+// An RGB PNG with unfiltered rows in stored deflate blocks, returns the bytes written or 0 on failure
+static size_t FrameCaptureWritePng(FrameCapture* capture, const FrameCaptureSlot* slot) {
+    uint32_t width      = slot->Extent.width;
+    uint32_t height     = slot->Extent.height;
+    size_t rowSize      = 1 + cast(size_t) width * 3;
+    size_t rawSize      = rowSize * height;
+    size_t blockCount   = (rawSize + FrameCaptureMaxStoredBlock - 1) / FrameCaptureMaxStoredBlock;
+    size_t deflatedSize = 2 + blockCount * 5 + rawSize + 4;
+    if (deflatedSize > UINT32_MAX || !FrameCaptureReserveScratch(capture, rawSize + deflatedSize)) {
+        return 0;
+    }
+
+    uint8_t* raw         = capture->Scratch;
+    const uint8_t* image = slot->Allocation->Mapped;
+    for (uint32_t y = 0; y < height; y++) {
+        uint8_t* row = raw + y * rowSize;
+        row[0]       = 0;
+        for (uint32_t x = 0; x < width; x++) {
+            int32_t rgb[3];
+            FrameCaptureLoadPixel(capture, image + (cast(size_t) y * width + x) * 4, rgb);
+            row[1 + x * 3]     = cast(uint8_t) rgb[0];
+            row[1 + x * 3 + 1] = cast(uint8_t) rgb[1];
+            row[1 + x * 3 + 2] = cast(uint8_t) rgb[2];
+        }
+    }
+
+    // zlib header without a preset dictionary, the fastest level, then stored blocks and the Adler-32 of the rows
+    uint8_t* deflated = raw + rawSize;
+    uint8_t* out      = deflated;
+    *out++            = 0x78;
+    *out++            = 0x01;
+    uint32_t adlerA   = 1;
+    uint32_t adlerB   = 0;
+    for (size_t offset = 0; offset < rawSize; offset += FrameCaptureMaxStoredBlock) {
+        uint32_t blockSize = cast(uint32_t)(rawSize - offset < FrameCaptureMaxStoredBlock ? rawSize - offset : FrameCaptureMaxStoredBlock);
+        *out++             = offset + blockSize == rawSize ? 1 : 0;
+        *out++             = cast(uint8_t) blockSize;
+        *out++             = cast(uint8_t)(blockSize >> 8);
+        *out++             = cast(uint8_t) ~blockSize;
+        *out++             = cast(uint8_t)(~blockSize >> 8);
+        memcpy(out, raw + offset, blockSize);
+        out += blockSize;
+        for (uint32_t i = 0; i < blockSize; i++) {
+            adlerA = (adlerA + raw[offset + i]) % 65521;
+            adlerB = (adlerB + adlerA) % 65521;
+        }
+    }
+    FrameCaptureStoreBigEndian(out, adlerB << 16 | adlerA);
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s_%05llu.png", capture->Path, cast(unsigned long long) slot->Frame);
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        return 0;
+    }
+    static const uint8_t Signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    uint8_t header[13]                = { [8] = 8, [9] = 2 };
+    FrameCaptureStoreBigEndian(header, width);
+    FrameCaptureStoreBigEndian(header + 4, height);
+    bool written = fwrite(Signature, 1, sizeof(Signature), file) == sizeof(Signature) &&
+                   FrameCaptureWriteChunk(file, "IHDR", header, sizeof(header)) &&
+                   FrameCaptureWriteChunk(file, "IDAT", deflated, cast(uint32_t) deflatedSize) &&
+                   FrameCaptureWriteChunk(file, "IEND", NULL, 0);
+    written = fclose(file) == 0 && written;
+    return written ? sizeof(Signature) + 3 * 12 + sizeof(header) + deflatedSize : 0;
+}
+
+// Converts to limited range BT.601 4:2:0 and appends the frame to the video, returns the bytes written or 0 on failure
+static size_t FrameCaptureWriteY4m(FrameCapture* capture, const FrameCaptureSlot* slot) {
+    uint32_t width  = slot->Extent.width;
+    uint32_t height = slot->Extent.height;
+    if (capture->Video == NULL) {
+        capture->Video = fopen(capture->Path, "wb");
+        if (capture->Video == NULL) {
+            return 0;
+        }
+        capture->VideoExtent = slot->Extent;
+        fprintf(capture->Video, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420jpeg\n", width, height, FrameCaptureVideoFrameRate);
+    }
+    // The stream has one size, frames rendered after a resize are left out
+    if (width != capture->VideoExtent.width || height != capture->VideoExtent.height) {
+        return 0;
+    }
+
+    uint32_t chromaWidth  = (width + 1) / 2;
+    uint32_t chromaHeight = (height + 1) / 2;
+    size_t lumaSize       = cast(size_t) width * height;
+    size_t chromaSize     = cast(size_t) chromaWidth * chromaHeight;
+    if (!FrameCaptureReserveScratch(capture, lumaSize + 2 * chromaSize)) {
+        return 0;
+    }
+    uint8_t* luma        = capture->Scratch;
+    uint8_t* blue        = luma + lumaSize;
+    uint8_t* red         = blue + chromaSize;
+    const uint8_t* image = slot->Allocation->Mapped;
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            int32_t rgb[3];
+            FrameCaptureLoadPixel(capture, image + (cast(size_t) y * width + x) * 4, rgb);
+            luma[cast(size_t) y * width + x] = cast(uint8_t)(((66 * rgb[0] + 129 * rgb[1] + 25 * rgb[2] + 128) >> 8) + 16);
+        }
+    }
+    // Chroma comes from the average of each 2x2 block, clamped at the right and bottom edges
+    for (uint32_t y = 0; y < chromaHeight; y++) {
+        for (uint32_t x = 0; x < chromaWidth; x++) {
+            int32_t sum[3] = {};
+            for (uint32_t i = 0; i < 4; i++) {
+                uint32_t sampleX = x * 2 + (i & 1) < width ? x * 2 + (i & 1) : width - 1;
+                uint32_t sampleY = y * 2 + (i >> 1) < height ? y * 2 + (i >> 1) : height - 1;
+                int32_t rgb[3];
+                FrameCaptureLoadPixel(capture, image + (cast(size_t) sampleY * width + sampleX) * 4, rgb);
+                sum[0] += rgb[0];
+                sum[1] += rgb[1];
+                sum[2] += rgb[2];
+            }
+            int32_t r                                = sum[0] / 4;
+            int32_t g                                = sum[1] / 4;
+            int32_t b                                = sum[2] / 4;
+            blue[cast(size_t) y * chromaWidth + x] = cast(uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            red[cast(size_t) y * chromaWidth + x]  = cast(uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+
+    static const char FrameHeader[] = "FRAME\n";
+    size_t frameSize                = lumaSize + 2 * chromaSize;
+    bool written                    = fwrite(FrameHeader, 1, sizeof(FrameHeader) - 1, capture->Video) == sizeof(FrameHeader) - 1 &&
+                   fwrite(capture->Scratch, 1, frameSize, capture->Video) == frameSize;
+    return written ? sizeof(FrameHeader) - 1 + frameSize : 0;
+}
+
+static void FrameCaptureConsumerMain(void* userData) {
+    FrameCapture* capture = userData;
+    SystemMutexLock(&capture->Mutex);
+    while (true) {
+        while (capture->QueueCount == 0 && !capture->ShuttingDown) {
+            SystemConditionVariableWait(&capture->WorkAvailable, &capture->Mutex);
+        }
+        // Everything queued is still written when shutting down, so no captured frame goes missing
+        if (capture->QueueCount == 0) {
+            break;
+        }
+        FrameCaptureSlot* slot = &capture->Slots[capture->Queue[capture->QueueHead]];
+        capture->QueueHead     = (capture->QueueHead + 1) % FrameCaptureMaxSlots;
+        capture->QueueCount--;
+        SystemMutexUnlock(&capture->Mutex);
+
+        // The slot isn't touched by the render thread until it's free again, so it's read without the lock
+        uint64_t startTime = SystemGetTimeNanoseconds();
+        size_t bytes       = capture->Format == FrameCaptureFormat_Png ? FrameCaptureWritePng(capture, slot)
+                                                                       : FrameCaptureWriteY4m(capture, slot);
+        uint64_t endTime   = SystemGetTimeNanoseconds();
+
+        SystemMutexLock(&capture->Mutex);
+        if (bytes > 0) {
+            capture->Stats.Written++;
+            capture->Stats.BytesWritten += bytes;
+        } else {
+            capture->Stats.WriteFailures++;
+        }
+        capture->Stats.WriteNanoseconds += endTime - startTime;
+        if (endTime - slot->SubmitTime > capture->Stats.MaxLatencyNanoseconds) {
+            capture->Stats.MaxLatencyNanoseconds = endTime - slot->SubmitTime;
+        }
+        slot->State = FrameCaptureSlotState_Free;
+        SystemConditionVariableBroadcast(&capture->WorkDone);
+    }
+    SystemMutexUnlock(&capture->Mutex);
+}
+
+static void FrameCaptureRecordPass(VkCommandBuffer commandBuffer, RenderGraph* graph, void* userData) {
+    const FrameCapture* capture  = userData;
+    const FrameCaptureSlot* slot = &capture->Slots[capture->RecordingSlot];
+    vkCmdCopyImageToBuffer(commandBuffer,
+                           RenderGraphGetImage(graph, capture->Target),
+                           VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                           RenderGraphGetBuffer(graph, capture->Destination),
+                           1,
+                           &(VkBufferImageCopy){
+                               .imageSubresource =
+                                   (VkImageSubresourceLayers){
+                                       .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                       .layerCount = 1,
+                                   },
+                               .imageExtent = { slot->Extent.width, slot->Extent.height, 1 },
+                           });
+}
+
+FrameCapture* FrameCaptureCreate(VkDevice device,
+                                 DeviceAllocator* deviceAllocator,
+                                 Timeline* graphicsTimeline,
+                                 VkFormat imageFormat,
+                                 FrameCaptureFormat format,
+                                 const char* path,
+                                 const VkAllocationCallbacks* allocator) {
+    if (imageFormat != VK_FORMAT_R8G8B8A8_UNORM && imageFormat != VK_FORMAT_R8G8B8A8_SRGB &&
+        imageFormat != VK_FORMAT_B8G8R8A8_UNORM && imageFormat != VK_FORMAT_B8G8R8A8_SRGB) {
+        fflush(stdout);
+        fprintf(stderr, "Frames of format %d can't be captured, only 8 bit RGBA and BGRA!\n", imageFormat);
+        exit(1);
+    }
+    FrameCapture* capture = calloc(1, sizeof(FrameCapture));
+    if (capture == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate the frame capture!\n");
+        exit(1);
+    }
+    capture->Device          = device;
+    capture->Allocator       = allocator;
+    capture->DeviceAllocator = deviceAllocator;
+    capture->Timeline        = graphicsTimeline;
+    capture->Format          = format;
+    capture->Path            = path;
+    capture->Bgra            = imageFormat == VK_FORMAT_B8G8R8A8_UNORM || imageFormat == VK_FORMAT_B8G8R8A8_SRGB;
+    capture->RecordingSlot   = UINT32_MAX;
+    FrameCaptureInitCrcTable();
+    SystemMutexInit(&capture->Mutex);
+    SystemConditionVariableInit(&capture->WorkAvailable);
+    SystemConditionVariableInit(&capture->WorkDone);
+    SystemThreadCreate(&capture->Consumer, FrameCaptureConsumerMain, capture);
+    return capture;
+}
+
+void FrameCaptureDestroy(FrameCapture* capture) {
+    FrameCaptureFlush(capture);
+    SystemMutexLock(&capture->Mutex);
+    capture->ShuttingDown = true;
+    SystemConditionVariableBroadcast(&capture->WorkAvailable);
+    SystemMutexUnlock(&capture->Mutex);
+    SystemThreadJoin(&capture->Consumer);
+
+    for (uint32_t i = 0; i < FrameCaptureMaxSlots; i++) {
+        FrameCaptureSlot* slot = &capture->Slots[i];
+        if (slot->Buffer != VK_NULL_HANDLE) {
+            vkDestroyBuffer(capture->Device, slot->Buffer, capture->Allocator);
+            DeviceAllocatorFree(capture->DeviceAllocator, slot->Allocation);
+        }
+    }
+    if (capture->Video) {
+        fclose(capture->Video);
+    }
+    free(capture->Scratch);
+    SystemConditionVariableDestroy(&capture->WorkDone);
+    SystemConditionVariableDestroy(&capture->WorkAvailable);
+    SystemMutexDestroy(&capture->Mutex);
+    free(capture);
+}
+
+void FrameCaptureFlush(FrameCapture* capture) {
+    // The device is idle, so every submitted copy has finished and is queued here
+    FrameCaptureBeginFrame(capture);
+    SystemMutexLock(&capture->Mutex);
+    while (true) {
+        bool writing = false;
+        for (uint32_t i = 0; i < FrameCaptureMaxSlots; i++) {
+            writing = writing || capture->Slots[i].State == FrameCaptureSlotState_Writing;
+        }
+        if (!writing) {
+            break;
+        }
+        SystemConditionVariableWait(&capture->WorkDone, &capture->Mutex);
+    }
+    SystemMutexUnlock(&capture->Mutex);
+}
+
+void FrameCaptureBeginFrame(FrameCapture* capture) {
+    uint64_t completedValue = TimelineGetCompletedValue(capture->Timeline);
+    SystemMutexLock(&capture->Mutex);
+    uint32_t queued = 0;
+    while (true) {
+        // Oldest first, so the consumer gets the frames in order
+        FrameCaptureSlot* oldest = NULL;
+        for (uint32_t i = 0; i < FrameCaptureMaxSlots; i++) {
+            FrameCaptureSlot* slot = &capture->Slots[i];
+            if (slot->State == FrameCaptureSlotState_InFlight && slot->Value <= completedValue &&
+                (oldest == NULL || slot->Value < oldest->Value)) {
+                oldest = slot;
+            }
+        }
+        if (oldest == NULL) {
+            break;
+        }
+        VkCheck(DeviceAllocatorInvalidate(capture->DeviceAllocator, oldest->Allocation, 0, oldest->Size));
+        oldest->State = FrameCaptureSlotState_Writing;
+        capture->Queue[(capture->QueueHead + capture->QueueCount++) % FrameCaptureMaxSlots] = cast(uint32_t)(oldest - capture->Slots);
+        queued++;
+    }
+    if (queued > 0) {
+        SystemConditionVariableSignal(&capture->WorkAvailable);
+    }
+    SystemMutexUnlock(&capture->Mutex);
+}
+
+bool FrameCaptureAddPass(FrameCapture* capture, RenderGraph* graph, RenderGraphResource target, VkExtent2D extent) {
+    assert(capture->RecordingSlot == UINT32_MAX);
+    uint64_t frame = capture->FrameCount++;
+    SystemMutexLock(&capture->Mutex);
+    FrameCaptureSlot* slot = NULL;
+    for (uint32_t i = 0; i < FrameCaptureMaxSlots && slot == NULL; i++) {
+        uint32_t index = (capture->NextSlot + i) % FrameCaptureMaxSlots;
+        if (capture->Slots[index].State == FrameCaptureSlotState_Free) {
+            slot = &capture->Slots[index];
+        }
+    }
+    if (slot == NULL) {
+        capture->Stats.Dropped++;
+        SystemMutexUnlock(&capture->Mutex);
+        return false;
+    }
+    SystemMutexUnlock(&capture->Mutex);
+
+    // Free slots belong to the render thread, so growing one after a resize needs no lock
+    VkDeviceSize size = cast(VkDeviceSize) extent.width * extent.height * 4;
+    if (slot->Size < size) {
+        if (slot->Buffer != VK_NULL_HANDLE) {
+            vkDestroyBuffer(capture->Device, slot->Buffer, capture->Allocator);
+            DeviceAllocatorFree(capture->DeviceAllocator, slot->Allocation);
+            *slot = (FrameCaptureSlot){};
+        }
+        VkResult bufferCreateResult = DeviceAllocatorCreateBuffer(capture->DeviceAllocator,
+                                                                  &(VkBufferCreateInfo){
+                                                                      .sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+                                                                      .size        = size,
+                                                                      .usage       = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                                                      .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                                                                  },
+                                                                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+                                                                  VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+                                                                  &slot->Buffer,
+                                                                  &slot->Allocation);
+        // Running out of memory costs the capture a frame, not the renderer
+        if (bufferCreateResult != VK_SUCCESS) {
+            SystemMutexLock(&capture->Mutex);
+            capture->Stats.Dropped++;
+            SystemMutexUnlock(&capture->Mutex);
+            return false;
+        }
+        slot->Size = size;
+        DebugUtilsSetObjectName(
+            capture->Device, VK_OBJECT_TYPE_BUFFER, cast(uint64_t) slot->Buffer, "Frame capture %u", cast(uint32_t)(slot - capture->Slots));
+    }
+    slot->Extent = extent;
+    slot->Frame  = frame;
+
+    SystemMutexLock(&capture->Mutex);
+    slot->State = FrameCaptureSlotState_Recorded;
+    capture->Stats.Captured++;
+    SystemMutexUnlock(&capture->Mutex);
+    capture->RecordingSlot = cast(uint32_t)(slot - capture->Slots);
+    capture->NextSlot      = (capture->RecordingSlot + 1) % FrameCaptureMaxSlots;
+    capture->Target        = target;
+    capture->Destination   = RenderGraphImportBuffer(graph, "Capture", slot->Buffer, RenderGraphUsage_HostRead);
+    uint32_t pass          = RenderGraphAddPass(graph, "Capture", FrameCaptureRecordPass, capture);
+    RenderGraphUse(graph, pass, target, RenderGraphUsage_TransferSrc);
+    RenderGraphUse(graph, pass, capture->Destination, RenderGraphUsage_TransferDst);
+    return true;
+}
+
+void FrameCaptureSubmitted(FrameCapture* capture, uint64_t graphicsValue) {
+    if (capture->RecordingSlot == UINT32_MAX) {
+        return;
+    }
+    FrameCaptureSlot* slot = &capture->Slots[capture->RecordingSlot];
+    SystemMutexLock(&capture->Mutex);
+    slot->State      = FrameCaptureSlotState_InFlight;
+    slot->Value      = graphicsValue;
+    slot->SubmitTime = SystemGetTimeNanoseconds();
+    SystemMutexUnlock(&capture->Mutex);
+    capture->RecordingSlot = UINT32_MAX;
+}
+
+void FrameCapturePrintStats(FrameCapture* capture) {
+    SystemMutexLock(&capture->Mutex);
+    const FrameCaptureStats* stats = &capture->Stats;
+    printf("Captured %llu frames to '%s', wrote %llu and dropped %llu while every slot was busy, %llu writes failed!\n",
+           cast(unsigned long long) stats->Captured,
+           capture->Path,
+           cast(unsigned long long) stats->Written,
+           cast(unsigned long long) stats->Dropped,
+           cast(unsigned long long) stats->WriteFailures);
+    if (stats->Written > 0) {
+        printf("Wrote %.1fMB taking %.3fms per frame on the consumer thread, at most %.3fms from submission to file!\n",
+               cast(double) stats->BytesWritten / (1024.0 * 1024.0),
+               cast(double) stats->WriteNanoseconds / cast(double) stats->Written / 1e6,
+               cast(double) stats->MaxLatencyNanoseconds / 1e6);
+    }
+    SystemMutexUnlock(&capture->Mutex);
+}
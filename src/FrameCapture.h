@@ -0,0 +1,119 @@
+#pragma once
+
+#include "Common.h"
+#include "System.h"
+#include "DeviceAllocator.h"
+#include "RenderGraph.h"
+#include "Timeline.h"
+
+// Frames that can be in flight or waiting to be written at once, captures past that are dropped
+#define FrameCaptureMaxSlots 8
+// Y4M headers need a frame rate, players use it to pace the video
+#define FrameCaptureVideoFrameRate 60
+
+typedef enum FrameCaptureFormat {
+    // One file per frame, named <path>_<frame>.png
+    FrameCaptureFormat_Png,
+    // A single YUV4MPEG2 stream of 4:2:0 frames, which video tools and encoders take as raw input
+    FrameCaptureFormat_Y4m,
+} FrameCaptureFormat;
+
+typedef enum FrameCaptureSlotState {
+    FrameCaptureSlotState_Free,
+    // The copy is in the frame's command buffer, which hasn't been submitted yet
+    FrameCaptureSlotState_Recorded,
+    // Waiting for the graphics timeline to pass Value
+    FrameCaptureSlotState_InFlight,
+    // Queued for or being written by the consumer thread
+    FrameCaptureSlotState_Writing,
+} FrameCaptureSlotState;
+
+typedef struct FrameCaptureSlot {
+    // Guarded by the mutex
+    FrameCaptureSlotState State;
+    VkBuffer Buffer;
+    DeviceAllocation* Allocation;
+    VkDeviceSize Size;
+    VkExtent2D Extent;
+    uint64_t Frame;
+    uint64_t Value;
+    uint64_t SubmitTime;
+} FrameCaptureSlot;
+
+typedef struct FrameCaptureStats {
+    // Guarded by the mutex
+    uint64_t Captured;
+    uint64_t Written;
+    uint64_t Dropped;
+    uint64_t WriteFailures;
+    uint64_t BytesWritten;
+    uint64_t WriteNanoseconds;
+    // From the frame's submission until its file was written
+    uint64_t MaxLatencyNanoseconds;
+} FrameCaptureStats;
+
+// Copies rendered frames out of the swapchain into a ring of host visible buffers without ever waiting for the GPU.
+// The copy is a pass at the end of the frame's render graph. FrameCaptureBeginFrame later hands every buffer the
+// graphics timeline has passed to a consumer thread, which encodes straight out of the mapped memory and only then
+// frees the slot. When every slot is still busy, because the GPU is behind or the encoder can't keep up, the frame
+// is dropped from the capture rather than slowing rendering down. Frames reach the consumer in the order they were
+// rendered. PNGs are stored uncompressed, which costs disk space but keeps the encoder cheap enough to keep up.
+// Everything but the consumer is for the render thread only.
+typedef struct FrameCapture {
+    VkDevice Device;
+    const VkAllocationCallbacks* Allocator;
+    DeviceAllocator* DeviceAllocator;
+    Timeline* Timeline;
+    FrameCaptureFormat Format;
+    const char* Path;
+    // Whether the image's bytes are in BGRA order
+    bool Bgra;
+    uint64_t FrameCount;
+    // What the frame's pass was added with, read by the callback while the graph executes
+    uint32_t RecordingSlot;
+    RenderGraphResource Target;
+    RenderGraphResource Destination;
+    // Render thread only, the slot the next capture tries first
+    uint32_t NextSlot;
+
+    SystemThread Consumer;
+    SystemMutex Mutex;
+    SystemConditionVariable WorkAvailable;
+    // Signaled whenever the consumer finishes a frame
+    SystemConditionVariable WorkDone;
+    bool ShuttingDown;
+    uint32_t Queue[FrameCaptureMaxSlots];
+    uint32_t QueueHead;
+    uint32_t QueueCount;
+    FrameCaptureSlot Slots[FrameCaptureMaxSlots];
+    FrameCaptureStats Stats;
+
+    // Consumer thread only
+    FILE* Video;
+    VkExtent2D VideoExtent;
+    uint8_t* Scratch;
+    size_t ScratchSize;
+} FrameCapture;
+
+// imageFormat is the format of the images that are captured, only 8 bit RGBA and BGRA formats are supported
+FrameCapture* FrameCaptureCreate(VkDevice device,
+                                 DeviceAllocator* deviceAllocator,
+                                 Timeline* graphicsTimeline,
+                                 VkFormat imageFormat,
+                                 FrameCaptureFormat format,
+                                 const char* path,
+                                 const VkAllocationCallbacks* allocator);
+// The device must be idle, every captured frame is written before it returns
+void FrameCaptureDestroy(FrameCapture* capture);
+// The device must be idle, waits until every captured frame has been written
+void FrameCaptureFlush(FrameCapture* capture);
+
+// Hands finished copies to the consumer thread, call it once per frame
+void FrameCaptureBeginFrame(FrameCapture* capture);
+// Adds the pass copying target out, add it after every pass drawing into target. Returns false if the frame was
+// dropped.
+bool FrameCaptureAddPass(FrameCapture* capture, RenderGraph* graph, RenderGraphResource target, VkExtent2D extent);
+// graphicsValue is what the submission of the frame the pass was added to signals
+void FrameCaptureSubmitted(FrameCapture* capture, uint64_t graphicsValue);
+
+void FrameCapturePrintStats(FrameCapture* capture);
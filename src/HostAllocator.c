@@ -0,0 +1,304 @@
+#include "HostAllocator.h"
+
+typedef enum HostAllocationSource {
+    HostAllocationSource_Arena,
+    HostAllocationSource_Command,
+    HostAllocationSource_Heap,
+} HostAllocationSource;
+
+// Sits directly in front of every pointer handed to the driver, user pointers are always at least 16 byte
+// aligned so the header is too
+typedef struct HostAllocationHeader {
+    uint64_t Size;
+    uint32_t Offset; // from the start of the block to the user pointer
+    uint8_t Scope;
+    uint8_t Source;
+    uint8_t Index; // size class or command pool
+    uint8_t Padding;
+} HostAllocationHeader;
+static_assert(sizeof(HostAllocationHeader) == 16, "HostAllocationHeader must keep user pointers 16 byte aligned");
+
+static size_t HostAllocatorAlignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static HostAllocationHeader* HostAllocatorGetHeader(void* memory) {
+    return cast(HostAllocationHeader*)(cast(uint8_t*) memory - sizeof(HostAllocationHeader));
+}
+
+// Bytes a block needs so that a header and an aligned allocation of the given size fit in it
+static size_t HostAllocatorBlockSize(size_t size, size_t alignment) {
+    return sizeof(HostAllocationHeader) + size + (alignment > sizeof(HostAllocationHeader) ? alignment - sizeof(HostAllocationHeader) : 0);
+}
+
+static void* HostAllocatorPlace(uint8_t* block, size_t size, size_t alignment, VkSystemAllocationScope scope, uint8_t source, uint8_t index) {
+    if (alignment < sizeof(HostAllocationHeader)) {
+        alignment = sizeof(HostAllocationHeader);
+    }
+    uint8_t* memory              = cast(uint8_t*) HostAllocatorAlignUp(cast(uintptr_t)(block + sizeof(HostAllocationHeader)), alignment);
+    HostAllocationHeader* header = HostAllocatorGetHeader(memory);
+    header->Size                 = size;
+    header->Offset               = cast(uint32_t)(memory - block);
+    header->Scope                = cast(uint8_t) scope;
+    header->Source               = source;
+    header->Index                = index;
+    header->Padding              = 0;
+    return memory;
+}
+
+static void* HostAllocatorAllocateArena(HostAllocator* hostAllocator, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+    size_t blockSize = HostAllocatorBlockSize(size, alignment);
+    uint32_t sizeClass = 0;
+    while (sizeClass < HostAllocatorClassCount && (cast(size_t) 1 << (sizeClass + HostAllocatorMinClassShift)) < blockSize) {
+        sizeClass++;
+    }
+
+    if (sizeClass == HostAllocatorClassCount) {
+        uint8_t* block = malloc(blockSize);
+        if (block == NULL) {
+            return NULL;
+        }
+        hostAllocator->SystemHeapAllocations++;
+        return HostAllocatorPlace(block, size, alignment, scope, HostAllocationSource_Heap, 0);
+    }
+
+    uint8_t* block = hostAllocator->FreeLists[sizeClass];
+    if (block != NULL) {
+        hostAllocator->FreeLists[sizeClass] = *cast(void**) block;
+        return HostAllocatorPlace(block, size, alignment, scope, HostAllocationSource_Arena, cast(uint8_t) sizeClass);
+    }
+
+    size_t classSize = cast(size_t) 1 << (sizeClass + HostAllocatorMinClassShift);
+    if (hostAllocator->ChunkCursor == NULL || cast(size_t)(hostAllocator->ChunkEnd - hostAllocator->ChunkCursor) < classSize) {
+        // The first 16 bytes of every chunk link it into the chunk list, the rest of the old chunk is abandoned
+        uint8_t* chunk = malloc(HostAllocatorChunkSize);
+        if (chunk == NULL) {
+            return NULL;
+        }
+        hostAllocator->SystemHeapAllocations++;
+        *cast(uint8_t**) chunk     = hostAllocator->ChunkList;
+        hostAllocator->ChunkList   = chunk;
+        hostAllocator->ChunkCursor = chunk + sizeof(HostAllocationHeader);
+        hostAllocator->ChunkEnd    = chunk + HostAllocatorChunkSize;
+    }
+    block = hostAllocator->ChunkCursor;
+    hostAllocator->ChunkCursor += classSize;
+    return HostAllocatorPlace(block, size, alignment, scope, HostAllocationSource_Arena, cast(uint8_t) sizeClass);
+}
+
+static void* HostAllocatorAllocateLocked(HostAllocator* hostAllocator, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+    void* memory = NULL;
+    if (scope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND) {
+        uint32_t poolIndex             = hostAllocator->CurrentCommandPool;
+        HostAllocatorCommandPool* pool = &hostAllocator->CommandPools[poolIndex];
+        size_t blockSize               = HostAllocatorBlockSize(size, alignment);
+        if (pool->Memory != NULL && HostAllocatorCommandPoolSize - pool->Offset >= blockSize) {
+            memory       = HostAllocatorPlace(pool->Memory + pool->Offset, size, alignment, scope, HostAllocationSource_Command, cast(uint8_t) poolIndex);
+            pool->Offset = HostAllocatorAlignUp(cast(size_t)(cast(uint8_t*) memory - pool->Memory) + size, sizeof(HostAllocationHeader));
+            pool->LiveCount++;
+        } else {
+            hostAllocator->CommandPoolOverflows++;
+        }
+    }
+    if (memory == NULL) {
+        memory = HostAllocatorAllocateArena(hostAllocator, size, alignment, scope);
+        if (memory == NULL) {
+            return NULL;
+        }
+    }
+
+    HostAllocatorScopeStats* stats = &hostAllocator->Scopes[scope];
+    stats->Bytes += size;
+    stats->Count++;
+    stats->TotalAllocations++;
+    if (stats->Bytes > stats->PeakBytes) {
+        stats->PeakBytes = stats->Bytes;
+    }
+    hostAllocator->Bytes += size;
+    if (hostAllocator->Bytes > hostAllocator->PeakBytes) {
+        hostAllocator->PeakBytes = hostAllocator->Bytes;
+    }
+    return memory;
+}
+
+static void HostAllocatorFreeLocked(HostAllocator* hostAllocator, void* memory) {
+    HostAllocationHeader* header   = HostAllocatorGetHeader(memory);
+    uint8_t* block                 = cast(uint8_t*) memory - header->Offset;
+    HostAllocatorScopeStats* stats = &hostAllocator->Scopes[header->Scope];
+    stats->Bytes -= header->Size;
+    stats->Count--;
+    hostAllocator->Bytes -= header->Size;
+
+    switch (header->Source) {
+        case HostAllocationSource_Arena: {
+            *cast(void**) block                     = hostAllocator->FreeLists[header->Index];
+            hostAllocator->FreeLists[header->Index] = block;
+        } break;
+
+        case HostAllocationSource_Command: {
+            HostAllocatorCommandPool* pool = &hostAllocator->CommandPools[header->Index];
+            assert(pool->LiveCount > 0);
+            if (--pool->LiveCount == 0) {
+                pool->Offset = 0;
+            }
+        } break;
+
+        case HostAllocationSource_Heap: {
+            free(block);
+        } break;
+    }
+}
+
+static void* VKAPI_CALL HostAllocatorAllocation(void* pUserData, size_t size, size_t alignment, VkSystemAllocationScope allocationScope) {
+    HostAllocator* hostAllocator = pUserData;
+    SystemMutexLock(&hostAllocator->Mutex);
+    void* memory = HostAllocatorAllocateLocked(hostAllocator, size, alignment, allocationScope);
+    SystemMutexUnlock(&hostAllocator->Mutex);
+    return memory;
+}
+
+static void* VKAPI_CALL
+HostAllocatorReallocation(void* pUserData, void* pOriginal, size_t size, size_t alignment, VkSystemAllocationScope allocationScope) {
+    HostAllocator* hostAllocator = pUserData;
+    SystemMutexLock(&hostAllocator->Mutex);
+    void* memory = NULL;
+    if (pOriginal == NULL) {
+        memory = HostAllocatorAllocateLocked(hostAllocator, size, alignment, allocationScope);
+    } else if (size == 0) {
+        HostAllocatorFreeLocked(hostAllocator, pOriginal);
+    } else {
+        // On failure the original allocation must be left untouched
+        memory = HostAllocatorAllocateLocked(hostAllocator, size, alignment, allocationScope);
+        if (memory != NULL) {
+            uint64_t originalSize = HostAllocatorGetHeader(pOriginal)->Size;
+            memcpy(memory, pOriginal, originalSize < size ? originalSize : size);
+            HostAllocatorFreeLocked(hostAllocator, pOriginal);
+        }
+    }
+    SystemMutexUnlock(&hostAllocator->Mutex);
+    return memory;
+}
+
+static void VKAPI_CALL HostAllocatorFree(void* pUserData, void* pMemory) {
+    HostAllocator* hostAllocator = pUserData;
+    if (pMemory == NULL) {
+        return;
+    }
+    SystemMutexLock(&hostAllocator->Mutex);
+    HostAllocatorFreeLocked(hostAllocator, pMemory);
+    SystemMutexUnlock(&hostAllocator->Mutex);
+}
+
+static void VKAPI_CALL HostAllocatorInternalAllocation(void* pUserData,
+                                                       size_t size,
+                                                       VkInternalAllocationType allocationType,
+                                                       VkSystemAllocationScope allocationScope) {
+    HostAllocator* hostAllocator = pUserData;
+    (void)allocationType;
+    SystemMutexLock(&hostAllocator->Mutex);
+    hostAllocator->Scopes[allocationScope].InternalBytes += size;
+    SystemMutexUnlock(&hostAllocator->Mutex);
+}
+
+static void VKAPI_CALL HostAllocatorInternalFree(void* pUserData,
+                                                 size_t size,
+                                                 VkInternalAllocationType allocationType,
+                                                 VkSystemAllocationScope allocationScope) {
+    HostAllocator* hostAllocator = pUserData;
+    (void)allocationType;
+    SystemMutexLock(&hostAllocator->Mutex);
+    hostAllocator->Scopes[allocationScope].InternalBytes -= size;
+    SystemMutexUnlock(&hostAllocator->Mutex);
+}
+
+HostAllocator* HostAllocatorCreate(void) {
+    HostAllocator* hostAllocator = calloc(1, sizeof(HostAllocator));
+    if (hostAllocator == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate the host allocator!\n");
+        exit(1);
+    }
+    SystemMutexInit(&hostAllocator->Mutex);
+
+    for (uint32_t i = 0; i < MaxFramesInFlight; i++) {
+        hostAllocator->CommandPools[i].Memory = malloc(HostAllocatorCommandPoolSize);
+        if (hostAllocator->CommandPools[i].Memory == NULL) {
+            fflush(stdout);
+            fprintf(stderr, "Failed to allocate command pool %d for the host allocator!\n", i);
+            exit(1);
+        }
+        hostAllocator->SystemHeapAllocations++;
+    }
+
+    hostAllocator->Callbacks = (VkAllocationCallbacks){
+        .pUserData             = hostAllocator,
+        .pfnAllocation         = HostAllocatorAllocation,
+        .pfnReallocation       = HostAllocatorReallocation,
+        .pfnFree               = HostAllocatorFree,
+        .pfnInternalAllocation = HostAllocatorInternalAllocation,
+        .pfnInternalFree       = HostAllocatorInternalFree,
+    };
+    return hostAllocator;
+}
+
+void HostAllocatorDestroy(HostAllocator* hostAllocator) {
+    uint64_t leakedCount = 0;
+    uint64_t leakedBytes = 0;
+    for (uint32_t i = 0; i < HostAllocatorScopeCount; i++) {
+        leakedCount += hostAllocator->Scopes[i].Count;
+        leakedBytes += hostAllocator->Scopes[i].Bytes;
+    }
+    if (leakedCount > 0) {
+        fflush(stdout);
+        fprintf(stderr,
+                "Host allocator destroyed with %llu allocations (%llu bytes) still alive!\n",
+                cast(unsigned long long) leakedCount,
+                cast(unsigned long long) leakedBytes);
+    }
+
+    uint8_t* chunk = hostAllocator->ChunkList;
+    while (chunk != NULL) {
+        uint8_t* next = *cast(uint8_t**) chunk;
+        free(chunk);
+        chunk = next;
+    }
+    for (uint32_t i = 0; i < MaxFramesInFlight; i++) {
+        free(hostAllocator->CommandPools[i].Memory);
+    }
+    SystemMutexDestroy(&hostAllocator->Mutex);
+    free(hostAllocator);
+}
+
+void HostAllocatorBeginFrame(HostAllocator* hostAllocator, uint32_t frameSlot) {
+    assert(frameSlot < MaxFramesInFlight);
+    SystemMutexLock(&hostAllocator->Mutex);
+    hostAllocator->CurrentCommandPool = frameSlot;
+    SystemMutexUnlock(&hostAllocator->Mutex);
+}
+
+void HostAllocatorPrintStats(HostAllocator* hostAllocator) {
+    static const char* const ScopeNames[HostAllocatorScopeCount] = {
+        [VK_SYSTEM_ALLOCATION_SCOPE_COMMAND]  = "Command",
+        [VK_SYSTEM_ALLOCATION_SCOPE_OBJECT]   = "Object",
+        [VK_SYSTEM_ALLOCATION_SCOPE_CACHE]    = "Cache",
+        [VK_SYSTEM_ALLOCATION_SCOPE_DEVICE]   = "Device",
+        [VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE] = "Instance",
+    };
+
+    SystemMutexLock(&hostAllocator->Mutex);
+    printf("%-10s %10s %12s %12s %12s %14s\n", "Scope", "Live", "LiveBytes", "PeakBytes", "Allocations", "InternalBytes");
+    for (uint32_t i = 0; i < HostAllocatorScopeCount; i++) {
+        const HostAllocatorScopeStats* stats = &hostAllocator->Scopes[i];
+        printf("%-10s %10llu %12llu %12llu %12llu %14llu\n",
+               ScopeNames[i],
+               cast(unsigned long long) stats->Count,
+               cast(unsigned long long) stats->Bytes,
+               cast(unsigned long long) stats->PeakBytes,
+               cast(unsigned long long) stats->TotalAllocations,
+               cast(unsigned long long) stats->InternalBytes);
+    }
+    printf("Host allocator made %llu system heap allocations, %llu command allocations overflowed their pool\n",
+           cast(unsigned long long) hostAllocator->SystemHeapAllocations,
+           cast(unsigned long long) hostAllocator->CommandPoolOverflows);
+    SystemMutexUnlock(&hostAllocator->Mutex);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Common.h"
+#include "System.h"
+
+// Scopes are indexed by VkSystemAllocationScope, COMMAND through INSTANCE
+#define HostAllocatorScopeCount 5
+
+// Blocks are 32 bytes up to 8KB in powers of two, anything bigger goes straight to the system heap
+#define HostAllocatorMinClassShift 5
+#define HostAllocatorClassCount    9
+#define HostAllocatorChunkSize     (256 * 1024)
+
+// Each frame slot gets a bump pool of this size for COMMAND scope allocations
+#define HostAllocatorCommandPoolSize (64 * 1024)
+
+typedef struct HostAllocatorScopeStats {
+    uint64_t Bytes;
+    uint64_t Count;
+    uint64_t PeakBytes;
+    uint64_t TotalAllocations;
+    uint64_t InternalBytes;
+} HostAllocatorScopeStats;
+
+typedef struct HostAllocatorCommandPool {
+    uint8_t* Memory;
+    size_t Offset;
+    uint32_t LiveCount;
+} HostAllocatorCommandPool;
+
+// Implements VkAllocationCallbacks for the driver. Object, cache, device and instance scope allocations
+// come from size-class free lists carved out of large arena chunks that are only returned to the system
+// when the allocator is destroyed. Command scope allocations only live for the duration of a single
+// Vulkan call, so they are bumped out of the current frame slot's pool, which rewinds whenever everything
+// in it has been freed. Every allocation is prefixed with a small header so frees know where it came from.
+typedef struct HostAllocator {
+    VkAllocationCallbacks Callbacks;
+    SystemMutex Mutex;
+    uint8_t* ChunkList;
+    uint8_t* ChunkCursor;
+    uint8_t* ChunkEnd;
+    void* FreeLists[HostAllocatorClassCount];
+    uint32_t CurrentCommandPool;
+    HostAllocatorCommandPool CommandPools[MaxFramesInFlight];
+    HostAllocatorScopeStats Scopes[HostAllocatorScopeCount];
+    // Live and peak bytes across all scopes, the peak of the sum isn't the sum of the scope peaks
+    uint64_t Bytes;
+    uint64_t PeakBytes;
+    uint64_t SystemHeapAllocations;
+    uint64_t CommandPoolOverflows;
+} HostAllocator;
+
+HostAllocator* HostAllocatorCreate(void);
+// All objects created with the callbacks must be destroyed first, anything left over is reported as leaked
+void HostAllocatorDestroy(HostAllocator* hostAllocator);
+
+// Switches command scope allocations to the pool of the given frame slot
+void HostAllocatorBeginFrame(HostAllocator* hostAllocator, uint32_t frameSlot);
+
+void HostAllocatorPrintStats(HostAllocator* hostAllocator);
@@ -0,0 +1,85 @@
+// Keeps the counting macros out, this file needs the plain function pointer names
+#define LoaderImplementation
+#include "Common.h"
+#include "System.h"
+
+#if defined(VULKAN_COUNT_DISPATCHES)
+    #include <stdatomic.h>
+
+atomic_uint_least64_t LoaderDispatchCount;
+#endif
+
+#define LoaderDefineFunction(name) PFN_##name name = NULL;
+PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr = NULL;
+LoaderGlobalFunctions(LoaderDefineFunction)
+LoaderInstanceFunctions(LoaderDefineFunction)
+LoaderDeviceFunctions(LoaderDefineFunction)
+#undef LoaderDefineFunction
+
+static void* LoaderLibrary = NULL;
+
+static void LoaderCheckFunction(PFN_vkVoidFunction function, const char* name) {
+    if (function == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to load %s!\n", name);
+        exit(1);
+    }
+}
+
+bool LoaderInit(void) {
+#if defined(_WIN32)
+    LoaderLibrary = SystemLoadLibrary("vulkan-1.dll");
+#else
+    LoaderLibrary = SystemLoadLibrary("libvulkan.so.1");
+    if (LoaderLibrary == NULL) {
+        LoaderLibrary = SystemLoadLibrary("libvulkan.so");
+    }
+#endif
+    if (LoaderLibrary == NULL) {
+        return false;
+    }
+    vkGetInstanceProcAddr = cast(PFN_vkGetInstanceProcAddr) SystemGetLibraryFunction(LoaderLibrary, "vkGetInstanceProcAddr");
+    if (vkGetInstanceProcAddr == NULL) {
+        SystemUnloadLibrary(LoaderLibrary);
+        LoaderLibrary = NULL;
+        return false;
+    }
+
+#define LoaderLoadGlobalFunction(name)                                     \
+    name = cast(PFN_##name) vkGetInstanceProcAddr(VK_NULL_HANDLE, #name); \
+    LoaderCheckFunction(cast(PFN_vkVoidFunction) name, #name);
+    LoaderGlobalFunctions(LoaderLoadGlobalFunction)
+#undef LoaderLoadGlobalFunction
+    return true;
+}
+
+void LoaderLoadInstance(VkInstance instance) {
+#define LoaderLoadInstanceFunction(name)                             \
+    name = cast(PFN_##name) vkGetInstanceProcAddr(instance, #name); \
+    LoaderCheckFunction(cast(PFN_vkVoidFunction) name, #name);
+    LoaderInstanceFunctions(LoaderLoadInstanceFunction)
+#undef LoaderLoadInstanceFunction
+}
+
+void LoaderLoadDevice(VkDevice device) {
+#define LoaderLoadDeviceFunction(name)                             \
+    name = cast(PFN_##name) vkGetDeviceProcAddr(device, #name); \
+    LoaderCheckFunction(cast(PFN_vkVoidFunction) name, #name);
+    LoaderDeviceFunctions(LoaderLoadDeviceFunction)
+#undef LoaderLoadDeviceFunction
+}
+
+void LoaderShutdown(void) {
+    if (LoaderLibrary) {
+        SystemUnloadLibrary(LoaderLibrary);
+        LoaderLibrary = NULL;
+    }
+}
+
+uint64_t LoaderGetDispatchCount(void) {
+#if defined(VULKAN_COUNT_DISPATCHES)
+    return atomic_load_explicit(&LoaderDispatchCount, memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,222 @@
+#pragma once
+
+// Included from Common.h right after vulkan.h, which is included with VK_NO_PROTOTYPES. Every Vulkan function the
+// renderer calls is a global pointer with the function's own name, so call sites look exactly like static linking.
+// The library is opened at runtime and device functions come from vkGetDeviceProcAddr, which points them straight
+// at the driver instead of at the loader's trampolines that look the dispatch table up on every call.
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LoaderGlobalFunctions(X)              \
+    X(vkEnumerateInstanceVersion)             \
+    X(vkEnumerateInstanceLayerProperties)     \
+    X(vkEnumerateInstanceExtensionProperties) \
+    X(vkCreateInstance)
+
+#define LoaderInstanceFunctions(X)               \
+    X(vkDestroyInstance)                         \
+    X(vkEnumeratePhysicalDevices)                \
+    X(vkEnumerateDeviceExtensionProperties)      \
+    X(vkEnumerateDeviceLayerProperties)          \
+    X(vkGetPhysicalDeviceProperties)             \
+    X(vkGetPhysicalDeviceProperties2)            \
+    X(vkGetPhysicalDeviceQueueFamilyProperties)  \
+    X(vkGetPhysicalDeviceMemoryProperties)       \
+    X(vkGetPhysicalDeviceMemoryProperties2)      \
+    X(vkGetPhysicalDeviceFormatProperties)       \
+    X(vkGetPhysicalDeviceFeatures2)              \
+    X(vkGetPhysicalDeviceSurfaceSupportKHR)      \
+    X(vkGetPhysicalDeviceSurfaceCapabilitiesKHR) \
+    X(vkGetPhysicalDeviceSurfaceFormatsKHR)      \
+    X(vkGetPhysicalDeviceSurfacePresentModesKHR) \
+    X(vkDestroySurfaceKHR)                       \
+    X(vkCreateDevice)                            \
+    X(vkGetDeviceProcAddr)
+
+#define LoaderDeviceFunctions(X)      \
+    X(vkDestroyDevice)                \
+    X(vkGetDeviceQueue)               \
+    X(vkQueueSubmit)                  \
+    X(vkQueueWaitIdle)                \
+    X(vkQueuePresentKHR)              \
+    X(vkAcquireNextImageKHR)          \
+    X(vkCreateSwapchainKHR)           \
+    X(vkDestroySwapchainKHR)          \
+    X(vkGetSwapchainImagesKHR)        \
+    X(vkAllocateMemory)               \
+    X(vkFreeMemory)                   \
+    X(vkMapMemory)                    \
+    X(vkFlushMappedMemoryRanges)      \
+    X(vkInvalidateMappedMemoryRanges) \
+    X(vkBindBufferMemory)             \
+    X(vkBindImageMemory)              \
+    X(vkGetBufferMemoryRequirements)  \
+    X(vkGetImageMemoryRequirements)   \
+    X(vkCreateBuffer)                 \
+    X(vkDestroyBuffer)                \
+    X(vkCreateImage)                  \
+    X(vkDestroyImage)                 \
+    X(vkCreateImageView)              \
+    X(vkDestroyImageView)             \
+    X(vkCreateSampler)                \
+    X(vkDestroySampler)               \
+    X(vkCreateSemaphore)              \
+    X(vkDestroySemaphore)             \
+    X(vkWaitSemaphores)               \
+    X(vkGetSemaphoreCounterValue)     \
+    X(vkCreateCommandPool)            \
+    X(vkDestroyCommandPool)           \
+    X(vkResetCommandPool)             \
+    X(vkAllocateCommandBuffers)       \
+    X(vkBeginCommandBuffer)           \
+    X(vkEndCommandBuffer)             \
+    X(vkCreateQueryPool)              \
+    X(vkDestroyQueryPool)             \
+    X(vkGetQueryPoolResults)          \
+    X(vkCreatePipelineCache)          \
+    X(vkDestroyPipelineCache)         \
+    X(vkGetPipelineCacheData)         \
+    X(vkCreateShaderModule)           \
+    X(vkDestroyShaderModule)          \
+    X(vkCreatePipelineLayout)         \
+    X(vkDestroyPipelineLayout)        \
+    X(vkCreateComputePipelines)       \
+    X(vkCreateGraphicsPipelines)      \
+    X(vkDestroyPipeline)              \
+    X(vkCreateDescriptorSetLayout)    \
+    X(vkDestroyDescriptorSetLayout)   \
+    X(vkCreateDescriptorPool)         \
+    X(vkDestroyDescriptorPool)        \
+    X(vkResetDescriptorPool)          \
+    X(vkAllocateDescriptorSets)       \
+    X(vkUpdateDescriptorSets)         \
+    X(vkCmdBindPipeline)              \
+    X(vkCmdBindDescriptorSets)        \
+    X(vkCmdBindIndexBuffer)           \
+    X(vkCmdPushConstants)             \
+    X(vkCmdDispatch)                  \
+    X(vkCmdDraw)                      \
+    X(vkCmdDrawIndexed)               \
+    X(vkCmdDrawIndexedIndirect)       \
+    X(vkCmdDrawIndexedIndirectCount)  \
+    X(vkCmdCopyBuffer)                \
+    X(vkCmdCopyBufferToImage)         \
+    X(vkCmdCopyImageToBuffer)         \
+    X(vkCmdBlitImage)                 \
+    X(vkCmdFillBuffer)                \
+    X(vkCmdClearColorImage)           \
+    X(vkCmdPipelineBarrier)           \
+    X(vkCmdExecuteCommands)           \
+    X(vkCmdSetViewport)               \
+    X(vkCmdSetScissor)                \
+    X(vkCmdResetQueryPool)            \
+    X(vkCmdWriteTimestamp)
+
+#define LoaderDeclareFunction(name) extern PFN_##name name;
+extern PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr;
+LoaderGlobalFunctions(LoaderDeclareFunction)
+LoaderInstanceFunctions(LoaderDeclareFunction)
+LoaderDeviceFunctions(LoaderDeclareFunction)
+#undef LoaderDeclareFunction
+
+// Opens the Vulkan library and loads vkGetInstanceProcAddr and the global functions, returns false if there's no
+// Vulkan library on the system
+bool LoaderInit(void);
+void LoaderLoadInstance(VkInstance instance);
+// Only one device is supported, its functions replace whatever was loaded before
+void LoaderLoadDevice(VkDevice device);
+void LoaderShutdown(void);
+
+// How many device-level calls have been made so far, always 0 unless built with VULKAN_COUNT_DISPATCHES
+uint64_t LoaderGetDispatchCount(void);
+
+#if defined(VULKAN_COUNT_DISPATCHES) && !defined(LoaderImplementation)
+    #include <stdatomic.h>
+
+extern atomic_uint_least64_t LoaderDispatchCount;
+
+static inline void LoaderCountDispatch(void) {
+    atomic_fetch_add_explicit(&LoaderDispatchCount, 1, memory_order_relaxed);
+}
+
+    // Every device function name becomes an expression that counts the call and then evaluates to the function
+    // pointer, so call sites stay unchanged. Has to list the same functions as LoaderDeviceFunctions.
+    #define vkDestroyDevice                (LoaderCountDispatch(), vkDestroyDevice)
+    #define vkGetDeviceQueue               (LoaderCountDispatch(), vkGetDeviceQueue)
+    #define vkQueueSubmit                  (LoaderCountDispatch(), vkQueueSubmit)
+    #define vkQueueWaitIdle                (LoaderCountDispatch(), vkQueueWaitIdle)
+    #define vkQueuePresentKHR              (LoaderCountDispatch(), vkQueuePresentKHR)
+    #define vkAcquireNextImageKHR          (LoaderCountDispatch(), vkAcquireNextImageKHR)
+    #define vkCreateSwapchainKHR           (LoaderCountDispatch(), vkCreateSwapchainKHR)
+    #define vkDestroySwapchainKHR          (LoaderCountDispatch(), vkDestroySwapchainKHR)
+    #define vkGetSwapchainImagesKHR        (LoaderCountDispatch(), vkGetSwapchainImagesKHR)
+    #define vkAllocateMemory               (LoaderCountDispatch(), vkAllocateMemory)
+    #define vkFreeMemory                   (LoaderCountDispatch(), vkFreeMemory)
+    #define vkMapMemory                    (LoaderCountDispatch(), vkMapMemory)
+    #define vkFlushMappedMemoryRanges      (LoaderCountDispatch(), vkFlushMappedMemoryRanges)
+    #define vkInvalidateMappedMemoryRanges (LoaderCountDispatch(), vkInvalidateMappedMemoryRanges)
+    #define vkBindBufferMemory             (LoaderCountDispatch(), vkBindBufferMemory)
+    #define vkBindImageMemory              (LoaderCountDispatch(), vkBindImageMemory)
+    #define vkGetBufferMemoryRequirements  (LoaderCountDispatch(), vkGetBufferMemoryRequirements)
+    #define vkGetImageMemoryRequirements   (LoaderCountDispatch(), vkGetImageMemoryRequirements)
+    #define vkCreateBuffer                 (LoaderCountDispatch(), vkCreateBuffer)
+    #define vkDestroyBuffer                (LoaderCountDispatch(), vkDestroyBuffer)
+    #define vkCreateImage                  (LoaderCountDispatch(), vkCreateImage)
+    #define vkDestroyImage                 (LoaderCountDispatch(), vkDestroyImage)
+    #define vkCreateImageView              (LoaderCountDispatch(), vkCreateImageView)
+    #define vkDestroyImageView             (LoaderCountDispatch(), vkDestroyImageView)
+    #define vkCreateSampler                (LoaderCountDispatch(), vkCreateSampler)
+    #define vkDestroySampler               (LoaderCountDispatch(), vkDestroySampler)
+    #define vkCreateSemaphore              (LoaderCountDispatch(), vkCreateSemaphore)
+    #define vkDestroySemaphore             (LoaderCountDispatch(), vkDestroySemaphore)
+    #define vkWaitSemaphores               (LoaderCountDispatch(), vkWaitSemaphores)
+    #define vkGetSemaphoreCounterValue     (LoaderCountDispatch(), vkGetSemaphoreCounterValue)
+    #define vkCreateCommandPool            (LoaderCountDispatch(), vkCreateCommandPool)
+    #define vkDestroyCommandPool           (LoaderCountDispatch(), vkDestroyCommandPool)
+    #define vkResetCommandPool             (LoaderCountDispatch(), vkResetCommandPool)
+    #define vkAllocateCommandBuffers       (LoaderCountDispatch(), vkAllocateCommandBuffers)
+    #define vkBeginCommandBuffer           (LoaderCountDispatch(), vkBeginCommandBuffer)
+    #define vkEndCommandBuffer             (LoaderCountDispatch(), vkEndCommandBuffer)
+    #define vkCreateQueryPool              (LoaderCountDispatch(), vkCreateQueryPool)
+    #define vkDestroyQueryPool             (LoaderCountDispatch(), vkDestroyQueryPool)
+    #define vkGetQueryPoolResults          (LoaderCountDispatch(), vkGetQueryPoolResults)
+    #define vkCreatePipelineCache          (LoaderCountDispatch(), vkCreatePipelineCache)
+    #define vkDestroyPipelineCache         (LoaderCountDispatch(), vkDestroyPipelineCache)
+    #define vkGetPipelineCacheData         (LoaderCountDispatch(), vkGetPipelineCacheData)
+    #define vkCreateShaderModule           (LoaderCountDispatch(), vkCreateShaderModule)
+    #define vkDestroyShaderModule          (LoaderCountDispatch(), vkDestroyShaderModule)
+    #define vkCreatePipelineLayout         (LoaderCountDispatch(), vkCreatePipelineLayout)
+    #define vkDestroyPipelineLayout        (LoaderCountDispatch(), vkDestroyPipelineLayout)
+    #define vkCreateComputePipelines       (LoaderCountDispatch(), vkCreateComputePipelines)
+    #define vkCreateGraphicsPipelines      (LoaderCountDispatch(), vkCreateGraphicsPipelines)
+    #define vkDestroyPipeline              (LoaderCountDispatch(), vkDestroyPipeline)
+    #define vkCreateDescriptorSetLayout    (LoaderCountDispatch(), vkCreateDescriptorSetLayout)
+    #define vkDestroyDescriptorSetLayout   (LoaderCountDispatch(), vkDestroyDescriptorSetLayout)
+    #define vkCreateDescriptorPool         (LoaderCountDispatch(), vkCreateDescriptorPool)
+    #define vkDestroyDescriptorPool        (LoaderCountDispatch(), vkDestroyDescriptorPool)
+    #define vkResetDescriptorPool          (LoaderCountDispatch(), vkResetDescriptorPool)
+    #define vkAllocateDescriptorSets       (LoaderCountDispatch(), vkAllocateDescriptorSets)
+    #define vkUpdateDescriptorSets         (LoaderCountDispatch(), vkUpdateDescriptorSets)
+    #define vkCmdBindPipeline              (LoaderCountDispatch(), vkCmdBindPipeline)
+    #define vkCmdBindDescriptorSets        (LoaderCountDispatch(), vkCmdBindDescriptorSets)
+    #define vkCmdBindIndexBuffer           (LoaderCountDispatch(), vkCmdBindIndexBuffer)
+    #define vkCmdPushConstants             (LoaderCountDispatch(), vkCmdPushConstants)
+    #define vkCmdDispatch                  (LoaderCountDispatch(), vkCmdDispatch)
+    #define vkCmdDraw                      (LoaderCountDispatch(), vkCmdDraw)
+    #define vkCmdDrawIndexed               (LoaderCountDispatch(), vkCmdDrawIndexed)
+    #define vkCmdDrawIndexedIndirect       (LoaderCountDispatch(), vkCmdDrawIndexedIndirect)
+    #define vkCmdDrawIndexedIndirectCount  (LoaderCountDispatch(), vkCmdDrawIndexedIndirectCount)
+    #define vkCmdCopyBuffer                (LoaderCountDispatch(), vkCmdCopyBuffer)
+    #define vkCmdCopyBufferToImage         (LoaderCountDispatch(), vkCmdCopyBufferToImage)
+    #define vkCmdCopyImageToBuffer         (LoaderCountDispatch(), vkCmdCopyImageToBuffer)
+    #define vkCmdBlitImage                 (LoaderCountDispatch(), vkCmdBlitImage)
+    #define vkCmdFillBuffer                (LoaderCountDispatch(), vkCmdFillBuffer)
+    #define vkCmdClearColorImage           (LoaderCountDispatch(), vkCmdClearColorImage)
+    #define vkCmdPipelineBarrier           (LoaderCountDispatch(), vkCmdPipelineBarrier)
+    #define vkCmdExecuteCommands           (LoaderCountDispatch(), vkCmdExecuteCommands)
+    #define vkCmdSetViewport               (LoaderCountDispatch(), vkCmdSetViewport)
+    #define vkCmdSetScissor                (LoaderCountDispatch(), vkCmdSetScissor)
+    #define vkCmdResetQueryPool            (LoaderCountDispatch(), vkCmdResetQueryPool)
+    #define vkCmdWriteTimestamp            (LoaderCountDispatch(), vkCmdWriteTimestamp)
+#endif
@@ -0,0 +1,228 @@
+#include "Logger.h"
+
+static_assert((LoggerCapacity & (LoggerCapacity - 1)) == 0, "LoggerCapacity must be a power of two");
+static_assert((LoggerMaxTrackedIds & (LoggerMaxTrackedIds - 1)) == 0, "LoggerMaxTrackedIds must be a power of two");
+
+static const char* LoggerSeverityName(VkDebugUtilsMessageSeverityFlagBitsEXT severity) {
+    return (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT)   ? "Verbose"
+           : (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT)    ? "Info"
+           : (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) ? "Warning"
+           : (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)   ? "Error"
+                                                                          : "Unknown Type";
+}
+
+static uint64_t LoggerHash(const char* message) {
+    uint64_t hash = 14695981039346656037ull;
+    for (const char* c = message; *c; c++) {
+        hash = (hash ^ cast(uint8_t)(*c)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// Returns NULL once every slot is taken, messages with new IDs then go through unfiltered
+static LoggerIdState* LoggerFindId(Logger* logger, int32_t messageId) {
+    uint64_t key   = cast(uint64_t) cast(uint32_t) messageId + 1;
+    uint32_t index = (cast(uint32_t) messageId * 2654435761u) & (LoggerMaxTrackedIds - 1);
+    for (uint32_t probe = 0; probe < LoggerMaxTrackedIds; probe++) {
+        LoggerIdState* state    = &logger->Ids[(index + probe) & (LoggerMaxTrackedIds - 1)];
+        uint_least64_t existing = atomic_load_explicit(&state->Key, memory_order_acquire);
+        if (existing == 0 && atomic_compare_exchange_strong(&state->Key, &existing, key)) {
+            return state;
+        }
+        if (existing == key) {
+            return state;
+        }
+    }
+    return NULL;
+}
+
+static void LoggerWrite(const LoggerEntry* entry) {
+    if (entry->Suppressed > 0) {
+        fprintf(stderr,
+                "%s: %s (%u similar messages suppressed)\n",
+                LoggerSeverityName(entry->Severity),
+                entry->Message,
+                entry->Suppressed);
+    } else {
+        fprintf(stderr, "%s: %s\n", LoggerSeverityName(entry->Severity), entry->Message);
+    }
+}
+
+static void LoggerThread(void* userData) {
+    Logger* logger  = userData;
+    size_t position = 0;
+    for (;;) {
+        LoggerEntry* entry = &logger->Entries[position & (LoggerCapacity - 1)];
+        if (atomic_load_explicit(&entry->Sequence, memory_order_acquire) == position + 1) {
+            // Keeps stdout and stderr ordered the same way the synchronous callback did
+            fflush(stdout);
+            do {
+                LoggerWrite(entry);
+                atomic_fetch_add_explicit(&logger->Written, 1, memory_order_relaxed);
+                atomic_store_explicit(&entry->Sequence, position + LoggerCapacity, memory_order_release);
+                position++;
+                entry = &logger->Entries[position & (LoggerCapacity - 1)];
+            } while (atomic_load_explicit(&entry->Sequence, memory_order_acquire) == position + 1);
+            atomic_store_explicit(&logger->DequeuePosition, position, memory_order_release);
+            continue;
+        }
+        if (atomic_load(&logger->Stopping)) {
+            return;
+        }
+
+        // Producers only take the mutex when they see the flag, checking the ring again after setting it means
+        // either this thread sees the new entry or the producer sees the flag
+        SystemMutexLock(&logger->Mutex);
+        SystemConditionVariableBroadcast(&logger->Drained);
+        atomic_store(&logger->WriterSleeping, true);
+        if (atomic_load(&entry->Sequence) != position + 1 && !atomic_load(&logger->Stopping)) {
+            SystemConditionVariableWait(&logger->WorkAvailable, &logger->Mutex);
+        }
+        atomic_store(&logger->WriterSleeping, false);
+        SystemMutexUnlock(&logger->Mutex);
+    }
+}
+
+Logger* LoggerCreate(void) {
+    Logger* logger = calloc(1, sizeof(Logger));
+    if (logger == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate the logger!\n");
+        exit(1);
+    }
+    logger->Entries = calloc(LoggerCapacity, sizeof(LoggerEntry));
+    if (logger->Entries == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate the logger's ring!\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < LoggerCapacity; i++) {
+        atomic_init(&logger->Entries[i].Sequence, i);
+    }
+    SystemMutexInit(&logger->Mutex);
+    SystemConditionVariableInit(&logger->WorkAvailable);
+    SystemConditionVariableInit(&logger->Drained);
+    SystemThreadCreate(&logger->Thread, LoggerThread, logger);
+    return logger;
+}
+
+void LoggerDestroy(Logger* logger) {
+    SystemMutexLock(&logger->Mutex);
+    atomic_store(&logger->Stopping, true);
+    SystemConditionVariableSignal(&logger->WorkAvailable);
+    SystemMutexUnlock(&logger->Mutex);
+    SystemThreadJoin(&logger->Thread);
+
+    SystemConditionVariableDestroy(&logger->Drained);
+    SystemConditionVariableDestroy(&logger->WorkAvailable);
+    SystemMutexDestroy(&logger->Mutex);
+    free(logger->Entries);
+    free(logger);
+}
+
+void LoggerSubmit(Logger* logger,
+                  VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+                  VkDebugUtilsMessageTypeFlagsEXT types,
+                  int32_t messageId,
+                  const char* message) {
+    atomic_fetch_add_explicit(&logger->Received, 1, memory_order_relaxed);
+
+    uint32_t suppressed  = 0;
+    LoggerIdState* state = LoggerFindId(logger, messageId);
+    if (state) {
+        // The window reset races with other threads counting in it, that only makes the limit approximate
+        uint64_t now         = SystemGetTimeNanoseconds();
+        uint_least64_t start = atomic_load_explicit(&state->WindowStart, memory_order_relaxed);
+        if (now - start >= LoggerRateWindowNs &&
+            atomic_compare_exchange_strong_explicit(&state->WindowStart, &start, now, memory_order_relaxed, memory_order_relaxed)) {
+            atomic_store_explicit(&state->CountInWindow, 0, memory_order_relaxed);
+            atomic_store_explicit(&state->LastHash, 0, memory_order_relaxed);
+        }
+
+        uint64_t hash = LoggerHash(message);
+        if (atomic_exchange_explicit(&state->LastHash, hash, memory_order_relaxed) == hash) {
+            atomic_fetch_add_explicit(&logger->Duplicates, 1, memory_order_relaxed);
+            atomic_fetch_add_explicit(&state->Suppressed, 1, memory_order_relaxed);
+            return;
+        }
+        if (atomic_fetch_add_explicit(&state->CountInWindow, 1, memory_order_relaxed) >= LoggerRateLimit) {
+            atomic_fetch_add_explicit(&logger->RateLimited, 1, memory_order_relaxed);
+            atomic_fetch_add_explicit(&state->Suppressed, 1, memory_order_relaxed);
+            return;
+        }
+        suppressed = atomic_exchange_explicit(&state->Suppressed, 0, memory_order_relaxed);
+    }
+
+    LoggerEntry* entry = NULL;
+    size_t position    = atomic_load_explicit(&logger->EnqueuePosition, memory_order_relaxed);
+    for (;;) {
+        entry             = &logger->Entries[position & (LoggerCapacity - 1)];
+        size_t sequence   = atomic_load_explicit(&entry->Sequence, memory_order_acquire);
+        intptr_t distance = cast(intptr_t) sequence - cast(intptr_t) position;
+        if (distance == 0) {
+            if (atomic_compare_exchange_weak_explicit(
+                    &logger->EnqueuePosition, &position, position + 1, memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (distance < 0) {
+            // The writer is too far behind, blocking here would stall the driver thread that reported the message
+            atomic_fetch_add_explicit(&logger->Dropped, 1, memory_order_relaxed);
+            if (state) {
+                atomic_fetch_add_explicit(&state->Suppressed, suppressed, memory_order_relaxed);
+            }
+            return;
+        } else {
+            position = atomic_load_explicit(&logger->EnqueuePosition, memory_order_relaxed);
+        }
+    }
+
+    entry->Severity   = severity;
+    entry->Types      = types;
+    entry->MessageId  = messageId;
+    entry->Suppressed = suppressed;
+    size_t length     = strlen(message);
+    if (length >= LoggerMaxMessageLength) {
+        length = LoggerMaxMessageLength - 4;
+        memcpy(entry->Message + length, "...", 4);
+    } else {
+        entry->Message[length] = '\0';
+    }
+    memcpy(entry->Message, message, length);
+    atomic_store(&entry->Sequence, position + 1);
+
+    if (atomic_load(&logger->WriterSleeping)) {
+        SystemMutexLock(&logger->Mutex);
+        SystemConditionVariableSignal(&logger->WorkAvailable);
+        SystemMutexUnlock(&logger->Mutex);
+    }
+}
+
+void LoggerFlush(Logger* logger) {
+    size_t target = atomic_load(&logger->EnqueuePosition);
+    SystemMutexLock(&logger->Mutex);
+    while (atomic_load_explicit(&logger->DequeuePosition, memory_order_acquire) < target) {
+        SystemConditionVariableWait(&logger->Drained, &logger->Mutex);
+    }
+    SystemMutexUnlock(&logger->Mutex);
+}
+
+LoggerStats LoggerGetStats(Logger* logger) {
+    return (LoggerStats){
+        .Received    = atomic_load_explicit(&logger->Received, memory_order_relaxed),
+        .Written     = atomic_load_explicit(&logger->Written, memory_order_relaxed),
+        .Dropped     = atomic_load_explicit(&logger->Dropped, memory_order_relaxed),
+        .Duplicates  = atomic_load_explicit(&logger->Duplicates, memory_order_relaxed),
+        .RateLimited = atomic_load_explicit(&logger->RateLimited, memory_order_relaxed),
+    };
+}
+
+void LoggerPrintStats(Logger* logger) {
+    LoggerStats stats = LoggerGetStats(logger);
+    printf("Logged %llu of %llu debug messages, %llu dropped with the ring full, %llu duplicates and %llu over the rate "
+           "limit suppressed\n",
+           cast(unsigned long long) stats.Written,
+           cast(unsigned long long) stats.Received,
+           cast(unsigned long long) stats.Dropped,
+           cast(unsigned long long) stats.Duplicates,
+           cast(unsigned long long) stats.RateLimited);
+}
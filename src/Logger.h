@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Common.h"
+#include "System.h"
+
+#include <stdatomic.h>
+
+#define LoggerCapacity         256
+#define LoggerMaxMessageLength 2048
+#define LoggerMaxTrackedIds    256
+// Messages with the same ID beyond this many per window are suppressed until the window ends
+#define LoggerRateLimit        8
+#define LoggerRateWindowNs     1000000000ull
+
+typedef struct LoggerEntry {
+    // Vyukov-style sequence number, tells producers and the consumer whose turn the entry is
+    atomic_size_t Sequence;
+    VkDebugUtilsMessageSeverityFlagBitsEXT Severity;
+    VkDebugUtilsMessageTypeFlagsEXT Types;
+    int32_t MessageId;
+    // How many messages with this ID were suppressed since the last one that got through
+    uint32_t Suppressed;
+    char Message[LoggerMaxMessageLength];
+} LoggerEntry;
+
+// Open addressed, entries are claimed by the first message with the ID and never released
+typedef struct LoggerIdState {
+    // The message ID plus one in the low bits, 0 while the slot is unclaimed
+    atomic_uint_least64_t Key;
+    atomic_uint_least64_t WindowStart;
+    atomic_uint CountInWindow;
+    atomic_uint Suppressed;
+    atomic_uint_least64_t LastHash;
+} LoggerIdState;
+
+typedef struct LoggerStats {
+    uint64_t Received;
+    uint64_t Written;
+    uint64_t Dropped;
+    uint64_t Duplicates;
+    uint64_t RateLimited;
+} LoggerStats;
+
+// Takes messages from any thread without locking and writes them to stderr from a background thread, so threads
+// reporting validation or performance messages never wait on stdio. Repeats of the last message with an ID are
+// dropped as duplicates within the rate window, and IDs sending more than LoggerRateLimit messages per window are
+// suppressed, the next message that gets through says how many were skipped. When the ring is full messages are
+// dropped instead of blocking the driver thread.
+typedef struct Logger {
+    LoggerEntry* Entries;
+    atomic_size_t EnqueuePosition;
+    // Only written by the writer thread, atomic so LoggerFlush can watch it
+    atomic_size_t DequeuePosition;
+    LoggerIdState Ids[LoggerMaxTrackedIds];
+
+    atomic_uint_least64_t Received;
+    atomic_uint_least64_t Written;
+    atomic_uint_least64_t Dropped;
+    atomic_uint_least64_t Duplicates;
+    atomic_uint_least64_t RateLimited;
+
+    // Only taken to put the writer thread to sleep and to wake it up again
+    SystemMutex Mutex;
+    SystemConditionVariable WorkAvailable;
+    SystemConditionVariable Drained;
+    atomic_bool WriterSleeping;
+    atomic_bool Stopping;
+    SystemThread Thread;
+} Logger;
+
+Logger* LoggerCreate(void);
+// Writes out everything still queued before returning
+void LoggerDestroy(Logger* logger);
+
+// Safe to call from any thread, copies the message and never blocks
+void LoggerSubmit(Logger* logger,
+                  VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+                  VkDebugUtilsMessageTypeFlagsEXT types,
+                  int32_t messageId,
+                  const char* message);
+
+// Waits until everything submitted before the call has been written
+void LoggerFlush(Logger* logger);
+
+LoggerStats LoggerGetStats(Logger* logger);
+void LoggerPrintStats(Logger* logger);
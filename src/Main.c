@@ -1,111 +1,539 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <stdbool.h>
-#include <string.h>
-#include <assert.h>
-
-#define VK_USE_PLATFORM_WIN32_KHR
-#include <vulkan/vulkan.h>
-
-#define cast(type) (type)
-
-#define VkCheck(result)                                        \
-    do {                                                       \
-        VkResult _result = result;                             \
-        if (_result != VK_SUCCESS) {                           \
-            fflush(stdout);                                    \
-            fprintf(stderr, #result " failed! %x\n", _result); \
-            exit(1);                                           \
-        }                                                      \
-    } while (0)
-
+#include "Common.h"
+#include "Platform.h"
+#include "System.h"
+#include "Profiler.h"
+#include "HostAllocator.h"
+#include "DeviceAllocator.h"
+#include "MemoryBudget.h"
+#include "PipelineCache.h"
+#include "PipelineManager.h"
+#include "CommandRecorder.h"
+#include "Uploader.h"
+#include "Compute.h"
+#include "Culling.h"
+#include "SpriteBatch.h"
+#include "TextureStreamer.h"
+#include "FrameCapture.h"
+#include "Bindless.h"
+#include "Shader.h"
+#include "Timeline.h"
+#include "Present.h"
+#include "Swapchain.h"
+#include "RenderGraph.h"
+#include "Logger.h"
+#include "DebugUtils.h"
+
+#include <ctype.h>
+#include <math.h>
+
+#if defined(VULKAN_DEBUG)
+// Runs on whichever thread the driver or a layer reports from, so it only hands the message to the logger
 VkBool32 VKAPI_CALL DebugMessengerCallback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
                                            VkDebugUtilsMessageTypeFlagsEXT messageTypes,
                                            const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
                                            void* pUserData) {
-    const char* flagString = (messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT)   ? "Verbose"
-                             : (messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT)    ? "Info"
-                             : (messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) ? "Warning"
-                             : (messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)   ? "Error"
-                                                                                                   : "Unknown Type";
-    (void)messageTypes;
-    (void)pUserData;
-    fflush(stdout);
-    fprintf(stderr, "%s: %s\n", flagString, pCallbackData->pMessage);
+    LoggerSubmit(pUserData, messageSeverity, messageTypes, pCallbackData->messageIdNumber, pCallbackData->pMessage);
     return VK_TRUE;
 }
+#endif
+
+static bool HasInstanceExtension(const char* layerName, const char* extensionName) {
+    uint32_t availableInstanceExtensionCount = 0;
+    VkCheck(vkEnumerateInstanceExtensionProperties(layerName, &availableInstanceExtensionCount, NULL));
+    VkExtensionProperties availableInstanceExtensions[availableInstanceExtensionCount];
+    VkCheck(vkEnumerateInstanceExtensionProperties(layerName, &availableInstanceExtensionCount, availableInstanceExtensions));
+    for (uint32_t i = 0; i < availableInstanceExtensionCount; i++) {
+        if (strcmp(extensionName, availableInstanceExtensions[i].extensionName) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
 
-static bool Running = true;
+static bool HasDeviceExtension(VkPhysicalDevice physicalDevice, const char* extensionName) {
+    uint32_t availableDeviceExtensionCount = 0;
+    VkCheck(vkEnumerateDeviceExtensionProperties(physicalDevice, NULL, &availableDeviceExtensionCount, NULL));
+    VkExtensionProperties availableDeviceExtensions[availableDeviceExtensionCount];
+    VkCheck(vkEnumerateDeviceExtensionProperties(physicalDevice, NULL, &availableDeviceExtensionCount, availableDeviceExtensions));
+    for (uint32_t i = 0; i < availableDeviceExtensionCount; i++) {
+        if (strcmp(extensionName, availableDeviceExtensions[i].extensionName) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+typedef struct FrameData {
+    VkCommandPool commandPool;
+    VkCommandBuffer commandBuffer;
+    // Binary because the swapchain can't use timeline semaphores
+    VkSemaphore imageAvailableSemaphore;
+    // The graphics timeline value the slot's last submission signals
+    uint64_t timelineValue;
+} FrameData;
+
+typedef struct StateItemsData {
+    uint32_t width;
+    uint32_t height;
+} StateItemsData;
+
+// Stand-in for per-draw state until there is real geometry, lets --record-items measure how
+// recording time scales with --record-threads
+static void RecordStateItems(VkCommandBuffer commandBuffer, uint32_t firstItem, uint32_t itemCount, void* userData) {
+    const StateItemsData* data = userData;
+    for (uint32_t item = firstItem; item < firstItem + itemCount; item++) {
+        uint32_t x = item % data->width;
+        uint32_t y = item / data->width % data->height;
+        vkCmdSetViewport(commandBuffer,
+                         0,
+                         1,
+                         &(VkViewport){
+                             .x        = cast(float) x,
+                             .y        = cast(float) y,
+                             .width    = cast(float)(data->width - x),
+                             .height   = cast(float)(data->height - y),
+                             .minDepth = 0.0f,
+                             .maxDepth = 1.0f,
+                         });
+        vkCmdSetScissor(commandBuffer,
+                        0,
+                        1,
+                        &(VkRect2D){
+                            .offset = { .x = cast(int32_t) x, .y = cast(int32_t) y },
+                            .extent = { .width = data->width - x, .height = data->height - y },
+                        });
+    }
+}
+
+typedef struct ClearPassData {
+    Profiler* profiler;
+    uint32_t phase;
+    RenderGraphResource target;
+} ClearPassData;
+
+static void RecordClearPass(VkCommandBuffer commandBuffer, RenderGraph* graph, void* userData) {
+    const ClearPassData* data = userData;
+    ProfilerBeginGpuPass(data->profiler, commandBuffer, data->phase);
+    vkCmdClearColorImage(commandBuffer,
+                         RenderGraphGetImage(graph, data->target),
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                         &(VkClearColorValue){
+                             .float32 = { 1.0f, 0.0f, 0.0f, 1.0f },
+                         },
+                         1,
+                         &(VkImageSubresourceRange){
+                             .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+                             .baseMipLevel   = 0,
+                             .levelCount     = 1,
+                             .baseArrayLayer = 0,
+                             .layerCount     = 1,
+                         });
+    ProfilerEndGpuPass(data->profiler, commandBuffer, data->phase);
+}
+
+// --render-scale draws the clear and the culled objects into a smaller transient image, this blits it over the
+// whole backbuffer before the sprites are drawn on top at full resolution
+typedef struct UpscalePassData {
+    Profiler* profiler;
+    uint32_t phase;
+    RenderGraphResource source;
+    RenderGraphResource destination;
+    VkExtent2D sourceExtent;
+    VkExtent2D destinationExtent;
+    VkFilter filter;
+} UpscalePassData;
+
+static void RecordUpscalePass(VkCommandBuffer commandBuffer, RenderGraph* graph, void* userData) {
+    const UpscalePassData* data                = userData;
+    const VkImageSubresourceLayers Subresource = {
+        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .layerCount = 1,
+    };
+    VkOffset3D sourceEnd      = { cast(int32_t) data->sourceExtent.width, cast(int32_t) data->sourceExtent.height, 1 };
+    VkOffset3D destinationEnd = { cast(int32_t) data->destinationExtent.width, cast(int32_t) data->destinationExtent.height, 1 };
+    ProfilerBeginGpuPass(data->profiler, commandBuffer, data->phase);
+    vkCmdBlitImage(commandBuffer,
+                   RenderGraphGetImage(graph, data->source),
+                   VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                   RenderGraphGetImage(graph, data->destination),
+                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                   1,
+                   &(VkImageBlit){
+                       .srcSubresource = Subresource,
+                       .srcOffsets     = { {}, sourceEnd },
+                       .dstSubresource = Subresource,
+                       .dstOffsets     = { {}, destinationEnd },
+                   },
+                   data->filter);
+    ProfilerEndGpuPass(data->profiler, commandBuffer, data->phase);
+}
+
+// Stand-in for GPU-side preprocessing, Fill.comp fills a buffer that graphics then reads from. The buffer comes from
+// the bindless storage buffer array.
+typedef struct FillPushConstants {
+    uint32_t count;
+    uint32_t seed;
+    uint32_t bufferIndex;
+} FillPushConstants;
+
+// How many of the filled values graphics copies back to check the compute results
+#define ComputeReadbackCount 16
+
+// How long the loop idles between attempts to acquire while the window has no area
+#define MinimizedSleepMilliseconds 10
+
+// Cap on what one --defragment-every pass copies, so it never takes much of a frame
+#define DefragmentMaxBytes (4ull * 1024 * 1024)
+
+typedef struct ReadbackPassData {
+    RenderGraphResource source;
+    RenderGraphResource destination;
+} ReadbackPassData;
+
+static void RecordReadbackPass(VkCommandBuffer commandBuffer, RenderGraph* graph, void* userData) {
+    const ReadbackPassData* data = userData;
+    vkCmdCopyBuffer(commandBuffer,
+                    RenderGraphGetBuffer(graph, data->source),
+                    RenderGraphGetBuffer(graph, data->destination),
+                    1,
+                    &(VkBufferCopy){
+                        .size = ComputeReadbackCount * sizeof(uint32_t),
+                    });
+}
 
-LRESULT CALLBACK WindowMessageCallback(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) {
-    LRESULT result = 0;
-    switch (message) {
-        case WM_CLOSE: {
-            Running = false;
-        } break;
+// --cull-objects scatters objects over a square world with about this much room each, the camera sees
+// CullingViewHeight units of it and circles around so the visible set changes every frame
+#define CullingObjectSpacing 2.0f
+#define CullingViewHeight    40.0f
 
-        default: {
-            result = DefWindowProcA(hWnd, message, wParam, lParam);
-        } break;
+static CullingObject* GenerateCullingObjects(uint32_t count, float worldHalfExtent) {
+    CullingObject* objects = malloc(count * sizeof(CullingObject));
+    if (objects == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate the culling test objects!\n");
+        exit(1);
     }
-    return result;
+    uint32_t state = 12345;
+    for (uint32_t i = 0; i < count; i++) {
+        float random[6];
+        for (uint32_t j = 0; j < 6; j++) {
+            state     = state * 1664525u + 1013904223u;
+            random[j] = cast(float)(state >> 8) / cast(float)(1u << 24);
+        }
+        objects[i] = (CullingObject){
+            .Sphere       = { (random[0] * 2.0f - 1.0f) * worldHalfExtent, (random[1] * 2.0f - 1.0f) * worldHalfExtent, 0.5f,
+                              0.2f + random[2] * 0.6f },
+            .Color        = { random[3], random[4], random[5], 1.0f },
+            .IndexCount   = CullingQuadIndexCount,
+            .FirstIndex   = 0,
+            .VertexOffset = 0,
+        };
+    }
+    return objects;
 }
 
-int main() {
-    const size_t WindowWidth          = 640;
-    const size_t WindowHeight         = 480;
-    const char* const WindowClassName = "Vulkan Testing";
-    const char* const WindowTitle     = "Vulkan Testing";
-    HINSTANCE hinstance               = GetModuleHandleA(NULL);
-    HWND windowHandle                 = NULL;
-    {
-        const DWORD WindowStyle   = WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU | WS_VISIBLE;
-        const DWORD WindowStyleEx = 0;
-
-        if (RegisterClassExA(&(WNDCLASSEXA){
-                .cbSize        = sizeof(WNDCLASSEXA),
-                .style         = CS_OWNDC,
-                .lpfnWndProc   = WindowMessageCallback,
-                .hInstance     = hinstance,
-                .hCursor       = LoadCursor(NULL, IDC_ARROW),
-                .lpszClassName = WindowClassName,
-            }) == 0) {
-            fflush(stdout);
-            fprintf(stderr, "Failed to register a window class! %lx\n", GetLastError());
-            exit(1);
+// Column major orthographic projection of the world's z = 0 plane, with the objects' depth of 0.5 mapped to itself
+static void CullingCameraViewProjection(uint64_t frameNumber, VkExtent2D extent, float worldHalfExtent, float viewProjection[16]) {
+    float angle      = cast(float) frameNumber * 0.01f;
+    float centerX    = cosf(angle) * worldHalfExtent * 0.5f;
+    float centerY    = sinf(angle) * worldHalfExtent * 0.5f;
+    float halfHeight = CullingViewHeight * 0.5f;
+    float halfWidth  = halfHeight * cast(float) extent.width / cast(float) extent.height;
+    memset(viewProjection, 0, 16 * sizeof(float));
+    viewProjection[0]  = 1.0f / halfWidth;
+    viewProjection[5]  = 1.0f / halfHeight;
+    viewProjection[10] = 1.0f;
+    viewProjection[12] = -centerX / halfWidth;
+    viewProjection[13] = -centerY / halfHeight;
+    viewProjection[15] = 1.0f;
+}
+
+// --sprites adds the sprites in chunks of this many, spread over SpriteLayerCount layers and every blend mode, so
+// the batch has runs to sort and merge like a UI drawn widget by widget would give it
+#define SpriteChunkSize  1024
+#define SpriteLayerCount 4
+
+static SpriteBatchInstance* GenerateSprites(uint32_t count, uint32_t whiteTexture) {
+    SpriteBatchInstance* sprites = malloc(count * sizeof(SpriteBatchInstance));
+    if (sprites == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate the test sprites!\n");
+        exit(1);
+    }
+    uint32_t state = 54321;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t random[4];
+        for (uint32_t j = 0; j < 4; j++) {
+            state     = state * 1664525u + 1013904223u;
+            random[j] = state >> 8;
         }
+        sprites[i] = (SpriteBatchInstance){
+            .Rect    = { cast(float)(random[0] % 640), cast(float)(random[1] % 480), 4.0f + cast(float)(random[2] % 12),
+                         4.0f + cast(float)(random[3] % 12) },
+            .Uv0     = SpriteBatchPackUv(0.0f, 0.0f),
+            .Uv1     = SpriteBatchPackUv(1.0f, 1.0f),
+            .Color   = SpriteBatchPackColor(cast(uint8_t) random[0], cast(uint8_t) random[1], cast(uint8_t) random[2], 128),
+            .Texture = whiteTexture,
+        };
+    }
+    return sprites;
+}
+
+// Moves every sprite along a circle so the instance data really changes every frame
+static void MoveSprites(const SpriteBatchInstance* sprites, SpriteBatchInstance* moved, uint32_t count, uint64_t frameNumber) {
+    float angle   = cast(float) frameNumber * 0.05f;
+    float offsetX = cosf(angle) * 16.0f;
+    float offsetY = sinf(angle) * 16.0f;
+    for (uint32_t i = 0; i < count; i++) {
+        moved[i] = sprites[i];
+        moved[i].Rect[0] += offsetX;
+        moved[i].Rect[1] += offsetY;
+    }
+}
 
-        RECT windowRect   = {};
-        windowRect.left   = 100;
-        windowRect.right  = windowRect.left + cast(LONG) WindowWidth;
-        windowRect.top    = 100;
-        windowRect.bottom = windowRect.left + cast(LONG) WindowHeight;
-        if (!AdjustWindowRectEx(&windowRect, WindowStyle, false, WindowStyleEx)) {
+static void AddSprites(SpriteBatch* batch, const SpriteBatchInstance* sprites, uint32_t count) {
+    for (uint32_t first = 0, chunk = 0; first < count; first += SpriteChunkSize, chunk++) {
+        SpriteBatchAdd(batch,
+                       chunk % SpriteLayerCount,
+                       cast(SpriteBatchBlend)(chunk / SpriteLayerCount % SpriteBatchBlendCount),
+                       &sprites[first],
+                       count - first < SpriteChunkSize ? count - first : SpriteChunkSize);
+    }
+}
+
+// --textures streams that many generated textures onto the first TexturedSpriteCount sprites, TexturesOnScreen of
+// them at a time. The set moves on every TextureWindowFrames frames and the sprites zoom in and out, so levels are
+// streamed in, dropped and evicted all the time.
+#define StreamedTextureSize        512
+#define StreamedTextureLevels      10
+#define TexturedSpriteCount        64
+#define TexturesOnScreen           8
+#define TextureWindowFrames        32
+#define TextureUploadBytesPerFrame (4ull * 1024 * 1024)
+
+// Every level gets its own tint, so which one is sampled can be seen. Files from an earlier run are reused.
+static bool GenerateStreamedTexture(const char* path, uint32_t seed) {
+    uint64_t modifiedTime = 0;
+    if (SystemGetFileModifiedTime(path, &modifiedTime)) {
+        return true;
+    }
+    uint8_t* levels[StreamedTextureLevels];
+    for (uint32_t level = 0; level < StreamedTextureLevels; level++) {
+        uint32_t size = StreamedTextureSize >> level;
+        levels[level] = malloc(cast(size_t) size * size * 4);
+        if (levels[level] == NULL) {
             fflush(stdout);
-            fprintf(stderr, "Failed to get window rect size! %lx\n", GetLastError());
+            fprintf(stderr, "Failed to allocate the texture levels!\n");
             exit(1);
         }
+        uint32_t checker = size / 8 > 0 ? size / 8 : 1;
+        for (uint32_t y = 0; y < size; y++) {
+            for (uint32_t x = 0; x < size; x++) {
+                uint8_t* texel = &levels[level][(cast(size_t) y * size + x) * 4];
+                bool dark      = (x / checker + y / checker) % 2 == 1;
+                texel[0]       = cast(uint8_t)(dark ? seed * 67 : 255 - level * 20);
+                texel[1]       = cast(uint8_t)(dark ? seed * 131 : 255 - level * 10);
+                texel[2]       = cast(uint8_t)(dark ? seed * 29 : 128 + level * 12);
+                texel[3]       = 255;
+            }
+        }
+    }
+    bool written =
+        TextureStreamerWriteKtx2(path, StreamedTextureSize, StreamedTextureSize, StreamedTextureLevels, cast(const uint8_t* const*) levels);
+    for (uint32_t level = 0; level < StreamedTextureLevels; level++) {
+        free(levels[level]);
+    }
+    return written;
+}
+
+// One flat object so the benchmark driver can pick values out of it without a JSON parser
+static bool WriteBenchResult(const char* path,
+                             uint64_t frames,
+                             uint32_t framesInFlight,
+                             double seconds,
+                             const Profiler* profiler,
+                             const HostAllocator* hostAllocator,
+                             const DeviceAllocator* deviceAllocator) {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to open '%s' for writing the benchmark result!\n", path);
+        return false;
+    }
+    fprintf(file,
+            "{\n  \"frames\": %llu,\n  \"frames_in_flight\": %u,\n  \"seconds\": %.6f,\n  \"frames_per_second\": %.3f,\n",
+            cast(unsigned long long) frames,
+            framesInFlight,
+            seconds,
+            seconds > 0.0 ? cast(double) frames / seconds : 0.0);
+    for (uint32_t i = 0; i < ProfilerPhase_CpuCount; i++) {
+        const ProfilerHistogram* histogram = &profiler->Phases[i];
+        char name[32]                      = {};
+        for (size_t c = 0; histogram->Name[c] && c + 1 < sizeof(name); c++) {
+            name[c] = cast(char) tolower(histogram->Name[c]);
+        }
+        fprintf(file,
+                "  \"cpu_%s_mean_ns\": %llu,\n  \"cpu_%s_p95_ns\": %llu,\n",
+                name,
+                cast(unsigned long long)(histogram->Count > 0 ? histogram->TotalNanoseconds / histogram->Count : 0),
+                name,
+                cast(unsigned long long) ProfilerPercentile(histogram, 95.0));
+    }
+    fprintf(file,
+            "  \"shader_bytes\": %llu,\n  \"shader_module_ns\": %llu,\n",
+            cast(unsigned long long) ShaderGetEmbeddedBytes(),
+            cast(unsigned long long) ShaderGetCreateNanoseconds());
+    fprintf(file,
+            "  \"peak_process_bytes\": %llu,\n  \"peak_host_bytes\": %llu,\n  \"peak_device_bytes\": %llu\n}\n",
+            cast(unsigned long long) SystemGetPeakMemoryUsage(),
+            cast(unsigned long long) hostAllocator->PeakBytes,
+            cast(unsigned long long) deviceAllocator->PeakMemoryBytes);
+
+    bool success = ferror(file) == 0;
+    success      = fclose(file) == 0 && success;
+    if (!success) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to write the benchmark result to '%s'!\n", path);
+    }
+    return success;
+}
 
-        windowHandle = CreateWindowExA(WindowStyleEx,
-                                       WindowClassName,
-                                       WindowTitle,
-                                       WindowStyle,
-                                       CW_USEDEFAULT,
-                                       CW_USEDEFAULT,
-                                       windowRect.right - windowRect.left,
-                                       windowRect.bottom - windowRect.top,
-                                       NULL,
-                                       NULL,
-                                       hinstance,
-                                       NULL);
-        if (windowHandle == NULL) {
+int main(int argc, char** argv) {
+#if defined(_WIN32)
+    const Platform* platform = &Win32Platform;
+#else
+    const Platform* platform = &HeadlessPlatform;
+#endif
+    uint32_t framesInFlight       = 2;
+    uint64_t frameLimit           = 0;
+    const char* profilePath       = NULL;
+    const char* benchPath         = NULL;
+    const char* pipelineCachePath = "pipeline_cache.bin";
+    bool pipelineCacheBenchmark   = false;
+    const char* shaderDirectory   = NULL;
+    uint32_t recordThreads        = SystemGetProcessorCount() - 1;
+    uint32_t recordItems          = 0;
+    uint32_t uploadMegabytes      = 0;
+    uint32_t computeItems         = 0;
+    uint32_t resizeEvery          = 0;
+    uint32_t defragmentEvery      = 0;
+    float renderScale             = 1.0f;
+    uint32_t cullObjects          = 0;
+    bool cullOnCpu                = false;
+    uint32_t sprites              = 0;
+    uint32_t textures             = 0;
+    uint32_t textureBudget        = 32;
+    uint32_t memoryLimit          = 0;
+    const char* capturePath       = NULL;
+    PresentGoal presentGoal       = PresentGoal_Latency;
+    VkPresentModeKHR presentMode  = VK_PRESENT_MODE_MAX_ENUM_KHR;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            platform = &HeadlessPlatform;
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frameLimit = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--profile-out") == 0 && i + 1 < argc) {
+            profilePath = argv[++i];
+        } else if (strcmp(argv[i], "--bench-out") == 0 && i + 1 < argc) {
+            benchPath = argv[++i];
+        } else if (strcmp(argv[i], "--pipeline-cache") == 0 && i + 1 < argc) {
+            pipelineCachePath = argv[++i];
+        } else if (strcmp(argv[i], "--pipeline-cache-benchmark") == 0) {
+            pipelineCacheBenchmark = true;
+        } else if (strcmp(argv[i], "--shader-dir") == 0 && i + 1 < argc) {
+            shaderDirectory = argv[++i];
+        } else if (strcmp(argv[i], "--record-threads") == 0 && i + 1 < argc) {
+            recordThreads = cast(uint32_t) atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--record-items") == 0 && i + 1 < argc) {
+            recordItems = cast(uint32_t) atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--upload-megabytes") == 0 && i + 1 < argc) {
+            uploadMegabytes = cast(uint32_t) atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--compute-items") == 0 && i + 1 < argc) {
+            computeItems = cast(uint32_t) atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--cull-objects") == 0 && i + 1 < argc) {
+            cullObjects = cast(uint32_t) atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--cull-on-cpu") == 0) {
+            cullOnCpu = true;
+        } else if (strcmp(argv[i], "--sprites") == 0 && i + 1 < argc) {
+            sprites = cast(uint32_t) atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--textures") == 0 && i + 1 < argc) {
+            textures = cast(uint32_t) atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--texture-budget-megabytes") == 0 && i + 1 < argc) {
+            textureBudget = cast(uint32_t) atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--memory-budget-megabytes") == 0 && i + 1 < argc) {
+            memoryLimit = cast(uint32_t) atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+            capturePath = argv[++i];
+        } else if (strcmp(argv[i], "--resize-every") == 0 && i + 1 < argc) {
+            resizeEvery = cast(uint32_t) atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--defragment-every") == 0 && i + 1 < argc) {
+            defragmentEvery = cast(uint32_t) atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--render-scale") == 0 && i + 1 < argc) {
+            renderScale = strtof(argv[++i], NULL);
+            if (!(renderScale > 0.0f && renderScale <= 1.0f)) {
+                fflush(stdout);
+                fprintf(stderr, "Render scale must be above 0 and at most 1!\n");
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--present-goal") == 0 && i + 1 < argc) {
+            const char* goal = argv[++i];
+            if (strcmp(goal, "latency") == 0) {
+                presentGoal = PresentGoal_Latency;
+            } else if (strcmp(goal, "throughput") == 0) {
+                presentGoal = PresentGoal_Throughput;
+            } else {
+                fflush(stdout);
+                fprintf(stderr, "Unknown present goal '%s', expected latency or throughput!\n", goal);
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--present-mode") == 0 && i + 1 < argc) {
+            const char* mode = argv[++i];
+            for (VkPresentModeKHR candidate = VK_PRESENT_MODE_IMMEDIATE_KHR; candidate <= VK_PRESENT_MODE_FIFO_RELAXED_KHR; candidate++) {
+                if (strcmp(mode, PresentModeName(candidate)) == 0) {
+                    presentMode = candidate;
+                }
+            }
+            if (presentMode == VK_PRESENT_MODE_MAX_ENUM_KHR) {
+                fflush(stdout);
+                fprintf(stderr, "Unknown present mode '%s', expected immediate, mailbox, fifo or fifo-relaxed!\n", mode);
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--frames-in-flight") == 0 && i + 1 < argc) {
+            framesInFlight = cast(uint32_t) atoi(argv[++i]);
+            if (framesInFlight < 1 || framesInFlight > MaxFramesInFlight) {
+                fflush(stdout);
+                fprintf(stderr, "Frames in flight must be between 1 and %d!\n", MaxFramesInFlight);
+                exit(1);
+            }
+        } else {
             fflush(stdout);
-            fprintf(stderr, "Failed to create window! %lx\n", GetLastError());
+            fprintf(stderr, "Unknown argument '%s'!\n", argv[i]);
             exit(1);
         }
     }
+    if (textures > 0 && sprites == 0) {
+        fflush(stdout);
+        fprintf(stderr, "--textures draws the textures on sprites, so it needs --sprites!\n");
+        exit(1);
+    }
 
-    VkAllocationCallbacks* allocator = NULL;
+    const size_t WindowWidth  = 640;
+    const size_t WindowHeight = 480;
+    platform->Init(cast(uint32_t) WindowWidth, cast(uint32_t) WindowHeight, "Vulkan Testing");
+    printf("Using the %s platform!\n", platform->Name);
+
+    if (!LoaderInit()) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to load the vulkan library!\n");
+        exit(1);
+    }
+
+#if defined(VULKAN_DEBUG)
+    Logger* logger = LoggerCreate();
+#endif
+
+    HostAllocator* hostAllocator     = HostAllocatorCreate();
+    VkAllocationCallbacks* allocator = &hostAllocator->Callbacks;
 
     const uint32_t vulkanVersion = VK_API_VERSION_1_2;
     {
@@ -118,15 +546,21 @@ int main() {
         }
     }
 
+    // Release builds run without validation or debug utils, they cost CPU time on every call
     const char* const InstanceLayers[] = {
+#if defined(VULKAN_DEBUG)
         "VK_LAYER_KHRONOS_validation",
+#endif
     };
     const size_t InstanceLayersCount = sizeof(InstanceLayers) / sizeof(InstanceLayers[0]);
 
     const char* const InstanceExtensions[] = {
         VK_KHR_SURFACE_EXTENSION_NAME,
-        VK_KHR_WIN32_SURFACE_EXTENSION_NAME,
+        platform->SurfaceExtensionName,
+#if defined(VULKAN_DEBUG)
         VK_EXT_DEBUG_UTILS_EXTENSION_NAME,
+        VK_EXT_VALIDATION_FEATURES_EXTENSION_NAME,
+#endif
     };
     const size_t InstanceExtensionsCount = sizeof(InstanceExtensions) / sizeof(InstanceExtensions[0]);
 
@@ -151,17 +585,11 @@ int main() {
             }
         }
 
-        uint32_t availableInstanceExtensionCount = 0;
-        VkCheck(vkEnumerateInstanceExtensionProperties(NULL, &availableInstanceExtensionCount, NULL));
-        VkExtensionProperties availableInstanceExtensions[availableInstanceExtensionCount];
-        VkCheck(vkEnumerateInstanceExtensionProperties(NULL, &availableInstanceExtensionCount, availableInstanceExtensions));
+        // Extensions can come from the implementation or from one of the enabled layers
         for (size_t i = 0; i < InstanceExtensionsCount; i++) {
-            bool foundExtension = false;
-            for (uint32_t j = 0; j < availableInstanceExtensionCount; j++) {
-                if (strcmp(InstanceExtensions[i], availableInstanceExtensions[j].extensionName) == 0) {
-                    foundExtension = true;
-                    break;
-                }
+            bool foundExtension = HasInstanceExtension(NULL, InstanceExtensions[i]);
+            for (size_t j = 0; j < InstanceLayersCount && !foundExtension; j++) {
+                foundExtension = HasInstanceExtension(InstanceLayers[j], InstanceExtensions[i]);
             }
             if (!foundExtension) {
                 fflush(stdout);
@@ -170,9 +598,26 @@ int main() {
             }
         }
 
+#if defined(VULKAN_DEBUG)
+        // GPU-assisted validation instruments shaders to catch out of bounds and uninitialized descriptor accesses,
+        // synchronization validation catches missing or wrong barriers
+        const VkValidationFeatureEnableEXT ValidationFeatures[] = {
+            VK_VALIDATION_FEATURE_ENABLE_GPU_ASSISTED_EXT,
+            VK_VALIDATION_FEATURE_ENABLE_GPU_ASSISTED_RESERVE_BINDING_SLOT_EXT,
+            VK_VALIDATION_FEATURE_ENABLE_SYNCHRONIZATION_VALIDATION_EXT,
+        };
+        const void* instanceCreateNext = &(VkValidationFeaturesEXT){
+            .sType                         = VK_STRUCTURE_TYPE_VALIDATION_FEATURES_EXT,
+            .enabledValidationFeatureCount = sizeof(ValidationFeatures) / sizeof(ValidationFeatures[0]),
+            .pEnabledValidationFeatures    = ValidationFeatures,
+        };
+#else
+        const void* instanceCreateNext = NULL;
+#endif
         const VkResult instanceCreateResult = vkCreateInstance(
             &(VkInstanceCreateInfo){
                 .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+                .pNext = instanceCreateNext,
                 .pApplicationInfo =
                     &(VkApplicationInfo){
                         .sType              = VK_STRUCTURE_TYPE_APPLICATION_INFO,
@@ -195,8 +640,12 @@ int main() {
             exit(1);
         }
     }
+    LoaderLoadInstance(instance);
     printf("Created the vulkan instance!\n");
 
+#if defined(VULKAN_DEBUG)
+    DebugUtilsInit(instance);
+
     VkDebugUtilsMessengerEXT debugMessenger = VK_NULL_HANDLE;
     {
         PFN_vkCreateDebugUtilsMessengerEXT vkCreateDebugUtilsMessengerEXT =
@@ -212,6 +661,7 @@ int main() {
                 .messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT |
                                VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT,
                 .pfnUserCallback = &DebugMessengerCallback,
+                .pUserData       = logger,
             },
             allocator,
             &debugMessenger);
@@ -222,17 +672,11 @@ int main() {
         }
     }
     printf("Created the debug messenger!\n");
+#endif
 
     VkSurfaceKHR surface = VK_NULL_HANDLE;
     {
-        VkResult surfaceCreateResult = vkCreateWin32SurfaceKHR(instance,
-                                                               &(VkWin32SurfaceCreateInfoKHR){
-                                                                   .sType     = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR,
-                                                                   .hinstance = hinstance,
-                                                                   .hwnd      = windowHandle,
-                                                               },
-                                                               allocator,
-                                                               &surface);
+        VkResult surfaceCreateResult = platform->CreateSurface(instance, allocator, &surface);
         if (surfaceCreateResult != VK_SUCCESS || surface == VK_NULL_HANDLE) {
             fflush(stdout);
             fprintf(stderr, "Failed to create a surface! %x\n", surfaceCreateResult);
@@ -252,6 +696,9 @@ int main() {
     VkPhysicalDevice physicalDevice   = VK_NULL_HANDLE;
     uint32_t graphicsQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
     uint32_t presentQueueFamilyIndex  = VK_QUEUE_FAMILY_IGNORED;
+    uint32_t transferQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    uint32_t transferQueueIndex       = 0;
+    uint32_t computeQueueFamilyIndex  = VK_QUEUE_FAMILY_IGNORED;
     {
         uint32_t physicalDeviceCount = 0;
         VkCheck(vkEnumeratePhysicalDevices(instance, &physicalDeviceCount, NULL));
@@ -318,7 +765,7 @@ int main() {
                     VkBool32 presentSupport = false;
                     VkCheck(vkGetPhysicalDeviceSurfaceSupportKHR(currentPhysicalDevice, i, surface, &presentSupport));
 
-                    if (presentSupport && vkGetPhysicalDeviceWin32PresentationSupportKHR(currentPhysicalDevice, i)) {
+                    if (presentSupport && platform->GetPresentationSupport(currentPhysicalDevice, i)) {
                         tempPresentQueueFamilyIndex = i;
                         break;
                     }
@@ -330,7 +777,7 @@ int main() {
                     VkBool32 presentSupport = false;
                     VkCheck(vkGetPhysicalDeviceSurfaceSupportKHR(currentPhysicalDevice, i, surface, &presentSupport));
 
-                    if (presentSupport && vkGetPhysicalDeviceWin32PresentationSupportKHR(currentPhysicalDevice, i)) {
+                    if (presentSupport && platform->GetPresentationSupport(currentPhysicalDevice, i)) {
                         tempPresentQueueFamilyIndex = i;
                         break;
                     }
@@ -340,14 +787,46 @@ int main() {
             if (tempGraphicsQueueFamilyIndex == VK_QUEUE_FAMILY_IGNORED || tempPresentQueueFamilyIndex == VK_QUEUE_FAMILY_IGNORED)
                 continue;
 
+            // A transfer-only family is usually backed by dedicated copy engines that run alongside graphics work,
+            // without one uploads go to a second queue of the graphics family, or the graphics queue itself
+            uint32_t tempTransferQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            uint32_t tempTransferQueueIndex       = 0;
+            for (uint32_t i = 0; i < queueFamilyPropertiesCount; i++) {
+                VkQueueFlags flags = queueFamilyProperties[i].queueFlags;
+                if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+                    tempTransferQueueFamilyIndex = i;
+                    break;
+                }
+            }
+            if (tempTransferQueueFamilyIndex == VK_QUEUE_FAMILY_IGNORED) {
+                tempTransferQueueFamilyIndex = tempGraphicsQueueFamilyIndex;
+                tempTransferQueueIndex       = queueFamilyProperties[tempGraphicsQueueFamilyIndex].queueCount > 1 ? 1 : 0;
+            }
+
+            // A compute family without graphics runs on the async compute engines, otherwise compute work is
+            // submitted to the graphics queue ahead of the frame
+            uint32_t tempComputeQueueFamilyIndex = tempGraphicsQueueFamilyIndex;
+            for (uint32_t i = 0; i < queueFamilyPropertiesCount; i++) {
+                VkQueueFlags flags = queueFamilyProperties[i].queueFlags;
+                if ((flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT)) {
+                    tempComputeQueueFamilyIndex = i;
+                    break;
+                }
+            }
+
             VkPhysicalDeviceProperties properties = {};
             vkGetPhysicalDeviceProperties(currentPhysicalDevice, &properties);
             if (properties.apiVersion < vulkanVersion)
                 continue;
+            if (!BindlessIsSupported(currentPhysicalDevice))
+                continue;
 
             physicalDevice           = currentPhysicalDevice;
             graphicsQueueFamilyIndex = tempGraphicsQueueFamilyIndex;
             presentQueueFamilyIndex  = tempPresentQueueFamilyIndex;
+            transferQueueFamilyIndex = tempTransferQueueFamilyIndex;
+            transferQueueIndex       = tempTransferQueueIndex;
+            computeQueueFamilyIndex  = tempComputeQueueFamilyIndex;
 
             if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
                 break;
@@ -365,32 +844,192 @@ int main() {
         printf("Chose physical device '%s'!\n", properties.deviceName);
     }
 
+    // Optional, the render graph falls back to the original barriers without it
+    bool synchronization2 = false;
+    if (HasDeviceExtension(physicalDevice, VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME)) {
+        VkPhysicalDeviceSynchronization2Features synchronization2Features = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES,
+        };
+        vkGetPhysicalDeviceFeatures2(physicalDevice,
+                                     &(VkPhysicalDeviceFeatures2){
+                                         .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+                                         .pNext = &synchronization2Features,
+                                     });
+        synchronization2 = synchronization2Features.synchronization2;
+    }
+    printf("Synchronization2 is %s!\n", synchronization2 ? "available" : "unavailable");
+
+    // Optional, without it the latency goal can't see when frames are shown and falls back to mailbox
+    bool presentWait = false;
+    if (HasDeviceExtension(physicalDevice, VK_KHR_PRESENT_ID_EXTENSION_NAME) &&
+        HasDeviceExtension(physicalDevice, VK_KHR_PRESENT_WAIT_EXTENSION_NAME)) {
+        VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR,
+        };
+        VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR,
+            .pNext = &presentWaitFeatures,
+        };
+        vkGetPhysicalDeviceFeatures2(physicalDevice,
+                                     &(VkPhysicalDeviceFeatures2){
+                                         .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+                                         .pNext = &presentIdFeatures,
+                                     });
+        presentWait = presentIdFeatures.presentId && presentWaitFeatures.presentWait;
+    }
+    printf("Present wait is %s!\n", presentWait ? "available" : "unavailable");
+
+    // Optional, without it memory pressure is judged by what the device allocator holds against the heap sizes
+    bool memoryBudgetExtension = HasDeviceExtension(physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    printf("Memory budget is %s!\n", memoryBudgetExtension ? "available" : "unavailable");
+
+    // Optional, and only enabled when --cull-objects or --sprites needs it
+    bool dynamicRendering  = false;
+    bool gpuDriven         = false;
+    bool drawIndirectCount = false;
+    {
+        if (HasDeviceExtension(physicalDevice, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME)) {
+            VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures = {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR,
+            };
+            VkPhysicalDeviceVulkan12Features vulkan12Features = {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+                .pNext = &dynamicRenderingFeatures,
+            };
+            VkPhysicalDeviceFeatures2 features = {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+                .pNext = &vulkan12Features,
+            };
+            vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+            dynamicRendering  = dynamicRenderingFeatures.dynamicRendering;
+            gpuDriven         = dynamicRendering && features.features.multiDrawIndirect && features.features.drawIndirectFirstInstance;
+            drawIndirectCount = gpuDriven && vulkan12Features.drawIndirectCount;
+        }
+        printf("GPU-driven rendering is %s%s!\n",
+               gpuDriven ? "available" : "unavailable",
+               gpuDriven && !drawIndirectCount ? ", without indirect count draws" : "");
+        if (cullObjects > 0 && !gpuDriven) {
+            fflush(stdout);
+            fprintf(stderr, "--cull-objects needs dynamic rendering and multi draw indirect!\n");
+            exit(1);
+        }
+        if (sprites > 0 && !dynamicRendering) {
+            fflush(stdout);
+            fprintf(stderr, "--sprites needs dynamic rendering!\n");
+            exit(1);
+        }
+        gpuDriven         = cullObjects > 0;
+        drawIndirectCount = drawIndirectCount && gpuDriven;
+        dynamicRendering  = gpuDriven || sprites > 0;
+    }
+
     VkDevice device = VK_NULL_HANDLE;
     {
+        // Families can overlap, each one gets a single create info asking for as many queues as any user of it needs
+        const uint32_t RequestedQueues[][2] = {
+            { graphicsQueueFamilyIndex, 1 },
+            { presentQueueFamilyIndex, 1 },
+            { transferQueueFamilyIndex, transferQueueIndex + 1 },
+            { computeQueueFamilyIndex, 1 },
+        };
+        const size_t RequestedQueuesCount = sizeof(RequestedQueues) / sizeof(RequestedQueues[0]);
+        const float QueuePriorities[]     = { 1.0f, 1.0f };
+
+        VkDeviceQueueCreateInfo queueCreateInfos[RequestedQueuesCount];
+        uint32_t queueCreateInfoCount = 0;
+        for (size_t i = 0; i < RequestedQueuesCount; i++) {
+            uint32_t j = 0;
+            while (j < queueCreateInfoCount && queueCreateInfos[j].queueFamilyIndex != RequestedQueues[i][0]) {
+                j++;
+            }
+            if (j == queueCreateInfoCount) {
+                queueCreateInfos[queueCreateInfoCount++] = (VkDeviceQueueCreateInfo){
+                    .sType            = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+                    .queueFamilyIndex = RequestedQueues[i][0],
+                    .pQueuePriorities = QueuePriorities,
+                };
+            }
+            if (queueCreateInfos[j].queueCount < RequestedQueues[i][1]) {
+                queueCreateInfos[j].queueCount = RequestedQueues[i][1];
+            }
+        }
+
+        const char* enabledDeviceExtensions[DeviceExtensionsCount + 5];
+        uint32_t enabledDeviceExtensionCount = 0;
+        for (size_t i = 0; i < DeviceExtensionsCount; i++) {
+            enabledDeviceExtensions[enabledDeviceExtensionCount++] = DeviceExtensions[i];
+        }
+        if (synchronization2) {
+            enabledDeviceExtensions[enabledDeviceExtensionCount++] = VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME;
+        }
+        if (presentWait) {
+            enabledDeviceExtensions[enabledDeviceExtensionCount++] = VK_KHR_PRESENT_ID_EXTENSION_NAME;
+            enabledDeviceExtensions[enabledDeviceExtensionCount++] = VK_KHR_PRESENT_WAIT_EXTENSION_NAME;
+        }
+        if (dynamicRendering) {
+            enabledDeviceExtensions[enabledDeviceExtensionCount++] = VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME;
+        }
+        if (memoryBudgetExtension) {
+            enabledDeviceExtensions[enabledDeviceExtensionCount++] = VK_EXT_MEMORY_BUDGET_EXTENSION_NAME;
+        }
+
+        // Optional feature structs are chained in front of each other, each one only when its extension is enabled
+        void* deviceFeatures = NULL;
+
+        VkPhysicalDeviceSynchronization2Features synchronization2Features = {
+            .sType            = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES,
+            .synchronization2 = VK_TRUE,
+        };
+        if (synchronization2) {
+            synchronization2Features.pNext = deviceFeatures;
+            deviceFeatures                 = &synchronization2Features;
+        }
+        VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures = {
+            .sType       = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR,
+            .presentWait = VK_TRUE,
+        };
+        VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures = {
+            .sType     = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR,
+            .pNext     = &presentWaitFeatures,
+            .presentId = VK_TRUE,
+        };
+        if (presentWait) {
+            presentWaitFeatures.pNext = deviceFeatures;
+            deviceFeatures            = &presentIdFeatures;
+        }
+        VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures = {
+            .sType            = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR,
+            .dynamicRendering = VK_TRUE,
+        };
+        if (dynamicRendering) {
+            dynamicRenderingFeatures.pNext = deviceFeatures;
+            deviceFeatures                 = &dynamicRenderingFeatures;
+        }
+
+        VkPhysicalDeviceVulkan12Features vulkan12Features = {
+            .sType             = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+            .pNext             = deviceFeatures,
+            .timelineSemaphore = VK_TRUE,
+            .drawIndirectCount = drawIndirectCount,
+        };
+        BindlessEnableFeatures(&vulkan12Features);
+
         VkResult deviceCreateResult =
             vkCreateDevice(physicalDevice,
                            &(VkDeviceCreateInfo){
-                               .sType                = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-                               .queueCreateInfoCount = graphicsQueueFamilyIndex == presentQueueFamilyIndex ? 1 : 2,
-                               .pQueueCreateInfos =
-                                   (VkDeviceQueueCreateInfo[2]){
-                                       {
-                                           .sType            = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-                                           .queueFamilyIndex = graphicsQueueFamilyIndex,
-                                           .queueCount       = 1,
-                                           .pQueuePriorities = (float[1]){ 1.0f },
-                                       },
-                                       {
-                                           .sType            = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-                                           .queueFamilyIndex = presentQueueFamilyIndex,
-                                           .queueCount       = 1,
-                                           .pQueuePriorities = (float[1]){ 1.0f },
-                                       },
-                                   },
+                               .sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+                               .pNext                   = &vulkan12Features,
+                               .queueCreateInfoCount    = queueCreateInfoCount,
+                               .pQueueCreateInfos       = queueCreateInfos,
                                .enabledLayerCount       = DeviceLayersCount,
                                .ppEnabledLayerNames     = DeviceLayers,
-                               .enabledExtensionCount   = DeviceExtensionsCount,
-                               .ppEnabledExtensionNames = DeviceExtensions,
+                               .enabledExtensionCount   = enabledDeviceExtensionCount,
+                               .ppEnabledExtensionNames = enabledDeviceExtensions,
+                               .pEnabledFeatures =
+                                   &(VkPhysicalDeviceFeatures){
+                                       .multiDrawIndirect         = gpuDriven,
+                                       .drawIndirectFirstInstance = gpuDriven,
+                                   },
                            },
                            allocator,
                            &device);
@@ -400,8 +1039,21 @@ int main() {
             exit(1);
         }
     }
+    LoaderLoadDevice(device);
     printf("Created logical device!\n");
 
+    DeviceAllocator* deviceAllocator = DeviceAllocatorCreate(device, physicalDevice, allocator);
+    // --memory-budget-megabytes caps every heap's budget, to see how the renderer copes with a GPU shared with others
+    MemoryBudget* memoryBudget =
+        MemoryBudgetCreate(physicalDevice, deviceAllocator, memoryBudgetExtension, cast(VkDeviceSize) memoryLimit * 1024 * 1024);
+
+    RenderGraph* renderGraph = RenderGraphCreate(device, deviceAllocator, synchronization2, framesInFlight, allocator);
+
+    PipelineCache* pipelineCache = PipelineCacheCreate(device, physicalDevice, pipelineCachePath, allocator);
+    if (pipelineCacheBenchmark) {
+        PipelineCacheBenchmark(pipelineCache, 64);
+    }
+
     VkQueue graphicsQueue = VK_NULL_HANDLE;
     vkGetDeviceQueue(device, graphicsQueueFamilyIndex, 0, &graphicsQueue);
     if (graphicsQueue == VK_NULL_HANDLE) {
@@ -418,141 +1070,38 @@ int main() {
         exit(1);
     }
 
-    VkSwapchainKHR swapchain           = VK_NULL_HANDLE;
-    VkSurfaceFormatKHR swapchainFormat = {};
-    {
-        VkSurfaceCapabilitiesKHR surfaceCapabilities = {};
-        VkCheck(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &surfaceCapabilities));
-
-        uint32_t presentModeCount = 0;
-        VkCheck(vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &presentModeCount, NULL));
-        VkPresentModeKHR presentModes[presentModeCount];
-        VkCheck(vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &presentModeCount, presentModes));
-
-        VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
-        for (uint32_t i = 0; i < presentModeCount; i++) {
-            if (presentModes[i] == VK_PRESENT_MODE_MAILBOX_KHR) {
-                presentMode = presentModes[i];
-                break;
-            }
-        }
-
-        uint32_t imageCount = surfaceCapabilities.minImageCount + 1;
-        if (imageCount > surfaceCapabilities.maxImageCount) {
-            imageCount = surfaceCapabilities.maxImageCount;
-        }
-
-        uint32_t surfaceFormatCount = 0;
-        VkCheck(vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &surfaceFormatCount, NULL));
-        VkSurfaceFormatKHR surfaceFormats[surfaceFormatCount];
-        VkCheck(vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &surfaceFormatCount, surfaceFormats));
-
-        assert(surfaceFormatCount > 0);
-        swapchainFormat = surfaceFormats[0];
-        if (surfaceFormatCount == 1 && surfaceFormats[0].format == VK_FORMAT_UNDEFINED) {
-            swapchainFormat.format     = VK_FORMAT_R8G8B8A8_UNORM;
-            swapchainFormat.colorSpace = surfaceFormats[0].colorSpace;
-        } else {
-            for (uint32_t i = 0; i < surfaceFormatCount; i++) {
-                if ((surfaceFormats[i].format == VK_FORMAT_B8G8R8A8_SRGB ||
-                     surfaceFormats[i].format == VK_FORMAT_R8G8B8A8_UNORM) &&
-                    surfaceFormats[i].colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
-                    swapchainFormat = surfaceFormats[i];
-                    break;
-                }
-            }
-        }
-
-        VkExtent2D extents = {};
-        if (surfaceCapabilities.currentExtent.width != ~0u && surfaceCapabilities.currentExtent.height != ~0u) {
-            extents = surfaceCapabilities.currentExtent;
-        } else {
-            uint32_t width  = cast(uint32_t) WindowWidth;
-            uint32_t height = cast(uint32_t) WindowHeight;
-
-            if (width > surfaceCapabilities.maxImageExtent.width) {
-                width = surfaceCapabilities.maxImageExtent.width;
-            } else if (width < surfaceCapabilities.minImageExtent.width) {
-                width = surfaceCapabilities.minImageExtent.width;
-            }
-
-            if (height > surfaceCapabilities.maxImageExtent.height) {
-                height = surfaceCapabilities.maxImageExtent.height;
-            } else if (height < surfaceCapabilities.minImageExtent.height) {
-                height = surfaceCapabilities.minImageExtent.height;
-            }
-
-            extents = (VkExtent2D){ .width = width, .height = height };
-        }
-
-        VkResult swapchainCreateResult = vkCreateSwapchainKHR(
-            device,
-            &(VkSwapchainCreateInfoKHR){
-                .sType            = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
-                .surface          = surface,
-                .minImageCount    = imageCount,
-                .imageFormat      = swapchainFormat.format,
-                .imageColorSpace  = swapchainFormat.colorSpace,
-                .imageExtent      = extents,
-                .imageArrayLayers = 1,
-                .imageUsage       = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
-                .imageSharingMode =
-                    graphicsQueueFamilyIndex != presentQueueFamilyIndex ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE,
-                .queueFamilyIndexCount = graphicsQueueFamilyIndex != presentQueueFamilyIndex ? 2 : 1,
-                .pQueueFamilyIndices   = (uint32_t[2]){ graphicsQueueFamilyIndex, presentQueueFamilyIndex },
-                .preTransform          = surfaceCapabilities.currentTransform,
-                .compositeAlpha        = (surfaceCapabilities.supportedCompositeAlpha & VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR)
-                                             ? VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR
-                                         : (surfaceCapabilities.supportedCompositeAlpha & VK_COMPOSITE_ALPHA_PRE_MULTIPLIED_BIT_KHR)
-                                             ? VK_COMPOSITE_ALPHA_PRE_MULTIPLIED_BIT_KHR
-                                         : (surfaceCapabilities.supportedCompositeAlpha & VK_COMPOSITE_ALPHA_POST_MULTIPLIED_BIT_KHR)
-                                             ? VK_COMPOSITE_ALPHA_POST_MULTIPLIED_BIT_KHR
-                                             : VK_COMPOSITE_ALPHA_INHERIT_BIT_KHR,
-                .presentMode           = presentMode,
-                .clipped               = VK_TRUE,
-                .oldSwapchain          = swapchain,
-            },
-            allocator,
-            &swapchain);
-        if (swapchainCreateResult != VK_SUCCESS || swapchain == VK_NULL_HANDLE) {
-            fflush(stdout);
-            fprintf(stderr, "Failed to create swapchain! %x\n", swapchainCreateResult);
-            exit(1);
-        }
+    VkQueue transferQueue = VK_NULL_HANDLE;
+    vkGetDeviceQueue(device, transferQueueFamilyIndex, transferQueueIndex, &transferQueue);
+    if (transferQueue == VK_NULL_HANDLE) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to get the transfer queue!\n");
+        exit(1);
     }
-    printf("Created the swapchain!\n");
-
-    uint32_t swapchainImageCount = 0;
-    VkCheck(vkGetSwapchainImagesKHR(device, swapchain, &swapchainImageCount, NULL));
-    VkImage swapchainImages[swapchainImageCount];
-    VkCheck(vkGetSwapchainImagesKHR(device, swapchain, &swapchainImageCount, swapchainImages));
-
-    VkImageView swapchainImageViews[swapchainImageCount];
-    for (uint32_t i = 0; i < swapchainImageCount; i++) {
-        VkResult imageViewCreateResult = vkCreateImageView(device,
-                                                           &(VkImageViewCreateInfo){
-                                                               .sType    = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-                                                               .image    = swapchainImages[i],
-                                                               .viewType = VK_IMAGE_VIEW_TYPE_2D,
-                                                               .format   = swapchainFormat.format,
-                                                               .subresourceRange =
-                                                                   (VkImageSubresourceRange){
-                                                                       .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                                                                       .levelCount = 1,
-                                                                       .layerCount = 1,
-                                                                   },
-                                                           },
-                                                           allocator,
-                                                           &swapchainImageViews[i]);
-        if (imageViewCreateResult != VK_SUCCESS || swapchainImageViews[i] == VK_NULL_HANDLE) {
-            fflush(stdout);
-            fprintf(stderr, "Failed to create swapchain image view %d! %x\n", i, imageViewCreateResult);
-            exit(1);
-        }
+    printf("Using queue %d of family %d for transfers%s!\n",
+           transferQueueIndex,
+           transferQueueFamilyIndex,
+           transferQueue == graphicsQueue ? ", shared with graphics" : "");
+
+    VkQueue computeQueue = VK_NULL_HANDLE;
+    vkGetDeviceQueue(device, computeQueueFamilyIndex, 0, &computeQueue);
+    if (computeQueue == VK_NULL_HANDLE) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to get the compute queue!\n");
+        exit(1);
     }
-
-    VkCommandPool graphicsCommandPool = VK_NULL_HANDLE;
-    {
+    printf("Using family %d for compute%s!\n", computeQueueFamilyIndex, computeQueue == graphicsQueue ? ", shared with graphics" : "");
+    DebugUtilsSetObjectName(device, VK_OBJECT_TYPE_QUEUE, cast(uint64_t) transferQueue, "Transfer");
+    DebugUtilsSetObjectName(device, VK_OBJECT_TYPE_QUEUE, cast(uint64_t) computeQueue, "Compute");
+    DebugUtilsSetObjectName(device, VK_OBJECT_TYPE_QUEUE, cast(uint64_t) graphicsQueue, "Graphics");
+
+    Present* present = PresentCreate(device, physicalDevice, surface, presentGoal, presentMode, presentWait);
+    printf("Presenting in %s mode with %d images, %s!\n",
+           PresentModeName(present->Mode),
+           present->ImageCount,
+           present->WaitForPresent && presentGoal == PresentGoal_Latency ? "paced on present wait" : "unpaced");
+
+    FrameData frames[MaxFramesInFlight] = {};
+    for (uint32_t i = 0; i < framesInFlight; i++) {
         VkResult commandPoolCreateResult = vkCreateCommandPool(device,
                                                                &(VkCommandPoolCreateInfo){
                                                                    .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
@@ -560,201 +1109,760 @@ int main() {
                                                                    .queueFamilyIndex = graphicsQueueFamilyIndex,
                                                                },
                                                                allocator,
-                                                               &graphicsCommandPool);
-        if (commandPoolCreateResult != VK_SUCCESS || graphicsCommandPool == VK_NULL_HANDLE) {
+                                                               &frames[i].commandPool);
+        if (commandPoolCreateResult != VK_SUCCESS || frames[i].commandPool == VK_NULL_HANDLE) {
             fflush(stdout);
-            fprintf(stderr, "Failed to create graphics command pool! %x\n", commandPoolCreateResult);
+            fprintf(stderr, "Failed to create graphics command pool %d! %x\n", i, commandPoolCreateResult);
             exit(1);
         }
-    }
 
-    VkCommandBuffer graphicsCommandBuffer = VK_NULL_HANDLE;
-    {
         VkResult commandBufferAllocateResult =
             vkAllocateCommandBuffers(device,
                                      &(VkCommandBufferAllocateInfo){
                                          .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-                                         .commandPool        = graphicsCommandPool,
+                                         .commandPool        = frames[i].commandPool,
                                          .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
                                          .commandBufferCount = 1,
                                      },
-                                     &graphicsCommandBuffer);
-        if (commandBufferAllocateResult != VK_SUCCESS || graphicsCommandBuffer == VK_NULL_HANDLE) {
+                                     &frames[i].commandBuffer);
+        if (commandBufferAllocateResult != VK_SUCCESS || frames[i].commandBuffer == VK_NULL_HANDLE) {
             fflush(stdout);
-            fprintf(stderr, "Failed to create graphics command buffer! %x\n", commandBufferAllocateResult);
+            fprintf(stderr, "Failed to create graphics command buffer %d! %x\n", i, commandBufferAllocateResult);
             exit(1);
         }
-    }
 
-    VkSemaphore imageAvailableSemaphore = VK_NULL_HANDLE;
-    {
         VkResult semaphoreCreateResult = vkCreateSemaphore(device,
                                                            &(VkSemaphoreCreateInfo){
                                                                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
                                                            },
                                                            allocator,
-                                                           &imageAvailableSemaphore);
-        if (semaphoreCreateResult != VK_SUCCESS || imageAvailableSemaphore == VK_NULL_HANDLE) {
+                                                           &frames[i].imageAvailableSemaphore);
+        if (semaphoreCreateResult != VK_SUCCESS || frames[i].imageAvailableSemaphore == VK_NULL_HANDLE) {
             fflush(stdout);
-            fprintf(stderr, "Failed to create image available semaphore! %x\n", semaphoreCreateResult);
+            fprintf(stderr, "Failed to create image available semaphore %d! %x\n", i, semaphoreCreateResult);
             exit(1);
         }
+
+        DebugUtilsSetObjectName(device, VK_OBJECT_TYPE_COMMAND_BUFFER, cast(uint64_t) frames[i].commandBuffer, "Frame %u", i);
+        DebugUtilsSetObjectName(
+            device, VK_OBJECT_TYPE_SEMAPHORE, cast(uint64_t) frames[i].imageAvailableSemaphore, "Frame %u image available", i);
     }
+    printf("Created %d frames in flight!\n", framesInFlight);
+
+    // Every graphics submission signals the next value, each frame slot remembers which one it has to wait for
+    Timeline* graphicsTimeline = TimelineCreate(device, allocator);
+    DebugUtilsSetObjectName(device, VK_OBJECT_TYPE_SEMAPHORE, cast(uint64_t) graphicsTimeline->Semaphore, "Graphics timeline");
+
+    Bindless* bindless = BindlessCreate(device, physicalDevice, graphicsTimeline, allocator);
+    printf("Created the bindless descriptor set with %d images, %d buffers and %d samplers!\n",
+           bindless->Arrays[BindlessType_SampledImage].Capacity,
+           bindless->Arrays[BindlessType_StorageBuffer].Capacity,
+           bindless->Arrays[BindlessType_Sampler].Capacity);
+
+    // Culling and sprite pipelines are built in the background, --shader-dir reloads their shaders when they change.
+    // Pipelines are few, so one worker is enough unless there are cores to spare.
+    uint32_t pipelineWorkers         = SystemGetProcessorCount() > 2 ? 2 : 1;
+    PipelineManager* pipelineManager = PipelineManagerCreate(
+        device, pipelineCache->Cache, graphicsTimeline, pipelineWorkers, shaderDirectory, allocator);
+
+    Swapchain* swapchain = SwapchainCreate(device,
+                                           physicalDevice,
+                                           surface,
+                                           graphicsQueueFamilyIndex,
+                                           presentQueueFamilyIndex,
+                                           present,
+                                           graphicsTimeline,
+                                           (VkExtent2D){ .width = cast(uint32_t) WindowWidth, .height = cast(uint32_t) WindowHeight },
+                                           capturePath != NULL,
+                                           allocator);
+    printf("Created the swapchain!\n");
 
-    VkSemaphore renderFinishedSemaphore = VK_NULL_HANDLE;
-    {
-        VkResult semaphoreCreateResult = vkCreateSemaphore(device,
-                                                           &(VkSemaphoreCreateInfo){
-                                                               .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
-                                                           },
-                                                           allocator,
-                                                           &renderFinishedSemaphore);
-        if (semaphoreCreateResult != VK_SUCCESS || renderFinishedSemaphore == VK_NULL_HANDLE) {
+    // The scene is only blitted when it's rendered smaller, filtered where the format allows it
+    VkFilter upscaleFilter = VK_FILTER_NEAREST;
+    if (renderScale < 1.0f) {
+        VkFormatProperties formatProperties = {};
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, swapchain->Format.format, &formatProperties);
+        VkFormatFeatureFlags blitFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT;
+        if ((formatProperties.optimalTilingFeatures & blitFeatures) != blitFeatures) {
+            fflush(stdout);
+            fprintf(stderr, "--render-scale needs a swapchain format that can be blitted!\n");
+            exit(1);
+        }
+        if (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) {
+            upscaleFilter = VK_FILTER_LINEAR;
+        }
+    }
+
+    // --capture writes every frame it can keep up with, into one video if the path ends in .y4m and as numbered PNGs
+    // with the path as prefix otherwise
+    FrameCapture* capture = NULL;
+    if (capturePath) {
+        size_t pathLength         = strlen(capturePath);
+        FrameCaptureFormat format = pathLength >= 4 && strcmp(capturePath + pathLength - 4, ".y4m") == 0 ? FrameCaptureFormat_Y4m
+                                                                                                          : FrameCaptureFormat_Png;
+        capture = FrameCaptureCreate(device, deviceAllocator, graphicsTimeline, swapchain->Format.format, format, capturePath, allocator);
+        printf("Capturing frames to '%s'!\n", capturePath);
+    }
+
+    CommandRecorder* recorder = CommandRecorderCreate(device, graphicsQueueFamilyIndex, recordThreads, framesInFlight, allocator);
+    printf("Created %d command recording threads!\n", recorder->WorkerCount);
+    StateItemsData stateItems = {
+        .width  = cast(uint32_t) WindowWidth,
+        .height = cast(uint32_t) WindowHeight,
+    };
+
+    Uploader* uploader = UploaderCreate(device,
+                                        deviceAllocator,
+                                        transferQueue,
+                                        transferQueueFamilyIndex,
+                                        graphicsQueueFamilyIndex,
+                                        32ull * 1024 * 1024,
+                                        allocator);
+
+    // Streams --upload-megabytes of data into a device local buffer a chunk per frame, to check the uploads
+    // don't show up in the frame times
+    VkBuffer uploadBuffer              = VK_NULL_HANDLE;
+    DeviceAllocation* uploadAllocation = NULL;
+    uint8_t* uploadData                = NULL;
+    const VkDeviceSize UploadChunkSize = 4ull * 1024 * 1024;
+    VkDeviceSize uploadSize            = cast(VkDeviceSize) uploadMegabytes * 1024 * 1024;
+    VkDeviceSize uploadedSize          = 0;
+    if (uploadSize > 0) {
+        VkResult uploadBufferCreateResult = DeviceAllocatorCreateBuffer(deviceAllocator,
+                                                                        &(VkBufferCreateInfo){
+                                                                            .sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+                                                                            .size        = uploadSize,
+                                                                            .usage       = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                                                            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                                                                        },
+                                                                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                                                        0,
+                                                                        &uploadBuffer,
+                                                                        &uploadAllocation);
+        if (uploadBufferCreateResult != VK_SUCCESS) {
+            fflush(stdout);
+            fprintf(stderr, "Failed to create the upload test buffer! %x\n", uploadBufferCreateResult);
+            exit(1);
+        }
+        uploadData = malloc(UploadChunkSize);
+        if (uploadData == NULL) {
+            fflush(stdout);
+            fprintf(stderr, "Failed to allocate the upload test data!\n");
+            exit(1);
+        }
+        for (VkDeviceSize i = 0; i < UploadChunkSize; i++) {
+            uploadData[i] = cast(uint8_t)(i * 31);
+        }
+    }
+
+    Compute* compute = ComputeCreate(device,
+                                     pipelineCache->Cache,
+                                     computeQueue,
+                                     computeQueueFamilyIndex,
+                                     graphicsQueue,
+                                     graphicsQueueFamilyIndex,
+                                     framesInFlight,
+                                     allocator);
+
+    // --compute-items fills a buffer per frame slot on the compute queue, graphics copies the start of it back so
+    // the results can be checked at exit
+    ComputePipeline* fillPipeline = NULL;
+    VkBuffer computeBuffers[MaxFramesInFlight]                    = {};
+    DeviceAllocation* computeBufferAllocations[MaxFramesInFlight] = {};
+    uint32_t computeBufferIndices[MaxFramesInFlight]              = {};
+    VkBuffer readbackBuffers[MaxFramesInFlight]                   = {};
+    DeviceAllocation* readbackAllocations[MaxFramesInFlight]      = {};
+    if (computeItems > 0) {
+        if (computeItems < ComputeReadbackCount) {
+            computeItems = ComputeReadbackCount;
+        }
+        assert(Shaders[ShaderId_FillComp].PushConstantSize == sizeof(FillPushConstants));
+        fillPipeline = ComputePipelineCreateBindless(compute, bindless, ShaderId_FillComp, 64, NULL, 0);
+        VkSharingMode sharingMode = compute->QueueFamilyIndexCount > 1 ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
+        for (uint32_t i = 0; i < framesInFlight; i++) {
+            VkResult computeBufferCreateResult =
+                DeviceAllocatorCreateBuffer(deviceAllocator,
+                                            &(VkBufferCreateInfo){
+                                                .sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+                                                .size                  = cast(VkDeviceSize) computeItems * sizeof(uint32_t),
+                                                .usage                 = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                                .sharingMode           = sharingMode,
+                                                .queueFamilyIndexCount = compute->QueueFamilyIndexCount,
+                                                .pQueueFamilyIndices   = compute->QueueFamilyIndices,
+                                            },
+                                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                            0,
+                                            &computeBuffers[i],
+                                            &computeBufferAllocations[i]);
+            VkResult readbackBufferCreateResult =
+                DeviceAllocatorCreateBuffer(deviceAllocator,
+                                            &(VkBufferCreateInfo){
+                                                .sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+                                                .size        = ComputeReadbackCount * sizeof(uint32_t),
+                                                .usage       = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                                .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                                            },
+                                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+                                            VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+                                            &readbackBuffers[i],
+                                            &readbackAllocations[i]);
+            if (computeBufferCreateResult != VK_SUCCESS || readbackBufferCreateResult != VK_SUCCESS) {
+                fflush(stdout);
+                fprintf(stderr,
+                        "Failed to create the compute test buffers! %x %x\n",
+                        computeBufferCreateResult,
+                        readbackBufferCreateResult);
+                exit(1);
+            }
+            computeBufferIndices[i] = BindlessAddStorageBuffer(bindless,
+                                                               &(VkDescriptorBufferInfo){
+                                                                   .buffer = computeBuffers[i],
+                                                                   .range  = VK_WHOLE_SIZE,
+                                                               });
+            DebugUtilsSetObjectName(device, VK_OBJECT_TYPE_BUFFER, cast(uint64_t) computeBuffers[i], "Compute results %u", i);
+            DebugUtilsSetObjectName(device, VK_OBJECT_TYPE_BUFFER, cast(uint64_t) readbackBuffers[i], "Compute readback %u", i);
+        }
+    }
+
+    Profiler* profiler      = ProfilerCreate(device, physicalDevice, graphicsQueueFamilyIndex, framesInFlight, allocator);
+    uint32_t clearPassPhase = ProfilerRegisterGpuPass(profiler, "Clear");
+    uint32_t upscalePhase   = renderScale < 1.0f ? ProfilerRegisterGpuPass(profiler, "Upscale") : 0;
+
+    // --cull-objects draws that many objects through GPU culling on top of the clear, the last frame's visible count
+    // is checked against the CPU at exit. --cull-on-cpu culls them on the recording threads instead, for comparison.
+    Culling* culling              = NULL;
+    CullingObject* cullingObjects = NULL;
+    float cullingWorldHalfExtent  = sqrtf(cast(float) cullObjects) * CullingObjectSpacing * 0.5f;
+    float cullingViewProjection[16];
+    bool cullingDrawn = false;
+    if (cullObjects > 0) {
+        if (cullOnCpu && recorder->WorkerCount == 0) {
             fflush(stdout);
-            fprintf(stderr, "Failed to create render finished semaphore! %x\n", semaphoreCreateResult);
+            fprintf(stderr, "--cull-on-cpu needs at least one recording thread!\n");
             exit(1);
         }
+        cullingObjects = GenerateCullingObjects(cullObjects, cullingWorldHalfExtent);
+        culling = CullingCreate(device,
+                                pipelineManager,
+                                deviceAllocator,
+                                uploader,
+                                bindless,
+                                profiler,
+                                swapchain->Format.format,
+                                drawIndirectCount,
+                                cullOnCpu ? recorder : NULL,
+                                cullingObjects,
+                                cullObjects,
+                                framesInFlight,
+                                allocator);
+        printf("Created %d objects for %s culling!\n", cullObjects, cullOnCpu ? "CPU" : "GPU");
     }
 
-    while (Running) {
-        {
-            MSG message;
-            while (PeekMessageA(&message, windowHandle, 0, 0, PM_REMOVE)) {
-                TranslateMessage(&message);
-                DispatchMessageA(&message);
+    // --sprites draws that many sprites on top of everything else, timing how long the batch takes on the CPU
+    SpriteBatch* spriteBatch           = NULL;
+    SpriteBatchInstance* spriteSources = NULL;
+    SpriteBatchInstance* spriteMoved   = NULL;
+    uint64_t spriteTime                = 0;
+    uint64_t spriteMaxTime             = 0;
+    uint64_t spriteFrames              = 0;
+    if (sprites > 0) {
+        spriteBatch   = SpriteBatchCreate(device,
+                                          pipelineManager,
+                                          deviceAllocator,
+                                          uploader,
+                                          bindless,
+                                          profiler,
+                                          swapchain->Format.format,
+                                          sprites,
+                                          framesInFlight,
+                                          allocator);
+        spriteSources = GenerateSprites(sprites, spriteBatch->WhiteTexture);
+        spriteMoved   = malloc(sprites * sizeof(SpriteBatchInstance));
+        if (spriteMoved == NULL) {
+            fflush(stdout);
+            fprintf(stderr, "Failed to allocate the moved sprites!\n");
+            exit(1);
+        }
+        printf("Created a sprite batch for %d sprites!\n", sprites);
+    }
+
+    TextureStreamer* textureStreamer = NULL;
+    uint32_t* streamedTextures       = NULL;
+    uint32_t streamedTextureCount    = 0;
+    if (textures > 0) {
+        textureStreamer  = TextureStreamerCreate(device,
+                                                 deviceAllocator,
+                                                 uploader,
+                                                 bindless,
+                                                 graphicsTimeline,
+                                                 cast(VkDeviceSize) textureBudget * 1024 * 1024,
+                                                 TextureUploadBytesPerFrame,
+                                                 spriteBatch->WhiteTexture,
+                                                 allocator);
+        streamedTextures = malloc(textures * sizeof(uint32_t));
+        if (streamedTextures == NULL) {
+            fflush(stdout);
+            fprintf(stderr, "Failed to allocate the streamed texture indices!\n");
+            exit(1);
+        }
+        for (uint32_t i = 0; i < textures; i++) {
+            char path[64];
+            snprintf(path, sizeof(path), "streamed_texture_%u.ktx2", i);
+            uint32_t texture = GenerateStreamedTexture(path, i) ? TextureStreamerAdd(textureStreamer, path) : UINT32_MAX;
+            if (texture != UINT32_MAX) {
+                streamedTextures[streamedTextureCount++] = texture;
+            }
+        }
+        printf("Added %u textures to stream with a %uMB budget!\n", streamedTextureCount, textureBudget);
+        MemoryBudgetAddListener(memoryBudget, TextureStreamerOnMemoryPressure, textureStreamer);
+    }
+
+    uint64_t frameNumber        = 0;
+    uint64_t startTime          = SystemGetTimeNanoseconds();
+    uint64_t startDispatches    = LoaderGetDispatchCount();
+    uint64_t maxFrameDispatches = 0;
+    // Graphics timeline value of the frame that recorded the running defragmentation, 0 while none is running
+    uint64_t defragmentValue = 0;
+    while (platform->PollEvents() && (frameLimit == 0 || frameNumber < frameLimit)) {
+        if (platform->ConsumeDumpRequest()) {
+            const char* path = profilePath ? profilePath : "profile.csv";
+            if (ProfilerDump(profiler, path)) {
+                printf("Wrote the profile to '%s'!\n", path);
             }
         }
 
+        if (platform->ConsumeResize()) {
+            VkExtent2D windowExtent = {};
+            platform->GetWindowSize(&windowExtent.width, &windowExtent.height);
+            SwapchainResize(swapchain, windowExtent);
+        }
+        // --resize-every switches between two sizes, so recreation can be tested without a window to drag around
+        if (resizeEvery > 0 && frameNumber > 0 && frameNumber % resizeEvery == 0) {
+            bool shrink = frameNumber / resizeEvery % 2 == 1;
+            SwapchainResize(swapchain,
+                            (VkExtent2D){
+                                .width  = cast(uint32_t)(shrink ? WindowWidth / 2 : WindowWidth),
+                                .height = cast(uint32_t)(shrink ? WindowHeight / 2 : WindowHeight),
+                            });
+        }
+
+        uint32_t frameSlot  = cast(uint32_t)(frameNumber % framesInFlight);
+        FrameData* frame    = &frames[frameSlot];
+        uint64_t frameStart      = SystemGetTimeNanoseconds();
+        uint64_t frameDispatches = LoaderGetDispatchCount();
+
+        // Pacing comes first, so everything the frame does afterwards is as close to it being shown as possible
+        PresentPace(present, swapchain->Current.Handle);
+        // Only block on the GPU work that last used this slot, the other slots keep running
+        TimelineWait(graphicsTimeline, frame->timelineValue);
+        SwapchainBeginFrame(swapchain);
+        BindlessBeginFrame(bindless);
+        PipelineManagerBeginFrame(pipelineManager);
+        MemoryBudgetUpdate(memoryBudget);
+        if (capture) {
+            FrameCaptureBeginFrame(capture);
+        }
+        uint64_t waitEnd = SystemGetTimeNanoseconds();
+        ProfilerRecord(profiler, ProfilerPhase_Wait, waitEnd - frameStart);
+
+        // Acquiring before anything is submitted means a frame without an image can be dropped, while minimized
+        // there's nothing to render to so the loop just idles
         uint32_t imageIndex = 0;
-        VkCheck(vkAcquireNextImageKHR(device, swapchain, ~0ull, imageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex));
+        if (!SwapchainAcquire(swapchain, frame->imageAvailableSemaphore, &imageIndex)) {
+            SystemSleep(MinimizedSleepMilliseconds);
+            continue;
+        }
+        uint64_t acquireEnd = SystemGetTimeNanoseconds();
+        ProfilerRecord(profiler, ProfilerPhase_Acquire, acquireEnd - waitEnd);
+        stateItems.width  = swapchain->Current.Extent.width;
+        stateItems.height = swapchain->Current.Extent.height;
+
+        HostAllocatorBeginFrame(hostAllocator, frameSlot);
+        CommandRecorderBeginFrame(recorder, frameSlot);
+        ComputeBeginFrame(compute, frameSlot);
+
+        // Compute goes out first so it can overlap with whatever graphics work is still running
+        if (computeItems > 0) {
+            ComputeDispatchBindless(compute,
+                                    fillPipeline,
+                                    bindless,
+                                    &(FillPushConstants){
+                                        .count       = computeItems,
+                                        .seed        = cast(uint32_t) frameNumber,
+                                        .bufferIndex = computeBufferIndices[frameSlot],
+                                    },
+                                    ComputeGroupCount(fillPipeline, computeItems),
+                                    1,
+                                    1);
+        }
+        uint64_t computeValue = ComputeSubmit(compute);
 
-        VkCheck(vkResetCommandPool(device, graphicsCommandPool, 0));
-        VkCheck(vkBeginCommandBuffer(graphicsCommandBuffer,
+        VkCheck(vkResetCommandPool(device, frame->commandPool, 0));
+        VkCheck(vkBeginCommandBuffer(frame->commandBuffer,
                                      &(VkCommandBufferBeginInfo){
                                          .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
                                          .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
                                      }));
+        ProfilerBeginFrame(profiler, frame->commandBuffer, frameSlot);
+
+        if (uploadedSize < uploadSize) {
+            VkDeviceSize chunkSize = uploadSize - uploadedSize < UploadChunkSize ? uploadSize - uploadedSize : UploadChunkSize;
+            UploaderUploadBuffer(uploader, uploadBuffer, uploadedSize, uploadData, chunkSize);
+            UploaderFlush(uploader);
+            uploadedSize += chunkSize;
+            if (uploadedSize == uploadSize) {
+                printf("Queued %d MB of uploads over %llu frames in %.3fms!\n",
+                       uploadMegabytes,
+                       cast(unsigned long long) frameNumber + 1,
+                       cast(double)(SystemGetTimeNanoseconds() - startTime) / 1e6);
+            }
+        }
+        if (textureStreamer) {
+            TextureStreamerUpdate(textureStreamer);
+        }
+        uint64_t uploadValue = UploaderAcquire(uploader, frame->commandBuffer);
 
-        vkCmdPipelineBarrier(graphicsCommandBuffer,
-                             VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-                             VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-                             VK_DEPENDENCY_BY_REGION_BIT,
-                             0,
-                             NULL,
-                             0,
-                             NULL,
-                             1,
-                             &(VkImageMemoryBarrier){
-                                 .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-                                 .srcAccessMask       = 0,
-                                 .dstAccessMask       = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-                                 .oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED,
-                                 .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                 .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                                 .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                                 .image               = swapchainImages[imageIndex],
-                                 .subresourceRange =
-                                     (VkImageSubresourceRange){
-                                         .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                                         .levelCount = VK_REMAINING_MIP_LEVELS,
-                                         .layerCount = VK_REMAINING_ARRAY_LAYERS,
-                                     },
-                             });
-
-        vkCmdClearColorImage(graphicsCommandBuffer,
-                             swapchainImages[imageIndex],
-                             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                             &(VkClearColorValue){
-                                 .float32 = { 1.0f, 0.0f, 0.0f, 1.0f },
-                             },
-                             1,
-                             &(VkImageSubresourceRange){
-                                 .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
-                                 .baseMipLevel   = 0,
-                                 .levelCount     = 1,
-                                 .baseArrayLayer = 0,
-                                 .layerCount     = 1,
-                             });
-
-        vkCmdPipelineBarrier(graphicsCommandBuffer,
-                             VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-                             VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                             VK_DEPENDENCY_BY_REGION_BIT,
-                             0,
-                             NULL,
-                             0,
-                             NULL,
-                             1,
-                             &(VkImageMemoryBarrier){
-                                 .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-                                 .srcAccessMask       = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-                                 .dstAccessMask       = 0,
-                                 .oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED,
-                                 .newLayout           = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-                                 .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                                 .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                                 .image               = swapchainImages[imageIndex],
-                                 .subresourceRange =
-                                     (VkImageSubresourceRange){
-                                         .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                                         .levelCount = VK_REMAINING_MIP_LEVELS,
-                                         .layerCount = VK_REMAINING_ARRAY_LAYERS,
-                                     },
-                             });
+        // Old ranges are given back once the frame that copied out of them has finished, only then does the next
+        // defragmentation start. It comes after the acquire so it copies what the uploads left behind.
+        if (defragmentValue > 0 && TimelineIsComplete(graphicsTimeline, defragmentValue)) {
+            DeviceAllocatorEndDefragment(deviceAllocator);
+            defragmentValue = 0;
+        }
+        if (defragmentEvery > 0 && defragmentValue == 0 && frameNumber % defragmentEvery == 0 &&
+            DeviceAllocatorDefragment(deviceAllocator, frame->commandBuffer, DefragmentMaxBytes) > 0) {
+            if (culling) {
+                CullingRebind(culling);
+            }
+            defragmentValue = graphicsTimeline->LastSubmittedValue + 1;
+        }
+
+        RenderGraphBeginFrame(renderGraph);
+        RenderGraphResource backbuffer = RenderGraphImportImage(renderGraph,
+                                                                "Backbuffer",
+                                                                swapchain->Current.Images[imageIndex],
+                                                                swapchain->Current.Views[imageIndex],
+                                                                VK_IMAGE_ASPECT_COLOR_BIT,
+                                                                VK_IMAGE_LAYOUT_UNDEFINED,
+                                                                RenderGraphUsage_Present);
+        RenderGraphResource scene = backbuffer;
+        VkExtent2D sceneExtent    = swapchain->Current.Extent;
+        if (renderScale < 1.0f) {
+            sceneExtent.width  = cast(uint32_t)(cast(float) sceneExtent.width * renderScale);
+            sceneExtent.height = cast(uint32_t)(cast(float) sceneExtent.height * renderScale);
+            sceneExtent.width  = sceneExtent.width > 0 ? sceneExtent.width : 1;
+            sceneExtent.height = sceneExtent.height > 0 ? sceneExtent.height : 1;
+            scene              = RenderGraphCreateImage(renderGraph,
+                                           "Scene",
+                                           &(RenderGraphImageDesc){
+                                               .Format = swapchain->Format.format,
+                                               .Extent = sceneExtent,
+                                               .Usage  = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+                                                        VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                                               .Aspect = VK_IMAGE_ASPECT_COLOR_BIT,
+                                           });
+        }
+        ClearPassData clearPass = {
+            .profiler = profiler,
+            .phase    = clearPassPhase,
+            .target   = scene,
+        };
+        RenderGraphUse(renderGraph, RenderGraphAddPass(renderGraph, "Clear", RecordClearPass, &clearPass), scene, RenderGraphUsage_TransferDst);
+        if (culling) {
+            CullingCameraViewProjection(frameNumber, sceneExtent, cullingWorldHalfExtent, cullingViewProjection);
+            cullingDrawn = CullingAddPasses(culling, renderGraph, frameSlot, scene, sceneExtent, cullingViewProjection);
+        }
+        UpscalePassData upscalePass = {
+            .profiler          = profiler,
+            .phase             = upscalePhase,
+            .source            = scene,
+            .destination       = backbuffer,
+            .sourceExtent      = sceneExtent,
+            .destinationExtent = swapchain->Current.Extent,
+            .filter            = upscaleFilter,
+        };
+        if (scene != backbuffer) {
+            uint32_t pass = RenderGraphAddPass(renderGraph, "Upscale", RecordUpscalePass, &upscalePass);
+            RenderGraphUse(renderGraph, pass, scene, RenderGraphUsage_TransferSrc);
+            RenderGraphUse(renderGraph, pass, backbuffer, RenderGraphUsage_TransferDst);
+        }
+        if (spriteBatch) {
+            // Moving the sprites is the test's own work, only the batch's is timed
+            MoveSprites(spriteSources, spriteMoved, sprites, frameNumber);
+            if (streamedTextureCount > 0) {
+                float zoom      = 1.0f + 31.0f * (0.5f - 0.5f * cosf(cast(float) frameNumber * 0.02f));
+                uint32_t window = cast(uint32_t)(frameNumber / TextureWindowFrames) * TexturesOnScreen;
+                for (uint32_t i = 0; i < sprites && i < TexturedSpriteCount; i++) {
+                    float* rect = spriteMoved[i].Rect;
+                    rect[2] *= zoom;
+                    rect[3] *= zoom;
+                    uint32_t texture       = streamedTextures[(window + i % TexturesOnScreen) % streamedTextureCount];
+                    spriteMoved[i].Texture = TextureStreamerUse(textureStreamer, texture, rect[2] > rect[3] ? rect[2] : rect[3]);
+                }
+            }
+            uint64_t spriteStart = SystemGetTimeNanoseconds();
+            SpriteBatchBegin(spriteBatch, frameSlot);
+            AddSprites(spriteBatch, spriteMoved, sprites);
+            SpriteBatchAddPass(spriteBatch, renderGraph, backbuffer, swapchain->Current.Extent);
+            uint64_t spriteElapsed = SystemGetTimeNanoseconds() - spriteStart;
+            spriteTime += spriteElapsed;
+            spriteMaxTime = spriteElapsed > spriteMaxTime ? spriteElapsed : spriteMaxTime;
+            spriteFrames++;
+        }
+
+        RenderGraphResource computeResult = 0;
+        ReadbackPassData readbackPass     = {};
+        if (computeItems > 0) {
+            // The compute results are left as they are, the next dispatch into them waits on the graphics timeline
+            computeResult       = RenderGraphImportBuffer(renderGraph, "ComputeResult", computeBuffers[frameSlot], RenderGraphUsage_TransferSrc);
+            readbackPass.source = computeResult;
+            readbackPass.destination =
+                RenderGraphImportBuffer(renderGraph, "Readback", readbackBuffers[frameSlot], RenderGraphUsage_HostRead);
+            uint32_t pass = RenderGraphAddPass(renderGraph, "Readback", RecordReadbackPass, &readbackPass);
+            RenderGraphUse(renderGraph, pass, readbackPass.source, RenderGraphUsage_TransferSrc);
+            RenderGraphUse(renderGraph, pass, readbackPass.destination, RenderGraphUsage_TransferDst);
+        }
+        if (capture) {
+            FrameCaptureAddPass(capture, renderGraph, backbuffer, swapchain->Current.Extent);
+        }
+        RenderGraphExecute(renderGraph, frame->commandBuffer);
+
+        // The wait value of the binary swapchain semaphore is ignored
+        VkSemaphore waitSemaphores[3]      = { frame->imageAvailableSemaphore };
+        uint64_t waitValues[3]             = { 0 };
+        VkPipelineStageFlags waitStages[3] = { RenderGraphGetFirstStages(renderGraph, backbuffer) };
+        uint32_t waitCount                 = 1;
+        if (computeValue > 0) {
+            // Graphics only has to wait for compute where it first reads the results
+            waitSemaphores[waitCount] = compute->Timeline->Semaphore;
+            waitValues[waitCount]     = computeValue;
+            waitStages[waitCount]     = RenderGraphGetFirstStages(renderGraph, computeResult);
+            waitCount++;
+        }
+        if (uploadValue > 0) {
+            waitSemaphores[waitCount] = uploader->Timeline->Semaphore;
+            waitValues[waitCount]     = uploadValue;
+            waitStages[waitCount]     = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+            waitCount++;
+        }
+
+        if (recordItems > 0) {
+            CommandRecorderRecord(recorder,
+                                  frame->commandBuffer,
+                                  &(VkCommandBufferInheritanceInfo){
+                                      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+                                  },
+                                  recordItems,
+                                  RecordStateItems,
+                                  &stateItems);
+        }
 
-        VkCheck(vkEndCommandBuffer(graphicsCommandBuffer));
+        VkCheck(vkEndCommandBuffer(frame->commandBuffer));
+        uint64_t recordEnd = SystemGetTimeNanoseconds();
+        ProfilerRecord(profiler, ProfilerPhase_Record, recordEnd - acquireEnd);
 
+        frame->timelineValue          = TimelineNextValue(graphicsTimeline);
+        VkSemaphore signalSemaphores[] = { swapchain->Current.RenderFinished[imageIndex], graphicsTimeline->Semaphore };
+        uint64_t signalValues[]        = { 0, frame->timelineValue };
         VkCheck(vkQueueSubmit(graphicsQueue,
                               1,
                               &(VkSubmitInfo){
-                                  .sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-                                  .waitSemaphoreCount = 1,
-                                  .pWaitSemaphores    = &imageAvailableSemaphore,
-                                  .pWaitDstStageMask =
-                                      &(VkPipelineStageFlags){
-                                          VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                  .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                                  .pNext =
+                                      &(VkTimelineSemaphoreSubmitInfo){
+                                          .sType                     = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+                                          .waitSemaphoreValueCount   = waitCount,
+                                          .pWaitSemaphoreValues      = waitValues,
+                                          .signalSemaphoreValueCount = 2,
+                                          .pSignalSemaphoreValues    = signalValues,
                                       },
+                                  .waitSemaphoreCount   = waitCount,
+                                  .pWaitSemaphores      = waitSemaphores,
+                                  .pWaitDstStageMask    = waitStages,
                                   .commandBufferCount   = 1,
-                                  .pCommandBuffers      = &graphicsCommandBuffer,
-                                  .signalSemaphoreCount = 1,
-                                  .pSignalSemaphores    = &renderFinishedSemaphore,
+                                  .pCommandBuffers      = &frame->commandBuffer,
+                                  .signalSemaphoreCount = 2,
+                                  .pSignalSemaphores    = signalSemaphores,
                               },
                               VK_NULL_HANDLE));
+        if (capture) {
+            FrameCaptureSubmitted(capture, frame->timelineValue);
+        }
+        uint64_t submitEnd = SystemGetTimeNanoseconds();
+        ProfilerRecord(profiler, ProfilerPhase_Submit, submitEnd - recordEnd);
+
+        SwapchainPresent(swapchain, presentQueue, imageIndex);
+        uint64_t presentEnd = SystemGetTimeNanoseconds();
+        ProfilerRecord(profiler, ProfilerPhase_Present, presentEnd - submitEnd);
+        ProfilerRecord(profiler, ProfilerPhase_Frame, presentEnd - frameStart);
+        uint64_t latency = 0;
+        if (PresentConsumeLatency(present, &latency)) {
+            ProfilerRecord(profiler, ProfilerPhase_Latency, latency);
+        }
 
-        VkCheck(vkQueuePresentKHR(presentQueue,
-                                  &(VkPresentInfoKHR){
-                                      .sType              = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
-                                      .waitSemaphoreCount = 1,
-                                      .pWaitSemaphores    = &renderFinishedSemaphore,
-                                      .swapchainCount     = 1,
-                                      .pSwapchains        = &swapchain,
-                                      .pImageIndices      = &imageIndex,
-                                  }));
+        // Includes the calls worker threads made while recording for this frame
+        frameDispatches = LoaderGetDispatchCount() - frameDispatches;
+        if (frameDispatches > maxFrameDispatches) {
+            maxFrameDispatches = frameDispatches;
+        }
+        frameNumber++;
+    }
 
-        VkCheck(vkDeviceWaitIdle(device));
+    {
+        double elapsedSeconds = cast(double)(SystemGetTimeNanoseconds() - startTime) / 1e9;
+        if (frameNumber > 0 && elapsedSeconds > 0.0) {
+            printf("Rendered %llu frames in %.3fs (%.1f frames/s, %d frames in flight)!\n",
+                   cast(unsigned long long) frameNumber,
+                   elapsedSeconds,
+                   cast(double) frameNumber / elapsedSeconds,
+                   framesInFlight);
+        }
+        uint64_t dispatches = LoaderGetDispatchCount() - startDispatches;
+        if (frameNumber > 0 && dispatches > 0) {
+            printf("Made %.1f device-level vulkan calls per frame on average, %llu at most!\n",
+                   cast(double) dispatches / cast(double) frameNumber,
+                   cast(unsigned long long) maxFrameDispatches);
+        }
+        if (benchPath &&
+            WriteBenchResult(benchPath, frameNumber, framesInFlight, elapsedSeconds, profiler, hostAllocator, deviceAllocator)) {
+            printf("Wrote the benchmark result to '%s'!\n", benchPath);
+        }
     }
 
-    vkDeviceWaitIdle(device);
-    vkDestroySemaphore(device, renderFinishedSemaphore, allocator);
-    vkDestroySemaphore(device, imageAvailableSemaphore, allocator);
-    vkDestroyCommandPool(device, graphicsCommandPool, allocator);
-    for (uint32_t i = 0; i < swapchainImageCount; i++) {
-        vkDestroyImageView(device, swapchainImageViews[i], allocator);
+    // Every submission is covered by one of the timelines, only presentation has to be waited for separately
+    TimelineWait(graphicsTimeline, graphicsTimeline->LastSubmittedValue);
+    TimelineWait(compute->Timeline, compute->Timeline->LastSubmittedValue);
+    TimelineWait(uploader->Timeline, uploader->Timeline->LastSubmittedValue);
+    VkCheck(vkQueueWaitIdle(presentQueue));
+    if (defragmentValue > 0) {
+        DeviceAllocatorEndDefragment(deviceAllocator);
     }
-    vkDestroySwapchainKHR(device, swapchain, allocator);
+    CommandRecorderDestroy(recorder);
+    if (computeItems > 0) {
+        if (frameNumber > 0) {
+            // The last frame's copy is the newest one, everything is idle so it can be read directly
+            uint32_t lastSlot          = cast(uint32_t)((frameNumber - 1) % framesInFlight);
+            DeviceAllocation* readback = readbackAllocations[lastSlot];
+            const uint32_t* values     = readback->Mapped;
+            uint32_t seed              = cast(uint32_t)(frameNumber - 1);
+            uint32_t mismatches        = 0;
+            VkCheck(DeviceAllocatorInvalidate(deviceAllocator, readback, 0, ComputeReadbackCount * sizeof(uint32_t)));
+            for (uint32_t i = 0; i < ComputeReadbackCount; i++) {
+                if (values[i] != i * 1664525u + seed) {
+                    mismatches++;
+                }
+            }
+            printf("Compute results %s, %d of %d values were wrong!\n",
+                   mismatches == 0 ? "verified" : "are broken",
+                   mismatches,
+                   ComputeReadbackCount);
+        }
+        for (uint32_t i = 0; i < framesInFlight; i++) {
+            vkDestroyBuffer(device, readbackBuffers[i], allocator);
+            DeviceAllocatorFree(deviceAllocator, readbackAllocations[i]);
+            BindlessRemove(bindless, BindlessType_StorageBuffer, computeBufferIndices[i]);
+            vkDestroyBuffer(device, computeBuffers[i], allocator);
+            DeviceAllocatorFree(deviceAllocator, computeBufferAllocations[i]);
+        }
+        ComputePipelineDestroy(compute, fillPipeline);
+    }
+    if (spriteBatch) {
+        if (spriteFrames > 0) {
+            printf("Batching %u sprites took %.3fms on average and %.3fms at most on the CPU!\n",
+                   sprites,
+                   cast(double) spriteTime / cast(double) spriteFrames / 1e6,
+                   cast(double) spriteMaxTime / 1e6);
+        }
+        if (textureStreamer) {
+            TextureStreamerPrintStats(textureStreamer);
+            TextureStreamerDestroy(textureStreamer);
+            free(streamedTextures);
+        }
+        SpriteBatchPrintStats(spriteBatch);
+        SpriteBatchDestroy(spriteBatch);
+        free(spriteSources);
+        free(spriteMoved);
+    }
+    if (culling) {
+        if (cullingDrawn) {
+            // The visible count is the last frame's, which used the last view projection
+            float planes[6][4];
+            CullingExtractPlanes(cullingViewProjection, planes);
+            uint32_t expected = 0;
+            for (uint32_t i = 0; i < cullObjects; i++) {
+                expected += CullingIsVisible(planes, &cullingObjects[i]) ? 1 : 0;
+            }
+            printf("%s culling kept %u of %u objects, the CPU reference kept %u!\n",
+                   cullOnCpu ? "CPU" : "GPU",
+                   CullingGetVisibleCount(culling, cast(uint32_t)((frameNumber - 1) % framesInFlight)),
+                   cullObjects,
+                   expected);
+        }
+        CullingDestroy(culling);
+        free(cullingObjects);
+    }
+    if (capture) {
+        FrameCaptureFlush(capture);
+        FrameCapturePrintStats(capture);
+        FrameCaptureDestroy(capture);
+    }
+    PipelineManagerPrintStats(pipelineManager);
+    PipelineManagerDestroy(pipelineManager);
+    ComputeDestroy(compute);
+    BindlessPrintStats(bindless);
+    BindlessDestroy(bindless);
+    ShaderPrintStats();
+    UploaderPrintStats(uploader);
+    UploaderDestroy(uploader);
+    if (uploadBuffer != VK_NULL_HANDLE) {
+        vkDestroyBuffer(device, uploadBuffer, allocator);
+        DeviceAllocatorFree(deviceAllocator, uploadAllocation);
+        free(uploadData);
+    }
+    ProfilerPrintSummary(profiler);
+    if (profilePath && ProfilerDump(profiler, profilePath)) {
+        printf("Wrote the profile to '%s'!\n", profilePath);
+    }
+    ProfilerDestroy(profiler);
+    for (uint32_t i = 0; i < framesInFlight; i++) {
+        vkDestroySemaphore(device, frames[i].imageAvailableSemaphore, allocator);
+        vkDestroyCommandPool(device, frames[i].commandPool, allocator);
+    }
+    if (swapchain->RecreateCount > 0) {
+        printf("Recreated the swapchain %d times!\n", swapchain->RecreateCount);
+    }
+    SwapchainDestroy(swapchain);
+    PresentDestroy(present);
+    TimelineDestroy(graphicsTimeline);
+    PipelineCacheDestroy(pipelineCache);
+    RenderGraphPrintStats(renderGraph);
+    RenderGraphDestroy(renderGraph);
+    MemoryBudgetPrintStats(memoryBudget);
+    MemoryBudgetDestroy(memoryBudget);
+    DeviceAllocatorPrintStats(deviceAllocator);
+    DeviceAllocatorDestroy(deviceAllocator);
     vkDestroyDevice(device, allocator);
 
     vkDestroySurfaceKHR(instance, surface, allocator);
+#if defined(VULKAN_DEBUG)
     {
         PFN_vkDestroyDebugUtilsMessengerEXT vkDestroyDebugUtilsMessengerEXT =
             cast(PFN_vkDestroyDebugUtilsMessengerEXT) vkGetInstanceProcAddr(instance, "vkDestroyDebugUtilsMessengerEXT");
         assert(vkDestroyDebugUtilsMessengerEXT);
         vkDestroyDebugUtilsMessengerEXT(instance, debugMessenger, allocator);
     }
+#endif
     vkDestroyInstance(instance, allocator);
+#if defined(VULKAN_DEBUG)
+    LoggerFlush(logger);
+    LoggerPrintStats(logger);
+    LoggerDestroy(logger);
+#endif
+
+    HostAllocatorPrintStats(hostAllocator);
+    HostAllocatorDestroy(hostAllocator);
+    LoaderShutdown();
 
-    DestroyWindow(windowHandle);
-    UnregisterClassA(WindowClassName, hinstance);
+    platform->Shutdown();
 
     return 0;
 }
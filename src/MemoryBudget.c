@@ -0,0 +1,159 @@
+#include "MemoryBudget.h"
+
+static const uint32_t MemoryBudgetEnterPercents[MemoryPressureCount] = {
+    [MemoryPressure_Elevated] = MemoryBudgetElevatedPercent,
+    [MemoryPressure_Critical] = MemoryBudgetCriticalPercent,
+};
+
+static MemoryPressure MemoryBudgetNextPressure(MemoryPressure current, VkDeviceSize usage, VkDeviceSize budget) {
+    MemoryPressure pressure = MemoryPressure_None;
+    for (uint32_t level = MemoryPressure_Elevated; level < MemoryPressureCount; level++) {
+        // Levels up to the current one are held until usage is clearly below where they start
+        uint32_t percent = MemoryBudgetEnterPercents[level] - (level <= current ? MemoryBudgetHysteresisPercent : 0);
+        if (usage * 100 >= budget * percent) {
+            pressure = cast(MemoryPressure) level;
+        }
+    }
+    return pressure;
+}
+
+MemoryBudget* MemoryBudgetCreate(VkPhysicalDevice physicalDevice,
+                                 DeviceAllocator* deviceAllocator,
+                                 bool memoryBudgetExtension,
+                                 VkDeviceSize limit) {
+    MemoryBudget* budget = calloc(1, sizeof(MemoryBudget));
+    if (budget == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate the memory budget!\n");
+        exit(1);
+    }
+    budget->PhysicalDevice  = physicalDevice;
+    budget->DeviceAllocator = deviceAllocator;
+    budget->Extension       = memoryBudgetExtension;
+    budget->Limit           = limit;
+
+    VkPhysicalDeviceMemoryProperties properties = {};
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &properties);
+    budget->HeapCount = properties.memoryHeapCount;
+    for (uint32_t i = 0; i < budget->HeapCount; i++) {
+        budget->Heaps[i] = (MemoryBudgetHeap){
+            .Flags       = properties.memoryHeaps[i].flags,
+            .Size        = properties.memoryHeaps[i].size,
+            .MinHeadroom = INT64_MAX,
+        };
+    }
+    MemoryBudgetUpdate(budget);
+    return budget;
+}
+
+void MemoryBudgetDestroy(MemoryBudget* budget) {
+    free(budget);
+}
+
+void MemoryBudgetAddListener(MemoryBudget* budget, MemoryBudgetCallback callback, void* userData) {
+    if (budget->ListenerCount == MemoryBudgetMaxListeners) {
+        fflush(stdout);
+        fprintf(stderr, "More than %d memory budget listeners!\n", MemoryBudgetMaxListeners);
+        exit(1);
+    }
+    budget->Listeners[budget->ListenerCount++] = (MemoryBudgetListener){
+        .Callback = callback,
+        .UserData = userData,
+    };
+    // Late listeners hear about pressure that started before they were added
+    for (uint32_t i = 0; i < budget->HeapCount; i++) {
+        if (budget->Heaps[i].Pressure != MemoryPressure_None) {
+            callback(userData, i, &budget->Heaps[i]);
+        }
+    }
+}
+
+void MemoryBudgetUpdate(MemoryBudget* budget) {
+    // The driver's numbers are fresh on every query, it's cheap enough to do once per frame
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT,
+    };
+    if (budget->Extension) {
+        vkGetPhysicalDeviceMemoryProperties2(budget->PhysicalDevice,
+                                             &(VkPhysicalDeviceMemoryProperties2){
+                                                 .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2,
+                                                 .pNext = &budgetProperties,
+                                             });
+    }
+    budget->UpdateCount++;
+
+    for (uint32_t i = 0; i < budget->HeapCount; i++) {
+        MemoryBudgetHeap* heap = &budget->Heaps[i];
+        heap->AllocatorBytes   = DeviceAllocatorGetHeapStats(budget->DeviceAllocator, i).BlockBytes;
+        if (budget->Extension) {
+            heap->Budget = budgetProperties.heapBudget[i];
+            heap->Usage  = budgetProperties.heapUsage[i];
+        } else {
+            heap->Budget = heap->Size / 100 * MemoryBudgetFallbackPercent;
+            heap->Usage  = heap->AllocatorBytes;
+        }
+        if (budget->Limit > 0 && heap->Budget > budget->Limit) {
+            heap->Budget = budget->Limit;
+        }
+        if (heap->Usage > heap->PeakUsage) {
+            heap->PeakUsage = heap->Usage;
+        }
+        int64_t headroom = cast(int64_t) heap->Budget - cast(int64_t) heap->Usage;
+        if (headroom < heap->MinHeadroom) {
+            heap->MinHeadroom = headroom;
+        }
+
+        MemoryPressure pressure = MemoryBudgetNextPressure(heap->Pressure, heap->Usage, heap->Budget);
+        heap->Frames[pressure]++;
+        if (pressure == heap->Pressure) {
+            continue;
+        }
+        printf("Heap %u went from %s to %s memory pressure, using %.1fMB of a %.1fMB budget!\n",
+               i,
+               MemoryPressureName(heap->Pressure),
+               MemoryPressureName(pressure),
+               cast(double) heap->Usage / (1024.0 * 1024.0),
+               cast(double) heap->Budget / (1024.0 * 1024.0));
+        heap->Pressure = pressure;
+        budget->Events++;
+        DeviceAllocatorSetHeapPressured(budget->DeviceAllocator, i, pressure != MemoryPressure_None);
+        for (uint32_t j = 0; j < budget->ListenerCount; j++) {
+            budget->Listeners[j].Callback(budget->Listeners[j].UserData, i, heap);
+        }
+    }
+}
+
+const char* MemoryPressureName(MemoryPressure pressure) {
+    return pressure == MemoryPressure_None       ? "no"
+           : pressure == MemoryPressure_Elevated ? "elevated"
+           : pressure == MemoryPressure_Critical ? "critical"
+                                                 : "unknown";
+}
+
+void MemoryBudgetPrintStats(const MemoryBudget* budget) {
+    printf("Tracked memory budgets %s over %llu updates, %llu pressure changes!\n",
+           budget->Extension ? "from VK_EXT_memory_budget" : "as a share of the heap sizes",
+           cast(unsigned long long) budget->UpdateCount,
+           cast(unsigned long long) budget->Events);
+    printf("%-6s %-12s %12s %12s %12s %14s %10s %10s\n",
+           "Heap",
+           "Flags",
+           "Size(MB)",
+           "Budget(MB)",
+           "Peak(MB)",
+           "Headroom(MB)",
+           "Elevated",
+           "Critical");
+    for (uint32_t i = 0; i < budget->HeapCount; i++) {
+        const MemoryBudgetHeap* heap = &budget->Heaps[i];
+        printf("%-6u %-12s %12.1f %12.1f %12.1f %14.1f %10llu %10llu\n",
+               i,
+               (heap->Flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? "DeviceLocal" : "Host",
+               cast(double) heap->Size / (1024.0 * 1024.0),
+               cast(double) heap->Budget / (1024.0 * 1024.0),
+               cast(double) heap->PeakUsage / (1024.0 * 1024.0),
+               cast(double) heap->MinHeadroom / (1024.0 * 1024.0),
+               cast(unsigned long long) heap->Frames[MemoryPressure_Elevated],
+               cast(unsigned long long) heap->Frames[MemoryPressure_Critical]);
+    }
+}
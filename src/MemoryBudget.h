@@ -0,0 +1,83 @@
+#pragma once
+
+#include "Common.h"
+#include "DeviceAllocator.h"
+
+#define MemoryBudgetMaxListeners 8
+// Usage past these percentages of a heap's budget raises its pressure, it only drops again once usage is
+// MemoryBudgetHysteresisPercent below, so a heap hovering around a threshold doesn't flood listeners with events
+#define MemoryBudgetElevatedPercent   80
+#define MemoryBudgetCriticalPercent   95
+#define MemoryBudgetHysteresisPercent 10
+// Without VK_EXT_memory_budget the budget is this share of the heap, the rest is left to other processes and the
+// driver's own allocations
+#define MemoryBudgetFallbackPercent 80
+
+typedef enum MemoryPressure {
+    MemoryPressure_None,
+    // Caches and optional resources should shrink
+    MemoryPressure_Elevated,
+    // Allocations are about to fail, drop everything that can be rebuilt
+    MemoryPressure_Critical,
+    MemoryPressureCount,
+} MemoryPressure;
+
+typedef struct MemoryBudgetHeap {
+    VkMemoryHeapFlags Flags;
+    VkDeviceSize Size;
+    // What this process may use, and what it does use, as of the last update
+    VkDeviceSize Budget;
+    VkDeviceSize Usage;
+    // The device allocator's share of Usage
+    VkDeviceSize AllocatorBytes;
+    VkDeviceSize PeakUsage;
+    // Smallest distance between usage and budget seen, negative once the budget was exceeded
+    int64_t MinHeadroom;
+    MemoryPressure Pressure;
+    // Updates spent at each pressure level
+    uint64_t Frames[MemoryPressureCount];
+} MemoryBudgetHeap;
+
+// Called on the thread that updates the budget whenever a heap's pressure changes
+typedef void (*MemoryBudgetCallback)(void* userData, uint32_t heapIndex, const MemoryBudgetHeap* heap);
+
+typedef struct MemoryBudgetListener {
+    MemoryBudgetCallback Callback;
+    void* UserData;
+} MemoryBudgetListener;
+
+// Tracks how much of each memory heap the process uses against how much it may use. With VK_EXT_memory_budget both
+// come from the driver, which accounts for other processes sharing the GPU, otherwise usage is what the device
+// allocator holds and the budget a fixed share of the heap. Every update turns the numbers into a pressure level per
+// heap and tells listeners when one changes, so resources are dropped before allocations start to fail. The device
+// allocator itself is told first, it stops keeping empty blocks around on heaps under pressure. Only to be used from
+// one thread.
+typedef struct MemoryBudget {
+    VkPhysicalDevice PhysicalDevice;
+    DeviceAllocator* DeviceAllocator;
+    bool Extension;
+    // Caps every heap's budget when nonzero, to test how the renderer degrades on a shared GPU
+    VkDeviceSize Limit;
+    uint32_t HeapCount;
+    MemoryBudgetHeap Heaps[VK_MAX_MEMORY_HEAPS];
+    uint32_t ListenerCount;
+    MemoryBudgetListener Listeners[MemoryBudgetMaxListeners];
+    uint64_t UpdateCount;
+    uint64_t Events;
+} MemoryBudget;
+
+// memoryBudgetExtension is whether VK_EXT_memory_budget was enabled on the device. limit caps the budget of every
+// heap, 0 leaves them as the driver reports them.
+MemoryBudget* MemoryBudgetCreate(VkPhysicalDevice physicalDevice,
+                                 DeviceAllocator* deviceAllocator,
+                                 bool memoryBudgetExtension,
+                                 VkDeviceSize limit);
+void MemoryBudgetDestroy(MemoryBudget* budget);
+
+// Listeners are told about every heap, they pick the ones their resources live in by the heap's flags
+void MemoryBudgetAddListener(MemoryBudget* budget, MemoryBudgetCallback callback, void* userData);
+// Reads the current usage and budget of every heap and publishes pressure changes, call it once per frame
+void MemoryBudgetUpdate(MemoryBudget* budget);
+
+const char* MemoryPressureName(MemoryPressure pressure);
+void MemoryBudgetPrintStats(const MemoryBudget* budget);
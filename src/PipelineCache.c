@@ -0,0 +1,260 @@
+#include "PipelineCache.h"
+#include "Shader.h"
+#include "System.h"
+
+#define PipelineCacheFileMagic   0x43504B56 // "VKPC"
+#define PipelineCacheFileVersion 1
+
+typedef struct PipelineCacheFileHeader {
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t VendorId;
+    uint32_t DeviceId;
+    uint32_t DriverVersion;
+    uint8_t PipelineCacheUuid[VK_UUID_SIZE];
+    uint32_t Padding;
+    uint64_t DataSize;
+    uint64_t DataHash;
+} PipelineCacheFileHeader;
+
+static uint64_t PipelineCacheHash(const uint8_t* data, size_t size) {
+    // FNV-1a
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 0x100000001B3ull;
+    }
+    return hash;
+}
+
+// Returns NULL if the file can be used, otherwise the reason it was rejected
+static const char* PipelineCacheValidate(const PipelineCache* pipelineCache, const uint8_t* fileData, size_t fileSize) {
+    PipelineCacheFileHeader header = {};
+    if (fileSize < sizeof(header)) {
+        return "the file is truncated";
+    }
+    memcpy(&header, fileData, sizeof(header));
+    if (header.Magic != PipelineCacheFileMagic || header.Version != PipelineCacheFileVersion) {
+        return "the file is not a pipeline cache or from a different version";
+    }
+    if (header.VendorId != pipelineCache->VendorId || header.DeviceId != pipelineCache->DeviceId ||
+        header.DriverVersion != pipelineCache->DriverVersion ||
+        memcmp(header.PipelineCacheUuid, pipelineCache->PipelineCacheUuid, VK_UUID_SIZE) != 0) {
+        return "it was written by a different device or driver";
+    }
+    if (header.DataSize != fileSize - sizeof(header)) {
+        return "the file is truncated";
+    }
+    const uint8_t* data = fileData + sizeof(header);
+    if (header.DataHash != PipelineCacheHash(data, header.DataSize)) {
+        return "the contents are corrupted";
+    }
+
+    // The driver validates its own header too, but some drivers have been known to crash on bad data instead
+    VkPipelineCacheHeaderVersionOne vulkanHeader = {};
+    if (header.DataSize < sizeof(vulkanHeader)) {
+        return "the Vulkan header is truncated";
+    }
+    memcpy(&vulkanHeader, data, sizeof(vulkanHeader));
+    if (vulkanHeader.headerSize < sizeof(vulkanHeader) || vulkanHeader.headerSize > header.DataSize ||
+        vulkanHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE || vulkanHeader.vendorID != pipelineCache->VendorId ||
+        vulkanHeader.deviceID != pipelineCache->DeviceId ||
+        memcmp(vulkanHeader.pipelineCacheUUID, pipelineCache->PipelineCacheUuid, VK_UUID_SIZE) != 0) {
+        return "the Vulkan header does not match this device";
+    }
+    return NULL;
+}
+
+PipelineCache* PipelineCacheCreate(VkDevice device, VkPhysicalDevice physicalDevice, const char* path, const VkAllocationCallbacks* allocator) {
+    PipelineCache* pipelineCache = calloc(1, sizeof(PipelineCache));
+    if (pipelineCache == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate the pipeline cache!\n");
+        exit(1);
+    }
+    pipelineCache->Device    = device;
+    pipelineCache->Allocator = allocator;
+    pipelineCache->Path      = path;
+
+    VkPhysicalDeviceProperties properties = {};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    pipelineCache->VendorId      = properties.vendorID;
+    pipelineCache->DeviceId      = properties.deviceID;
+    pipelineCache->DriverVersion = properties.driverVersion;
+    memcpy(pipelineCache->PipelineCacheUuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+    const void* initialData = NULL;
+    size_t initialDataSize  = 0;
+    SystemMappedFile file   = {};
+    if (SystemMapFile(path, &file)) {
+        const char* rejectReason = PipelineCacheValidate(pipelineCache, file.Data, file.Size);
+        if (rejectReason == NULL) {
+            initialData     = file.Data + sizeof(PipelineCacheFileHeader);
+            initialDataSize = file.Size - sizeof(PipelineCacheFileHeader);
+        } else {
+            printf("Ignoring the pipeline cache at '%s' because %s!\n", path, rejectReason);
+        }
+    }
+
+    VkResult pipelineCacheCreateResult = vkCreatePipelineCache(device,
+                                                               &(VkPipelineCacheCreateInfo){
+                                                                   .sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+                                                                   .initialDataSize = initialDataSize,
+                                                                   .pInitialData    = initialData,
+                                                               },
+                                                               allocator,
+                                                               &pipelineCache->Cache);
+    SystemUnmapFile(&file);
+    if (pipelineCacheCreateResult != VK_SUCCESS || pipelineCache->Cache == VK_NULL_HANDLE) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to create the pipeline cache! %x\n", pipelineCacheCreateResult);
+        exit(1);
+    }
+
+    pipelineCache->LoadedFromDisk = initialData != NULL;
+    if (pipelineCache->LoadedFromDisk) {
+        printf("Loaded %zu bytes of pipeline cache from '%s'!\n", initialDataSize, path);
+    }
+    return pipelineCache;
+}
+
+void PipelineCacheDestroy(PipelineCache* pipelineCache) {
+    PipelineCacheSave(pipelineCache);
+    vkDestroyPipelineCache(pipelineCache->Device, pipelineCache->Cache, pipelineCache->Allocator);
+    free(pipelineCache);
+}
+
+bool PipelineCacheSave(PipelineCache* pipelineCache) {
+    size_t dataSize = 0;
+    VkCheck(vkGetPipelineCacheData(pipelineCache->Device, pipelineCache->Cache, &dataSize, NULL));
+
+    uint8_t* fileData = malloc(sizeof(PipelineCacheFileHeader) + dataSize);
+    if (fileData == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate %zu bytes for saving the pipeline cache!\n", dataSize);
+        return false;
+    }
+    // The size can only grow between the two calls if another thread creates pipelines, VK_INCOMPLETE then
+    // means the data is a valid but smaller cache, which is still fine to save
+    VkResult dataResult = vkGetPipelineCacheData(pipelineCache->Device, pipelineCache->Cache, &dataSize, fileData + sizeof(PipelineCacheFileHeader));
+    if (dataResult != VK_INCOMPLETE) {
+        VkCheck(dataResult);
+    }
+
+    PipelineCacheFileHeader header = {
+        .Magic         = PipelineCacheFileMagic,
+        .Version       = PipelineCacheFileVersion,
+        .VendorId      = pipelineCache->VendorId,
+        .DeviceId      = pipelineCache->DeviceId,
+        .DriverVersion = pipelineCache->DriverVersion,
+        .DataSize      = dataSize,
+        .DataHash      = PipelineCacheHash(fileData + sizeof(PipelineCacheFileHeader), dataSize),
+    };
+    memcpy(header.PipelineCacheUuid, pipelineCache->PipelineCacheUuid, VK_UUID_SIZE);
+    memcpy(fileData, &header, sizeof(header));
+
+    bool success = SystemWriteFileAtomic(pipelineCache->Path, fileData, sizeof(header) + dataSize);
+    free(fileData);
+    if (!success) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to write the pipeline cache to '%s'!\n", pipelineCache->Path);
+    }
+    return success;
+}
+
+static uint64_t PipelineCacheTimePipelines(PipelineCache* pipelineCache,
+                                           VkPipelineCache cache,
+                                           VkShaderModule shaderModule,
+                                           VkPipelineLayout pipelineLayout,
+                                           uint32_t pipelineCount) {
+    VkPipeline pipelines[pipelineCount];
+    uint64_t startTime = SystemGetTimeNanoseconds();
+    for (uint32_t i = 0; i < pipelineCount; i++) {
+        // Every pipeline gets a different workgroup size so none of them are duplicates of each other
+        uint32_t localSizeX = i + 1;
+        ShaderSpecialization specialization;
+        const VkSpecializationInfo* specializationInfo = ShaderSpecialize(ShaderId_EmptyComp, &localSizeX, 1, &specialization);
+        VkCheck(vkCreateComputePipelines(pipelineCache->Device,
+                                         cache,
+                                         1,
+                                         &(VkComputePipelineCreateInfo){
+                                             .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+                                             .stage =
+                                                 (VkPipelineShaderStageCreateInfo){
+                                                     .sType               = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                                                     .stage               = VK_SHADER_STAGE_COMPUTE_BIT,
+                                                     .module              = shaderModule,
+                                                     .pName               = "main",
+                                                     .pSpecializationInfo = specializationInfo,
+                                                 },
+                                             .layout = pipelineLayout,
+                                         },
+                                         pipelineCache->Allocator,
+                                         &pipelines[i]));
+    }
+    uint64_t elapsed = SystemGetTimeNanoseconds() - startTime;
+    for (uint32_t i = 0; i < pipelineCount; i++) {
+        vkDestroyPipeline(pipelineCache->Device, pipelines[i], pipelineCache->Allocator);
+    }
+    return elapsed;
+}
+
+void PipelineCacheBenchmark(PipelineCache* pipelineCache, uint32_t pipelineCount) {
+    // Every device supports workgroups of at least 128 invocations
+    if (pipelineCount > 128) {
+        pipelineCount = 128;
+    }
+
+    VkShaderModule shaderModule     = ShaderCreateModule(pipelineCache->Device, ShaderId_EmptyComp, pipelineCache->Allocator);
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkCheck(vkCreatePipelineLayout(pipelineCache->Device,
+                                   &(VkPipelineLayoutCreateInfo){
+                                       .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+                                   },
+                                   pipelineCache->Allocator,
+                                   &pipelineLayout));
+
+    VkPipelineCache coldCache = VK_NULL_HANDLE;
+    VkCheck(vkCreatePipelineCache(pipelineCache->Device,
+                                  &(VkPipelineCacheCreateInfo){
+                                      .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+                                  },
+                                  pipelineCache->Allocator,
+                                  &coldCache));
+    uint64_t coldTime = PipelineCacheTimePipelines(pipelineCache, coldCache, shaderModule, pipelineLayout, pipelineCount);
+
+    // Round trip the cold cache through its serialized form, like a second run of the program would
+    size_t dataSize = 0;
+    VkCheck(vkGetPipelineCacheData(pipelineCache->Device, coldCache, &dataSize, NULL));
+    void* data = malloc(dataSize);
+    if (data == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate %zu bytes for the pipeline cache benchmark!\n", dataSize);
+        exit(1);
+    }
+    VkCheck(vkGetPipelineCacheData(pipelineCache->Device, coldCache, &dataSize, data));
+    VkPipelineCache warmCache = VK_NULL_HANDLE;
+    VkCheck(vkCreatePipelineCache(pipelineCache->Device,
+                                  &(VkPipelineCacheCreateInfo){
+                                      .sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+                                      .initialDataSize = dataSize,
+                                      .pInitialData    = data,
+                                  },
+                                  pipelineCache->Allocator,
+                                  &warmCache));
+    free(data);
+    uint64_t warmTime = PipelineCacheTimePipelines(pipelineCache, warmCache, shaderModule, pipelineLayout, pipelineCount);
+
+    uint64_t persistentTime = PipelineCacheTimePipelines(pipelineCache, pipelineCache->Cache, shaderModule, pipelineLayout, pipelineCount);
+
+    printf("Created %u compute pipelines: cold %.3fms, warm %.3fms, with the on-disk cache (%s) %.3fms!\n",
+           pipelineCount,
+           cast(double) coldTime / 1e6,
+           cast(double) warmTime / 1e6,
+           pipelineCache->LoadedFromDisk ? "warm" : "cold",
+           cast(double) persistentTime / 1e6);
+
+    vkDestroyPipelineCache(pipelineCache->Device, warmCache, pipelineCache->Allocator);
+    vkDestroyPipelineCache(pipelineCache->Device, coldCache, pipelineCache->Allocator);
+    vkDestroyPipelineLayout(pipelineCache->Device, pipelineLayout, pipelineCache->Allocator);
+    vkDestroyShaderModule(pipelineCache->Device, shaderModule, pipelineCache->Allocator);
+}
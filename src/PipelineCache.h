@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Common.h"
+
+// Wraps a VkPipelineCache that is loaded from disk at startup and written back on destroy. The file is
+// only accepted if it was written for the same physical device and driver, and its contents are intact.
+typedef struct PipelineCache {
+    VkDevice Device;
+    const VkAllocationCallbacks* Allocator;
+    VkPipelineCache Cache;
+    const char* Path;
+    uint32_t VendorId;
+    uint32_t DeviceId;
+    uint32_t DriverVersion;
+    uint8_t PipelineCacheUuid[VK_UUID_SIZE];
+    bool LoadedFromDisk;
+} PipelineCache;
+
+PipelineCache* PipelineCacheCreate(VkDevice device, VkPhysicalDevice physicalDevice, const char* path, const VkAllocationCallbacks* allocator);
+// Saves the cache before destroying it
+void PipelineCacheDestroy(PipelineCache* pipelineCache);
+bool PipelineCacheSave(PipelineCache* pipelineCache);
+
+// Times creating pipelineCount compute pipelines with an empty cache, with a cache warmed up in memory,
+// and with the cache that was loaded from disk, which is cold on the first run and warm afterwards
+void PipelineCacheBenchmark(PipelineCache* pipelineCache, uint32_t pipelineCount);
@@ -0,0 +1,483 @@
+#include "PipelineManager.h"
+
+// The mutex must be held
+static void PipelineManagerEnqueue(PipelineManager* manager, uint32_t index) {
+    PipelineManagerEntry* entry = &manager->Entries[index];
+    if (entry->Queued) {
+        return;
+    }
+    entry->Queued = true;
+    manager->Queue[(manager->QueueHead + manager->QueueCount) % PipelineManagerMaxPipelines] = index;
+    manager->QueueCount++;
+    SystemConditionVariableSignal(&manager->WorkAvailable);
+}
+
+// Creates the entry's modules from the reloaded code if there is any, the embedded code otherwise
+static VkResult PipelineManagerCreateModules(PipelineManager* manager, const PipelineManagerEntry* entry, VkShaderModule* modules) {
+    VkResult result = VK_SUCCESS;
+    SystemMutexLock(&manager->Mutex);
+    for (uint32_t i = 0; i < entry->ShaderCount && result == VK_SUCCESS; i++) {
+        const PipelineManagerShaderCode* reloaded = &manager->Reloaded[entry->Shaders[i]];
+        if (reloaded->Code == NULL) {
+            modules[i] = ShaderCreateModule(manager->Device, entry->Shaders[i], manager->Allocator);
+            continue;
+        }
+        // Reloaded code has passed ShaderCheckReplacement, so it's whole and matches the layout, but it can still fail
+        // to compile, which only fails the build instead of exiting
+        result = vkCreateShaderModule(manager->Device,
+                                      &(VkShaderModuleCreateInfo){
+                                          .sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+                                          .codeSize = reloaded->CodeSize,
+                                          .pCode    = reloaded->Code,
+                                      },
+                                      manager->Allocator,
+                                      &modules[i]);
+    }
+    SystemMutexUnlock(&manager->Mutex);
+    return result;
+}
+
+static VkResult PipelineManagerBuild(PipelineManager* manager, const PipelineManagerEntry* entry, VkPipeline* pipeline) {
+    VkShaderModule modules[PipelineManagerMaxStages] = {};
+    VkResult result                                  = PipelineManagerCreateModules(manager, entry, modules);
+    if (result == VK_SUCCESS && entry->Build != NULL) {
+        result = entry->Build(manager->Device, manager->PipelineCache, modules, entry->Variant, entry->UserData, pipeline);
+    } else if (result == VK_SUCCESS) {
+        ShaderSpecialization specialization;
+        VkPipelineShaderStageCreateInfo stage = {
+            .sType               = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage               = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module              = modules[0],
+            .pName               = "main",
+            .pSpecializationInfo = ShaderSpecialize(entry->Shaders[0], entry->SpecConstants, entry->SpecConstantCount, &specialization),
+        };
+        result = vkCreateComputePipelines(manager->Device,
+                                          manager->PipelineCache,
+                                          1,
+                                          &(VkComputePipelineCreateInfo){
+                                              .sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+                                              .stage  = stage,
+                                              .layout = entry->Layout,
+                                          },
+                                          manager->Allocator,
+                                          pipeline);
+    }
+    for (uint32_t i = 0; i < entry->ShaderCount; i++) {
+        vkDestroyShaderModule(manager->Device, modules[i], manager->Allocator);
+    }
+    return result;
+}
+
+static void PipelineManagerWorkerMain(void* userData) {
+    PipelineManager* manager = userData;
+
+    SystemMutexLock(&manager->Mutex);
+    while (true) {
+        while (manager->QueueCount == 0 && !manager->ShuttingDown) {
+            SystemConditionVariableWait(&manager->WorkAvailable, &manager->Mutex);
+        }
+        if (manager->ShuttingDown) {
+            break;
+        }
+        uint32_t index              = manager->Queue[manager->QueueHead];
+        PipelineManagerEntry* entry = &manager->Entries[index];
+        manager->QueueHead          = (manager->QueueHead + 1) % PipelineManagerMaxPipelines;
+        manager->QueueCount--;
+        entry->Queued = false;
+        // Another worker is on it with older code, it builds again once it's done
+        if (entry->Building) {
+            entry->Dirty = true;
+            continue;
+        }
+        entry->Building = true;
+        manager->BuildingCount++;
+
+        SystemMutexUnlock(&manager->Mutex);
+        uint64_t startTime  = SystemGetTimeNanoseconds();
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        VkResult result     = PipelineManagerBuild(manager, entry, &pipeline);
+        uint64_t elapsed    = SystemGetTimeNanoseconds() - startTime;
+        SystemMutexLock(&manager->Mutex);
+
+        manager->Stats.Builds++;
+        manager->Stats.BuildNanoseconds += elapsed;
+        if (elapsed > manager->Stats.MaxBuildNanoseconds) {
+            manager->Stats.MaxBuildNanoseconds = elapsed;
+        }
+        if (result == VK_SUCCESS) {
+            // A pipeline the render thread hasn't picked up yet was never used, so it can go right away
+            uint64_t unused = atomic_exchange_explicit(&entry->Ready, cast(uint64_t) pipeline, memory_order_acq_rel);
+            if (unused != 0) {
+                vkDestroyPipeline(manager->Device, cast(VkPipeline) unused, manager->Allocator);
+            }
+            entry->Built = true;
+        } else if (!entry->Built) {
+            fflush(stdout);
+            fprintf(stderr, "Failed to create the %s pipeline! %x\n", entry->Name, result);
+            exit(1);
+        } else {
+            // A broken reload keeps the pipeline that's in use
+            manager->Stats.Failures++;
+            fflush(stdout);
+            fprintf(stderr, "Failed to rebuild the %s pipeline, keeping the previous one! %x\n", entry->Name, result);
+        }
+        entry->Building = false;
+        manager->BuildingCount--;
+        if (entry->Dirty) {
+            entry->Dirty = false;
+            PipelineManagerEnqueue(manager, index);
+        }
+        SystemConditionVariableBroadcast(&manager->WorkDone);
+    }
+    SystemMutexUnlock(&manager->Mutex);
+}
+
+static void PipelineManagerGetShaderPath(const PipelineManager* manager, ShaderId shader, char* path, size_t pathSize) {
+    snprintf(path, pathSize, "%s/%s.spv", manager->ShaderDirectory, Shaders[shader].Name);
+}
+
+// Invalid SPIR-V is undefined behaviour in vkCreateShaderModule, so the code has to pass ShaderCheckReplacement
+// first. Returns NULL with error set if it doesn't, which also happens while the file is still being written.
+static uint32_t* PipelineManagerLoadShader(const char* path, ShaderId shader, size_t* codeSize, const char** error) {
+    SystemMappedFile file = {};
+    if (!SystemMapFile(path, &file)) {
+        *error = "the file can't be opened";
+        return NULL;
+    }
+    // Copied first, so the check sees the same words that are handed to the driver
+    uint32_t* code = malloc(file.Size > 0 ? file.Size : 1);
+    if (code == NULL) {
+        SystemUnmapFile(&file);
+        *error = "the file is too large";
+        return NULL;
+    }
+    memcpy(code, file.Data, file.Size);
+    *codeSize = file.Size;
+    SystemUnmapFile(&file);
+
+    *error = ShaderCheckReplacement(shader, code, *codeSize);
+    if (*error != NULL) {
+        free(code);
+        return NULL;
+    }
+    return code;
+}
+
+static void PipelineManagerWatcherMain(void* userData) {
+    PipelineManager* manager = userData;
+    while (true) {
+        SystemSleep(PipelineManagerWatchMilliseconds);
+        SystemMutexLock(&manager->Mutex);
+        bool shuttingDown = manager->ShuttingDown;
+        SystemMutexUnlock(&manager->Mutex);
+        if (shuttingDown) {
+            break;
+        }
+
+        for (uint32_t shader = 0; shader < ShaderIdCount; shader++) {
+            char path[1024];
+            PipelineManagerGetShaderPath(manager, cast(ShaderId) shader, path, sizeof(path));
+            uint64_t modifiedTime = 0;
+            if (!SystemGetFileModifiedTime(path, &modifiedTime) || modifiedTime == manager->ModifiedTimes[shader]) {
+                continue;
+            }
+            // A file still being written keeps changing, it's only read once it stayed the same for a whole poll
+            if (modifiedTime != manager->PendingTimes[shader]) {
+                manager->PendingTimes[shader] = modifiedTime;
+                continue;
+            }
+            size_t codeSize   = 0;
+            const char* error = NULL;
+            uint32_t* code    = PipelineManagerLoadShader(path, cast(ShaderId) shader, &codeSize, &error);
+            if (code == NULL) {
+                // Looked at again on the next poll, but only reported once per change
+                if (modifiedTime != manager->RejectedTimes[shader]) {
+                    manager->RejectedTimes[shader] = modifiedTime;
+                    printf("Not reloading %s, %s!\n", Shaders[shader].Name, error);
+                }
+                continue;
+            }
+            manager->ModifiedTimes[shader] = modifiedTime;
+
+            SystemMutexLock(&manager->Mutex);
+            PipelineManagerShaderCode* reloaded = &manager->Reloaded[shader];
+            free(reloaded->Code);
+            reloaded->Code     = code;
+            reloaded->CodeSize = codeSize;
+            manager->Stats.Reloads++;
+            uint32_t rebuilds = 0;
+            for (uint32_t i = 0; i < PipelineManagerMaxPipelines; i++) {
+                const PipelineManagerEntry* entry = &manager->Entries[i];
+                for (uint32_t j = 0; entry->InUse && j < entry->ShaderCount; j++) {
+                    if (entry->Shaders[j] == shader) {
+                        PipelineManagerEnqueue(manager, i);
+                        rebuilds++;
+                        break;
+                    }
+                }
+            }
+            SystemMutexUnlock(&manager->Mutex);
+            printf("Reloaded %s, rebuilding %u pipelines!\n", Shaders[shader].Name, rebuilds);
+        }
+    }
+}
+
+PipelineManager* PipelineManagerCreate(VkDevice device,
+                                       VkPipelineCache pipelineCache,
+                                       Timeline* graphicsTimeline,
+                                       uint32_t workerCount,
+                                       const char* shaderDirectory,
+                                       const VkAllocationCallbacks* allocator) {
+    PipelineManager* manager = calloc(1, sizeof(PipelineManager));
+    if (manager == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate the pipeline manager!\n");
+        exit(1);
+    }
+    manager->Device          = device;
+    manager->Allocator       = allocator;
+    manager->PipelineCache   = pipelineCache;
+    manager->Timeline        = graphicsTimeline;
+    manager->WorkerCount     = workerCount < 1 ? 1 : workerCount > PipelineManagerMaxWorkers ? PipelineManagerMaxWorkers : workerCount;
+    manager->ShaderDirectory = shaderDirectory;
+    SystemMutexInit(&manager->Mutex);
+    SystemConditionVariableInit(&manager->WorkAvailable);
+    SystemConditionVariableInit(&manager->WorkDone);
+
+    for (uint32_t i = 0; i < manager->WorkerCount; i++) {
+        SystemThreadCreate(&manager->Workers[i], PipelineManagerWorkerMain, manager);
+    }
+    if (shaderDirectory != NULL) {
+        // Only changes after startup are reloaded, the files are expected to match the embedded code at first
+        for (uint32_t shader = 0; shader < ShaderIdCount; shader++) {
+            char path[1024];
+            PipelineManagerGetShaderPath(manager, cast(ShaderId) shader, path, sizeof(path));
+            SystemGetFileModifiedTime(path, &manager->ModifiedTimes[shader]);
+        }
+        SystemThreadCreate(&manager->Watcher, PipelineManagerWatcherMain, manager);
+        printf("Watching '%s' for shader changes!\n", shaderDirectory);
+    }
+    return manager;
+}
+
+void PipelineManagerDestroy(PipelineManager* manager) {
+    SystemMutexLock(&manager->Mutex);
+    manager->ShuttingDown = true;
+    SystemConditionVariableBroadcast(&manager->WorkAvailable);
+    SystemMutexUnlock(&manager->Mutex);
+    for (uint32_t i = 0; i < manager->WorkerCount; i++) {
+        SystemThreadJoin(&manager->Workers[i]);
+    }
+    if (manager->ShaderDirectory != NULL) {
+        SystemThreadJoin(&manager->Watcher);
+    }
+
+    for (uint32_t i = 0; i < PipelineManagerMaxPipelines; i++) {
+        PipelineManagerEntry* entry = &manager->Entries[i];
+        uint64_t ready              = atomic_load_explicit(&entry->Ready, memory_order_acquire);
+        if (ready != 0) {
+            vkDestroyPipeline(manager->Device, cast(VkPipeline) ready, manager->Allocator);
+        }
+        vkDestroyPipeline(manager->Device, entry->Current, manager->Allocator);
+    }
+    for (uint32_t i = 0; i < manager->RetiredCount; i++) {
+        vkDestroyPipeline(manager->Device, manager->Retired[i].Pipeline, manager->Allocator);
+    }
+    for (uint32_t shader = 0; shader < ShaderIdCount; shader++) {
+        free(manager->Reloaded[shader].Code);
+    }
+    SystemConditionVariableDestroy(&manager->WorkDone);
+    SystemConditionVariableDestroy(&manager->WorkAvailable);
+    SystemMutexDestroy(&manager->Mutex);
+    free(manager);
+}
+
+// Only the render thread registers pipelines, so the mutex is needed for the queue and not for finding a free entry
+static uint32_t PipelineManagerAdd(PipelineManager* manager, const PipelineManagerEntry* description) {
+    uint32_t index = 0;
+    while (index < PipelineManagerMaxPipelines && manager->Entries[index].InUse) {
+        index++;
+    }
+    if (index == PipelineManagerMaxPipelines) {
+        fflush(stdout);
+        fprintf(stderr, "More than %d pipelines registered with the pipeline manager!\n", PipelineManagerMaxPipelines);
+        exit(1);
+    }
+
+    SystemMutexLock(&manager->Mutex);
+    PipelineManagerEntry* entry = &manager->Entries[index];
+    entry->Name                 = description->Name;
+    entry->InUse                = true;
+    entry->ShaderCount          = description->ShaderCount;
+    entry->Build                = description->Build;
+    entry->UserData             = description->UserData;
+    entry->Variant              = description->Variant;
+    entry->Layout               = description->Layout;
+    entry->SpecConstantCount    = description->SpecConstantCount;
+    entry->Built                = false;
+    entry->Dirty                = false;
+    entry->Current              = VK_NULL_HANDLE;
+    memcpy(entry->Shaders, description->Shaders, sizeof(entry->Shaders));
+    memcpy(entry->SpecConstants, description->SpecConstants, sizeof(entry->SpecConstants));
+    atomic_store_explicit(&entry->Ready, 0, memory_order_relaxed);
+    PipelineManagerEnqueue(manager, index);
+    SystemMutexUnlock(&manager->Mutex);
+    return index;
+}
+
+uint32_t PipelineManagerAddCompute(PipelineManager* manager,
+                                   const char* name,
+                                   ShaderId shader,
+                                   VkPipelineLayout layout,
+                                   const uint32_t* specConstants,
+                                   uint32_t specConstantCount) {
+    assert(Shaders[shader].Stage == VK_SHADER_STAGE_COMPUTE_BIT);
+    assert(specConstantCount <= ShaderMaxSpecConstants);
+    PipelineManagerEntry description = {
+        .Name              = name,
+        .Shaders           = { shader },
+        .ShaderCount       = 1,
+        .Layout            = layout,
+        .SpecConstantCount = specConstantCount,
+    };
+    for (uint32_t i = 0; i < specConstantCount; i++) {
+        description.SpecConstants[i] = specConstants[i];
+    }
+    return PipelineManagerAdd(manager, &description);
+}
+
+uint32_t PipelineManagerAddGraphics(PipelineManager* manager,
+                                    const char* name,
+                                    const ShaderId* shaders,
+                                    uint32_t shaderCount,
+                                    PipelineManagerBuildCallback build,
+                                    uint32_t variant,
+                                    void* userData) {
+    assert(shaderCount > 0 && shaderCount <= PipelineManagerMaxStages);
+    PipelineManagerEntry description = {
+        .Name        = name,
+        .ShaderCount = shaderCount,
+        .Build       = build,
+        .UserData    = userData,
+        .Variant     = variant,
+    };
+    for (uint32_t i = 0; i < shaderCount; i++) {
+        description.Shaders[i] = shaders[i];
+    }
+    return PipelineManagerAdd(manager, &description);
+}
+
+static void PipelineManagerRetire(PipelineManager* manager, VkPipeline pipeline) {
+    if (manager->RetiredCount == PipelineManagerMaxRetired) {
+        // Only happens when shaders are reloaded faster than frames finish
+        TimelineWait(manager->Timeline, manager->Timeline->LastSubmittedValue);
+        for (uint32_t i = 0; i < manager->RetiredCount; i++) {
+            vkDestroyPipeline(manager->Device, manager->Retired[i].Pipeline, manager->Allocator);
+        }
+        manager->RetiredCount = 0;
+    }
+    manager->Retired[manager->RetiredCount++] = (PipelineManagerRetired){
+        .Pipeline = pipeline,
+        .Value    = manager->Timeline->LastSubmittedValue,
+    };
+}
+
+void PipelineManagerRemove(PipelineManager* manager, uint32_t pipeline) {
+    assert(pipeline < PipelineManagerMaxPipelines && manager->Entries[pipeline].InUse);
+    PipelineManagerEntry* entry = &manager->Entries[pipeline];
+
+    SystemMutexLock(&manager->Mutex);
+    if (entry->Queued) {
+        uint32_t kept = 0;
+        for (uint32_t i = 0; i < manager->QueueCount; i++) {
+            uint32_t index = manager->Queue[(manager->QueueHead + i) % PipelineManagerMaxPipelines];
+            if (index != pipeline) {
+                manager->Queue[(manager->QueueHead + kept++) % PipelineManagerMaxPipelines] = index;
+            }
+        }
+        manager->QueueCount = kept;
+        entry->Queued       = false;
+    }
+    entry->Dirty = false;
+    // The build callback may still be reading the owner's state
+    while (entry->Building) {
+        SystemConditionVariableWait(&manager->WorkDone, &manager->Mutex);
+    }
+    entry->InUse = false;
+    SystemMutexUnlock(&manager->Mutex);
+
+    uint64_t ready = atomic_exchange_explicit(&entry->Ready, 0, memory_order_acq_rel);
+    if (ready != 0) {
+        vkDestroyPipeline(manager->Device, cast(VkPipeline) ready, manager->Allocator);
+    }
+    if (entry->Current != VK_NULL_HANDLE) {
+        PipelineManagerRetire(manager, entry->Current);
+        entry->Current = VK_NULL_HANDLE;
+    }
+}
+
+void PipelineManagerBeginFrame(PipelineManager* manager) {
+    uint64_t startTime      = SystemGetTimeNanoseconds();
+    uint64_t completedValue = TimelineGetCompletedValue(manager->Timeline);
+    uint32_t kept           = 0;
+    for (uint32_t i = 0; i < manager->RetiredCount; i++) {
+        if (manager->Retired[i].Value <= completedValue) {
+            vkDestroyPipeline(manager->Device, manager->Retired[i].Pipeline, manager->Allocator);
+        } else {
+            manager->Retired[kept++] = manager->Retired[i];
+        }
+    }
+    manager->RetiredCount = kept;
+
+    for (uint32_t i = 0; i < PipelineManagerMaxPipelines; i++) {
+        PipelineManagerEntry* entry = &manager->Entries[i];
+        if (!entry->InUse || atomic_load_explicit(&entry->Ready, memory_order_relaxed) == 0) {
+            continue;
+        }
+        uint64_t ready = atomic_exchange_explicit(&entry->Ready, 0, memory_order_acq_rel);
+        if (entry->Current != VK_NULL_HANDLE) {
+            PipelineManagerRetire(manager, entry->Current);
+        }
+        entry->Current = cast(VkPipeline) ready;
+        manager->Stats.Swaps++;
+    }
+
+    uint64_t elapsed = SystemGetTimeNanoseconds() - startTime;
+    if (elapsed > manager->Stats.MaxBeginFrameNanoseconds) {
+        manager->Stats.MaxBeginFrameNanoseconds = elapsed;
+    }
+}
+
+VkPipeline PipelineManagerGet(PipelineManager* manager, uint32_t pipeline) {
+    assert(pipeline < PipelineManagerMaxPipelines && manager->Entries[pipeline].InUse);
+    VkPipeline current = manager->Entries[pipeline].Current;
+    if (current == VK_NULL_HANDLE) {
+        manager->Stats.NotReady++;
+    }
+    return current;
+}
+
+void PipelineManagerWaitIdle(PipelineManager* manager) {
+    SystemMutexLock(&manager->Mutex);
+    while (manager->QueueCount > 0 || manager->BuildingCount > 0) {
+        SystemConditionVariableWait(&manager->WorkDone, &manager->Mutex);
+    }
+    SystemMutexUnlock(&manager->Mutex);
+}
+
+void PipelineManagerPrintStats(PipelineManager* manager) {
+    SystemMutexLock(&manager->Mutex);
+    PipelineManagerStats stats = manager->Stats;
+    SystemMutexUnlock(&manager->Mutex);
+    printf("Built %llu pipelines on %u threads in %.3fms, %.3fms at most, %llu rebuilds failed after %llu shader reloads!\n",
+           cast(unsigned long long) stats.Builds,
+           manager->WorkerCount,
+           cast(double) stats.BuildNanoseconds / 1e6,
+           cast(double) stats.MaxBuildNanoseconds / 1e6,
+           cast(unsigned long long) stats.Failures,
+           cast(unsigned long long) stats.Reloads);
+    printf("Swapped in %llu pipelines, %llu lookups found nothing ready, the render thread spent %.3fms at most per frame!\n",
+           cast(unsigned long long) stats.Swaps,
+           cast(unsigned long long) stats.NotReady,
+           cast(double) stats.MaxBeginFrameNanoseconds / 1e6);
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "Common.h"
+#include "Shader.h"
+#include "System.h"
+#include "Timeline.h"
+
+#include <stdatomic.h>
+
+#define PipelineManagerMaxPipelines 64
+#define PipelineManagerMaxStages    2
+#define PipelineManagerMaxWorkers   4
+// Replaced pipelines waiting for the frames that used them, beyond that BeginFrame waits for the GPU
+#define PipelineManagerMaxRetired 128
+// How often the watcher thread looks at the shader files
+#define PipelineManagerWatchMilliseconds 250
+
+// Creates a graphics pipeline from modules, which hold the shaders the pipeline was added with in the same order.
+// Called on a worker thread, so it may only read state that doesn't change while the pipeline is registered.
+typedef VkResult (*PipelineManagerBuildCallback)(VkDevice device,
+                                                VkPipelineCache pipelineCache,
+                                                const VkShaderModule* modules,
+                                                uint32_t variant,
+                                                void* userData,
+                                                VkPipeline* pipeline);
+
+typedef struct PipelineManagerEntry {
+    const char* Name;
+    bool InUse;
+    ShaderId Shaders[PipelineManagerMaxStages];
+    uint32_t ShaderCount;
+    // Graphics pipelines are built by the callback
+    PipelineManagerBuildCallback Build;
+    void* UserData;
+    uint32_t Variant;
+    // Compute pipelines are built by the manager, SpecConstants is indexed by constant_id
+    VkPipelineLayout Layout;
+    uint32_t SpecConstants[ShaderMaxSpecConstants];
+    uint32_t SpecConstantCount;
+
+    // Guarded by the mutex
+    bool Queued;
+    bool Building;
+    // Queued again while it was building, so it's built once more with the newer code afterwards
+    bool Dirty;
+    bool Built;
+
+    // Handed from the worker that built it to PipelineManagerBeginFrame, 0 while nothing new is waiting
+    atomic_uint_least64_t Ready;
+    // Only touched by the render thread
+    VkPipeline Current;
+} PipelineManagerEntry;
+
+typedef struct PipelineManagerRetired {
+    VkPipeline Pipeline;
+    // Graphics timeline value after which nothing uses the pipeline anymore
+    uint64_t Value;
+} PipelineManagerRetired;
+
+// Shader code loaded from disk to replace the embedded one
+typedef struct PipelineManagerShaderCode {
+    uint32_t* Code;
+    size_t CodeSize;
+} PipelineManagerShaderCode;
+
+typedef struct PipelineManagerStats {
+    // Guarded by the mutex
+    uint64_t Builds;
+    uint64_t Failures;
+    uint64_t Reloads;
+    uint64_t BuildNanoseconds;
+    uint64_t MaxBuildNanoseconds;
+    // Render thread only
+    uint64_t Swaps;
+    uint64_t NotReady;
+    uint64_t MaxBeginFrameNanoseconds;
+} PipelineManagerStats;
+
+// Creates pipelines on worker threads so the render thread never stalls on a driver compile. Every pipeline is
+// registered once and referred to by its index from then on. Workers build it with the shared VkPipelineCache,
+// which Vulkan synchronizes internally, and hand it over through an atomic slot. PipelineManagerBeginFrame swaps it
+// in at the next frame boundary. Until then PipelineManagerGet returns VK_NULL_HANDLE, and callers skip the work
+// that needs the pipeline. With a shader directory, a watcher thread polls <directory>/<Name>.spv for changes. It
+// rebuilds every pipeline using a changed shader from the new code in the background. The old pipeline stays in use
+// until the new one is ready, and is destroyed once the graphics timeline shows no frame uses it. Reloaded code has
+// to keep the embedded shader's interface, since layouts and push constants come from the build-time reflection,
+// files that don't are reported and skipped, see ShaderCheckReplacement.
+// Registering, removing, getting and BeginFrame are only for the render thread.
+typedef struct PipelineManager {
+    VkDevice Device;
+    const VkAllocationCallbacks* Allocator;
+    VkPipelineCache PipelineCache;
+    Timeline* Timeline;
+    uint32_t WorkerCount;
+    SystemThread Workers[PipelineManagerMaxWorkers];
+    const char* ShaderDirectory;
+    SystemThread Watcher;
+    // Watcher thread only, the times of the files last loaded, last seen and last rejected
+    uint64_t ModifiedTimes[ShaderIdCount];
+    uint64_t PendingTimes[ShaderIdCount];
+    uint64_t RejectedTimes[ShaderIdCount];
+
+    SystemMutex Mutex;
+    SystemConditionVariable WorkAvailable;
+    SystemConditionVariable WorkDone;
+    bool ShuttingDown;
+    uint32_t Queue[PipelineManagerMaxPipelines];
+    uint32_t QueueHead;
+    uint32_t QueueCount;
+    uint32_t BuildingCount;
+    PipelineManagerShaderCode Reloaded[ShaderIdCount];
+
+    PipelineManagerEntry Entries[PipelineManagerMaxPipelines];
+    uint32_t RetiredCount;
+    PipelineManagerRetired Retired[PipelineManagerMaxRetired];
+    PipelineManagerStats Stats;
+} PipelineManager;
+
+// shaderDirectory can be NULL to not watch anything. graphicsTimeline tells when replaced pipelines can be destroyed.
+PipelineManager* PipelineManagerCreate(VkDevice device,
+                                       VkPipelineCache pipelineCache,
+                                       Timeline* graphicsTimeline,
+                                       uint32_t workerCount,
+                                       const char* shaderDirectory,
+                                       const VkAllocationCallbacks* allocator);
+// The device must be idle, builds that haven't started yet are dropped
+void PipelineManagerDestroy(PipelineManager* manager);
+
+// specConstants[i] is the value of constant_id i, constants past specConstantCount keep their defaults
+uint32_t PipelineManagerAddCompute(PipelineManager* manager,
+                                   const char* name,
+                                   ShaderId shader,
+                                   VkPipelineLayout layout,
+                                   const uint32_t* specConstants,
+                                   uint32_t specConstantCount);
+// build gets the modules for shaders in the same order, variant tells apart pipelines sharing the callback
+uint32_t PipelineManagerAddGraphics(PipelineManager* manager,
+                                    const char* name,
+                                    const ShaderId* shaders,
+                                    uint32_t shaderCount,
+                                    PipelineManagerBuildCallback build,
+                                    uint32_t variant,
+                                    void* userData);
+// Waits for a running build of the pipeline, then retires it like a replaced one
+void PipelineManagerRemove(PipelineManager* manager, uint32_t pipeline);
+
+// Swaps in the pipelines that finished building and destroys the replaced ones no frame uses anymore, call it once
+// per frame before recording
+void PipelineManagerBeginFrame(PipelineManager* manager);
+// VK_NULL_HANDLE until the pipeline has been built and swapped in
+VkPipeline PipelineManagerGet(PipelineManager* manager, uint32_t pipeline);
+// Blocks until nothing is queued or building, for tools and tests that want every pipeline before the first frame
+void PipelineManagerWaitIdle(PipelineManager* manager);
+
+void PipelineManagerPrintStats(PipelineManager* manager);
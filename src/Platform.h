@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Common.h"
+
+// A platform backend owns everything the renderer needs from the outside world:
+// the surface it presents to and the event pump that decides when to stop.
+typedef struct Platform {
+    const char* Name;
+    const char* SurfaceExtensionName;
+    void (*Init)(uint32_t width, uint32_t height, const char* title);
+    void (*Shutdown)(void);
+    // Returns false once the platform wants the frame loop to stop
+    bool (*PollEvents)(void);
+    // Returns true once per request to dump the profile, F12 on Win32 and SIGUSR1 when headless
+    bool (*ConsumeDumpRequest)(void);
+    // Returns true once per change of the window's client area, GetWindowSize has the new size
+    bool (*ConsumeResize)(void);
+    void (*GetWindowSize)(uint32_t* width, uint32_t* height);
+    VkResult (*CreateSurface)(VkInstance instance, const VkAllocationCallbacks* allocator, VkSurfaceKHR* surface);
+    VkBool32 (*GetPresentationSupport)(VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex);
+} Platform;
+
+// Uses VK_EXT_headless_surface, so the swapchain and frame loop are identical to the windowed path
+// but nothing is shown. Works on software implementations like lavapipe or SwiftShader.
+extern const Platform HeadlessPlatform;
+
+#if defined(_WIN32)
+extern const Platform Win32Platform;
+#endif
@@ -0,0 +1,92 @@
+#include "Platform.h"
+
+#include <signal.h>
+
+static volatile sig_atomic_t HeadlessStopRequested = 0;
+static volatile sig_atomic_t HeadlessDumpRequested = 0;
+static uint32_t HeadlessWidth                      = 0;
+static uint32_t HeadlessHeight                     = 0;
+
+static void HeadlessSignalHandler(int signal) {
+    (void)signal;
+    HeadlessStopRequested = 1;
+}
+
+#if defined(SIGUSR1)
+static void HeadlessDumpSignalHandler(int signal) {
+    (void)signal;
+    HeadlessDumpRequested = 1;
+}
+#endif
+
+static void HeadlessInit(uint32_t width, uint32_t height, const char* title) {
+    (void)title;
+    HeadlessWidth  = width;
+    HeadlessHeight = height;
+    signal(SIGINT, HeadlessSignalHandler);
+    signal(SIGTERM, HeadlessSignalHandler);
+#if defined(SIGUSR1)
+    signal(SIGUSR1, HeadlessDumpSignalHandler);
+#endif
+}
+
+static void HeadlessShutdown(void) {
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+#if defined(SIGUSR1)
+    signal(SIGUSR1, SIG_DFL);
+#endif
+}
+
+static bool HeadlessPollEvents(void) {
+    return !HeadlessStopRequested;
+}
+
+static bool HeadlessConsumeDumpRequest(void) {
+    bool requested        = HeadlessDumpRequested != 0;
+    HeadlessDumpRequested = 0;
+    return requested;
+}
+
+static bool HeadlessConsumeResize(void) {
+    return false;
+}
+
+static void HeadlessGetWindowSize(uint32_t* width, uint32_t* height) {
+    *width  = HeadlessWidth;
+    *height = HeadlessHeight;
+}
+
+static VkResult HeadlessCreateSurface(VkInstance instance, const VkAllocationCallbacks* allocator, VkSurfaceKHR* surface) {
+    PFN_vkCreateHeadlessSurfaceEXT vkCreateHeadlessSurfaceEXT =
+        cast(PFN_vkCreateHeadlessSurfaceEXT) vkGetInstanceProcAddr(instance, "vkCreateHeadlessSurfaceEXT");
+    if (!vkCreateHeadlessSurfaceEXT) {
+        return VK_ERROR_EXTENSION_NOT_PRESENT;
+    }
+    return vkCreateHeadlessSurfaceEXT(instance,
+                                      &(VkHeadlessSurfaceCreateInfoEXT){
+                                          .sType = VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT,
+                                      },
+                                      allocator,
+                                      surface);
+}
+
+static VkBool32 HeadlessGetPresentationSupport(VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex) {
+    // Headless surfaces have no platform-specific presentation query, vkGetPhysicalDeviceSurfaceSupportKHR is enough
+    (void)physicalDevice;
+    (void)queueFamilyIndex;
+    return VK_TRUE;
+}
+
+const Platform HeadlessPlatform = {
+    .Name                   = "headless",
+    .SurfaceExtensionName   = VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME,
+    .Init                   = HeadlessInit,
+    .Shutdown               = HeadlessShutdown,
+    .PollEvents             = HeadlessPollEvents,
+    .ConsumeDumpRequest     = HeadlessConsumeDumpRequest,
+    .ConsumeResize          = HeadlessConsumeResize,
+    .GetWindowSize          = HeadlessGetWindowSize,
+    .CreateSurface          = HeadlessCreateSurface,
+    .GetPresentationSupport = HeadlessGetPresentationSupport,
+};
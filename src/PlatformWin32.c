@@ -0,0 +1,162 @@
+#define VK_USE_PLATFORM_WIN32_KHR
+#include "Platform.h"
+
+static const char* const WindowClassName = "Vulkan Testing";
+
+static HINSTANCE Win32Instance  = NULL;
+static HWND Win32WindowHandle   = NULL;
+static bool Win32CloseRequested = false;
+static bool Win32DumpRequested  = false;
+static bool Win32Resized        = false;
+static uint32_t Win32Width      = 0;
+static uint32_t Win32Height     = 0;
+
+static PFN_vkGetPhysicalDeviceWin32PresentationSupportKHR Win32GetPresentationSupportFunction = NULL;
+
+static LRESULT CALLBACK WindowMessageCallback(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) {
+    LRESULT result = 0;
+    switch (message) {
+        case WM_CLOSE: {
+            Win32CloseRequested = true;
+        } break;
+
+        case WM_SIZE: {
+            // Minimizing reports a zero size, the renderer stops presenting until it's restored
+            Win32Width   = LOWORD(lParam);
+            Win32Height  = HIWORD(lParam);
+            Win32Resized = true;
+        } break;
+
+        case WM_KEYDOWN: {
+            if (wParam == VK_F12) {
+                Win32DumpRequested = true;
+            } else {
+                result = DefWindowProcA(hWnd, message, wParam, lParam);
+            }
+        } break;
+
+        default: {
+            result = DefWindowProcA(hWnd, message, wParam, lParam);
+        } break;
+    }
+    return result;
+}
+
+static void Win32Init(uint32_t width, uint32_t height, const char* title) {
+    const DWORD WindowStyle   = WS_OVERLAPPEDWINDOW | WS_VISIBLE;
+    const DWORD WindowStyleEx = 0;
+
+    Win32Instance = GetModuleHandleA(NULL);
+    Win32Width    = width;
+    Win32Height   = height;
+
+    if (RegisterClassExA(&(WNDCLASSEXA){
+            .cbSize        = sizeof(WNDCLASSEXA),
+            .style         = CS_OWNDC,
+            .lpfnWndProc   = WindowMessageCallback,
+            .hInstance     = Win32Instance,
+            .hCursor       = LoadCursor(NULL, IDC_ARROW),
+            .lpszClassName = WindowClassName,
+        }) == 0) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to register a window class! %lx\n", GetLastError());
+        exit(1);
+    }
+
+    RECT windowRect   = {};
+    windowRect.left   = 100;
+    windowRect.right  = windowRect.left + cast(LONG) width;
+    windowRect.top    = 100;
+    windowRect.bottom = windowRect.top + cast(LONG) height;
+    if (!AdjustWindowRectEx(&windowRect, WindowStyle, false, WindowStyleEx)) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to get window rect size! %lx\n", GetLastError());
+        exit(1);
+    }
+
+    Win32WindowHandle = CreateWindowExA(WindowStyleEx,
+                                        WindowClassName,
+                                        title,
+                                        WindowStyle,
+                                        CW_USEDEFAULT,
+                                        CW_USEDEFAULT,
+                                        windowRect.right - windowRect.left,
+                                        windowRect.bottom - windowRect.top,
+                                        NULL,
+                                        NULL,
+                                        Win32Instance,
+                                        NULL);
+    if (Win32WindowHandle == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to create window! %lx\n", GetLastError());
+        exit(1);
+    }
+}
+
+static void Win32Shutdown(void) {
+    DestroyWindow(Win32WindowHandle);
+    UnregisterClassA(WindowClassName, Win32Instance);
+    Win32WindowHandle = NULL;
+}
+
+static bool Win32PollEvents(void) {
+    MSG message;
+    while (PeekMessageA(&message, Win32WindowHandle, 0, 0, PM_REMOVE)) {
+        TranslateMessage(&message);
+        DispatchMessageA(&message);
+    }
+    return !Win32CloseRequested;
+}
+
+static bool Win32ConsumeDumpRequest(void) {
+    bool requested     = Win32DumpRequested;
+    Win32DumpRequested = false;
+    return requested;
+}
+
+static bool Win32ConsumeResize(void) {
+    bool resized = Win32Resized;
+    Win32Resized = false;
+    return resized;
+}
+
+static void Win32GetWindowSize(uint32_t* width, uint32_t* height) {
+    *width  = Win32Width;
+    *height = Win32Height;
+}
+
+static VkResult Win32CreateSurface(VkInstance instance, const VkAllocationCallbacks* allocator, VkSurfaceKHR* surface) {
+    // Platform functions aren't part of the loader's tables, the surface is created before any presentation query
+    PFN_vkCreateWin32SurfaceKHR vkCreateWin32SurfaceKHR =
+        cast(PFN_vkCreateWin32SurfaceKHR) vkGetInstanceProcAddr(instance, "vkCreateWin32SurfaceKHR");
+    Win32GetPresentationSupportFunction = cast(PFN_vkGetPhysicalDeviceWin32PresentationSupportKHR)
+        vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceWin32PresentationSupportKHR");
+    if (!vkCreateWin32SurfaceKHR || !Win32GetPresentationSupportFunction) {
+        return VK_ERROR_EXTENSION_NOT_PRESENT;
+    }
+    return vkCreateWin32SurfaceKHR(instance,
+                                   &(VkWin32SurfaceCreateInfoKHR){
+                                       .sType     = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR,
+                                       .hinstance = Win32Instance,
+                                       .hwnd      = Win32WindowHandle,
+                                   },
+                                   allocator,
+                                   surface);
+}
+
+static VkBool32 Win32GetPresentationSupport(VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex) {
+    return Win32GetPresentationSupportFunction(physicalDevice, queueFamilyIndex);
+}
+
+const Platform Win32Platform = {
+    .Name                   = "win32",
+    .SurfaceExtensionName   = VK_KHR_WIN32_SURFACE_EXTENSION_NAME,
+    .Init                   = Win32Init,
+    .Shutdown               = Win32Shutdown,
+    .PollEvents             = Win32PollEvents,
+    .ConsumeDumpRequest     = Win32ConsumeDumpRequest,
+    .ConsumeResize          = Win32ConsumeResize,
+    .GetWindowSize          = Win32GetWindowSize,
+    .CreateSurface          = Win32CreateSurface,
+    .GetPresentationSupport = Win32GetPresentationSupport,
+};
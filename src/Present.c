@@ -0,0 +1,169 @@
+#include "Present.h"
+#include "System.h"
+
+static_assert((PresentMaxPendingIds & (PresentMaxPendingIds - 1)) == 0, "PresentMaxPendingIds must be a power of two");
+static_assert(PresentMaxPendingIds > PresentMaxQueuedFrames + 1, "PresentMaxPendingIds is too small");
+
+// Waiting for a frame to be shown gives up after this long, so a minimized window doesn't stall the loop forever
+#define PresentWaitTimeoutNs 100000000ull
+
+static bool PresentHasMode(const VkPresentModeKHR* modes, uint32_t modeCount, VkPresentModeKHR mode) {
+    for (uint32_t i = 0; i < modeCount; i++) {
+        if (modes[i] == mode) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* PresentModeName(VkPresentModeKHR mode) {
+    return mode == VK_PRESENT_MODE_IMMEDIATE_KHR      ? "immediate"
+           : mode == VK_PRESENT_MODE_MAILBOX_KHR      ? "mailbox"
+           : mode == VK_PRESENT_MODE_FIFO_KHR         ? "fifo"
+           : mode == VK_PRESENT_MODE_FIFO_RELAXED_KHR ? "fifo-relaxed"
+                                                      : "unknown";
+}
+
+Present* PresentCreate(VkDevice device,
+                       VkPhysicalDevice physicalDevice,
+                       VkSurfaceKHR surface,
+                       PresentGoal goal,
+                       VkPresentModeKHR requestedMode,
+                       bool presentWait) {
+    Present* present = calloc(1, sizeof(Present));
+    if (present == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate the present state!\n");
+        exit(1);
+    }
+    present->Device        = device;
+    present->Goal          = goal;
+    present->NextPresentId = 1;
+    if (presentWait) {
+        present->WaitForPresent = cast(PFN_vkWaitForPresentKHR) vkGetDeviceProcAddr(device, "vkWaitForPresentKHR");
+    }
+
+    uint32_t modeCount = 0;
+    VkCheck(vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &modeCount, NULL));
+    VkPresentModeKHR modes[modeCount];
+    VkCheck(vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &modeCount, modes));
+
+    // FIFO is the only mode every surface has to support, so it ends every list
+    static const VkPresentModeKHR LatencyModes[] = {
+        VK_PRESENT_MODE_MAILBOX_KHR,
+        VK_PRESENT_MODE_FIFO_RELAXED_KHR,
+        VK_PRESENT_MODE_FIFO_KHR,
+    };
+    static const VkPresentModeKHR PacedModes[] = {
+        VK_PRESENT_MODE_FIFO_KHR,
+    };
+    static const VkPresentModeKHR ThroughputModes[] = {
+        VK_PRESENT_MODE_IMMEDIATE_KHR,
+        VK_PRESENT_MODE_MAILBOX_KHR,
+        VK_PRESENT_MODE_FIFO_RELAXED_KHR,
+        VK_PRESENT_MODE_FIFO_KHR,
+    };
+    const VkPresentModeKHR* candidates = ThroughputModes;
+    size_t candidateCount              = sizeof(ThroughputModes) / sizeof(ThroughputModes[0]);
+    if (goal == PresentGoal_Latency && present->WaitForPresent) {
+        candidates     = PacedModes;
+        candidateCount = sizeof(PacedModes) / sizeof(PacedModes[0]);
+    } else if (goal == PresentGoal_Latency) {
+        candidates     = LatencyModes;
+        candidateCount = sizeof(LatencyModes) / sizeof(LatencyModes[0]);
+    }
+    present->Mode = VK_PRESENT_MODE_FIFO_KHR;
+    if (requestedMode != VK_PRESENT_MODE_MAX_ENUM_KHR && PresentHasMode(modes, modeCount, requestedMode)) {
+        present->Mode = requestedMode;
+    } else {
+        if (requestedMode != VK_PRESENT_MODE_MAX_ENUM_KHR) {
+            printf("The surface doesn't support %s presentation, leaving it to the goal!\n", PresentModeName(requestedMode));
+        }
+        for (size_t i = 0; i < candidateCount; i++) {
+            if (PresentHasMode(modes, modeCount, candidates[i])) {
+                present->Mode = candidates[i];
+                break;
+            }
+        }
+    }
+
+    // Every extra image is another frame that can sit in the queue, mailbox needs one to replace while another is
+    // shown and one being scanned out, throughput wants one more so acquire never waits for the display
+    VkSurfaceCapabilitiesKHR surfaceCapabilities = {};
+    VkCheck(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &surfaceCapabilities));
+    uint32_t imageCount = surfaceCapabilities.minImageCount;
+    if (goal == PresentGoal_Throughput) {
+        imageCount++;
+    }
+    if (present->Mode == VK_PRESENT_MODE_MAILBOX_KHR && imageCount < 3) {
+        imageCount = 3;
+    }
+    if (imageCount < 2) {
+        imageCount = 2;
+    }
+    if (surfaceCapabilities.maxImageCount > 0 && imageCount > surfaceCapabilities.maxImageCount) {
+        imageCount = surfaceCapabilities.maxImageCount;
+    }
+    present->ImageCount = imageCount;
+
+    return present;
+}
+
+void PresentDestroy(Present* present) {
+    free(present);
+}
+
+void PresentPace(Present* present, VkSwapchainKHR swapchain) {
+    if (present->WaitForPresent && present->Goal == PresentGoal_Latency && present->NextPresentId > PresentMaxQueuedFrames + 1) {
+        uint64_t presentId = present->NextPresentId - 1 - PresentMaxQueuedFrames;
+        if (presentId > present->WaitedPresentId) {
+            // Returns once the frame or a later one has been shown. The latency is only exact when this actually
+            // blocked, if the frame was shown a while ago it's an upper bound.
+            VkResult result = present->WaitForPresent(present->Device, swapchain, presentId, PresentWaitTimeoutNs);
+            if (result == VK_SUCCESS) {
+                present->LatencyNanoseconds =
+                    SystemGetTimeNanoseconds() - present->StartTimes[presentId & (PresentMaxPendingIds - 1)];
+            } else if (result != VK_TIMEOUT && result != VK_ERROR_OUT_OF_DATE_KHR && result != VK_SUBOPTIMAL_KHR) {
+                VkCheck(result);
+            }
+            present->WaitedPresentId = presentId;
+        }
+    }
+    present->StartTimes[present->NextPresentId & (PresentMaxPendingIds - 1)] = SystemGetTimeNanoseconds();
+}
+
+void PresentSwapchainChanged(Present* present) {
+    present->WaitedPresentId = present->NextPresentId - 1;
+}
+
+VkResult PresentQueue(Present* present, VkQueue queue, VkSwapchainKHR swapchain, uint32_t imageIndex, VkSemaphore waitSemaphore) {
+    uint64_t presentId           = present->NextPresentId++;
+    VkPresentIdKHR presentIdInfo = {
+        .sType          = VK_STRUCTURE_TYPE_PRESENT_ID_KHR,
+        .swapchainCount = 1,
+        .pPresentIds    = &presentId,
+    };
+    VkResult result = vkQueuePresentKHR(queue,
+                                        &(VkPresentInfoKHR){
+                                            .sType              = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+                                            .pNext              = present->WaitForPresent ? &presentIdInfo : NULL,
+                                            .waitSemaphoreCount = 1,
+                                            .pWaitSemaphores    = &waitSemaphore,
+                                            .swapchainCount     = 1,
+                                            .pSwapchains        = &swapchain,
+                                            .pImageIndices      = &imageIndex,
+                                        });
+    if (!present->WaitForPresent || present->Goal != PresentGoal_Latency) {
+        present->LatencyNanoseconds = SystemGetTimeNanoseconds() - present->StartTimes[presentId & (PresentMaxPendingIds - 1)];
+    }
+    return result;
+}
+
+bool PresentConsumeLatency(Present* present, uint64_t* nanoseconds) {
+    if (present->LatencyNanoseconds == 0) {
+        return false;
+    }
+    *nanoseconds                = present->LatencyNanoseconds;
+    present->LatencyNanoseconds = 0;
+    return true;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Common.h"
+
+// How many presented frames may still be waiting to be shown when the latency goal starts the next one
+#define PresentMaxQueuedFrames 1
+// Frame start times are kept for this many present IDs, has to cover the queued frames plus every frame in flight
+#define PresentMaxPendingIds 8
+
+typedef enum PresentGoal {
+    // Frames are started as late as possible, so what they show is as fresh as possible when it reaches the screen
+    PresentGoal_Latency,
+    // Frames are produced as fast as the CPU and GPU allow, whether they are shown or not
+    PresentGoal_Throughput,
+} PresentGoal;
+
+// Picks the present mode and swapchain image count for a goal and paces the frame loop to match it.
+// With VK_KHR_present_wait the latency goal uses FIFO and waits before every acquire until no more than
+// PresentMaxQueuedFrames frames are queued for display, so the CPU never runs ahead of the screen and
+// latency stays at a fixed number of refreshes. Without it the latency goal falls back to MAILBOX, which
+// keeps latency low by replacing queued frames instead of waiting for them.
+typedef struct Present {
+    VkDevice Device;
+    PresentGoal Goal;
+    VkPresentModeKHR Mode;
+    uint32_t ImageCount;
+    // NULL unless VK_KHR_present_id and VK_KHR_present_wait are enabled
+    PFN_vkWaitForPresentKHR WaitForPresent;
+    // IDs start at 1, 0 means nothing was presented
+    uint64_t NextPresentId;
+    uint64_t WaitedPresentId;
+    uint64_t StartTimes[PresentMaxPendingIds];
+    // Latency of the last frame that was measured, 0 once it has been consumed
+    uint64_t LatencyNanoseconds;
+} Present;
+
+// requestedMode overrides the goal's choice if the surface supports it, VK_PRESENT_MODE_MAX_ENUM_KHR leaves it to the goal
+Present* PresentCreate(VkDevice device,
+                       VkPhysicalDevice physicalDevice,
+                       VkSurfaceKHR surface,
+                       PresentGoal goal,
+                       VkPresentModeKHR requestedMode,
+                       bool presentWait);
+void PresentDestroy(Present* present);
+
+// Called at the start of every frame before it acquires, blocks until the frame should start when pacing
+void PresentPace(Present* present, VkSwapchainKHR swapchain);
+// Present IDs only count on the swapchain they were presented to, frames queued on the old one aren't waited for
+void PresentSwapchainChanged(Present* present);
+VkResult PresentQueue(Present* present, VkQueue queue, VkSwapchainKHR swapchain, uint32_t imageIndex, VkSemaphore waitSemaphore);
+
+// From the end of PresentPace until the frame was shown with present wait, until vkQueuePresentKHR returned otherwise
+bool PresentConsumeLatency(Present* present, uint64_t* nanoseconds);
+const char* PresentModeName(VkPresentModeKHR mode);
@@ -0,0 +1,323 @@
+#include "Profiler.h"
+
+static uint32_t ProfilerBucketIndex(uint64_t nanoseconds) {
+    const uint64_t subBucketCount = 1ull << ProfilerSubBucketBits;
+    if (nanoseconds < subBucketCount) {
+        return cast(uint32_t) nanoseconds;
+    }
+    uint32_t highestBit = 63 - cast(uint32_t) __builtin_clzll(nanoseconds);
+    uint32_t shift      = highestBit - ProfilerSubBucketBits;
+    uint32_t subBucket  = cast(uint32_t)((nanoseconds >> shift) & (subBucketCount - 1));
+    return ((shift + 1) << ProfilerSubBucketBits) + subBucket;
+}
+
+static uint64_t ProfilerBucketMidpoint(uint32_t bucket) {
+    const uint64_t subBucketCount = 1ull << ProfilerSubBucketBits;
+    if (bucket < subBucketCount) {
+        return bucket;
+    }
+    uint32_t shift     = (bucket >> ProfilerSubBucketBits) - 1;
+    uint64_t subBucket = bucket & (subBucketCount - 1);
+    return ((subBucketCount + subBucket) << shift) + ((1ull << shift) >> 1);
+}
+
+static uint32_t ProfilerAddPhase(Profiler* profiler, const char* name, bool isGpu) {
+    for (uint32_t i = 0; i < profiler->PhaseCount; i++) {
+        if (profiler->Phases[i].IsGpu == isGpu && strcmp(profiler->Phases[i].Name, name) == 0) {
+            return i;
+        }
+    }
+    if (profiler->PhaseCount >= ProfilerMaxPhases) {
+        fflush(stdout);
+        fprintf(stderr, "Too many profiler phases, cannot add '%s'!\n", name);
+        exit(1);
+    }
+    uint32_t phase                         = profiler->PhaseCount++;
+    profiler->Phases[phase].Name           = name;
+    profiler->Phases[phase].IsGpu          = isGpu;
+    profiler->Phases[phase].MinNanoseconds = UINT64_MAX;
+    return phase;
+}
+
+Profiler* ProfilerCreate(VkDevice device,
+                         VkPhysicalDevice physicalDevice,
+                         uint32_t queueFamilyIndex,
+                         uint32_t framesInFlight,
+                         const VkAllocationCallbacks* allocator) {
+    assert(framesInFlight <= MaxFramesInFlight);
+
+    Profiler* profiler = calloc(1, sizeof(Profiler));
+    if (profiler == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate the profiler!\n");
+        exit(1);
+    }
+    profiler->Device         = device;
+    profiler->Allocator      = allocator;
+    profiler->FramesInFlight = framesInFlight;
+
+    static const char* const CpuPhaseNames[ProfilerPhase_CpuCount] = {
+        [ProfilerPhase_Wait]    = "Wait",
+        [ProfilerPhase_Acquire] = "Acquire",
+        [ProfilerPhase_Record]  = "Record",
+        [ProfilerPhase_Submit]  = "Submit",
+        [ProfilerPhase_Present] = "Present",
+        [ProfilerPhase_Frame]   = "Frame",
+        [ProfilerPhase_Latency] = "Latency",
+    };
+    for (uint32_t i = 0; i < ProfilerPhase_CpuCount; i++) {
+        ProfilerAddPhase(profiler, CpuPhaseNames[i], false);
+    }
+
+    VkPhysicalDeviceProperties properties = {};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    uint32_t queueFamilyPropertiesCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyPropertiesCount, NULL);
+    VkQueueFamilyProperties queueFamilyProperties[queueFamilyPropertiesCount];
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyPropertiesCount, queueFamilyProperties);
+
+    uint32_t timestampValidBits = queueFamilyProperties[queueFamilyIndex].timestampValidBits;
+    if (timestampValidBits == 0 || properties.limits.timestampPeriod == 0.0f) {
+        printf("Timestamps are not supported on this queue, GPU passes will not be profiled!\n");
+        return profiler;
+    }
+    profiler->TimestampPeriod = properties.limits.timestampPeriod;
+    profiler->TimestampMask   = timestampValidBits >= 64 ? UINT64_MAX : (1ull << timestampValidBits) - 1;
+
+    VkResult queryPoolCreateResult = vkCreateQueryPool(device,
+                                                       &(VkQueryPoolCreateInfo){
+                                                           .sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+                                                           .queryType  = VK_QUERY_TYPE_TIMESTAMP,
+                                                           .queryCount = framesInFlight * ProfilerMaxGpuPasses * 2,
+                                                       },
+                                                       allocator,
+                                                       &profiler->QueryPool);
+    if (queryPoolCreateResult != VK_SUCCESS || profiler->QueryPool == VK_NULL_HANDLE) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to create the timestamp query pool! %x\n", queryPoolCreateResult);
+        exit(1);
+    }
+
+    return profiler;
+}
+
+void ProfilerDestroy(Profiler* profiler) {
+    if (profiler->QueryPool != VK_NULL_HANDLE) {
+        vkDestroyQueryPool(profiler->Device, profiler->QueryPool, profiler->Allocator);
+    }
+    free(profiler);
+}
+
+uint32_t ProfilerRegisterGpuPass(Profiler* profiler, const char* name) {
+    return ProfilerAddPhase(profiler, name, true);
+}
+
+void ProfilerBeginFrame(Profiler* profiler, VkCommandBuffer commandBuffer, uint32_t frameSlot) {
+    assert(frameSlot < profiler->FramesInFlight);
+    profiler->CurrentSlot   = frameSlot;
+    ProfilerFrameSlot* slot = &profiler->Slots[frameSlot];
+    if (profiler->QueryPool == VK_NULL_HANDLE) {
+        return;
+    }
+
+    uint32_t firstQuery = frameSlot * ProfilerMaxGpuPasses * 2;
+    if (slot->PassCount > 0) {
+        // The slot's fence has signaled, so these are ready and this does not wait. A pass that was begun
+        // but never ended makes the whole slot unavailable, in that case the frame is skipped.
+        uint64_t timestamps[ProfilerMaxGpuPasses * 2];
+        VkResult queryResult = vkGetQueryPoolResults(profiler->Device,
+                                                     profiler->QueryPool,
+                                                     firstQuery,
+                                                     slot->PassCount * 2,
+                                                     sizeof(uint64_t) * slot->PassCount * 2,
+                                                     timestamps,
+                                                     sizeof(uint64_t),
+                                                     VK_QUERY_RESULT_64_BIT);
+        if (queryResult == VK_SUCCESS) {
+            for (uint32_t i = 0; i < slot->PassCount; i++) {
+                uint64_t ticks = (timestamps[i * 2 + 1] - timestamps[i * 2 + 0]) & profiler->TimestampMask;
+                ProfilerRecord(profiler, slot->PassPhases[i], cast(uint64_t)(cast(double) ticks * profiler->TimestampPeriod));
+            }
+        } else if (queryResult != VK_NOT_READY) {
+            VkCheck(queryResult);
+        }
+    }
+
+    slot->PassCount    = 0;
+    slot->DroppedDepth = 0;
+    vkCmdResetQueryPool(commandBuffer, profiler->QueryPool, firstQuery, ProfilerMaxGpuPasses * 2);
+}
+
+void ProfilerBeginGpuPass(Profiler* profiler, VkCommandBuffer commandBuffer, uint32_t phase) {
+    ProfilerFrameSlot* slot = &profiler->Slots[profiler->CurrentSlot];
+    if (profiler->QueryPool == VK_NULL_HANDLE) {
+        return;
+    }
+    if (slot->PassCount >= ProfilerMaxGpuPasses) {
+        slot->DroppedDepth++;
+        return;
+    }
+    uint32_t pass          = slot->PassCount++;
+    slot->PassPhases[pass] = phase;
+    vkCmdWriteTimestamp(commandBuffer,
+                        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                        profiler->QueryPool,
+                        profiler->CurrentSlot * ProfilerMaxGpuPasses * 2 + pass * 2 + 0);
+}
+
+void ProfilerEndGpuPass(Profiler* profiler, VkCommandBuffer commandBuffer, uint32_t phase) {
+    ProfilerFrameSlot* slot = &profiler->Slots[profiler->CurrentSlot];
+    if (profiler->QueryPool == VK_NULL_HANDLE) {
+        return;
+    }
+    // Passes nest, so while a dropped one is open the innermost open pass is dropped too, and matching its end by
+    // phase would overwrite the end of an earlier pass with the same phase
+    if (slot->DroppedDepth > 0) {
+        slot->DroppedDepth--;
+        return;
+    }
+    for (uint32_t pass = slot->PassCount; pass-- > 0;) {
+        if (slot->PassPhases[pass] == phase) {
+            vkCmdWriteTimestamp(commandBuffer,
+                                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                                profiler->QueryPool,
+                                profiler->CurrentSlot * ProfilerMaxGpuPasses * 2 + pass * 2 + 1);
+            return;
+        }
+    }
+}
+
+void ProfilerRecord(Profiler* profiler, uint32_t phase, uint64_t nanoseconds) {
+    assert(phase < profiler->PhaseCount);
+    ProfilerHistogram* histogram = &profiler->Phases[phase];
+    histogram->Count++;
+    histogram->TotalNanoseconds += nanoseconds;
+    if (nanoseconds < histogram->MinNanoseconds) {
+        histogram->MinNanoseconds = nanoseconds;
+    }
+    if (nanoseconds > histogram->MaxNanoseconds) {
+        histogram->MaxNanoseconds = nanoseconds;
+    }
+    histogram->Buckets[ProfilerBucketIndex(nanoseconds)]++;
+}
+
+uint64_t ProfilerPercentile(const ProfilerHistogram* histogram, double percentile) {
+    if (histogram->Count == 0) {
+        return 0;
+    }
+    uint64_t target = cast(uint64_t)(percentile / 100.0 * cast(double) histogram->Count + 0.5);
+    if (target < 1) {
+        target = 1;
+    }
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < ProfilerBucketCount; i++) {
+        seen += histogram->Buckets[i];
+        if (seen >= target) {
+            uint64_t value = ProfilerBucketMidpoint(i);
+            if (value < histogram->MinNanoseconds) {
+                value = histogram->MinNanoseconds;
+            }
+            if (value > histogram->MaxNanoseconds) {
+                value = histogram->MaxNanoseconds;
+            }
+            return value;
+        }
+    }
+    return histogram->MaxNanoseconds;
+}
+
+void ProfilerPrintSummary(const Profiler* profiler) {
+    printf("%-12s %-4s %8s %10s %10s %10s %10s %10s\n", "Phase", "", "Count", "Mean(us)", "p50(us)", "p95(us)", "p99(us)", "Max(us)");
+    for (uint32_t i = 0; i < profiler->PhaseCount; i++) {
+        const ProfilerHistogram* histogram = &profiler->Phases[i];
+        if (histogram->Count == 0) {
+            continue;
+        }
+        printf("%-12s %-4s %8llu %10.2f %10.2f %10.2f %10.2f %10.2f\n",
+               histogram->Name,
+               histogram->IsGpu ? "GPU" : "CPU",
+               cast(unsigned long long) histogram->Count,
+               cast(double) histogram->TotalNanoseconds / cast(double) histogram->Count / 1000.0,
+               cast(double) ProfilerPercentile(histogram, 50.0) / 1000.0,
+               cast(double) ProfilerPercentile(histogram, 95.0) / 1000.0,
+               cast(double) ProfilerPercentile(histogram, 99.0) / 1000.0,
+               cast(double) histogram->MaxNanoseconds / 1000.0);
+    }
+}
+
+bool ProfilerDump(const Profiler* profiler, const char* path) {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to open '%s' for writing the profile!\n", path);
+        return false;
+    }
+
+    size_t pathLength = strlen(path);
+    bool json         = pathLength >= 5 && strcmp(path + pathLength - 5, ".json") == 0;
+    if (json) {
+        fprintf(file, "{\n  \"phases\": [");
+    } else {
+        fprintf(file, "phase,type,count,mean_ns,min_ns,p50_ns,p95_ns,p99_ns,max_ns\n");
+    }
+
+    bool first = true;
+    for (uint32_t i = 0; i < profiler->PhaseCount; i++) {
+        const ProfilerHistogram* histogram = &profiler->Phases[i];
+        if (histogram->Count == 0) {
+            continue;
+        }
+        unsigned long long count = histogram->Count;
+        unsigned long long mean  = histogram->TotalNanoseconds / histogram->Count;
+        unsigned long long min   = histogram->MinNanoseconds;
+        unsigned long long p50   = ProfilerPercentile(histogram, 50.0);
+        unsigned long long p95   = ProfilerPercentile(histogram, 95.0);
+        unsigned long long p99   = ProfilerPercentile(histogram, 99.0);
+        unsigned long long max   = histogram->MaxNanoseconds;
+        const char* type         = histogram->IsGpu ? "gpu" : "cpu";
+        if (json) {
+            fprintf(file,
+                    "%s\n    {\"name\": \"%s\", \"type\": \"%s\", \"count\": %llu, \"mean_ns\": %llu, \"min_ns\": %llu, "
+                    "\"p50_ns\": %llu, \"p95_ns\": %llu, \"p99_ns\": %llu, \"max_ns\": %llu, \"histogram\": [",
+                    first ? "" : ",",
+                    histogram->Name,
+                    type,
+                    count,
+                    mean,
+                    min,
+                    p50,
+                    p95,
+                    p99,
+                    max);
+            bool firstBucket = true;
+            for (uint32_t bucket = 0; bucket < ProfilerBucketCount; bucket++) {
+                if (histogram->Buckets[bucket] == 0) {
+                    continue;
+                }
+                fprintf(file,
+                        "%s[%llu, %u]",
+                        firstBucket ? "" : ", ",
+                        cast(unsigned long long) ProfilerBucketMidpoint(bucket),
+                        histogram->Buckets[bucket]);
+                firstBucket = false;
+            }
+            fprintf(file, "]}");
+        } else {
+            fprintf(file, "%s,%s,%llu,%llu,%llu,%llu,%llu,%llu,%llu\n", histogram->Name, type, count, mean, min, p50, p95, p99, max);
+        }
+        first = false;
+    }
+
+    if (json) {
+        fprintf(file, "\n  ]\n}\n");
+    }
+
+    bool success = ferror(file) == 0;
+    success      = fclose(file) == 0 && success;
+    if (!success) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to write the profile to '%s'!\n", path);
+    }
+    return success;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Common.h"
+
+#define ProfilerMaxPhases    32
+#define ProfilerMaxGpuPasses 16
+
+// Values below 2^ProfilerSubBucketBits nanoseconds get exact buckets, above that every power of two
+// is split into 2^ProfilerSubBucketBits buckets, so percentiles are accurate to ~3% at any scale
+#define ProfilerSubBucketBits 5
+#define ProfilerBucketCount   ((64 - ProfilerSubBucketBits + 1) << ProfilerSubBucketBits)
+
+typedef enum ProfilerPhase {
+    ProfilerPhase_Wait,
+    ProfilerPhase_Acquire,
+    ProfilerPhase_Record,
+    ProfilerPhase_Submit,
+    ProfilerPhase_Present,
+    ProfilerPhase_Frame,
+    // From the start of the frame until it was shown, or presented where that can't be observed
+    ProfilerPhase_Latency,
+    ProfilerPhase_CpuCount,
+} ProfilerPhase;
+
+typedef struct ProfilerHistogram {
+    const char* Name;
+    bool IsGpu;
+    uint64_t Count;
+    uint64_t TotalNanoseconds;
+    uint64_t MinNanoseconds;
+    uint64_t MaxNanoseconds;
+    uint32_t Buckets[ProfilerBucketCount];
+} ProfilerHistogram;
+
+typedef struct ProfilerFrameSlot {
+    uint32_t PassCount;
+    uint32_t PassPhases[ProfilerMaxGpuPasses];
+    // Passes begun past ProfilerMaxGpuPasses that haven't ended yet, their ends are ignored as well
+    uint32_t DroppedDepth;
+} ProfilerFrameSlot;
+
+// CPU phases are measured by the caller and recorded directly. GPU passes are bracketed with timestamp
+// queries, each frame slot has its own range of queries that is read back when the slot is reused,
+// after its fence has been waited on, so collecting results never stalls the GPU.
+typedef struct Profiler {
+    VkDevice Device;
+    const VkAllocationCallbacks* Allocator;
+    VkQueryPool QueryPool;
+    double TimestampPeriod;
+    uint64_t TimestampMask;
+    uint32_t FramesInFlight;
+    uint32_t CurrentSlot;
+    ProfilerFrameSlot Slots[MaxFramesInFlight];
+    uint32_t PhaseCount;
+    ProfilerHistogram Phases[ProfilerMaxPhases];
+} Profiler;
+
+Profiler* ProfilerCreate(VkDevice device,
+                         VkPhysicalDevice physicalDevice,
+                         uint32_t queueFamilyIndex,
+                         uint32_t framesInFlight,
+                         const VkAllocationCallbacks* allocator);
+void ProfilerDestroy(Profiler* profiler);
+
+// Returns a phase index for a GPU pass, passes with the same name share a histogram
+uint32_t ProfilerRegisterGpuPass(Profiler* profiler, const char* name);
+
+// Must be called after the slot's fence has been waited on and before anything is recorded into the command buffer
+void ProfilerBeginFrame(Profiler* profiler, VkCommandBuffer commandBuffer, uint32_t frameSlot);
+// Passes may nest but must end in reverse order of beginning. Only the first ProfilerMaxGpuPasses of a frame are timed,
+// later ones are ignored from begin to end.
+void ProfilerBeginGpuPass(Profiler* profiler, VkCommandBuffer commandBuffer, uint32_t phase);
+void ProfilerEndGpuPass(Profiler* profiler, VkCommandBuffer commandBuffer, uint32_t phase);
+
+void ProfilerRecord(Profiler* profiler, uint32_t phase, uint64_t nanoseconds);
+uint64_t ProfilerPercentile(const ProfilerHistogram* histogram, double percentile);
+
+void ProfilerPrintSummary(const Profiler* profiler);
+// Writes JSON if the path ends in ".json", CSV otherwise
+bool ProfilerDump(const Profiler* profiler, const char* path);
@@ -0,0 +1,599 @@
+#include "RenderGraph.h"
+
+typedef struct RenderGraphUsageInfo {
+    VkPipelineStageFlags2 Stages;
+    VkAccessFlags2 Access;
+    VkImageLayout Layout;
+    bool Write;
+} RenderGraphUsageInfo;
+
+// Only stage and access bits that also exist in the original flags are used, so the same masks work for
+// vkCmdPipelineBarrier when synchronization2 isn't available
+static const RenderGraphUsageInfo RenderGraphUsageInfos[RenderGraphUsage_Count] = {
+    [RenderGraphUsage_TransferSrc] = { VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, false },
+    [RenderGraphUsage_TransferDst] = { VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, true },
+    [RenderGraphUsage_ColorAttachment] = { VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                           VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+                                           VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                                           true },
+    [RenderGraphUsage_DepthAttachment] = { VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+                                           VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                                           VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                                           true },
+    [RenderGraphUsage_FragmentSampled] = { VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false },
+    [RenderGraphUsage_ComputeSampled] = { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false },
+    [RenderGraphUsage_ComputeStorageRead] = { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, false },
+    [RenderGraphUsage_ComputeStorageWrite] = { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                                               VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT,
+                                               VK_IMAGE_LAYOUT_GENERAL,
+                                               true },
+    [RenderGraphUsage_IndirectRead] = { VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, false },
+    [RenderGraphUsage_VertexRead] = { VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT,
+                                      VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_2_INDEX_READ_BIT,
+                                      VK_IMAGE_LAYOUT_UNDEFINED,
+                                      false },
+    [RenderGraphUsage_HostRead] = { VK_PIPELINE_STAGE_2_HOST_BIT, VK_ACCESS_2_HOST_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, false },
+    // Presentation is synchronized by the semaphore the present waits on, only the layout matters here
+    [RenderGraphUsage_Present] = { VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, false },
+};
+
+typedef struct RenderGraphBarrierBatch {
+    uint32_t ImageBarrierCount;
+    VkImageMemoryBarrier2 ImageBarriers[RenderGraphMaxResources];
+    VkMemoryBarrier2 MemoryBarrier;
+} RenderGraphBarrierBatch;
+
+static RenderGraphResource RenderGraphAddResource(RenderGraph* graph, const char* name) {
+    if (graph->ResourceCount >= RenderGraphMaxResources) {
+        fflush(stdout);
+        fprintf(stderr, "More than %d render graph resources!\n", RenderGraphMaxResources);
+        exit(1);
+    }
+    RenderGraphResource resource = graph->ResourceCount++;
+    graph->Resources[resource]   = (RenderGraphResourceData){
+          .Name = name,
+    };
+    return resource;
+}
+
+// Works out what has to happen before the resource can be used as described, updates its state and returns
+// whether a barrier is needed
+static bool RenderGraphTransition(RenderGraphResourceData* resource,
+                                  const RenderGraphUsageInfo* usage,
+                                  VkPipelineStageFlags2* srcStages,
+                                  VkAccessFlags2* srcAccess,
+                                  VkImageLayout* oldLayout) {
+    RenderGraphResourceState* state = &resource->State;
+    bool layoutChange               = resource->IsImage && state->Layout != usage->Layout;
+    *oldLayout                      = state->Layout;
+
+    if (usage->Write || layoutChange) {
+        // Writes and layout transitions wait for every earlier access, only earlier writes need their memory made available
+        *srcStages           = state->WriteStages | state->ReadStages;
+        *srcAccess           = state->WriteAccess;
+        bool needed          = layoutChange || *srcStages != 0;
+        state->Layout        = usage->Layout;
+        state->WriteStages   = usage->Stages;
+        state->WriteAccess   = usage->Write ? usage->Access : VK_ACCESS_2_NONE;
+        state->ReadStages    = usage->Write ? VK_PIPELINE_STAGE_2_NONE : usage->Stages;
+        state->VisibleStages = usage->Stages;
+        state->VisibleAccess = usage->Access;
+        return needed;
+    }
+
+    bool visible = (usage->Stages & ~state->VisibleStages) == 0 && (usage->Access & ~state->VisibleAccess) == 0;
+    state->ReadStages |= usage->Stages;
+    if (state->WriteStages == VK_PIPELINE_STAGE_2_NONE || visible) {
+        return false;
+    }
+    *srcStages = state->WriteStages;
+    *srcAccess = state->WriteAccess;
+    state->VisibleStages |= usage->Stages;
+    state->VisibleAccess |= usage->Access;
+    return true;
+}
+
+static void RenderGraphAddBarrier(RenderGraph* graph,
+                                  RenderGraphBarrierBatch* batch,
+                                  RenderGraphResource resource,
+                                  const RenderGraphUsageInfo* usage) {
+    RenderGraphResourceData* data = &graph->Resources[resource];
+    VkPipelineStageFlags2 srcStages = VK_PIPELINE_STAGE_2_NONE;
+    VkAccessFlags2 srcAccess        = VK_ACCESS_2_NONE;
+    VkImageLayout oldLayout         = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (!RenderGraphTransition(data, usage, &srcStages, &srcAccess, &oldLayout)) {
+        return;
+    }
+
+    if (data->IsImage) {
+        batch->ImageBarriers[batch->ImageBarrierCount++] = (VkImageMemoryBarrier2){
+            .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .srcStageMask        = srcStages,
+            .srcAccessMask       = srcAccess,
+            .dstStageMask        = usage->Stages,
+            .dstAccessMask       = usage->Access,
+            .oldLayout           = oldLayout,
+            .newLayout           = usage->Layout,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image               = data->Image,
+            .subresourceRange =
+                (VkImageSubresourceRange){
+                    .aspectMask = data->Desc.Aspect,
+                    .levelCount = VK_REMAINING_MIP_LEVELS,
+                    .layerCount = VK_REMAINING_ARRAY_LAYERS,
+                },
+        };
+    } else {
+        // Buffers are whole-resource anyway, one global memory barrier covers all of them and is cheaper
+        batch->MemoryBarrier.srcStageMask |= srcStages;
+        batch->MemoryBarrier.srcAccessMask |= srcAccess;
+        batch->MemoryBarrier.dstStageMask |= usage->Stages;
+        batch->MemoryBarrier.dstAccessMask |= usage->Access;
+    }
+}
+
+static void RenderGraphFlushBarriers(RenderGraph* graph, VkCommandBuffer commandBuffer, RenderGraphBarrierBatch* batch) {
+    bool hasMemoryBarrier = batch->MemoryBarrier.srcStageMask != VK_PIPELINE_STAGE_2_NONE ||
+                            batch->MemoryBarrier.dstStageMask != VK_PIPELINE_STAGE_2_NONE;
+    if (batch->ImageBarrierCount == 0 && !hasMemoryBarrier) {
+        return;
+    }
+    graph->Stats.BarrierBatches++;
+    graph->Stats.ImageBarriers += batch->ImageBarrierCount;
+    graph->Stats.MemoryBarriers += hasMemoryBarrier ? 1 : 0;
+    batch->MemoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+
+    if (graph->CmdPipelineBarrier2) {
+        graph->CmdPipelineBarrier2(commandBuffer,
+                                   &(VkDependencyInfo){
+                                       .sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                       .memoryBarrierCount      = hasMemoryBarrier ? 1 : 0,
+                                       .pMemoryBarriers         = &batch->MemoryBarrier,
+                                       .imageMemoryBarrierCount = batch->ImageBarrierCount,
+                                       .pImageMemoryBarriers    = batch->ImageBarriers,
+                                   });
+        return;
+    }
+
+    // Without synchronization2 every barrier in the batch shares one pair of stage masks
+    VkPipelineStageFlags srcStages = cast(VkPipelineStageFlags) batch->MemoryBarrier.srcStageMask;
+    VkPipelineStageFlags dstStages = cast(VkPipelineStageFlags) batch->MemoryBarrier.dstStageMask;
+    VkImageMemoryBarrier imageBarriers[RenderGraphMaxResources];
+    for (uint32_t i = 0; i < batch->ImageBarrierCount; i++) {
+        const VkImageMemoryBarrier2* barrier = &batch->ImageBarriers[i];
+        srcStages |= cast(VkPipelineStageFlags) barrier->srcStageMask;
+        dstStages |= cast(VkPipelineStageFlags) barrier->dstStageMask;
+        imageBarriers[i] = (VkImageMemoryBarrier){
+            .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .srcAccessMask       = cast(VkAccessFlags) barrier->srcAccessMask,
+            .dstAccessMask       = cast(VkAccessFlags) barrier->dstAccessMask,
+            .oldLayout           = barrier->oldLayout,
+            .newLayout           = barrier->newLayout,
+            .srcQueueFamilyIndex = barrier->srcQueueFamilyIndex,
+            .dstQueueFamilyIndex = barrier->dstQueueFamilyIndex,
+            .image               = barrier->image,
+            .subresourceRange    = barrier->subresourceRange,
+        };
+    }
+    vkCmdPipelineBarrier(commandBuffer,
+                         srcStages != 0 ? srcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         dstStages != 0 ? dstStages : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                         0,
+                         hasMemoryBarrier ? 1 : 0,
+                         &(VkMemoryBarrier){
+                             .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                             .srcAccessMask = cast(VkAccessFlags) batch->MemoryBarrier.srcAccessMask,
+                             .dstAccessMask = cast(VkAccessFlags) batch->MemoryBarrier.dstAccessMask,
+                         },
+                         0,
+                         NULL,
+                         batch->ImageBarrierCount,
+                         imageBarriers);
+}
+
+static void RenderGraphDestroyTransients(RenderGraph* graph, RenderGraphTransientSet* set) {
+    for (uint32_t i = 0; i < set->ImageCount; i++) {
+        vkDestroyImageView(graph->Device, set->Images[i].View, graph->Allocator);
+        vkDestroyImage(graph->Device, set->Images[i].Image, graph->Allocator);
+    }
+    for (uint32_t i = 0; i < set->MemoryCount; i++) {
+        DeviceAllocatorFree(graph->DeviceAllocator, set->Memory[i].Allocation);
+    }
+    free(set);
+}
+
+static bool RenderGraphTransientsMatch(const RenderGraphTransientSet* set, const RenderGraphTransientImage* images, uint32_t imageCount) {
+    if (set == NULL || set->ImageCount != imageCount) {
+        return false;
+    }
+    for (uint32_t i = 0; i < imageCount; i++) {
+        const RenderGraphTransientImage* a = &set->Images[i];
+        const RenderGraphTransientImage* b = &images[i];
+        if (a->FirstPass != b->FirstPass || a->LastPass != b->LastPass || memcmp(&a->Desc, &b->Desc, sizeof(a->Desc)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Creates the images and packs them into as few memory allocations as their lifetimes allow, biggest first
+static RenderGraphTransientSet* RenderGraphCreateTransients(RenderGraph* graph, const RenderGraphTransientImage* images, uint32_t imageCount) {
+    RenderGraphTransientSet* set = calloc(1, sizeof(RenderGraphTransientSet));
+    if (set == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate render graph transients!\n");
+        exit(1);
+    }
+    set->ImageCount = imageCount;
+    memcpy(set->Images, images, imageCount * sizeof(images[0]));
+
+    uint32_t order[RenderGraphMaxTransients];
+    for (uint32_t i = 0; i < imageCount; i++) {
+        RenderGraphTransientImage* image = &set->Images[i];
+        VkCheck(vkCreateImage(graph->Device,
+                              &(VkImageCreateInfo){
+                                  .sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+                                  .imageType     = VK_IMAGE_TYPE_2D,
+                                  .format        = image->Desc.Format,
+                                  .extent        = { image->Desc.Extent.width, image->Desc.Extent.height, 1 },
+                                  .mipLevels     = 1,
+                                  .arrayLayers   = 1,
+                                  .samples       = VK_SAMPLE_COUNT_1_BIT,
+                                  .tiling        = VK_IMAGE_TILING_OPTIMAL,
+                                  .usage         = image->Desc.Usage,
+                                  .sharingMode   = VK_SHARING_MODE_EXCLUSIVE,
+                                  .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                              },
+                              graph->Allocator,
+                              &image->Image));
+        vkGetImageMemoryRequirements(graph->Device, image->Image, &image->Requirements);
+        graph->Stats.TransientImageBytes += image->Requirements.size;
+
+        uint32_t j = i;
+        while (j > 0 && set->Images[order[j - 1]].Requirements.size < image->Requirements.size) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    for (uint32_t i = 0; i < imageCount; i++) {
+        RenderGraphTransientImage* image = &set->Images[order[i]];
+        uint32_t memory                  = 0;
+        for (; memory < set->MemoryCount; memory++) {
+            if ((set->Memory[memory].Requirements.memoryTypeBits & image->Requirements.memoryTypeBits) == 0) {
+                continue;
+            }
+            bool overlaps = false;
+            for (uint32_t j = 0; j < i && !overlaps; j++) {
+                const RenderGraphTransientImage* other = &set->Images[order[j]];
+                overlaps = other->Memory == memory && other->FirstPass <= image->LastPass && image->FirstPass <= other->LastPass;
+            }
+            if (!overlaps) {
+                break;
+            }
+        }
+
+        VkMemoryRequirements* requirements = &set->Memory[memory].Requirements;
+        if (memory == set->MemoryCount) {
+            set->MemoryCount++;
+            *requirements = image->Requirements;
+        } else {
+            requirements->memoryTypeBits &= image->Requirements.memoryTypeBits;
+            requirements->alignment = requirements->alignment > image->Requirements.alignment ? requirements->alignment
+                                                                                              : image->Requirements.alignment;
+        }
+        image->Memory = memory;
+    }
+
+    for (uint32_t i = 0; i < set->MemoryCount; i++) {
+        RenderGraphTransientMemory* memory = &set->Memory[i];
+        VkResult allocateResult            = DeviceAllocatorAllocate(graph->DeviceAllocator,
+                                                          &memory->Requirements,
+                                                          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                                          0,
+                                                          DeviceAllocationKind_Optimal,
+                                                          &memory->Allocation);
+        if (allocateResult != VK_SUCCESS) {
+            fflush(stdout);
+            fprintf(stderr, "Failed to allocate render graph transient memory! %x\n", allocateResult);
+            exit(1);
+        }
+        graph->Stats.TransientMemoryBytes += memory->Requirements.size;
+    }
+
+    for (uint32_t i = 0; i < imageCount; i++) {
+        RenderGraphTransientImage* image = &set->Images[i];
+        DeviceAllocation* allocation     = set->Memory[image->Memory].Allocation;
+        VkCheck(vkBindImageMemory(graph->Device, image->Image, allocation->Memory, allocation->Offset));
+        VkCheck(vkCreateImageView(graph->Device,
+                                  &(VkImageViewCreateInfo){
+                                      .sType    = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+                                      .image    = image->Image,
+                                      .viewType = VK_IMAGE_VIEW_TYPE_2D,
+                                      .format   = image->Desc.Format,
+                                      .subresourceRange =
+                                          (VkImageSubresourceRange){
+                                              .aspectMask = image->Desc.Aspect,
+                                              .levelCount = 1,
+                                              .layerCount = 1,
+                                          },
+                                  },
+                                  graph->Allocator,
+                                  &image->View));
+    }
+
+    return set;
+}
+
+static void RenderGraphRetireTransients(RenderGraph* graph) {
+    if (graph->Transients == NULL) {
+        return;
+    }
+    for (uint32_t i = 0; i < MaxFramesInFlight; i++) {
+        if (graph->Retired[i] == NULL) {
+            graph->Transients->RetireFrame = graph->FrameNumber + graph->FramesInFlight;
+            graph->Retired[i]              = graph->Transients;
+            graph->Transients              = NULL;
+            return;
+        }
+    }
+    fflush(stdout);
+    fprintf(stderr, "Render graph transients are being retired faster than frames complete!\n");
+    exit(1);
+}
+
+RenderGraph* RenderGraphCreate(VkDevice device,
+                               DeviceAllocator* deviceAllocator,
+                               bool synchronization2,
+                               uint32_t framesInFlight,
+                               const VkAllocationCallbacks* allocator) {
+    RenderGraph* graph = calloc(1, sizeof(RenderGraph));
+    if (graph == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate the render graph!\n");
+        exit(1);
+    }
+    graph->Device          = device;
+    graph->Allocator       = allocator;
+    graph->DeviceAllocator = deviceAllocator;
+    graph->FramesInFlight  = framesInFlight;
+    if (synchronization2) {
+        graph->CmdPipelineBarrier2 = cast(PFN_vkCmdPipelineBarrier2KHR) vkGetDeviceProcAddr(device, "vkCmdPipelineBarrier2KHR");
+    }
+    return graph;
+}
+
+void RenderGraphDestroy(RenderGraph* graph) {
+    if (graph->Transients) {
+        RenderGraphDestroyTransients(graph, graph->Transients);
+    }
+    for (uint32_t i = 0; i < MaxFramesInFlight; i++) {
+        if (graph->Retired[i]) {
+            RenderGraphDestroyTransients(graph, graph->Retired[i]);
+        }
+    }
+    free(graph);
+}
+
+void RenderGraphBeginFrame(RenderGraph* graph) {
+    graph->FrameNumber++;
+    for (uint32_t i = 0; i < MaxFramesInFlight; i++) {
+        if (graph->Retired[i] && graph->Retired[i]->RetireFrame <= graph->FrameNumber) {
+            RenderGraphDestroyTransients(graph, graph->Retired[i]);
+            graph->Retired[i] = NULL;
+        }
+    }
+    graph->PassCount     = 0;
+    graph->ResourceCount = 0;
+}
+
+RenderGraphResource RenderGraphImportImage(RenderGraph* graph,
+                                           const char* name,
+                                           VkImage image,
+                                           VkImageView view,
+                                           VkImageAspectFlags aspect,
+                                           VkImageLayout initialLayout,
+                                           RenderGraphUsage finalUsage) {
+    RenderGraphResource resource  = RenderGraphAddResource(graph, name);
+    RenderGraphResourceData* data = &graph->Resources[resource];
+    data->IsImage                 = true;
+    data->Imported                = true;
+    data->HasFinalUsage           = true;
+    data->FinalUsage              = finalUsage;
+    data->Desc.Aspect             = aspect;
+    data->Image                   = image;
+    data->View                    = view;
+    data->State.Layout            = initialLayout;
+    return resource;
+}
+
+RenderGraphResource RenderGraphImportBuffer(RenderGraph* graph, const char* name, VkBuffer buffer, RenderGraphUsage finalUsage) {
+    RenderGraphResource resource  = RenderGraphAddResource(graph, name);
+    RenderGraphResourceData* data = &graph->Resources[resource];
+    data->Imported                = true;
+    data->HasFinalUsage           = true;
+    data->FinalUsage              = finalUsage;
+    data->Buffer                  = buffer;
+    return resource;
+}
+
+RenderGraphResource RenderGraphCreateImage(RenderGraph* graph, const char* name, const RenderGraphImageDesc* desc) {
+    RenderGraphResource resource  = RenderGraphAddResource(graph, name);
+    RenderGraphResourceData* data = &graph->Resources[resource];
+    data->IsImage                 = true;
+    data->Desc                    = *desc;
+    data->State.Layout            = VK_IMAGE_LAYOUT_UNDEFINED;
+    return resource;
+}
+
+uint32_t RenderGraphAddPass(RenderGraph* graph, const char* name, RenderGraphCallback callback, void* userData) {
+    if (graph->PassCount >= RenderGraphMaxPasses) {
+        fflush(stdout);
+        fprintf(stderr, "More than %d render graph passes!\n", RenderGraphMaxPasses);
+        exit(1);
+    }
+    uint32_t pass       = graph->PassCount++;
+    graph->Passes[pass] = (RenderGraphPass){
+        .Name     = name,
+        .Callback = callback,
+        .UserData = userData,
+    };
+    return pass;
+}
+
+void RenderGraphUse(RenderGraph* graph, uint32_t pass, RenderGraphResource resource, RenderGraphUsage usage) {
+    assert(pass < graph->PassCount && resource < graph->ResourceCount);
+    RenderGraphPass* passData = &graph->Passes[pass];
+    if (passData->UseCount >= RenderGraphMaxUsesPerPass) {
+        fflush(stdout);
+        fprintf(stderr, "Render graph pass '%s' uses more than %d resources!\n", passData->Name, RenderGraphMaxUsesPerPass);
+        exit(1);
+    }
+    passData->Uses[passData->UseCount++] = (RenderGraphResourceUse){
+        .Resource = resource,
+        .Usage    = usage,
+    };
+}
+
+void RenderGraphExecute(RenderGraph* graph, VkCommandBuffer commandBuffer) {
+    // Walk backwards from the imported resources, a pass only survives if something that survives needs what it writes
+    for (uint32_t i = 0; i < graph->ResourceCount; i++) {
+        graph->Resources[i].Needed = graph->Resources[i].Imported;
+        graph->Resources[i].Used   = false;
+    }
+    for (uint32_t pass = graph->PassCount; pass-- > 0;) {
+        RenderGraphPass* passData = &graph->Passes[pass];
+        passData->Live            = false;
+        for (uint32_t i = 0; i < passData->UseCount && !passData->Live; i++) {
+            const RenderGraphResourceUse* use = &passData->Uses[i];
+            passData->Live = RenderGraphUsageInfos[use->Usage].Write && graph->Resources[use->Resource].Needed;
+        }
+        if (!passData->Live) {
+            graph->Stats.PassesCulled++;
+            continue;
+        }
+        for (uint32_t i = 0; i < passData->UseCount; i++) {
+            RenderGraphResourceData* resource = &graph->Resources[passData->Uses[i].Resource];
+            if (!resource->Used) {
+                resource->Used     = true;
+                resource->LastPass = pass;
+            }
+            resource->FirstPass = pass;
+            if (!RenderGraphUsageInfos[passData->Uses[i].Usage].Write) {
+                resource->Needed = true;
+            }
+        }
+    }
+
+    RenderGraphTransientImage transients[RenderGraphMaxTransients];
+    uint32_t transientCount = 0;
+    for (uint32_t i = 0; i < graph->ResourceCount; i++) {
+        RenderGraphResourceData* resource = &graph->Resources[i];
+        if (resource->Imported || !resource->Used) {
+            continue;
+        }
+        if (transientCount >= RenderGraphMaxTransients) {
+            fflush(stdout);
+            fprintf(stderr, "More than %d transient render graph images!\n", RenderGraphMaxTransients);
+            exit(1);
+        }
+        resource->Transient        = transientCount;
+        transients[transientCount++] = (RenderGraphTransientImage){
+            .Desc      = resource->Desc,
+            .FirstPass = resource->FirstPass,
+            .LastPass  = resource->LastPass,
+        };
+    }
+    if (!RenderGraphTransientsMatch(graph->Transients, transients, transientCount)) {
+        RenderGraphRetireTransients(graph);
+        graph->Transients = RenderGraphCreateTransients(graph, transients, transientCount);
+    }
+    for (uint32_t i = 0; i < graph->ResourceCount; i++) {
+        RenderGraphResourceData* resource = &graph->Resources[i];
+        if (!resource->Imported && resource->Used) {
+            resource->Image = graph->Transients->Images[resource->Transient].Image;
+            resource->View  = graph->Transients->Images[resource->Transient].View;
+        }
+    }
+
+    for (uint32_t pass = 0; pass < graph->PassCount; pass++) {
+        RenderGraphPass* passData = &graph->Passes[pass];
+        if (!passData->Live) {
+            continue;
+        }
+
+        RenderGraphBarrierBatch batch = {};
+        for (uint32_t i = 0; i < passData->UseCount; i++) {
+            RenderGraphResourceData* resource = &graph->Resources[passData->Uses[i].Resource];
+            const RenderGraphUsageInfo* usage = &RenderGraphUsageInfos[passData->Uses[i].Usage];
+            RenderGraphTransientMemory* memory =
+                resource->Imported ? NULL : &graph->Transients->Memory[graph->Transients->Images[resource->Transient].Memory];
+            if (resource->FirstPass == pass) {
+                resource->FirstStages |= usage->Stages;
+                if (memory) {
+                    // Whatever used the memory last, this frame or a previous one, has to finish before it's overwritten
+                    resource->State.WriteStages = memory->LastStages;
+                    resource->State.WriteAccess = memory->LastAccess;
+                } else if (resource->IsImage && resource->State.WriteStages == VK_PIPELINE_STAGE_2_NONE) {
+                    // Chains the layout transition onto the semaphore wait that made the image available
+                    resource->State.WriteStages = usage->Stages;
+                }
+            }
+            RenderGraphAddBarrier(graph, &batch, passData->Uses[i].Resource, usage);
+            if (memory) {
+                memory->LastStages = resource->State.WriteStages | resource->State.ReadStages;
+                memory->LastAccess = resource->State.WriteAccess;
+            }
+        }
+        RenderGraphFlushBarriers(graph, commandBuffer, &batch);
+
+        passData->Callback(commandBuffer, graph, passData->UserData);
+        graph->Stats.PassesExecuted++;
+    }
+
+    RenderGraphBarrierBatch batch = {};
+    for (uint32_t i = 0; i < graph->ResourceCount; i++) {
+        RenderGraphResourceData* resource = &graph->Resources[i];
+        if (resource->HasFinalUsage && resource->Used) {
+            RenderGraphAddBarrier(graph, &batch, i, &RenderGraphUsageInfos[resource->FinalUsage]);
+        }
+    }
+    RenderGraphFlushBarriers(graph, commandBuffer, &batch);
+}
+
+VkImage RenderGraphGetImage(RenderGraph* graph, RenderGraphResource resource) {
+    assert(resource < graph->ResourceCount && graph->Resources[resource].IsImage);
+    return graph->Resources[resource].Image;
+}
+
+VkImageView RenderGraphGetImageView(RenderGraph* graph, RenderGraphResource resource) {
+    assert(resource < graph->ResourceCount && graph->Resources[resource].IsImage);
+    return graph->Resources[resource].View;
+}
+
+VkBuffer RenderGraphGetBuffer(RenderGraph* graph, RenderGraphResource resource) {
+    assert(resource < graph->ResourceCount && !graph->Resources[resource].IsImage);
+    return graph->Resources[resource].Buffer;
+}
+
+VkPipelineStageFlags RenderGraphGetFirstStages(RenderGraph* graph, RenderGraphResource resource) {
+    assert(resource < graph->ResourceCount);
+    return cast(VkPipelineStageFlags) graph->Resources[resource].FirstStages;
+}
+
+void RenderGraphPrintStats(RenderGraph* graph) {
+    printf("Render graph ran %llu passes and culled %llu, %llu barrier batches with %llu image and %llu memory barriers (%s)\n",
+           cast(unsigned long long) graph->Stats.PassesExecuted,
+           cast(unsigned long long) graph->Stats.PassesCulled,
+           cast(unsigned long long) graph->Stats.BarrierBatches,
+           cast(unsigned long long) graph->Stats.ImageBarriers,
+           cast(unsigned long long) graph->Stats.MemoryBarriers,
+           graph->CmdPipelineBarrier2 ? "synchronization2" : "legacy barriers");
+    if (graph->Stats.TransientImageBytes > 0) {
+        printf("Render graph transients needed %.1fMB of images in %.1fMB of memory\n",
+               cast(double) graph->Stats.TransientImageBytes / (1024.0 * 1024.0),
+               cast(double) graph->Stats.TransientMemoryBytes / (1024.0 * 1024.0));
+    }
+}
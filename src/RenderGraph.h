@@ -0,0 +1,178 @@
+#pragma once
+
+#include "Common.h"
+#include "DeviceAllocator.h"
+
+#define RenderGraphMaxPasses      64
+#define RenderGraphMaxResources   64
+#define RenderGraphMaxUsesPerPass 16
+#define RenderGraphMaxTransients  32
+
+typedef uint32_t RenderGraphResource;
+typedef struct RenderGraph RenderGraph;
+
+// Records the pass, resources it declared can be looked up with RenderGraphGetImage and friends
+typedef void (*RenderGraphCallback)(VkCommandBuffer commandBuffer, RenderGraph* graph, void* userData);
+
+// How a pass uses a resource, each one maps to exact stage and access masks and the image layout it needs
+typedef enum RenderGraphUsage {
+    RenderGraphUsage_TransferSrc,
+    RenderGraphUsage_TransferDst,
+    RenderGraphUsage_ColorAttachment,
+    RenderGraphUsage_DepthAttachment,
+    RenderGraphUsage_FragmentSampled,
+    RenderGraphUsage_ComputeSampled,
+    RenderGraphUsage_ComputeStorageRead,
+    RenderGraphUsage_ComputeStorageWrite,
+    RenderGraphUsage_IndirectRead,
+    RenderGraphUsage_VertexRead,
+    RenderGraphUsage_HostRead,
+    RenderGraphUsage_Present,
+    RenderGraphUsage_Count,
+} RenderGraphUsage;
+
+typedef struct RenderGraphImageDesc {
+    VkFormat Format;
+    VkExtent2D Extent;
+    VkImageUsageFlags Usage;
+    VkImageAspectFlags Aspect;
+} RenderGraphImageDesc;
+
+typedef struct RenderGraphResourceState {
+    VkImageLayout Layout;
+    VkPipelineStageFlags2 WriteStages;
+    VkAccessFlags2 WriteAccess;
+    // Stages that read since the last write, a later write has to wait for them
+    VkPipelineStageFlags2 ReadStages;
+    // Stages and accesses the last write has already been made visible to
+    VkPipelineStageFlags2 VisibleStages;
+    VkAccessFlags2 VisibleAccess;
+} RenderGraphResourceState;
+
+typedef struct RenderGraphResourceData {
+    const char* Name;
+    bool IsImage;
+    bool Imported;
+    bool HasFinalUsage;
+    RenderGraphUsage FinalUsage;
+    RenderGraphImageDesc Desc;
+    VkImage Image;
+    VkImageView View;
+    VkBuffer Buffer;
+    RenderGraphResourceState State;
+    VkPipelineStageFlags2 FirstStages;
+    bool Used;
+    bool Needed;
+    uint32_t FirstPass;
+    uint32_t LastPass;
+    uint32_t Transient;
+} RenderGraphResourceData;
+
+typedef struct RenderGraphResourceUse {
+    RenderGraphResource Resource;
+    RenderGraphUsage Usage;
+} RenderGraphResourceUse;
+
+typedef struct RenderGraphPass {
+    const char* Name;
+    RenderGraphCallback Callback;
+    void* UserData;
+    bool Live;
+    uint32_t UseCount;
+    RenderGraphResourceUse Uses[RenderGraphMaxUsesPerPass];
+} RenderGraphPass;
+
+typedef struct RenderGraphTransientImage {
+    RenderGraphImageDesc Desc;
+    uint32_t FirstPass;
+    uint32_t LastPass;
+    VkImage Image;
+    VkImageView View;
+    VkMemoryRequirements Requirements;
+    uint32_t Memory;
+} RenderGraphTransientImage;
+
+// Memory shared by transient images whose lifetimes don't overlap. The next image to use it has to wait for
+// whatever the previous one did last, even across frames.
+typedef struct RenderGraphTransientMemory {
+    DeviceAllocation* Allocation;
+    VkMemoryRequirements Requirements;
+    VkPipelineStageFlags2 LastStages;
+    VkAccessFlags2 LastAccess;
+} RenderGraphTransientMemory;
+
+typedef struct RenderGraphTransientSet {
+    uint32_t ImageCount;
+    RenderGraphTransientImage Images[RenderGraphMaxTransients];
+    uint32_t MemoryCount;
+    RenderGraphTransientMemory Memory[RenderGraphMaxTransients];
+    uint64_t RetireFrame;
+} RenderGraphTransientSet;
+
+typedef struct RenderGraphStats {
+    uint64_t PassesExecuted;
+    uint64_t PassesCulled;
+    uint64_t BarrierBatches;
+    uint64_t ImageBarriers;
+    uint64_t MemoryBarriers;
+    VkDeviceSize TransientImageBytes;
+    VkDeviceSize TransientMemoryBytes;
+} RenderGraphStats;
+
+// Rebuilt every frame: passes declare the resources they use and how, then RenderGraphExecute culls passes
+// whose results are never used, places transient images into shared memory where their lifetimes allow it
+// and records every pass with the layout transitions and barriers it needs, merged into one batch per pass.
+// Imported resources are assumed to be synchronized with the outside through a semaphore wait at their first
+// use stages, see RenderGraphGetFirstStages. Transient images are kept from frame to frame as long as the graph
+// keeps the same shape, and destroyed framesInFlight frames after it changes.
+struct RenderGraph {
+    VkDevice Device;
+    const VkAllocationCallbacks* Allocator;
+    DeviceAllocator* DeviceAllocator;
+    PFN_vkCmdPipelineBarrier2KHR CmdPipelineBarrier2;
+    uint32_t FramesInFlight;
+    uint64_t FrameNumber;
+
+    uint32_t PassCount;
+    RenderGraphPass Passes[RenderGraphMaxPasses];
+    uint32_t ResourceCount;
+    RenderGraphResourceData Resources[RenderGraphMaxResources];
+
+    RenderGraphTransientSet* Transients;
+    RenderGraphTransientSet* Retired[MaxFramesInFlight];
+    RenderGraphStats Stats;
+};
+
+// Barriers go through vkCmdPipelineBarrier2KHR when synchronization2 is enabled on the device
+RenderGraph* RenderGraphCreate(VkDevice device,
+                               DeviceAllocator* deviceAllocator,
+                               bool synchronization2,
+                               uint32_t framesInFlight,
+                               const VkAllocationCallbacks* allocator);
+// The device must be idle
+void RenderGraphDestroy(RenderGraph* graph);
+
+// Must be called after the frame slot's GPU work has finished, starts an empty graph
+void RenderGraphBeginFrame(RenderGraph* graph);
+// The image is left in finalUsage's layout at the end of the graph
+RenderGraphResource RenderGraphImportImage(RenderGraph* graph,
+                                           const char* name,
+                                           VkImage image,
+                                           VkImageView view,
+                                           VkImageAspectFlags aspect,
+                                           VkImageLayout initialLayout,
+                                           RenderGraphUsage finalUsage);
+RenderGraphResource RenderGraphImportBuffer(RenderGraph* graph, const char* name, VkBuffer buffer, RenderGraphUsage finalUsage);
+RenderGraphResource RenderGraphCreateImage(RenderGraph* graph, const char* name, const RenderGraphImageDesc* desc);
+uint32_t RenderGraphAddPass(RenderGraph* graph, const char* name, RenderGraphCallback callback, void* userData);
+void RenderGraphUse(RenderGraph* graph, uint32_t pass, RenderGraphResource resource, RenderGraphUsage usage);
+void RenderGraphExecute(RenderGraph* graph, VkCommandBuffer commandBuffer);
+
+VkImage RenderGraphGetImage(RenderGraph* graph, RenderGraphResource resource);
+VkImageView RenderGraphGetImageView(RenderGraph* graph, RenderGraphResource resource);
+VkBuffer RenderGraphGetBuffer(RenderGraph* graph, RenderGraphResource resource);
+// The stages of the resource's first use, which is where a semaphore wait guarding it has to be, valid after
+// RenderGraphExecute. Returns 0 if no live pass uses it.
+VkPipelineStageFlags RenderGraphGetFirstStages(RenderGraph* graph, RenderGraphResource resource);
+
+void RenderGraphPrintStats(RenderGraph* graph);
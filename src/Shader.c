@@ -0,0 +1,142 @@
+#include "Shader.h"
+#include "System.h"
+
+#include <stdatomic.h>
+
+typedef struct ShaderStats {
+    atomic_uint_least64_t ModuleCount;
+    atomic_uint_least64_t CreateNanoseconds;
+} ShaderStats;
+
+static ShaderStats ShaderStatsTable[ShaderIdCount];
+
+VkShaderModule ShaderCreateModule(VkDevice device, ShaderId shader, const VkAllocationCallbacks* allocator) {
+    assert(shader < ShaderIdCount);
+    const ShaderInfo* info      = &Shaders[shader];
+    uint64_t start              = SystemGetTimeNanoseconds();
+    VkShaderModule shaderModule = VK_NULL_HANDLE;
+    VkResult createResult       = vkCreateShaderModule(device,
+                                                 &(VkShaderModuleCreateInfo){
+                                                     .sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+                                                     .codeSize = info->CodeSize,
+                                                     .pCode    = info->Code,
+                                                 },
+                                                 allocator,
+                                                 &shaderModule);
+    if (createResult != VK_SUCCESS) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to create the shader module for %s! %x\n", info->Name, createResult);
+        exit(1);
+    }
+    ShaderStats* stats = &ShaderStatsTable[shader];
+    atomic_fetch_add_explicit(&stats->ModuleCount, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->CreateNanoseconds, SystemGetTimeNanoseconds() - start, memory_order_relaxed);
+    return shaderModule;
+}
+
+const VkSpecializationInfo* ShaderSpecialize(ShaderId shader, const uint32_t* values, uint32_t valueCount, ShaderSpecialization* spec) {
+    assert(shader < ShaderIdCount);
+    const ShaderInfo* info = &Shaders[shader];
+    uint32_t entryCount    = 0;
+    for (uint32_t i = 0; i < info->SpecConstantCount; i++) {
+        uint32_t id = info->SpecConstants[i].Id;
+        if (id >= valueCount) {
+            continue;
+        }
+        assert(entryCount < ShaderMaxSpecConstants);
+        spec->Data[entryCount]    = values[id];
+        spec->Entries[entryCount] = (VkSpecializationMapEntry){
+            .constantID = id,
+            .offset     = entryCount * sizeof(uint32_t),
+            .size       = sizeof(uint32_t),
+        };
+        entryCount++;
+    }
+    if (entryCount == 0) {
+        return NULL;
+    }
+    spec->Info = (VkSpecializationInfo){
+        .mapEntryCount = entryCount,
+        .pMapEntries   = spec->Entries,
+        .dataSize      = entryCount * sizeof(uint32_t),
+        .pData         = spec->Data,
+    };
+    return &spec->Info;
+}
+
+const char* ShaderCheckReplacement(ShaderId shader, const uint32_t* code, size_t codeSize) {
+    assert(shader < ShaderIdCount);
+    const ShaderInfo* info = &Shaders[shader];
+    if (codeSize % 4 != 0 || codeSize / 4 > UINT32_MAX) {
+        return "the file isn't a whole number of words";
+    }
+    ShaderReflection reflection;
+    const char* error = ShaderReflect(code, cast(uint32_t)(codeSize / 4), &reflection);
+    if (error != NULL) {
+        return error;
+    }
+    if (reflection.Stage != info->Stage) {
+        return "the entry point is for another stage";
+    }
+    if (reflection.PushConstantSize != info->PushConstantSize) {
+        return "the push constant size changed";
+    }
+    if (memcmp(reflection.LocalSize, info->LocalSize, sizeof(reflection.LocalSize)) != 0) {
+        return "the workgroup size changed";
+    }
+    if (reflection.BindingCount != info->BindingCount) {
+        return "the bindings changed";
+    }
+    for (uint32_t i = 0; i < info->BindingCount; i++) {
+        const ShaderBinding* binding  = &reflection.Bindings[i];
+        const ShaderBinding* embedded = &info->Bindings[i];
+        if (binding->Set != embedded->Set || binding->Binding != embedded->Binding || binding->Type != embedded->Type ||
+            binding->Count != embedded->Count) {
+            return "the bindings changed";
+        }
+    }
+    // Defaults may change, ShaderSpecialize only needs the ids
+    if (reflection.SpecConstantCount != info->SpecConstantCount) {
+        return "the specialization constants changed";
+    }
+    for (uint32_t i = 0; i < info->SpecConstantCount; i++) {
+        if (reflection.SpecConstants[i].Id != info->SpecConstants[i].Id) {
+            return "the specialization constants changed";
+        }
+    }
+    return NULL;
+}
+
+uint64_t ShaderGetEmbeddedBytes(void) {
+    uint64_t bytes = 0;
+    for (uint32_t i = 0; i < ShaderIdCount; i++) {
+        bytes += Shaders[i].CodeSize;
+    }
+    return bytes;
+}
+
+uint64_t ShaderGetCreateNanoseconds(void) {
+    uint64_t nanoseconds = 0;
+    for (uint32_t i = 0; i < ShaderIdCount; i++) {
+        nanoseconds += atomic_load_explicit(&ShaderStatsTable[i].CreateNanoseconds, memory_order_relaxed);
+    }
+    return nanoseconds;
+}
+
+void ShaderPrintStats(void) {
+    printf("%-16s %10s %8s %6s %8s %12s\n", "Shader", "Bytes", "Bindings", "Push", "Modules", "Create ms");
+    for (uint32_t i = 0; i < ShaderIdCount; i++) {
+        const ShaderInfo* info   = &Shaders[i];
+        const ShaderStats* stats = &ShaderStatsTable[i];
+        printf("%-16s %10zu %8u %6u %8llu %12.3f\n",
+               info->Name,
+               info->CodeSize,
+               info->BindingCount,
+               info->PushConstantSize,
+               cast(unsigned long long) atomic_load_explicit(&stats->ModuleCount, memory_order_relaxed),
+               cast(double) atomic_load_explicit(&stats->CreateNanoseconds, memory_order_relaxed) / 1e6);
+    }
+    printf("Embedded %llu bytes of SPIR-V and spent %.3fms creating shader modules!\n",
+           cast(unsigned long long) ShaderGetEmbeddedBytes(),
+           cast(double) ShaderGetCreateNanoseconds() / 1e6);
+}
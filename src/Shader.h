@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Common.h"
+#include "ShaderReflect.h"
+#include "Shaders.h"
+
+// Most specialization constants a ShaderSpecialize call can set
+#define ShaderMaxSpecConstants 8
+
+// A shader compiled and reflected at build time, see ShaderEmbed.c and ShaderReflect.c
+typedef struct ShaderInfo {
+    const char* Name;
+    const uint32_t* Code;
+    size_t CodeSize;
+    VkShaderStageFlagBits Stage;
+    uint32_t PushConstantSize;
+    // Before specialization
+    uint32_t LocalSize[3];
+    // Sorted by set and binding, variables aliasing a binding are listed once
+    uint32_t BindingCount;
+    const ShaderBinding* Bindings;
+    // Sorted by id
+    uint32_t SpecConstantCount;
+    const ShaderSpecConstant* SpecConstants;
+} ShaderInfo;
+
+extern const ShaderInfo Shaders[ShaderIdCount];
+
+// Points into itself, so it must not be copied after ShaderSpecialize
+typedef struct ShaderSpecialization {
+    VkSpecializationMapEntry Entries[ShaderMaxSpecConstants];
+    uint32_t Data[ShaderMaxSpecConstants];
+    VkSpecializationInfo Info;
+} ShaderSpecialization;
+
+// Creates a module from the embedded code and adds the time it took to the shader's stats, can be called from any
+// thread
+VkShaderModule ShaderCreateModule(VkDevice device, ShaderId shader, const VkAllocationCallbacks* allocator);
+// Fills spec with values[i] for constant_id i of every specialization constant the shader declares with an id below
+// valueCount, constants the shader doesn't declare are skipped and the rest keep their defaults. Returns
+// &spec->Info, or NULL if nothing was set.
+const VkSpecializationInfo* ShaderSpecialize(ShaderId shader, const uint32_t* values, uint32_t valueCount, ShaderSpecialization* spec);
+
+// Whether code can stand in for the shader's embedded code: it has to be whole SPIR-V with the same stage, bindings,
+// push constant size, workgroup size and specialization constant ids, since pipeline layouts and dispatches were set up
+// from the embedded reflection. Returns NULL if it can, otherwise why not.
+const char* ShaderCheckReplacement(ShaderId shader, const uint32_t* code, size_t codeSize);
+
+// Bytes of SPIR-V embedded in the executable
+uint64_t ShaderGetEmbeddedBytes(void);
+// Time spent in vkCreateShaderModule so far
+uint64_t ShaderGetCreateNanoseconds(void);
+void ShaderPrintStats(void);
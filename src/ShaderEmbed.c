@@ -0,0 +1,235 @@
+#include "Common.h"
+#include "ShaderReflect.h"
+
+// Build step that turns the compiled shaders into Shaders.h and Shaders.c. Every shader becomes a constant word array
+// in the executable, together with what ShaderReflect finds in it: the stage, descriptor bindings, push constant
+// size, specialization constants and workgroup size. Runs as
+//     ShaderEmbed Shaders.h Shaders.c Name.stage Name.stage.spv [Name.stage Name.stage.spv ...]
+// and prints each shader's size, so the build log tracks them.
+
+typedef struct ShaderEmbedShader {
+    const char* Name;
+    const char* Path;
+    char Identifier[64];
+    uint32_t* Words;
+    uint32_t WordCount;
+    ShaderReflection Reflection;
+} ShaderEmbedShader;
+
+static void ShaderEmbedFail(const ShaderEmbedShader* shader, const char* reason) {
+    fflush(stdout);
+    fprintf(stderr, "Failed to embed '%s', %s!\n", shader->Path, reason);
+    exit(1);
+}
+
+static void ShaderEmbedRead(ShaderEmbedShader* shader) {
+    FILE* file = fopen(shader->Path, "rb");
+    if (file == NULL) {
+        ShaderEmbedFail(shader, "the file can't be opened");
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size <= 0 || size % 4 != 0) {
+        ShaderEmbedFail(shader, "the file isn't a whole number of words");
+    }
+    shader->WordCount = cast(uint32_t)(size / 4);
+    shader->Words     = malloc(cast(size_t) size);
+    if (shader->Words == NULL || fread(shader->Words, 4, shader->WordCount, file) != shader->WordCount) {
+        ShaderEmbedFail(shader, "the file can't be read");
+    }
+    fclose(file);
+}
+
+// Cull.comp becomes CullComp
+static void ShaderEmbedMakeIdentifier(ShaderEmbedShader* shader) {
+    size_t length = 0;
+    bool upper    = true;
+    for (const char* c = shader->Name; *c && length + 1 < sizeof(shader->Identifier); c++) {
+        bool alphanumeric = (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') || (*c >= '0' && *c <= '9');
+        if (!alphanumeric) {
+            upper = true;
+            continue;
+        }
+        shader->Identifier[length++] = upper && *c >= 'a' && *c <= 'z' ? cast(char)(*c - 'a' + 'A') : *c;
+        upper                        = false;
+    }
+    shader->Identifier[length] = '\0';
+    if (length == 0 || (shader->Identifier[0] >= '0' && shader->Identifier[0] <= '9')) {
+        ShaderEmbedFail(shader, "the name doesn't make an identifier");
+    }
+}
+
+static const char* ShaderEmbedStageName(VkShaderStageFlagBits stage) {
+    switch (stage) {
+    case VK_SHADER_STAGE_VERTEX_BIT:
+        return "VK_SHADER_STAGE_VERTEX_BIT";
+    case VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT:
+        return "VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT";
+    case VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT:
+        return "VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT";
+    case VK_SHADER_STAGE_GEOMETRY_BIT:
+        return "VK_SHADER_STAGE_GEOMETRY_BIT";
+    case VK_SHADER_STAGE_FRAGMENT_BIT:
+        return "VK_SHADER_STAGE_FRAGMENT_BIT";
+    default:
+        return "VK_SHADER_STAGE_COMPUTE_BIT";
+    }
+}
+
+static const char* ShaderEmbedDescriptorTypeName(VkDescriptorType type) {
+    switch (type) {
+    case VK_DESCRIPTOR_TYPE_SAMPLER:
+        return "VK_DESCRIPTOR_TYPE_SAMPLER";
+    case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+        return "VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER";
+    case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+        return "VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE";
+    case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+        return "VK_DESCRIPTOR_TYPE_STORAGE_IMAGE";
+    case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+        return "VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER";
+    case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+        return "VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER";
+    case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+        return "VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER";
+    default:
+        return "VK_DESCRIPTOR_TYPE_STORAGE_BUFFER";
+    }
+}
+
+static void ShaderEmbedWriteHeader(FILE* file, const ShaderEmbedShader* shaders, uint32_t shaderCount) {
+    fprintf(file, "// Generated by ShaderEmbed from the shaders listed in CMakeLists.txt, do not edit\n#pragma once\n\n");
+    fprintf(file, "typedef enum ShaderId {\n");
+    for (uint32_t i = 0; i < shaderCount; i++) {
+        fprintf(file, "    ShaderId_%s,\n", shaders[i].Identifier);
+    }
+    fprintf(file, "    ShaderIdCount,\n} ShaderId;\n");
+}
+
+static void ShaderEmbedWriteSource(FILE* file, const ShaderEmbedShader* shaders, uint32_t shaderCount) {
+    fprintf(file, "// Generated by ShaderEmbed from the shaders listed in CMakeLists.txt, do not edit\n#include \"Shader.h\"\n");
+    for (uint32_t i = 0; i < shaderCount; i++) {
+        const ShaderEmbedShader* shader      = &shaders[i];
+        const ShaderReflection* reflection = &shader->Reflection;
+        fprintf(file, "\nstatic const uint32_t Shader%sCode[] = {", shader->Identifier);
+        for (uint32_t word = 0; word < shader->WordCount; word++) {
+            fprintf(file, "%s0x%08X,", word % 8 == 0 ? "\n    " : " ", shader->Words[word]);
+        }
+        fprintf(file, "\n};\n");
+        if (reflection->BindingCount > 0) {
+            fprintf(file, "static const ShaderBinding Shader%sBindings[] = {\n", shader->Identifier);
+            for (uint32_t j = 0; j < reflection->BindingCount; j++) {
+                const ShaderBinding* binding = &reflection->Bindings[j];
+                fprintf(file,
+                        "    { %u, %u, %s, %u },\n",
+                        binding->Set,
+                        binding->Binding,
+                        ShaderEmbedDescriptorTypeName(binding->Type),
+                        binding->Count);
+            }
+            fprintf(file, "};\n");
+        }
+        if (reflection->SpecConstantCount > 0) {
+            fprintf(file, "static const ShaderSpecConstant Shader%sSpecConstants[] = {\n", shader->Identifier);
+            for (uint32_t j = 0; j < reflection->SpecConstantCount; j++) {
+                fprintf(file, "    { %u, %u },\n", reflection->SpecConstants[j].Id, reflection->SpecConstants[j].Default);
+            }
+            fprintf(file, "};\n");
+        }
+    }
+
+    fprintf(file, "\nconst ShaderInfo Shaders[ShaderIdCount] = {\n");
+    for (uint32_t i = 0; i < shaderCount; i++) {
+        const ShaderEmbedShader* shader      = &shaders[i];
+        const ShaderReflection* reflection = &shader->Reflection;
+        const char* id                     = shader->Identifier;
+        fprintf(file, "    [ShaderId_%s] =\n        {\n", id);
+        fprintf(file, "            .Name              = \"%s\",\n", shader->Name);
+        fprintf(file, "            .Code              = Shader%sCode,\n", id);
+        fprintf(file, "            .CodeSize          = sizeof(Shader%sCode),\n", id);
+        fprintf(file, "            .Stage             = %s,\n", ShaderEmbedStageName(reflection->Stage));
+        fprintf(file, "            .PushConstantSize  = %u,\n", reflection->PushConstantSize);
+        fprintf(file, "            .LocalSize         = { %u, %u, %u },\n", reflection->LocalSize[0], reflection->LocalSize[1], reflection->LocalSize[2]);
+        fprintf(file, "            .BindingCount      = %u,\n", reflection->BindingCount);
+        if (reflection->BindingCount > 0) {
+            fprintf(file, "            .Bindings          = Shader%sBindings,\n", id);
+        }
+        fprintf(file, "            .SpecConstantCount = %u,\n", reflection->SpecConstantCount);
+        if (reflection->SpecConstantCount > 0) {
+            fprintf(file, "            .SpecConstants     = Shader%sSpecConstants,\n", id);
+        }
+        fprintf(file, "        },\n");
+    }
+    fprintf(file, "};\n");
+}
+
+static void ShaderEmbedWrite(const char* path, const ShaderEmbedShader* shaders, uint32_t shaderCount, bool header) {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to open '%s' for writing!\n", path);
+        exit(1);
+    }
+    if (header) {
+        ShaderEmbedWriteHeader(file, shaders, shaderCount);
+    } else {
+        ShaderEmbedWriteSource(file, shaders, shaderCount);
+    }
+    bool success = ferror(file) == 0;
+    success      = fclose(file) == 0 && success;
+    if (!success) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to write '%s'!\n", path);
+        exit(1);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 5 || (argc - 3) % 2 != 0) {
+        fflush(stdout);
+        fprintf(stderr, "Usage: ShaderEmbed Shaders.h Shaders.c Name.stage Name.stage.spv [Name.stage Name.stage.spv ...]\n");
+        return 1;
+    }
+    uint32_t shaderCount       = cast(uint32_t)(argc - 3) / 2;
+    ShaderEmbedShader* shaders = calloc(shaderCount, sizeof(ShaderEmbedShader));
+    if (shaders == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate the shaders!\n");
+        return 1;
+    }
+
+    uint64_t totalBytes = 0;
+    for (uint32_t i = 0; i < shaderCount; i++) {
+        ShaderEmbedShader* shader = &shaders[i];
+        shader->Name              = argv[3 + i * 2];
+        shader->Path              = argv[4 + i * 2];
+        ShaderEmbedMakeIdentifier(shader);
+        for (uint32_t j = 0; j < i; j++) {
+            if (strcmp(shaders[j].Identifier, shader->Identifier) == 0) {
+                ShaderEmbedFail(shader, "another shader has the same name");
+            }
+        }
+        ShaderEmbedRead(shader);
+        const char* error = ShaderReflect(shader->Words, shader->WordCount, &shader->Reflection);
+        if (error != NULL) {
+            ShaderEmbedFail(shader, error);
+        }
+        totalBytes += shader->WordCount * 4ull;
+        printf("Embedded %s, %u bytes, %u bindings, %u push constant bytes and %u specialization constants\n",
+               shader->Name,
+               shader->WordCount * 4,
+               shader->Reflection.BindingCount,
+               shader->Reflection.PushConstantSize,
+               shader->Reflection.SpecConstantCount);
+    }
+    printf("Embedded %u shaders in %llu bytes\n", shaderCount, cast(unsigned long long) totalBytes);
+
+    ShaderEmbedWrite(argv[1], shaders, shaderCount, true);
+    ShaderEmbedWrite(argv[2], shaders, shaderCount, false);
+    for (uint32_t i = 0; i < shaderCount; i++) {
+        free(shaders[i].Words);
+    }
+    free(shaders);
+    return 0;
+}
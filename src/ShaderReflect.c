@@ -0,0 +1,397 @@
+#include "ShaderReflect.h"
+
+// Structs nest deeper than this only in broken modules, which could otherwise make the size recursion loop forever
+#define ShaderReflectMaxTypeDepth 16
+
+// SPIR-V opcodes, decorations and enums the reflection looks at
+enum {
+    SpirvMagic                   = 0x07230203,
+    SpirvOpEntryPoint            = 15,
+    SpirvOpExecutionMode         = 16,
+    SpirvOpTypeBool              = 20,
+    SpirvOpTypeInt               = 21,
+    SpirvOpTypeFloat             = 22,
+    SpirvOpTypeVector            = 23,
+    SpirvOpTypeMatrix            = 24,
+    SpirvOpTypeImage             = 25,
+    SpirvOpTypeSampler           = 26,
+    SpirvOpTypeSampledImage      = 27,
+    SpirvOpTypeArray             = 28,
+    SpirvOpTypeRuntimeArray      = 29,
+    SpirvOpTypeStruct            = 30,
+    SpirvOpTypePointer           = 32,
+    SpirvOpConstant              = 43,
+    SpirvOpSpecConstantTrue      = 48,
+    SpirvOpSpecConstantFalse     = 49,
+    SpirvOpSpecConstant          = 50,
+    SpirvOpFunction              = 54,
+    SpirvOpFunctionEnd           = 56,
+    SpirvOpVariable              = 59,
+    SpirvOpDecorate              = 71,
+    SpirvOpMemberDecorate        = 72,
+    SpirvDecorationSpecId        = 1,
+    SpirvDecorationBlock         = 2,
+    SpirvDecorationBufferBlock   = 3,
+    SpirvDecorationArrayStride   = 6,
+    SpirvDecorationMatrixStride  = 7,
+    SpirvDecorationBinding       = 33,
+    SpirvDecorationDescriptorSet = 34,
+    SpirvDecorationOffset        = 35,
+    SpirvExecutionModeLocalSize  = 17,
+    SpirvExecutionModelGLCompute = 5,
+    SpirvStorageUniformConstant  = 0,
+    SpirvStorageUniform          = 2,
+    SpirvStoragePushConstant     = 9,
+    SpirvStorageStorageBuffer    = 12,
+    SpirvDimBuffer               = 5,
+};
+
+typedef struct ShaderReflectId {
+    // The instruction defining the id if it's a type, constant or variable, NULL otherwise
+    const uint32_t* Definition;
+    bool HasSet;
+    bool HasBinding;
+    bool HasSpecId;
+    bool BufferBlock;
+    uint32_t Set;
+    uint32_t Binding;
+    uint32_t SpecId;
+    uint32_t ArrayStride;
+} ShaderReflectId;
+
+typedef struct ShaderReflectState {
+    const uint32_t* Words;
+    uint32_t WordCount;
+    ShaderReflectId* Ids;
+    uint32_t Bound;
+    ShaderReflection* Reflection;
+    // The first failure, everything after it returns early
+    const char* Error;
+} ShaderReflectState;
+
+static void ShaderReflectFail(ShaderReflectState* state, const char* reason) {
+    if (state->Error == NULL) {
+        state->Error = reason;
+    }
+}
+
+// NULL if the id isn't defined or its instruction is shorter than minWordCount
+static const uint32_t* ShaderReflectDefinition(ShaderReflectState* state, uint32_t id, uint32_t minWordCount) {
+    if (id >= state->Bound || state->Ids[id].Definition == NULL) {
+        ShaderReflectFail(state, "an id is used without being defined");
+        return NULL;
+    }
+    const uint32_t* definition = state->Ids[id].Definition;
+    if ((definition[0] >> 16) < minWordCount) {
+        ShaderReflectFail(state, "an instruction is missing operands");
+        return NULL;
+    }
+    return definition;
+}
+
+// The instruction stream has been walked already, so every word count is known to be in bounds
+static uint32_t ShaderReflectMemberDecoration(const ShaderReflectState* state, uint32_t structId, uint32_t member, uint32_t decoration) {
+    for (const uint32_t* word = state->Words + 5; word < state->Words + state->WordCount; word += *word >> 16) {
+        if ((*word & 0xFFFF) == SpirvOpMemberDecorate && (*word >> 16) >= 5 && word[1] == structId && word[2] == member &&
+            word[3] == decoration) {
+            return word[4];
+        }
+    }
+    return 0;
+}
+
+static uint32_t ShaderReflectConstantValue(ShaderReflectState* state, uint32_t id) {
+    const uint32_t* constant = ShaderReflectDefinition(state, id, 4);
+    if (constant == NULL) {
+        return 0;
+    }
+    if ((constant[0] & 0xFFFF) != SpirvOpConstant) {
+        ShaderReflectFail(state, "an array length isn't a plain constant");
+        return 0;
+    }
+    return constant[3];
+}
+
+// Size of a type in a push constant block, matrixStride comes from the struct member holding the type
+static uint32_t ShaderReflectTypeSize(ShaderReflectState* state, uint32_t typeId, uint32_t matrixStride, uint32_t depth) {
+    const uint32_t* type = ShaderReflectDefinition(state, typeId, 2);
+    if (type == NULL) {
+        return 0;
+    }
+    if (depth > ShaderReflectMaxTypeDepth) {
+        ShaderReflectFail(state, "push constant types nest too deeply");
+        return 0;
+    }
+    uint32_t wordCount = type[0] >> 16;
+    switch (type[0] & 0xFFFF) {
+    case SpirvOpTypeBool:
+        return 4;
+    case SpirvOpTypeInt:
+    case SpirvOpTypeFloat:
+        if (wordCount < 3) {
+            break;
+        }
+        return type[2] / 8;
+    case SpirvOpTypeVector:
+        if (wordCount < 4) {
+            break;
+        }
+        return type[3] * ShaderReflectTypeSize(state, type[2], 0, depth + 1);
+    case SpirvOpTypeMatrix:
+        if (wordCount < 4) {
+            break;
+        }
+        return type[3] * (matrixStride > 0 ? matrixStride : ShaderReflectTypeSize(state, type[2], 0, depth + 1));
+    case SpirvOpTypeArray: {
+        if (wordCount < 4) {
+            break;
+        }
+        uint32_t stride = state->Ids[typeId].ArrayStride;
+        return ShaderReflectConstantValue(state, type[3]) *
+               (stride > 0 ? stride : ShaderReflectTypeSize(state, type[2], matrixStride, depth + 1));
+    }
+    case SpirvOpTypeStruct: {
+        uint32_t size = 0;
+        for (uint32_t member = 0; member + 2 < wordCount && state->Error == NULL; member++) {
+            uint32_t offset = ShaderReflectMemberDecoration(state, typeId, member, SpirvDecorationOffset);
+            uint32_t stride = ShaderReflectMemberDecoration(state, typeId, member, SpirvDecorationMatrixStride);
+            uint32_t end    = offset + ShaderReflectTypeSize(state, type[member + 2], stride, depth + 1);
+            size            = end > size ? end : size;
+        }
+        return size;
+    }
+    default:
+        ShaderReflectFail(state, "a push constant member has a type without a known size");
+        return 0;
+    }
+    ShaderReflectFail(state, "an instruction is missing operands");
+    return 0;
+}
+
+static void ShaderReflectBinding(ShaderReflectState* state, uint32_t variableId, const uint32_t* variable) {
+    ShaderReflection* reflection = state->Reflection;
+    const ShaderReflectId* id    = &state->Ids[variableId];
+    const uint32_t* pointer      = ShaderReflectDefinition(state, variable[1], 4);
+    if (pointer == NULL) {
+        return;
+    }
+    uint32_t storageClass = variable[3];
+    uint32_t typeId       = pointer[3];
+    const uint32_t* type  = ShaderReflectDefinition(state, typeId, 2);
+    uint32_t count        = 1;
+    if (type != NULL && (type[0] & 0xFFFF) == SpirvOpTypeArray && (type[0] >> 16) >= 4) {
+        count  = ShaderReflectConstantValue(state, type[3]);
+        typeId = type[2];
+        type   = ShaderReflectDefinition(state, typeId, 2);
+    } else if (type != NULL && (type[0] & 0xFFFF) == SpirvOpTypeRuntimeArray && (type[0] >> 16) >= 3) {
+        // Sized by the pipeline layout instead
+        count  = 0;
+        typeId = type[2];
+        type   = ShaderReflectDefinition(state, typeId, 2);
+    }
+    if (type == NULL) {
+        return;
+    }
+
+    VkDescriptorType descriptorType = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+    switch (type[0] & 0xFFFF) {
+    case SpirvOpTypeStruct:
+        if (storageClass == SpirvStorageStorageBuffer || (storageClass == SpirvStorageUniform && state->Ids[typeId].BufferBlock)) {
+            descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        } else if (storageClass == SpirvStorageUniform) {
+            descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        }
+        break;
+    case SpirvOpTypeImage:
+        if ((type[0] >> 16) < 9) {
+            break;
+        }
+        if (type[7] == 2) {
+            descriptorType = type[3] == SpirvDimBuffer ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        } else {
+            descriptorType = type[3] == SpirvDimBuffer ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        }
+        break;
+    case SpirvOpTypeSampler:
+        descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+        break;
+    case SpirvOpTypeSampledImage:
+        descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        break;
+    }
+    if (descriptorType == VK_DESCRIPTOR_TYPE_MAX_ENUM || storageClass == SpirvStoragePushConstant) {
+        ShaderReflectFail(state, "a descriptor has a type the reflection doesn't know");
+        return;
+    }
+
+    // Several variables can alias one binding, like blocks of different types in the same bindless array
+    for (uint32_t i = 0; i < reflection->BindingCount; i++) {
+        const ShaderBinding* binding = &reflection->Bindings[i];
+        if (binding->Set == id->Set && binding->Binding == id->Binding) {
+            if (binding->Type != descriptorType || binding->Count != count) {
+                ShaderReflectFail(state, "variables sharing a binding disagree on its type");
+            }
+            return;
+        }
+    }
+    if (reflection->BindingCount == ShaderReflectMaxBindings) {
+        ShaderReflectFail(state, "there are too many bindings");
+        return;
+    }
+    uint32_t i = reflection->BindingCount++;
+    // Kept sorted by set and binding
+    while (i > 0 && (reflection->Bindings[i - 1].Set > id->Set ||
+                     (reflection->Bindings[i - 1].Set == id->Set && reflection->Bindings[i - 1].Binding > id->Binding))) {
+        reflection->Bindings[i] = reflection->Bindings[i - 1];
+        i--;
+    }
+    reflection->Bindings[i] = (ShaderBinding){
+        .Set     = id->Set,
+        .Binding = id->Binding,
+        .Type    = descriptorType,
+        .Count   = count,
+    };
+}
+
+static void ShaderReflectSpecConstant(ShaderReflectState* state, const ShaderReflectId* id, const uint32_t* definition) {
+    ShaderReflection* reflection = state->Reflection;
+    uint32_t opcode              = definition[0] & 0xFFFF;
+    if (opcode == SpirvOpSpecConstant && (definition[0] >> 16) != 4) {
+        ShaderReflectFail(state, "only 32 bit specialization constants are supported");
+        return;
+    }
+    if (reflection->SpecConstantCount == ShaderReflectMaxSpecConstants) {
+        ShaderReflectFail(state, "there are too many specialization constants");
+        return;
+    }
+    uint32_t i = reflection->SpecConstantCount++;
+    while (i > 0 && reflection->SpecConstants[i - 1].Id > id->SpecId) {
+        reflection->SpecConstants[i] = reflection->SpecConstants[i - 1];
+        i--;
+    }
+    reflection->SpecConstants[i] = (ShaderSpecConstant){
+        .Id      = id->SpecId,
+        .Default = opcode == SpirvOpSpecConstant ? definition[3] : opcode == SpirvOpSpecConstantTrue,
+    };
+}
+
+// Records what every instruction defines or decorates, and checks that the stream ends exactly at the last word with
+// a whole function, which function definitions have to come last in any module
+static void ShaderReflectWalk(ShaderReflectState* state) {
+    ShaderReflection* reflection = state->Reflection;
+    uint32_t entryPointCount     = 0;
+    uint32_t openFunctions       = 0;
+    uint32_t lastOpcode          = 0;
+    for (uint32_t offset = 5; offset < state->WordCount;) {
+        const uint32_t* instruction = &state->Words[offset];
+        uint32_t opcode             = instruction[0] & 0xFFFF;
+        uint32_t wordCount          = instruction[0] >> 16;
+        if (wordCount == 0 || wordCount > state->WordCount - offset) {
+            ShaderReflectFail(state, "an instruction runs past the end of the module");
+            return;
+        }
+        offset += wordCount;
+        lastOpcode = opcode;
+
+        if (opcode == SpirvOpFunction) {
+            openFunctions++;
+        } else if (opcode == SpirvOpFunctionEnd && openFunctions-- == 0) {
+            ShaderReflectFail(state, "a function ends without having begun");
+            return;
+        } else if (opcode == SpirvOpEntryPoint) {
+            // Vertex, tessellation, geometry, fragment and compute map to the stage bits in order
+            if (wordCount < 4 || instruction[1] > SpirvExecutionModelGLCompute) {
+                ShaderReflectFail(state, "the entry point's execution model isn't supported");
+                return;
+            }
+            reflection->Stage = cast(VkShaderStageFlagBits)(1u << instruction[1]);
+            entryPointCount++;
+        } else if (opcode == SpirvOpExecutionMode && wordCount >= 6 && instruction[2] == SpirvExecutionModeLocalSize) {
+            reflection->LocalSize[0] = instruction[3];
+            reflection->LocalSize[1] = instruction[4];
+            reflection->LocalSize[2] = instruction[5];
+        } else if (opcode == SpirvOpDecorate && wordCount >= 3 && instruction[1] < state->Bound) {
+            ShaderReflectId* id = &state->Ids[instruction[1]];
+            uint32_t value      = wordCount >= 4 ? instruction[3] : 0;
+            switch (instruction[2]) {
+            case SpirvDecorationDescriptorSet:
+                id->HasSet = true;
+                id->Set    = value;
+                break;
+            case SpirvDecorationBinding:
+                id->HasBinding = true;
+                id->Binding    = value;
+                break;
+            case SpirvDecorationSpecId:
+                id->HasSpecId = true;
+                id->SpecId    = value;
+                break;
+            case SpirvDecorationBufferBlock:
+                id->BufferBlock = true;
+                break;
+            case SpirvDecorationArrayStride:
+                id->ArrayStride = value;
+                break;
+            }
+        } else if ((opcode >= SpirvOpTypeBool && opcode <= SpirvOpTypePointer) && wordCount >= 2 && instruction[1] < state->Bound) {
+            state->Ids[instruction[1]].Definition = instruction;
+        } else if ((opcode == SpirvOpConstant || opcode == SpirvOpSpecConstantTrue || opcode == SpirvOpSpecConstantFalse ||
+                    opcode == SpirvOpSpecConstant || opcode == SpirvOpVariable) &&
+                   wordCount >= 3 && instruction[2] < state->Bound) {
+            state->Ids[instruction[2]].Definition = instruction;
+        }
+    }
+    if (lastOpcode != SpirvOpFunctionEnd || openFunctions != 0) {
+        ShaderReflectFail(state, "the module ends in the middle of a function");
+    } else if (entryPointCount != 1) {
+        ShaderReflectFail(state, "there has to be exactly one entry point");
+    }
+}
+
+const char* ShaderReflect(const uint32_t* words, uint32_t wordCount, ShaderReflection* reflection) {
+    *reflection = (ShaderReflection){
+        .LocalSize = { 1, 1, 1 },
+    };
+    if (wordCount < 5 || words[0] != SpirvMagic) {
+        return "the file isn't SPIR-V";
+    }
+    ShaderReflectState state = {
+        .Words      = words,
+        .WordCount  = wordCount,
+        .Bound      = words[3],
+        .Reflection = reflection,
+    };
+    // Compilers keep ids dense, so a bound past the module's size only comes from a broken header
+    if (state.Bound > wordCount) {
+        return "the id bound is larger than the module";
+    }
+    state.Ids = calloc(state.Bound, sizeof(ShaderReflectId));
+    if (state.Ids == NULL) {
+        return "the id bound is too large";
+    }
+
+    ShaderReflectWalk(&state);
+    for (uint32_t i = 0; i < state.Bound && state.Error == NULL; i++) {
+        const ShaderReflectId* id   = &state.Ids[i];
+        const uint32_t* definition = id->Definition;
+        if (definition == NULL) {
+            continue;
+        }
+        uint32_t opcode = definition[0] & 0xFFFF;
+        if (opcode == SpirvOpVariable && (definition[0] >> 16) < 4) {
+            ShaderReflectFail(&state, "an instruction is missing operands");
+        } else if (opcode == SpirvOpVariable && definition[3] == SpirvStoragePushConstant) {
+            const uint32_t* pointer = ShaderReflectDefinition(&state, definition[1], 4);
+            if (pointer != NULL) {
+                reflection->PushConstantSize = ShaderReflectTypeSize(&state, pointer[3], 0, 0);
+            }
+        } else if (opcode == SpirvOpVariable && id->HasSet && id->HasBinding) {
+            ShaderReflectBinding(&state, i, definition);
+        } else if (id->HasSpecId &&
+                   (opcode == SpirvOpSpecConstantTrue || opcode == SpirvOpSpecConstantFalse || opcode == SpirvOpSpecConstant)) {
+            ShaderReflectSpecConstant(&state, id, definition);
+        }
+    }
+    free(state.Ids);
+    return state.Error;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Common.h"
+
+#define ShaderReflectMaxBindings      32
+#define ShaderReflectMaxSpecConstants 32
+
+typedef struct ShaderBinding {
+    uint32_t Set;
+    uint32_t Binding;
+    VkDescriptorType Type;
+    // 0 for runtime sized arrays, which the pipeline layout decides the size of
+    uint32_t Count;
+} ShaderBinding;
+
+typedef struct ShaderSpecConstant {
+    uint32_t Id;
+    // Bools are 0 or 1
+    uint32_t Default;
+} ShaderSpecConstant;
+
+// What a module declares that pipeline layouts, push constants and specialization depend on
+typedef struct ShaderReflection {
+    VkShaderStageFlagBits Stage;
+    uint32_t PushConstantSize;
+    // Before specialization
+    uint32_t LocalSize[3];
+    // Sorted by set and binding, variables aliasing a binding are listed once
+    uint32_t BindingCount;
+    ShaderBinding Bindings[ShaderReflectMaxBindings];
+    // Sorted by id
+    uint32_t SpecConstantCount;
+    ShaderSpecConstant SpecConstants[ShaderReflectMaxSpecConstants];
+} ShaderReflection;
+
+// Walks the whole instruction stream, which has to end exactly at wordCount with a whole function, and reflects the
+// module's single entry point. Shared by ShaderEmbed at build time and shader hot reload at runtime, so it never
+// exits and never reads past the words it was given. Returns NULL on success, otherwise why the module was rejected.
+// Passing this doesn't make the module valid SPIR-V, it only rules out truncated and mismatched files.
+const char* ShaderReflect(const uint32_t* words, uint32_t wordCount, ShaderReflection* reflection);
@@ -0,0 +1,506 @@
+#include "SpriteBatch.h"
+#include "DebugUtils.h"
+
+static_assert(sizeof(SpriteBatchInstance) == 32, "SpriteBatchInstance must match the vertex shader's std430 layout");
+static_assert(SpriteBatchBlendCount <= 4, "Sort keys hold the blend mode in two bits");
+
+typedef struct SpriteBatchPushConstants {
+    // Pixels to clip space
+    float Scale[2];
+    float Offset[2];
+    uint32_t InstanceBuffer;
+    uint32_t Sampler;
+} SpriteBatchPushConstants;
+
+// Builds the pipeline for the blend mode in variant, pipelines only differ in their blend state
+static VkResult SpriteBatchBuildPipeline(VkDevice device,
+                                         VkPipelineCache pipelineCache,
+                                         const VkShaderModule* modules,
+                                         uint32_t variant,
+                                         void* userData,
+                                         VkPipeline* pipeline) {
+    const SpriteBatch* batch = userData;
+    assert(variant < SpriteBatchBlendCount);
+    const VkColorComponentFlags ColorWriteMask =
+        VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    const VkPipelineColorBlendAttachmentState BlendStates[SpriteBatchBlendCount] = {
+        [SpriteBatchBlend_Opaque] =
+            {
+                .colorWriteMask = ColorWriteMask,
+            },
+        [SpriteBatchBlend_Alpha] =
+            {
+                .blendEnable         = VK_TRUE,
+                .srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
+                .dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+                .colorBlendOp        = VK_BLEND_OP_ADD,
+                .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+                .dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+                .alphaBlendOp        = VK_BLEND_OP_ADD,
+                .colorWriteMask      = ColorWriteMask,
+            },
+        [SpriteBatchBlend_Additive] =
+            {
+                .blendEnable         = VK_TRUE,
+                .srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
+                .dstColorBlendFactor = VK_BLEND_FACTOR_ONE,
+                .colorBlendOp        = VK_BLEND_OP_ADD,
+                .srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
+                .dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+                .alphaBlendOp        = VK_BLEND_OP_ADD,
+                .colorWriteMask      = ColorWriteMask,
+            },
+    };
+    const VkDynamicState DynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+    const VkPipelineRenderingCreateInfoKHR RenderingCreateInfo = {
+        .sType                   = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR,
+        .colorAttachmentCount    = 1,
+        .pColorAttachmentFormats = &batch->ColorFormat,
+    };
+    const VkPipelineShaderStageCreateInfo Stages[] = {
+        {
+            .sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage  = VK_SHADER_STAGE_VERTEX_BIT,
+            .module = modules[0],
+            .pName  = "main",
+        },
+        {
+            .sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage  = VK_SHADER_STAGE_FRAGMENT_BIT,
+            .module = modules[1],
+            .pName  = "main",
+        },
+    };
+    // Sprites and their corners both come out of the vertex index
+    const VkPipelineVertexInputStateCreateInfo VertexInputState = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+    };
+    const VkPipelineInputAssemblyStateCreateInfo InputAssemblyState = {
+        .sType    = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+        .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+    };
+    const VkPipelineViewportStateCreateInfo ViewportState = {
+        .sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+        .viewportCount = 1,
+        .scissorCount  = 1,
+    };
+    const VkPipelineRasterizationStateCreateInfo RasterizationState = {
+        .sType       = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+        .polygonMode = VK_POLYGON_MODE_FILL,
+        .cullMode    = VK_CULL_MODE_NONE,
+        .frontFace   = VK_FRONT_FACE_COUNTER_CLOCKWISE,
+        .lineWidth   = 1.0f,
+    };
+    const VkPipelineMultisampleStateCreateInfo MultisampleState = {
+        .sType                = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+    };
+    const VkPipelineDynamicStateCreateInfo DynamicState = {
+        .sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+        .dynamicStateCount = sizeof(DynamicStates) / sizeof(DynamicStates[0]),
+        .pDynamicStates    = DynamicStates,
+    };
+
+    const VkPipelineColorBlendStateCreateInfo ColorBlendState = {
+        .sType           = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+        .attachmentCount = 1,
+        .pAttachments    = &BlendStates[variant],
+    };
+
+    return vkCreateGraphicsPipelines(device,
+                                     pipelineCache,
+                                     1,
+                                     &(VkGraphicsPipelineCreateInfo){
+                                         .sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+                                         .pNext               = &RenderingCreateInfo,
+                                         .stageCount          = sizeof(Stages) / sizeof(Stages[0]),
+                                         .pStages             = Stages,
+                                         .pVertexInputState   = &VertexInputState,
+                                         .pInputAssemblyState = &InputAssemblyState,
+                                         .pViewportState      = &ViewportState,
+                                         .pRasterizationState = &RasterizationState,
+                                         .pMultisampleState   = &MultisampleState,
+                                         .pColorBlendState    = &ColorBlendState,
+                                         .pDynamicState       = &DynamicState,
+                                         .layout              = batch->Bindless->PipelineLayout,
+                                     },
+                                     batch->Allocator,
+                                     pipeline);
+}
+
+// A single white texel, so untextured sprites go through the same shader as textured ones
+static void SpriteBatchCreateWhiteTexture(SpriteBatch* batch, Uploader* uploader) {
+    VkResult imageCreateResult = DeviceAllocatorCreateImage(batch->DeviceAllocator,
+                                                            &(VkImageCreateInfo){
+                                                                .sType       = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+                                                                .imageType   = VK_IMAGE_TYPE_2D,
+                                                                .format      = VK_FORMAT_R8G8B8A8_UNORM,
+                                                                .extent      = { 1, 1, 1 },
+                                                                .mipLevels   = 1,
+                                                                .arrayLayers = 1,
+                                                                .samples     = VK_SAMPLE_COUNT_1_BIT,
+                                                                .tiling      = VK_IMAGE_TILING_OPTIMAL,
+                                                                .usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                                                                .sharingMode   = VK_SHARING_MODE_EXCLUSIVE,
+                                                                .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                                                            },
+                                                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                                            0,
+                                                            &batch->WhiteImage,
+                                                            &batch->WhiteAllocation);
+    if (imageCreateResult != VK_SUCCESS) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to create the white sprite texture! %x\n", imageCreateResult);
+        exit(1);
+    }
+    VkCheck(vkCreateImageView(batch->Device,
+                              &(VkImageViewCreateInfo){
+                                  .sType    = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+                                  .image    = batch->WhiteImage,
+                                  .viewType = VK_IMAGE_VIEW_TYPE_2D,
+                                  .format   = VK_FORMAT_R8G8B8A8_UNORM,
+                                  .subresourceRange =
+                                      (VkImageSubresourceRange){
+                                          .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                          .levelCount = 1,
+                                          .layerCount = 1,
+                                      },
+                              },
+                              batch->Allocator,
+                              &batch->WhiteView));
+    DebugUtilsSetObjectName(batch->Device, VK_OBJECT_TYPE_IMAGE, cast(uint64_t) batch->WhiteImage, "Sprite white texture");
+
+    const uint32_t White = 0xFFFFFFFF;
+    UploaderUploadImage(uploader,
+                        batch->WhiteImage,
+                        0,
+                        0,
+                        (VkExtent3D){ 1, 1, 1 },
+                        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                        &White,
+                        sizeof(White));
+    UploaderFlush(uploader);
+    // Acquires only pick up finished uploads, so without the wait the first frames would sample an undefined image
+    TimelineWait(uploader->Timeline, uploader->Timeline->LastSubmittedValue);
+    batch->WhiteTexture = BindlessAddSampledImage(batch->Bindless, batch->WhiteView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+}
+
+SpriteBatch* SpriteBatchCreate(VkDevice device,
+                               PipelineManager* pipelineManager,
+                               DeviceAllocator* deviceAllocator,
+                               Uploader* uploader,
+                               Bindless* bindless,
+                               Profiler* profiler,
+                               VkFormat colorFormat,
+                               uint32_t capacity,
+                               uint32_t framesInFlight,
+                               const VkAllocationCallbacks* allocator) {
+    SpriteBatch* batch = calloc(1, sizeof(SpriteBatch));
+    if (batch == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate the sprite batch!\n");
+        exit(1);
+    }
+    batch->Device            = device;
+    batch->Allocator         = allocator;
+    batch->DeviceAllocator   = deviceAllocator;
+    batch->PipelineManager   = pipelineManager;
+    batch->Bindless          = bindless;
+    batch->Profiler          = profiler;
+    batch->Phase             = ProfilerRegisterGpuPass(profiler, "Sprites");
+    batch->CmdBeginRendering = cast(PFN_vkCmdBeginRenderingKHR) vkGetDeviceProcAddr(device, "vkCmdBeginRenderingKHR");
+    batch->CmdEndRendering   = cast(PFN_vkCmdEndRenderingKHR) vkGetDeviceProcAddr(device, "vkCmdEndRenderingKHR");
+    batch->Capacity          = capacity;
+    batch->FramesInFlight    = framesInFlight;
+    batch->ColorFormat       = colorFormat;
+    assert(batch->CmdBeginRendering && batch->CmdEndRendering);
+    // gl_VertexIndex is signed
+    assert(cast(uint64_t) capacity * framesInFlight * SpriteBatchVerticesPerSprite <= INT32_MAX);
+
+    batch->Staging = malloc(cast(size_t) capacity * sizeof(SpriteBatchInstance));
+    if (batch->Staging == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate the sprite staging memory!\n");
+        exit(1);
+    }
+
+    const ShaderId PipelineShaders[] = { ShaderId_SpriteVert, ShaderId_SpriteFrag };
+    assert(BindlessSupportsShader(bindless, ShaderId_SpriteVert) && BindlessSupportsShader(bindless, ShaderId_SpriteFrag));
+    assert(Shaders[ShaderId_SpriteVert].PushConstantSize == sizeof(SpriteBatchPushConstants));
+    for (uint32_t i = 0; i < SpriteBatchBlendCount; i++) {
+        batch->Pipelines[i] = PipelineManagerAddGraphics(pipelineManager, "Sprite", PipelineShaders, 2, SpriteBatchBuildPipeline, i, batch);
+    }
+
+    VkCheck(vkCreateSampler(device,
+                            &(VkSamplerCreateInfo){
+                                .sType        = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+                                .magFilter    = VK_FILTER_LINEAR,
+                                .minFilter    = VK_FILTER_LINEAR,
+                                .mipmapMode   = VK_SAMPLER_MIPMAP_MODE_LINEAR,
+                                .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                                .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                                .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                                .maxLod       = VK_LOD_CLAMP_NONE,
+                            },
+                            allocator,
+                            &batch->Sampler));
+    batch->SamplerIndex = BindlessAddSampler(bindless, batch->Sampler);
+    SpriteBatchCreateWhiteTexture(batch, uploader);
+
+    // Written straight from the CPU every frame, so device local memory the host can see is the best fit
+    VkResult bufferCreateResult =
+        DeviceAllocatorCreateBuffer(deviceAllocator,
+                                    &(VkBufferCreateInfo){
+                                        .sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+                                        .size        = cast(VkDeviceSize) capacity * framesInFlight * sizeof(SpriteBatchInstance),
+                                        .usage       = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                                    },
+                                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+                                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                    &batch->InstanceBuffer,
+                                    &batch->InstanceAllocation);
+    if (bufferCreateResult != VK_SUCCESS) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to create the sprite instance buffer! %x\n", bufferCreateResult);
+        exit(1);
+    }
+    batch->InstanceIndex = BindlessAddStorageBuffer(bindless,
+                                                    &(VkDescriptorBufferInfo){
+                                                        .buffer = batch->InstanceBuffer,
+                                                        .range  = VK_WHOLE_SIZE,
+                                                    });
+    DebugUtilsSetObjectName(device, VK_OBJECT_TYPE_BUFFER, cast(uint64_t) batch->InstanceBuffer, "Sprite instances");
+    return batch;
+}
+
+void SpriteBatchDestroy(SpriteBatch* batch) {
+    BindlessRemove(batch->Bindless, BindlessType_StorageBuffer, batch->InstanceIndex);
+    BindlessRemove(batch->Bindless, BindlessType_SampledImage, batch->WhiteTexture);
+    BindlessRemove(batch->Bindless, BindlessType_Sampler, batch->SamplerIndex);
+    vkDestroyBuffer(batch->Device, batch->InstanceBuffer, batch->Allocator);
+    DeviceAllocatorFree(batch->DeviceAllocator, batch->InstanceAllocation);
+    vkDestroyImageView(batch->Device, batch->WhiteView, batch->Allocator);
+    vkDestroyImage(batch->Device, batch->WhiteImage, batch->Allocator);
+    DeviceAllocatorFree(batch->DeviceAllocator, batch->WhiteAllocation);
+    vkDestroySampler(batch->Device, batch->Sampler, batch->Allocator);
+    for (uint32_t i = 0; i < SpriteBatchBlendCount; i++) {
+        PipelineManagerRemove(batch->PipelineManager, batch->Pipelines[i]);
+    }
+    free(batch->Staging);
+    free(batch);
+}
+
+void SpriteBatchBegin(SpriteBatch* batch, uint32_t frameSlot) {
+    VkDeviceSize regionOffset = cast(VkDeviceSize) frameSlot * batch->Capacity * sizeof(SpriteBatchInstance);
+    batch->CurrentSlot    = frameSlot;
+    batch->SlotInstances  = cast(SpriteBatchInstance*)(cast(uint8_t*) batch->InstanceAllocation->Mapped + regionOffset);
+    batch->DirectCount    = 0;
+    batch->DirectRunCount = 0;
+    batch->SpriteCount    = 0;
+    batch->RunCount       = 0;
+    batch->DrawCount      = 0;
+}
+
+void SpriteBatchAdd(SpriteBatch* batch, uint32_t layer, SpriteBatchBlend blend, const SpriteBatchInstance* sprites, uint32_t count) {
+    if (count > batch->Capacity - batch->SpriteCount) {
+        batch->Stats.DroppedSprites += count - (batch->Capacity - batch->SpriteCount);
+        count = batch->Capacity - batch->SpriteCount;
+    }
+    if (count == 0) {
+        return;
+    }
+
+    uint32_t key         = layer << 2 | cast(uint32_t) blend;
+    SpriteBatchRun* last = batch->RunCount > 0 ? &batch->Runs[batch->RunCount - 1] : NULL;
+    // Written straight into the slot until the first run that would have to be sorted before an earlier one
+    bool direct = batch->DirectCount == batch->SpriteCount && (last == NULL || last->Key <= key);
+    if (last && last->Key == key) {
+        last->Count += count;
+    } else if (batch->RunCount < SpriteBatchMaxRuns) {
+        batch->Runs[batch->RunCount++] = (SpriteBatchRun){
+            .Key   = key,
+            .First = batch->SpriteCount,
+            .Count = count,
+        };
+    } else {
+        batch->Stats.DroppedSprites += count;
+        return;
+    }
+    if (direct) {
+        memcpy(&batch->SlotInstances[batch->SpriteCount], sprites, count * sizeof(SpriteBatchInstance));
+        batch->DirectCount += count;
+        batch->DirectRunCount = batch->RunCount;
+    } else {
+        memcpy(&batch->Staging[batch->SpriteCount - batch->DirectCount], sprites, count * sizeof(SpriteBatchInstance));
+    }
+    batch->SpriteCount += count;
+}
+
+// Runs are added in order, so ordering by First as well keeps the sort stable
+static int SpriteBatchCompareRuns(const void* a, const void* b) {
+    const SpriteBatchRun* runA = a;
+    const SpriteBatchRun* runB = b;
+    if (runA->Key != runB->Key) {
+        return runA->Key < runB->Key ? -1 : 1;
+    }
+    return runA->First < runB->First ? -1 : runA->First > runB->First ? 1 : 0;
+}
+
+static void SpriteBatchRecordPass(VkCommandBuffer commandBuffer, RenderGraph* graph, void* userData) {
+    SpriteBatch* batch = userData;
+    if (batch->DrawCount == 0) {
+        return;
+    }
+    SpriteBatchPushConstants pushConstants = {
+        .Scale          = { 2.0f / cast(float) batch->Extent.width, 2.0f / cast(float) batch->Extent.height },
+        .Offset         = { -1.0f, -1.0f },
+        .InstanceBuffer = batch->InstanceIndex,
+        .Sampler        = batch->SamplerIndex,
+    };
+
+    ProfilerBeginGpuPass(batch->Profiler, commandBuffer, batch->Phase);
+    batch->CmdBeginRendering(commandBuffer,
+                             &(VkRenderingInfoKHR){
+                                 .sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR,
+                                 .renderArea =
+                                     (VkRect2D){
+                                         .extent = batch->Extent,
+                                     },
+                                 .layerCount           = 1,
+                                 .colorAttachmentCount = 1,
+                                 .pColorAttachments =
+                                     &(VkRenderingAttachmentInfoKHR){
+                                         .sType       = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR,
+                                         .imageView   = RenderGraphGetImageView(graph, batch->Target),
+                                         .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                                         .loadOp      = VK_ATTACHMENT_LOAD_OP_LOAD,
+                                         .storeOp     = VK_ATTACHMENT_STORE_OP_STORE,
+                                     },
+                             });
+    BindlessBind(batch->Bindless, commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS);
+    BindlessPushConstants(batch->Bindless, commandBuffer, &pushConstants, sizeof(pushConstants));
+    vkCmdSetViewport(commandBuffer,
+                     0,
+                     1,
+                     &(VkViewport){
+                         .width    = cast(float) batch->Extent.width,
+                         .height   = cast(float) batch->Extent.height,
+                         .maxDepth = 1.0f,
+                     });
+    vkCmdSetScissor(commandBuffer,
+                    0,
+                    1,
+                    &(VkRect2D){
+                        .extent = batch->Extent,
+                    });
+    // Consecutive draws only share a blend mode where written and staged sprites meet
+    uint32_t slotFirst = batch->CurrentSlot * batch->Capacity;
+    for (uint32_t i = 0; i < batch->DrawCount; i++) {
+        const SpriteBatchDraw* draw = &batch->Draws[i];
+        if (i == 0 || batch->Draws[i - 1].Blend != draw->Blend) {
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, batch->FramePipelines[draw->Blend]);
+        }
+        vkCmdDraw(commandBuffer,
+                  draw->SpriteCount * SpriteBatchVerticesPerSprite,
+                  1,
+                  (slotFirst + draw->FirstSprite) * SpriteBatchVerticesPerSprite,
+                  0);
+    }
+    batch->CmdEndRendering(commandBuffer);
+    ProfilerEndGpuPass(batch->Profiler, commandBuffer, batch->Phase);
+}
+
+void SpriteBatchAddPass(SpriteBatch* batch, RenderGraph* graph, RenderGraphResource target, VkExtent2D extent) {
+    batch->Extent = extent;
+    batch->Target = target;
+    for (uint32_t i = 0; i < SpriteBatchBlendCount; i++) {
+        batch->FramePipelines[i] = PipelineManagerGet(batch->PipelineManager, batch->Pipelines[i]);
+    }
+
+    // Staged runs are usually in order among themselves, which is all the sort has to check then
+    SpriteBatchRun* staged  = &batch->Runs[batch->DirectRunCount];
+    uint32_t stagedRunCount = batch->RunCount - batch->DirectRunCount;
+    bool sorted             = true;
+    for (uint32_t i = 1; i < stagedRunCount && sorted; i++) {
+        sorted = staged[i - 1].Key <= staged[i].Key;
+    }
+    if (!sorted) {
+        qsort(staged, stagedRunCount, sizeof(SpriteBatchRun), SpriteBatchCompareRuns);
+    }
+
+    // Staged sprites go in sorted behind the ones already written. The mapped memory may be write combined, so it's
+    // only ever written front to back. Sprites whose pipeline is still being built are left out until it's ready.
+    uint32_t written = batch->DirectCount;
+    for (uint32_t i = 0; i < stagedRunCount; i++) {
+        SpriteBatchRun* run = &staged[i];
+        if (batch->FramePipelines[run->Key & 3] == VK_NULL_HANDLE) {
+            continue;
+        }
+        memcpy(&batch->SlotInstances[written],
+               &batch->Staging[run->First - batch->DirectCount],
+               run->Count * sizeof(SpriteBatchInstance));
+        run->First = written;
+        written += run->Count;
+    }
+    if (written > 0) {
+        VkCheck(DeviceAllocatorFlush(batch->DeviceAllocator,
+                                     batch->InstanceAllocation,
+                                     cast(VkDeviceSize) batch->CurrentSlot * batch->Capacity * sizeof(SpriteBatchInstance),
+                                     cast(VkDeviceSize) written * sizeof(SpriteBatchInstance)));
+    }
+
+    // Both lists of runs are sorted, so merging them gives the draw order. Runs with the same blend mode that are
+    // next to each other in both the draw order and the buffer form a single draw, on ties written runs go first
+    // because they were added first.
+    uint32_t drawn = 0;
+    for (uint32_t directIndex = 0, stagedIndex = 0; directIndex < batch->DirectRunCount || stagedIndex < stagedRunCount;) {
+        const SpriteBatchRun* run;
+        if (stagedIndex == stagedRunCount ||
+            (directIndex < batch->DirectRunCount && batch->Runs[directIndex].Key <= staged[stagedIndex].Key)) {
+            run = &batch->Runs[directIndex++];
+        } else {
+            run = &staged[stagedIndex++];
+        }
+        SpriteBatchBlend blend = cast(SpriteBatchBlend)(run->Key & 3);
+        if (batch->FramePipelines[blend] == VK_NULL_HANDLE) {
+            batch->Stats.UnbuiltSprites += run->Count;
+            continue;
+        }
+        SpriteBatchDraw* last = batch->DrawCount > 0 ? &batch->Draws[batch->DrawCount - 1] : NULL;
+        if (last && last->Blend == blend && last->FirstSprite + last->SpriteCount == run->First) {
+            last->SpriteCount += run->Count;
+        } else {
+            batch->Draws[batch->DrawCount++] = (SpriteBatchDraw){
+                .Blend       = blend,
+                .FirstSprite = run->First,
+                .SpriteCount = run->Count,
+            };
+        }
+        drawn += run->Count;
+    }
+
+    batch->Stats.Frames++;
+    batch->Stats.Sprites += drawn;
+    batch->Stats.Draws += batch->DrawCount;
+    if (drawn > batch->Stats.PeakSprites) {
+        batch->Stats.PeakSprites = drawn;
+    }
+
+    RenderGraphUse(graph, RenderGraphAddPass(graph, "Sprites", SpriteBatchRecordPass, batch), target, RenderGraphUsage_ColorAttachment);
+}
+
+void SpriteBatchPrintStats(const SpriteBatch* batch) {
+    if (batch->Stats.Frames == 0) {
+        return;
+    }
+    printf("Drew %.1f sprites in %.2f draws per frame on average, %u at most, dropped %llu!\n",
+           cast(double) batch->Stats.Sprites / cast(double) batch->Stats.Frames,
+           cast(double) batch->Stats.Draws / cast(double) batch->Stats.Frames,
+           batch->Stats.PeakSprites,
+           cast(unsigned long long) batch->Stats.DroppedSprites);
+    if (batch->Stats.UnbuiltSprites > 0) {
+        printf("Skipped %llu sprites while their pipelines were building!\n", cast(unsigned long long) batch->Stats.UnbuiltSprites);
+    }
+}
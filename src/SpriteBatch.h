@@ -0,0 +1,149 @@
+#pragma once
+
+#include "Common.h"
+#include "Bindless.h"
+#include "DeviceAllocator.h"
+#include "PipelineManager.h"
+#include "Profiler.h"
+#include "RenderGraph.h"
+#include "Uploader.h"
+
+// Separate SpriteBatchAdd calls with the same layer and blend mode are merged, so this only limits how often
+// the two can change within a frame
+#define SpriteBatchMaxRuns 4096
+// Two triangles, without an index buffer
+#define SpriteBatchVerticesPerSprite 6
+
+typedef enum SpriteBatchBlend {
+    SpriteBatchBlend_Opaque,
+    SpriteBatchBlend_Alpha,
+    SpriteBatchBlend_Additive,
+    SpriteBatchBlendCount,
+} SpriteBatchBlend;
+
+// Matches the std430 layout the vertex shader reads, 32 bytes so sprites never straddle a 16 byte boundary
+typedef struct SpriteBatchInstance {
+    // Top left corner and size in pixels
+    float Rect[4];
+    // Texture coordinates of the top left and bottom right corners, see SpriteBatchPackUv
+    uint32_t Uv0;
+    uint32_t Uv1;
+    // Multiplies the texture, see SpriteBatchPackColor
+    uint32_t Color;
+    // Bindless sampled image index, SpriteBatch->WhiteTexture for untextured sprites
+    uint32_t Texture;
+} SpriteBatchInstance;
+
+// Sprites added in one go with the same sort key, which is the layer and blend mode
+typedef struct SpriteBatchRun {
+    uint32_t Key;
+    // Where the run starts in the frame slot's region. Staged runs start at First - DirectCount in Staging until
+    // SpriteBatchAddPass writes them out.
+    uint32_t First;
+    uint32_t Count;
+} SpriteBatchRun;
+
+typedef struct SpriteBatchDraw {
+    SpriteBatchBlend Blend;
+    uint32_t FirstSprite;
+    uint32_t SpriteCount;
+} SpriteBatchDraw;
+
+typedef struct SpriteBatchStats {
+    uint64_t Frames;
+    uint64_t Sprites;
+    uint64_t Draws;
+    uint64_t DroppedSprites;
+    // Left out because their blend mode's pipeline wasn't built yet
+    uint64_t UnbuiltSprites;
+    uint32_t PeakSprites;
+} SpriteBatchStats;
+
+// Draws quads for text, UI and overlays with one draw per blend mode change. Sprites added in layer and blend mode
+// order are written straight into the frame slot's part of a persistently mapped instance buffer. Once a call goes
+// back to an earlier layer or blend mode, it and everything after it is collected on the CPU instead, then stably
+// sorted and copied in behind the sprites already written, so every sprite is copied once in the common case and a
+// sorted draw can at worst split in two where the written and collected sprites meet. The vertex shader pulls
+// instances from the buffer through the bindless set with six vertices per sprite. That keeps a
+// whole batch in a single non-instanced draw, rather than one tiny four vertex instance per sprite which packs badly
+// into shader waves. Textures come from the bindless set as well, so they don't split draws and only need to be
+// sorted for cache locality, which is left to the caller. Renders into the target with dynamic rendering on top of
+// what's already there. Only to be used from one thread.
+typedef struct SpriteBatch {
+    VkDevice Device;
+    const VkAllocationCallbacks* Allocator;
+    DeviceAllocator* DeviceAllocator;
+    PipelineManager* PipelineManager;
+    Bindless* Bindless;
+    Profiler* Profiler;
+    uint32_t Phase;
+    PFN_vkCmdBeginRenderingKHR CmdBeginRendering;
+    PFN_vkCmdEndRenderingKHR CmdEndRendering;
+    VkFormat ColorFormat;
+    // Pipeline manager indices, and what the frame's pass was added with
+    uint32_t Pipelines[SpriteBatchBlendCount];
+    VkPipeline FramePipelines[SpriteBatchBlendCount];
+
+    VkSampler Sampler;
+    uint32_t SamplerIndex;
+    VkImage WhiteImage;
+    VkImageView WhiteView;
+    DeviceAllocation* WhiteAllocation;
+    uint32_t WhiteTexture;
+
+    // FramesInFlight regions of Capacity sprites, each frame slot writes only its own
+    VkBuffer InstanceBuffer;
+    DeviceAllocation* InstanceAllocation;
+    uint32_t InstanceIndex;
+    uint32_t Capacity;
+    uint32_t FramesInFlight;
+    uint32_t CurrentSlot;
+
+    // The frame slot's region of the instance buffer
+    SpriteBatchInstance* SlotInstances;
+    // Sprites and runs written straight into SlotInstances, up to the first run added out of order
+    uint32_t DirectCount;
+    uint32_t DirectRunCount;
+    // The sprites from the first run added out of order on, in the order they were added
+    SpriteBatchInstance* Staging;
+    uint32_t SpriteCount;
+    uint32_t RunCount;
+    SpriteBatchRun Runs[SpriteBatchMaxRuns];
+    uint32_t DrawCount;
+    SpriteBatchDraw Draws[SpriteBatchMaxRuns];
+    VkExtent2D Extent;
+    RenderGraphResource Target;
+    SpriteBatchStats Stats;
+} SpriteBatch;
+
+// Needs VK_KHR_dynamic_rendering, capacity is the most sprites a single frame can draw
+SpriteBatch* SpriteBatchCreate(VkDevice device,
+                               PipelineManager* pipelineManager,
+                               DeviceAllocator* deviceAllocator,
+                               Uploader* uploader,
+                               Bindless* bindless,
+                               Profiler* profiler,
+                               VkFormat colorFormat,
+                               uint32_t capacity,
+                               uint32_t framesInFlight,
+                               const VkAllocationCallbacks* allocator);
+// The device must be idle
+void SpriteBatchDestroy(SpriteBatch* batch);
+
+// Must be called after the frame slot's GPU work has finished
+void SpriteBatchBegin(SpriteBatch* batch, uint32_t frameSlot);
+// Lower layers are drawn first, within a layer opaque sprites come before alpha blended and additive ones, and
+// otherwise sprites are drawn in the order they were added. Sprites past the capacity are dropped.
+void SpriteBatchAdd(SpriteBatch* batch, uint32_t layer, SpriteBatchBlend blend, const SpriteBatchInstance* sprites, uint32_t count);
+// Sorts and writes out the frame's staged sprites and adds the pass that draws them into target
+void SpriteBatchAddPass(SpriteBatch* batch, RenderGraph* graph, RenderGraphResource target, VkExtent2D extent);
+
+void SpriteBatchPrintStats(const SpriteBatch* batch);
+
+static inline uint32_t SpriteBatchPackUv(float u, float v) {
+    return cast(uint32_t)(u * 65535.0f + 0.5f) | cast(uint32_t)(v * 65535.0f + 0.5f) << 16;
+}
+
+static inline uint32_t SpriteBatchPackColor(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+    return cast(uint32_t) r | cast(uint32_t) g << 8 | cast(uint32_t) b << 16 | cast(uint32_t) a << 24;
+}
@@ -0,0 +1,268 @@
+#include "Swapchain.h"
+#include "DebugUtils.h"
+
+static void SwapchainDestroyGeneration(Swapchain* swapchain, SwapchainGeneration* generation) {
+    for (uint32_t i = 0; i < generation->ImageCount; i++) {
+        vkDestroySemaphore(swapchain->Device, generation->RenderFinished[i], swapchain->Allocator);
+        vkDestroyImageView(swapchain->Device, generation->Views[i], swapchain->Allocator);
+    }
+    vkDestroySwapchainKHR(swapchain->Device, generation->Handle, swapchain->Allocator);
+    *generation = (SwapchainGeneration){};
+}
+
+// Returns false if the surface currently has no area
+static bool SwapchainRecreate(Swapchain* swapchain) {
+    VkSurfaceCapabilitiesKHR surfaceCapabilities = {};
+    VkCheck(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(swapchain->PhysicalDevice, swapchain->Surface, &surfaceCapabilities));
+
+    VkExtent2D extent = surfaceCapabilities.currentExtent;
+    if (extent.width == ~0u || extent.height == ~0u) {
+        extent = swapchain->WindowExtent;
+        if (extent.width > surfaceCapabilities.maxImageExtent.width) {
+            extent.width = surfaceCapabilities.maxImageExtent.width;
+        } else if (extent.width < surfaceCapabilities.minImageExtent.width) {
+            extent.width = surfaceCapabilities.minImageExtent.width;
+        }
+        if (extent.height > surfaceCapabilities.maxImageExtent.height) {
+            extent.height = surfaceCapabilities.maxImageExtent.height;
+        } else if (extent.height < surfaceCapabilities.minImageExtent.height) {
+            extent.height = surfaceCapabilities.minImageExtent.height;
+        }
+    }
+    if (extent.width == 0 || extent.height == 0) {
+        return false;
+    }
+
+    bool sharedFamily              = swapchain->QueueFamilyIndices[0] == swapchain->QueueFamilyIndices[1];
+    VkSwapchainKHR handle          = VK_NULL_HANDLE;
+    VkResult swapchainCreateResult = vkCreateSwapchainKHR(
+        swapchain->Device,
+        &(VkSwapchainCreateInfoKHR){
+            .sType                 = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
+            .surface               = swapchain->Surface,
+            .minImageCount         = swapchain->Present->ImageCount,
+            .imageFormat           = swapchain->Format.format,
+            .imageColorSpace       = swapchain->Format.colorSpace,
+            .imageExtent           = extent,
+            .imageArrayLayers      = 1,
+            .imageUsage            = swapchain->ImageUsage,
+            .imageSharingMode      = sharedFamily ? VK_SHARING_MODE_EXCLUSIVE : VK_SHARING_MODE_CONCURRENT,
+            .queueFamilyIndexCount = sharedFamily ? 1 : 2,
+            .pQueueFamilyIndices   = swapchain->QueueFamilyIndices,
+            .preTransform          = surfaceCapabilities.currentTransform,
+            .compositeAlpha        = (surfaceCapabilities.supportedCompositeAlpha & VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR)
+                                         ? VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR
+                                     : (surfaceCapabilities.supportedCompositeAlpha & VK_COMPOSITE_ALPHA_PRE_MULTIPLIED_BIT_KHR)
+                                         ? VK_COMPOSITE_ALPHA_PRE_MULTIPLIED_BIT_KHR
+                                     : (surfaceCapabilities.supportedCompositeAlpha & VK_COMPOSITE_ALPHA_POST_MULTIPLIED_BIT_KHR)
+                                         ? VK_COMPOSITE_ALPHA_POST_MULTIPLIED_BIT_KHR
+                                         : VK_COMPOSITE_ALPHA_INHERIT_BIT_KHR,
+            .presentMode           = swapchain->Present->Mode,
+            .clipped               = VK_TRUE,
+            .oldSwapchain          = swapchain->Current.Handle,
+        },
+        swapchain->Allocator,
+        &handle);
+    if (swapchainCreateResult != VK_SUCCESS || handle == VK_NULL_HANDLE) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to create swapchain! %x\n", swapchainCreateResult);
+        exit(1);
+    }
+
+    // The old swapchain is retired by passing it as oldSwapchain, its images stay valid until it's destroyed
+    if (swapchain->Current.Handle != VK_NULL_HANDLE) {
+        if (swapchain->RetiredCount == SwapchainMaxRetired) {
+            TimelineWait(swapchain->Timeline, swapchain->Retired[0].RetireValue);
+            SwapchainBeginFrame(swapchain);
+        }
+        swapchain->Current.RetireValue                = swapchain->Timeline->LastSubmittedValue;
+        swapchain->Retired[swapchain->RetiredCount++] = swapchain->Current;
+        swapchain->RecreateCount++;
+        PresentSwapchainChanged(swapchain->Present);
+    }
+
+    SwapchainGeneration* generation = &swapchain->Current;
+    *generation                     = (SwapchainGeneration){
+        .Handle = handle,
+        .Extent = extent,
+    };
+    VkCheck(vkGetSwapchainImagesKHR(swapchain->Device, handle, &generation->ImageCount, NULL));
+    if (generation->ImageCount > SwapchainMaxImages) {
+        fflush(stdout);
+        fprintf(stderr, "The swapchain has %d images, more than the %d supported!\n", generation->ImageCount, SwapchainMaxImages);
+        exit(1);
+    }
+    VkCheck(vkGetSwapchainImagesKHR(swapchain->Device, handle, &generation->ImageCount, generation->Images));
+
+    for (uint32_t i = 0; i < generation->ImageCount; i++) {
+        VkResult imageViewCreateResult = vkCreateImageView(swapchain->Device,
+                                                           &(VkImageViewCreateInfo){
+                                                               .sType    = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+                                                               .image    = generation->Images[i],
+                                                               .viewType = VK_IMAGE_VIEW_TYPE_2D,
+                                                               .format   = swapchain->Format.format,
+                                                               .subresourceRange =
+                                                                   (VkImageSubresourceRange){
+                                                                       .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                                                       .levelCount = 1,
+                                                                       .layerCount = 1,
+                                                                   },
+                                                           },
+                                                           swapchain->Allocator,
+                                                           &generation->Views[i]);
+        if (imageViewCreateResult != VK_SUCCESS || generation->Views[i] == VK_NULL_HANDLE) {
+            fflush(stdout);
+            fprintf(stderr, "Failed to create swapchain image view %d! %x\n", i, imageViewCreateResult);
+            exit(1);
+        }
+
+        VkResult semaphoreCreateResult = vkCreateSemaphore(swapchain->Device,
+                                                           &(VkSemaphoreCreateInfo){
+                                                               .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+                                                           },
+                                                           swapchain->Allocator,
+                                                           &generation->RenderFinished[i]);
+        if (semaphoreCreateResult != VK_SUCCESS || generation->RenderFinished[i] == VK_NULL_HANDLE) {
+            fflush(stdout);
+            fprintf(stderr, "Failed to create render finished semaphore %d! %x\n", i, semaphoreCreateResult);
+            exit(1);
+        }
+
+        DebugUtilsSetObjectName(swapchain->Device, VK_OBJECT_TYPE_IMAGE, cast(uint64_t) generation->Images[i], "Swapchain %u", i);
+        DebugUtilsSetObjectName(swapchain->Device, VK_OBJECT_TYPE_IMAGE_VIEW, cast(uint64_t) generation->Views[i], "Swapchain %u", i);
+        DebugUtilsSetObjectName(
+            swapchain->Device, VK_OBJECT_TYPE_SEMAPHORE, cast(uint64_t) generation->RenderFinished[i], "Swapchain %u render finished", i);
+    }
+
+    swapchain->NeedsRecreate = false;
+    return true;
+}
+
+Swapchain* SwapchainCreate(VkDevice device,
+                           VkPhysicalDevice physicalDevice,
+                           VkSurfaceKHR surface,
+                           uint32_t graphicsQueueFamilyIndex,
+                           uint32_t presentQueueFamilyIndex,
+                           Present* present,
+                           Timeline* graphicsTimeline,
+                           VkExtent2D windowExtent,
+                           bool transferSource,
+                           const VkAllocationCallbacks* allocator) {
+    Swapchain* swapchain = calloc(1, sizeof(Swapchain));
+    if (swapchain == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate the swapchain!\n");
+        exit(1);
+    }
+    swapchain->Device                = device;
+    swapchain->PhysicalDevice        = physicalDevice;
+    swapchain->Surface               = surface;
+    swapchain->Allocator             = allocator;
+    swapchain->Present               = present;
+    swapchain->Timeline              = graphicsTimeline;
+    swapchain->QueueFamilyIndices[0] = graphicsQueueFamilyIndex;
+    swapchain->QueueFamilyIndices[1] = presentQueueFamilyIndex;
+    swapchain->WindowExtent          = windowExtent;
+    swapchain->ImageUsage            = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    if (transferSource) {
+        VkSurfaceCapabilitiesKHR surfaceCapabilities = {};
+        VkCheck(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &surfaceCapabilities));
+        if (!(surfaceCapabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT)) {
+            fflush(stdout);
+            fprintf(stderr, "The surface doesn't allow copying out of swapchain images!\n");
+            exit(1);
+        }
+        swapchain->ImageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    }
+
+    uint32_t surfaceFormatCount = 0;
+    VkCheck(vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &surfaceFormatCount, NULL));
+    VkSurfaceFormatKHR surfaceFormats[surfaceFormatCount];
+    VkCheck(vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &surfaceFormatCount, surfaceFormats));
+
+    assert(surfaceFormatCount > 0);
+    swapchain->Format = surfaceFormats[0];
+    if (surfaceFormatCount == 1 && surfaceFormats[0].format == VK_FORMAT_UNDEFINED) {
+        swapchain->Format.format     = VK_FORMAT_R8G8B8A8_UNORM;
+        swapchain->Format.colorSpace = surfaceFormats[0].colorSpace;
+    } else {
+        for (uint32_t i = 0; i < surfaceFormatCount; i++) {
+            if ((surfaceFormats[i].format == VK_FORMAT_B8G8R8A8_SRGB || surfaceFormats[i].format == VK_FORMAT_R8G8B8A8_UNORM) &&
+                surfaceFormats[i].colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
+                swapchain->Format = surfaceFormats[i];
+                break;
+            }
+        }
+    }
+
+    // A window that starts minimized gets its swapchain at the first acquire
+    swapchain->NeedsRecreate = !SwapchainRecreate(swapchain);
+    return swapchain;
+}
+
+void SwapchainDestroy(Swapchain* swapchain) {
+    for (uint32_t i = 0; i < swapchain->RetiredCount; i++) {
+        SwapchainDestroyGeneration(swapchain, &swapchain->Retired[i]);
+    }
+    if (swapchain->Current.Handle != VK_NULL_HANDLE) {
+        SwapchainDestroyGeneration(swapchain, &swapchain->Current);
+    }
+    free(swapchain);
+}
+
+void SwapchainBeginFrame(Swapchain* swapchain) {
+    if (swapchain->RetiredCount == 0) {
+        return;
+    }
+    // There's no way to know when presentation is done with an image before VK_EXT_swapchain_maintenance1, the
+    // frame that rendered to it having finished is what every engine goes by
+    uint64_t completedValue = TimelineGetCompletedValue(swapchain->Timeline);
+    uint32_t kept           = 0;
+    for (uint32_t i = 0; i < swapchain->RetiredCount; i++) {
+        if (swapchain->Retired[i].RetireValue <= completedValue) {
+            SwapchainDestroyGeneration(swapchain, &swapchain->Retired[i]);
+        } else {
+            swapchain->Retired[kept++] = swapchain->Retired[i];
+        }
+    }
+    swapchain->RetiredCount = kept;
+}
+
+void SwapchainResize(Swapchain* swapchain, VkExtent2D windowExtent) {
+    swapchain->WindowExtent  = windowExtent;
+    swapchain->NeedsRecreate = true;
+}
+
+bool SwapchainAcquire(Swapchain* swapchain, VkSemaphore imageAvailableSemaphore, uint32_t* imageIndex) {
+    // An out of date acquire leaves the semaphore untouched, so it can go straight to the new swapchain
+    for (uint32_t attempt = 0; attempt < 2; attempt++) {
+        if (swapchain->NeedsRecreate && !SwapchainRecreate(swapchain)) {
+            return false;
+        }
+        VkResult result =
+            vkAcquireNextImageKHR(swapchain->Device, swapchain->Current.Handle, ~0ull, imageAvailableSemaphore, VK_NULL_HANDLE, imageIndex);
+        if (result == VK_SUCCESS) {
+            return true;
+        }
+        if (result == VK_SUBOPTIMAL_KHR) {
+            swapchain->NeedsRecreate = true;
+            return true;
+        }
+        if (result != VK_ERROR_OUT_OF_DATE_KHR) {
+            VkCheck(result);
+        }
+        swapchain->NeedsRecreate = true;
+    }
+    return false;
+}
+
+void SwapchainPresent(Swapchain* swapchain, VkQueue queue, uint32_t imageIndex) {
+    // The semaphore wait still happens when presentation fails this way, so the semaphore can be reused either way
+    VkResult result = PresentQueue(
+        swapchain->Present, queue, swapchain->Current.Handle, imageIndex, swapchain->Current.RenderFinished[imageIndex]);
+    if (result == VK_SUBOPTIMAL_KHR || result == VK_ERROR_OUT_OF_DATE_KHR) {
+        swapchain->NeedsRecreate = true;
+    } else if (result != VK_SUCCESS) {
+        VkCheck(result);
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Common.h"
+#include "Present.h"
+#include "Timeline.h"
+
+#define SwapchainMaxImages  8
+// Rapid resizes can retire swapchains faster than frames finish, past this the oldest one is waited for
+#define SwapchainMaxRetired 4
+
+// A swapchain with everything that lives and dies with its images
+typedef struct SwapchainGeneration {
+    VkSwapchainKHR Handle;
+    VkExtent2D Extent;
+    uint32_t ImageCount;
+    VkImage Images[SwapchainMaxImages];
+    VkImageView Views[SwapchainMaxImages];
+    // Per image rather than per frame slot, presentation can still be waiting on one after the slot is reused,
+    // but never after the image was acquired again
+    VkSemaphore RenderFinished[SwapchainMaxImages];
+    // Graphics timeline value of the last frame that could have used it
+    uint64_t RetireValue;
+} SwapchainGeneration;
+
+// Recreating passes the live swapchain as oldSwapchain and keeps the old generation around until the graphics
+// timeline shows every frame submitted before the switch has finished, so resizes never wait for the device
+// to go idle. Acquire recreates and retries when the swapchain is out of date, a suboptimal one is used for the
+// frame and recreated before the next.
+typedef struct Swapchain {
+    VkDevice Device;
+    VkPhysicalDevice PhysicalDevice;
+    VkSurfaceKHR Surface;
+    const VkAllocationCallbacks* Allocator;
+    Present* Present;
+    Timeline* Timeline;
+    uint32_t QueueFamilyIndices[2];
+    VkSurfaceFormatKHR Format;
+    VkImageUsageFlags ImageUsage;
+    // Used when the surface lets the swapchain decide its size, like headless surfaces or Wayland
+    VkExtent2D WindowExtent;
+    bool NeedsRecreate;
+    uint32_t RecreateCount;
+
+    SwapchainGeneration Current;
+    uint32_t RetiredCount;
+    SwapchainGeneration Retired[SwapchainMaxRetired];
+} Swapchain;
+
+// transferSource lets frames be copied out of the images, exits if the surface doesn't allow it
+Swapchain* SwapchainCreate(VkDevice device,
+                           VkPhysicalDevice physicalDevice,
+                           VkSurfaceKHR surface,
+                           uint32_t graphicsQueueFamilyIndex,
+                           uint32_t presentQueueFamilyIndex,
+                           Present* present,
+                           Timeline* graphicsTimeline,
+                           VkExtent2D windowExtent,
+                           bool transferSource,
+                           const VkAllocationCallbacks* allocator);
+// The device must be idle
+void SwapchainDestroy(Swapchain* swapchain);
+
+// Destroys retired generations whose frames have finished
+void SwapchainBeginFrame(Swapchain* swapchain);
+// The swapchain is recreated at the next acquire
+void SwapchainResize(Swapchain* swapchain, VkExtent2D windowExtent);
+// Returns false if no image could be acquired, e.g. while the window is minimized, nothing for the frame should be
+// submitted then
+bool SwapchainAcquire(Swapchain* swapchain, VkSemaphore imageAvailableSemaphore, uint32_t* imageIndex);
+// The frame's submission must signal Current.RenderFinished[imageIndex]
+void SwapchainPresent(Swapchain* swapchain, VkQueue queue, uint32_t imageIndex);
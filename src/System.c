@@ -0,0 +1,411 @@
+#include "System.h"
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <time.h>
+    #include <pthread.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <dlfcn.h>
+    #include <sys/resource.h>
+#endif
+
+uint64_t SystemGetTimeNanoseconds(void) {
+#if defined(_WIN32)
+    static LARGE_INTEGER frequency = {};
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    LARGE_INTEGER counter = {};
+    QueryPerformanceCounter(&counter);
+    uint64_t seconds   = cast(uint64_t) counter.QuadPart / cast(uint64_t) frequency.QuadPart;
+    uint64_t remainder = cast(uint64_t) counter.QuadPart % cast(uint64_t) frequency.QuadPart;
+    return seconds * 1000000000ull + remainder * 1000000000ull / cast(uint64_t) frequency.QuadPart;
+#else
+    struct timespec time = {};
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return cast(uint64_t) time.tv_sec * 1000000000ull + cast(uint64_t) time.tv_nsec;
+#endif
+}
+
+void SystemSleep(uint32_t milliseconds) {
+#if defined(_WIN32)
+    Sleep(milliseconds);
+#else
+    struct timespec time = {
+        .tv_sec  = milliseconds / 1000,
+        .tv_nsec = cast(long)(milliseconds % 1000) * 1000000,
+    };
+    nanosleep(&time, NULL);
+#endif
+}
+
+#if defined(_WIN32)
+static_assert(sizeof(SRWLOCK) <= sizeof(SystemMutex), "SystemMutex is too small");
+
+void SystemMutexInit(SystemMutex* mutex) {
+    InitializeSRWLock(cast(SRWLOCK*) mutex->Storage);
+}
+
+void SystemMutexDestroy(SystemMutex* mutex) {
+    (void)mutex;
+}
+
+void SystemMutexLock(SystemMutex* mutex) {
+    AcquireSRWLockExclusive(cast(SRWLOCK*) mutex->Storage);
+}
+
+void SystemMutexUnlock(SystemMutex* mutex) {
+    ReleaseSRWLockExclusive(cast(SRWLOCK*) mutex->Storage);
+}
+static_assert(sizeof(CONDITION_VARIABLE) <= sizeof(SystemConditionVariable), "SystemConditionVariable is too small");
+
+void SystemConditionVariableInit(SystemConditionVariable* conditionVariable) {
+    InitializeConditionVariable(cast(CONDITION_VARIABLE*) conditionVariable->Storage);
+}
+
+void SystemConditionVariableDestroy(SystemConditionVariable* conditionVariable) {
+    (void)conditionVariable;
+}
+
+void SystemConditionVariableWait(SystemConditionVariable* conditionVariable, SystemMutex* mutex) {
+    SleepConditionVariableSRW(cast(CONDITION_VARIABLE*) conditionVariable->Storage, cast(SRWLOCK*) mutex->Storage, INFINITE, 0);
+}
+
+void SystemConditionVariableSignal(SystemConditionVariable* conditionVariable) {
+    WakeConditionVariable(cast(CONDITION_VARIABLE*) conditionVariable->Storage);
+}
+
+void SystemConditionVariableBroadcast(SystemConditionVariable* conditionVariable) {
+    WakeAllConditionVariable(cast(CONDITION_VARIABLE*) conditionVariable->Storage);
+}
+
+static DWORD WINAPI SystemThreadEntry(void* parameter) {
+    SystemThread* thread = parameter;
+    thread->Function(thread->UserData);
+    return 0;
+}
+
+void SystemThreadCreate(SystemThread* thread, void (*function)(void* userData), void* userData) {
+    thread->Function = function;
+    thread->UserData = userData;
+    HANDLE handle    = CreateThread(NULL, 0, SystemThreadEntry, thread, 0, NULL);
+    if (handle == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to create a thread! %lu\n", GetLastError());
+        exit(1);
+    }
+    thread->Handle = cast(uint64_t) cast(uintptr_t) handle;
+}
+
+void SystemThreadJoin(SystemThread* thread) {
+    HANDLE handle = cast(HANDLE) cast(uintptr_t) thread->Handle;
+    WaitForSingleObject(handle, INFINITE);
+    CloseHandle(handle);
+    thread->Handle = 0;
+}
+
+uint32_t SystemGetProcessorCount(void) {
+    SYSTEM_INFO systemInfo = {};
+    GetSystemInfo(&systemInfo);
+    return systemInfo.dwNumberOfProcessors > 0 ? cast(uint32_t) systemInfo.dwNumberOfProcessors : 1;
+}
+#else
+static_assert(sizeof(pthread_mutex_t) <= sizeof(SystemMutex), "SystemMutex is too small");
+
+void SystemMutexInit(SystemMutex* mutex) {
+    if (pthread_mutex_init(cast(pthread_mutex_t*) mutex->Storage, NULL) != 0) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to create a mutex!\n");
+        exit(1);
+    }
+}
+
+void SystemMutexDestroy(SystemMutex* mutex) {
+    pthread_mutex_destroy(cast(pthread_mutex_t*) mutex->Storage);
+}
+
+void SystemMutexLock(SystemMutex* mutex) {
+    pthread_mutex_lock(cast(pthread_mutex_t*) mutex->Storage);
+}
+
+void SystemMutexUnlock(SystemMutex* mutex) {
+    pthread_mutex_unlock(cast(pthread_mutex_t*) mutex->Storage);
+}
+static_assert(sizeof(pthread_cond_t) <= sizeof(SystemConditionVariable), "SystemConditionVariable is too small");
+
+void SystemConditionVariableInit(SystemConditionVariable* conditionVariable) {
+    if (pthread_cond_init(cast(pthread_cond_t*) conditionVariable->Storage, NULL) != 0) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to create a condition variable!\n");
+        exit(1);
+    }
+}
+
+void SystemConditionVariableDestroy(SystemConditionVariable* conditionVariable) {
+    pthread_cond_destroy(cast(pthread_cond_t*) conditionVariable->Storage);
+}
+
+void SystemConditionVariableWait(SystemConditionVariable* conditionVariable, SystemMutex* mutex) {
+    pthread_cond_wait(cast(pthread_cond_t*) conditionVariable->Storage, cast(pthread_mutex_t*) mutex->Storage);
+}
+
+void SystemConditionVariableSignal(SystemConditionVariable* conditionVariable) {
+    pthread_cond_signal(cast(pthread_cond_t*) conditionVariable->Storage);
+}
+
+void SystemConditionVariableBroadcast(SystemConditionVariable* conditionVariable) {
+    pthread_cond_broadcast(cast(pthread_cond_t*) conditionVariable->Storage);
+}
+
+static_assert(sizeof(pthread_t) <= sizeof(uint64_t), "pthread_t does not fit in SystemThread");
+
+static void* SystemThreadEntry(void* parameter) {
+    SystemThread* thread = parameter;
+    thread->Function(thread->UserData);
+    return NULL;
+}
+
+void SystemThreadCreate(SystemThread* thread, void (*function)(void* userData), void* userData) {
+    thread->Function = function;
+    thread->UserData = userData;
+    pthread_t handle;
+    int result = pthread_create(&handle, NULL, SystemThreadEntry, thread);
+    if (result != 0) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to create a thread! %d\n", result);
+        exit(1);
+    }
+    thread->Handle = 0;
+    memcpy(&thread->Handle, &handle, sizeof(handle));
+}
+
+void SystemThreadJoin(SystemThread* thread) {
+    pthread_t handle;
+    memcpy(&handle, &thread->Handle, sizeof(handle));
+    pthread_join(handle, NULL);
+    thread->Handle = 0;
+}
+
+uint32_t SystemGetProcessorCount(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? cast(uint32_t) count : 1;
+}
+#endif
+
+#if defined(_WIN32)
+bool SystemMapFile(const char* path, SystemMappedFile* file) {
+    *file = (SystemMappedFile){};
+
+    HANDLE fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size = {};
+    if (!GetFileSizeEx(fileHandle, &size) || size.QuadPart == 0) {
+        CloseHandle(fileHandle);
+        return false;
+    }
+    HANDLE mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mappingHandle == NULL) {
+        CloseHandle(fileHandle);
+        return false;
+    }
+    const uint8_t* data = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if (data == NULL) {
+        CloseHandle(mappingHandle);
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    file->Data          = data;
+    file->Size          = cast(size_t) size.QuadPart;
+    file->FileHandle    = fileHandle;
+    file->MappingHandle = mappingHandle;
+    return true;
+}
+
+void SystemUnmapFile(SystemMappedFile* file) {
+    if (file->Data != NULL) {
+        UnmapViewOfFile(file->Data);
+        CloseHandle(file->MappingHandle);
+        CloseHandle(file->FileHandle);
+    }
+    *file = (SystemMappedFile){};
+}
+
+bool SystemGetFileModifiedTime(const char* path, uint64_t* time) {
+    WIN32_FILE_ATTRIBUTE_DATA attributes = {};
+    if (!GetFileAttributesExA(path, GetFileExInfoStandard, &attributes)) {
+        return false;
+    }
+    *time = cast(uint64_t) attributes.ftLastWriteTime.dwHighDateTime << 32 | attributes.ftLastWriteTime.dwLowDateTime;
+    return true;
+}
+
+bool SystemWriteFileAtomic(const char* path, const void* data, size_t size) {
+    char temporaryPath[MAX_PATH];
+    if (snprintf(temporaryPath, sizeof(temporaryPath), "%s.tmp", path) >= cast(int) sizeof(temporaryPath)) {
+        return false;
+    }
+
+    HANDLE fileHandle = CreateFileA(temporaryPath, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    bool success             = true;
+    const uint8_t* remaining = data;
+    while (success && size > 0) {
+        DWORD chunk   = size > 0x40000000 ? 0x40000000 : cast(DWORD) size;
+        DWORD written = 0;
+        success       = WriteFile(fileHandle, remaining, chunk, &written, NULL) && written == chunk;
+        remaining += chunk;
+        size -= chunk;
+    }
+    success = success && FlushFileBuffers(fileHandle);
+    CloseHandle(fileHandle);
+
+    success = success && MoveFileExA(temporaryPath, path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+    if (!success) {
+        DeleteFileA(temporaryPath);
+    }
+    return success;
+}
+#else
+bool SystemMapFile(const char* path, SystemMappedFile* file) {
+    *file = (SystemMappedFile){};
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat status = {};
+    if (fstat(fd, &status) != 0 || status.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+    void* data = mmap(NULL, cast(size_t) status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps the file alive on its own
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    file->Data = data;
+    file->Size = cast(size_t) status.st_size;
+    return true;
+}
+
+void SystemUnmapFile(SystemMappedFile* file) {
+    if (file->Data != NULL) {
+        munmap(cast(void*) file->Data, file->Size);
+    }
+    *file = (SystemMappedFile){};
+}
+
+bool SystemGetFileModifiedTime(const char* path, uint64_t* time) {
+    struct stat status = {};
+    if (stat(path, &status) != 0) {
+        return false;
+    }
+    *time = cast(uint64_t) status.st_mtim.tv_sec * 1000000000ull + cast(uint64_t) status.st_mtim.tv_nsec;
+    return true;
+}
+
+bool SystemWriteFileAtomic(const char* path, const void* data, size_t size) {
+    size_t pathLength   = strlen(path);
+    char* temporaryPath = malloc(pathLength + sizeof(".tmp"));
+    if (temporaryPath == NULL) {
+        return false;
+    }
+    memcpy(temporaryPath, path, pathLength);
+    memcpy(temporaryPath + pathLength, ".tmp", sizeof(".tmp"));
+
+    int fd = open(temporaryPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        free(temporaryPath);
+        return false;
+    }
+    bool success             = true;
+    const uint8_t* remaining = data;
+    while (success && size > 0) {
+        ssize_t written = write(fd, remaining, size);
+        success         = written > 0;
+        if (success) {
+            remaining += written;
+            size -= cast(size_t) written;
+        }
+    }
+    success = fsync(fd) == 0 && success;
+    success = close(fd) == 0 && success;
+
+    success = success && rename(temporaryPath, path) == 0;
+    if (!success) {
+        unlink(temporaryPath);
+    }
+    free(temporaryPath);
+    return success;
+}
+#endif
+
+#if defined(_WIN32)
+void* SystemLoadLibrary(const char* name) {
+    return cast(void*) LoadLibraryA(name);
+}
+
+void* SystemGetLibraryFunction(void* library, const char* name) {
+    return cast(void*) GetProcAddress(cast(HMODULE) library, name);
+}
+
+void SystemUnloadLibrary(void* library) {
+    FreeLibrary(cast(HMODULE) library);
+}
+#else
+void* SystemLoadLibrary(const char* name) {
+    return dlopen(name, RTLD_NOW | RTLD_LOCAL);
+}
+
+void* SystemGetLibraryFunction(void* library, const char* name) {
+    return dlsym(library, name);
+}
+
+void SystemUnloadLibrary(void* library) {
+    dlclose(library);
+}
+#endif
+
+#if defined(_WIN32)
+uint64_t SystemGetPeakMemoryUsage(void) {
+    PROCESS_MEMORY_COUNTERS counters = {};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return counters.PeakWorkingSetSize;
+}
+
+bool SystemSetEnvironmentVariable(const char* name, const char* value) {
+    return _putenv_s(name, value) == 0;
+}
+#else
+uint64_t SystemGetPeakMemoryUsage(void) {
+    struct rusage usage = {};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    // Linux reports kilobytes, macOS bytes
+    #if defined(__APPLE__)
+    return cast(uint64_t) usage.ru_maxrss;
+    #else
+    return cast(uint64_t) usage.ru_maxrss * 1024;
+    #endif
+}
+
+bool SystemSetEnvironmentVariable(const char* name, const char* value) {
+    return setenv(name, value, 1) == 0;
+}
+#endif
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Common.h"
+
+// Monotonic clock for measuring durations, not tied to wall-clock time
+uint64_t SystemGetTimeNanoseconds(void);
+void SystemSleep(uint32_t milliseconds);
+
+// Storage for the platform mutex, big enough for a pthread_mutex_t on every platform we build for
+typedef struct SystemMutex {
+    uint64_t Storage[8];
+} SystemMutex;
+
+void SystemMutexInit(SystemMutex* mutex);
+void SystemMutexDestroy(SystemMutex* mutex);
+void SystemMutexLock(SystemMutex* mutex);
+void SystemMutexUnlock(SystemMutex* mutex);
+
+typedef struct SystemConditionVariable {
+    uint64_t Storage[8];
+} SystemConditionVariable;
+
+void SystemConditionVariableInit(SystemConditionVariable* conditionVariable);
+void SystemConditionVariableDestroy(SystemConditionVariable* conditionVariable);
+// The mutex must be locked, it is unlocked while waiting and locked again before returning
+void SystemConditionVariableWait(SystemConditionVariable* conditionVariable, SystemMutex* mutex);
+void SystemConditionVariableSignal(SystemConditionVariable* conditionVariable);
+void SystemConditionVariableBroadcast(SystemConditionVariable* conditionVariable);
+
+// The thread struct must stay at the same address until the thread has been joined
+typedef struct SystemThread {
+    uint64_t Handle;
+    void (*Function)(void* userData);
+    void* UserData;
+} SystemThread;
+
+void SystemThreadCreate(SystemThread* thread, void (*function)(void* userData), void* userData);
+void SystemThreadJoin(SystemThread* thread);
+uint32_t SystemGetProcessorCount(void);
+
+// Read-only view of a whole file, Data is NULL if the file couldn't be opened, is empty or couldn't be mapped
+typedef struct SystemMappedFile {
+    const uint8_t* Data;
+    size_t Size;
+    void* FileHandle;
+    void* MappingHandle;
+} SystemMappedFile;
+
+bool SystemMapFile(const char* path, SystemMappedFile* file);
+void SystemUnmapFile(SystemMappedFile* file);
+// Only good for telling whether the file changed, the unit and epoch depend on the platform
+bool SystemGetFileModifiedTime(const char* path, uint64_t* time);
+
+// Writes to a temporary file next to path, flushes it to disk and renames it over path,
+// so readers either see the old contents or the new ones but never a partial write
+bool SystemWriteFileAtomic(const char* path, const void* data, size_t size);
+
+// Returns NULL if the library couldn't be found or loaded
+void* SystemLoadLibrary(const char* name);
+void* SystemGetLibraryFunction(void* library, const char* name);
+void SystemUnloadLibrary(void* library);
+
+// Peak resident memory of the process in bytes, 0 if the platform can't tell
+uint64_t SystemGetPeakMemoryUsage(void);
+// Applies to this process and the processes it starts afterwards
+bool SystemSetEnvironmentVariable(const char* name, const char* value);
@@ -0,0 +1,544 @@
+#include "TextureStreamer.h"
+#include "DebugUtils.h"
+
+static const uint8_t TextureStreamerKtx2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+typedef struct TextureStreamerKtx2Header {
+    uint8_t Identifier[12];
+    uint32_t VkFormat;
+    uint32_t TypeSize;
+    uint32_t PixelWidth;
+    uint32_t PixelHeight;
+    uint32_t PixelDepth;
+    uint32_t LayerCount;
+    uint32_t FaceCount;
+    uint32_t LevelCount;
+    uint32_t SupercompressionScheme;
+    uint32_t DfdByteOffset;
+    uint32_t DfdByteLength;
+    uint32_t KvdByteOffset;
+    uint32_t KvdByteLength;
+    uint64_t SgdByteOffset;
+    uint64_t SgdByteLength;
+} TextureStreamerKtx2Header;
+
+// Follows the header, level 0 is the largest
+typedef struct TextureStreamerKtx2Level {
+    uint64_t ByteOffset;
+    uint64_t ByteLength;
+    uint64_t UncompressedByteLength;
+} TextureStreamerKtx2Level;
+
+static_assert(sizeof(TextureStreamerKtx2Header) == 80, "TextureStreamerKtx2Header must match the KTX2 file layout");
+static_assert(sizeof(TextureStreamerKtx2Level) == 24, "TextureStreamerKtx2Level must match the KTX2 file layout");
+
+static uint32_t TextureStreamerLevelDimension(uint32_t size, uint32_t level) {
+    return size >> level > 0 ? size >> level : 1;
+}
+
+static bool TextureStreamerIsSupportedFormat(VkFormat format) {
+    return format == VK_FORMAT_R8G8B8A8_UNORM || format == VK_FORMAT_R8G8B8A8_SRGB || format == VK_FORMAT_B8G8R8A8_UNORM ||
+           format == VK_FORMAT_B8G8R8A8_SRGB;
+}
+
+// Returns why the file can't be streamed, or NULL after filling in the texture's format, size and levels
+static const char* TextureStreamerParseKtx2(TextureStreamerTexture* texture, VkDeviceSize stagingSize) {
+    const uint8_t* data = texture->File.Data;
+    size_t size         = texture->File.Size;
+    TextureStreamerKtx2Header header;
+    if (size < sizeof(header)) {
+        return "it's too small to be a KTX2 file";
+    }
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.Identifier, TextureStreamerKtx2Identifier, sizeof(TextureStreamerKtx2Identifier)) != 0) {
+        return "it isn't a KTX2 file";
+    }
+    if (!TextureStreamerIsSupportedFormat(cast(VkFormat) header.VkFormat)) {
+        return "its format isn't 8 bit RGBA or BGRA";
+    }
+    if (header.PixelWidth == 0 || header.PixelHeight == 0 || header.PixelDepth != 0 || header.LayerCount != 0 || header.FaceCount != 1) {
+        return "it isn't a single 2D image";
+    }
+    if (header.SupercompressionScheme != 0) {
+        return "it's supercompressed";
+    }
+    // A level count of 0 asks the loader to generate the mips, which streaming can't do
+    if (header.LevelCount == 0 || header.LevelCount > TextureStreamerMaxLevels) {
+        return "it has no mip levels or more than the streamer supports";
+    }
+    // More levels than the chain down to 1x1 has would make an image vkCreateImage doesn't allow
+    uint32_t largestSide = header.PixelWidth > header.PixelHeight ? header.PixelWidth : header.PixelHeight;
+    uint32_t fullChain   = 1;
+    for (uint32_t side = largestSide; side > 1; side >>= 1) {
+        fullChain++;
+    }
+    if (header.LevelCount > fullChain) {
+        return "it has more mip levels than its size allows";
+    }
+    if (size < sizeof(header) + header.LevelCount * sizeof(TextureStreamerKtx2Level)) {
+        return "its level index is cut off";
+    }
+
+    texture->Format     = cast(VkFormat) header.VkFormat;
+    texture->Width      = header.PixelWidth;
+    texture->Height     = header.PixelHeight;
+    texture->LevelCount = header.LevelCount;
+    texture->TailLevel  = header.LevelCount - 1;
+    texture->TopLevel   = header.LevelCount;
+    for (uint32_t i = 0; i < header.LevelCount; i++) {
+        TextureStreamerKtx2Level level;
+        memcpy(&level, data + sizeof(header) + i * sizeof(level), sizeof(level));
+        uint32_t width  = TextureStreamerLevelDimension(header.PixelWidth, i);
+        uint32_t height = TextureStreamerLevelDimension(header.PixelHeight, i);
+        uint64_t needed = cast(uint64_t) width * height * 4;
+        if (level.ByteOffset > size || level.ByteLength > size - level.ByteOffset || level.ByteLength < needed) {
+            return "a level is outside the file or too small";
+        }
+        texture->Levels[i] = (TextureStreamerLevel){
+            .Offset = level.ByteOffset,
+            .Size   = needed,
+        };
+        if (i < texture->TailLevel && width <= TextureStreamerTailSize && height <= TextureStreamerTailSize) {
+            texture->TailLevel = i;
+        }
+        // Levels only get smaller, so the first one that fits half the staging ring is the top
+        if (texture->TopLevel == header.LevelCount && needed <= stagingSize / 2) {
+            texture->TopLevel = i;
+        }
+    }
+    if (texture->TopLevel > texture->TailLevel) {
+        return "its mip tail doesn't fit the staging ring";
+    }
+    return NULL;
+}
+
+static void TextureStreamerDestroyImage(TextureStreamer* streamer, const TextureStreamerImage* image) {
+    vkDestroyImageView(streamer->Device, image->View, streamer->Allocator);
+    vkDestroyImage(streamer->Device, image->Image, streamer->Allocator);
+    DeviceAllocatorFree(streamer->DeviceAllocator, image->Allocation);
+}
+
+static void TextureStreamerRetire(TextureStreamer* streamer, TextureStreamerImage* image) {
+    BindlessRemove(streamer->Bindless, BindlessType_SampledImage, image->Index);
+    if (streamer->RetiredCount == TextureStreamerMaxRetired) {
+        // Only happens when textures are swapped faster than frames finish
+        TimelineWait(streamer->Timeline, streamer->Timeline->LastSubmittedValue);
+        for (uint32_t i = 0; i < streamer->RetiredCount; i++) {
+            TextureStreamerDestroyImage(streamer, &streamer->Retired[i].Image);
+        }
+        streamer->RetiredCount = 0;
+    }
+    streamer->Retired[streamer->RetiredCount++] = (TextureStreamerRetired){
+        .Image = *image,
+        .Value = streamer->Timeline->LastSubmittedValue,
+    };
+    *image = (TextureStreamerImage){};
+}
+
+// Creates the image for the texture's levels from firstLevel down and queues their uploads smallest first, returns
+// the bytes queued or 0 if there was no device memory for the image
+static VkDeviceSize TextureStreamerLoad(TextureStreamer* streamer, uint32_t textureIndex, uint32_t firstLevel) {
+    TextureStreamerTexture* texture = &streamer->Textures[textureIndex];
+    TextureStreamerImage image      = { .FirstLevel = firstLevel };
+    uint32_t levelCount             = texture->LevelCount - firstLevel;
+    VkResult imageCreateResult      = DeviceAllocatorCreateImage(streamer->DeviceAllocator,
+                                                            &(VkImageCreateInfo){
+                                                                .sType     = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+                                                                .imageType = VK_IMAGE_TYPE_2D,
+                                                                .format    = texture->Format,
+                                                                .extent =
+                                                                    {
+                                                                        TextureStreamerLevelDimension(texture->Width, firstLevel),
+                                                                        TextureStreamerLevelDimension(texture->Height, firstLevel),
+                                                                        1,
+                                                                    },
+                                                                .mipLevels   = levelCount,
+                                                                .arrayLayers = 1,
+                                                                .samples     = VK_SAMPLE_COUNT_1_BIT,
+                                                                .tiling      = VK_IMAGE_TILING_OPTIMAL,
+                                                                .usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                                                                .sharingMode   = VK_SHARING_MODE_EXCLUSIVE,
+                                                                .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                                                            },
+                                                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                                            0,
+                                                            &image.Image,
+                                                            &image.Allocation);
+    if (imageCreateResult != VK_SUCCESS) {
+        return 0;
+    }
+    VkCheck(vkCreateImageView(streamer->Device,
+                              &(VkImageViewCreateInfo){
+                                  .sType    = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+                                  .image    = image.Image,
+                                  .viewType = VK_IMAGE_VIEW_TYPE_2D,
+                                  .format   = texture->Format,
+                                  .subresourceRange =
+                                      (VkImageSubresourceRange){
+                                          .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                          .levelCount = levelCount,
+                                          .layerCount = 1,
+                                      },
+                              },
+                              streamer->Allocator,
+                              &image.View));
+    DebugUtilsSetObjectName(streamer->Device,
+                            VK_OBJECT_TYPE_IMAGE,
+                            cast(uint64_t) image.Image,
+                            "Streamed texture %u from level %u",
+                            textureIndex,
+                            firstLevel);
+
+    // The texels go from the mapping straight into the staging ring, the file's pages are only read here
+    VkDeviceSize bytes = 0;
+    for (uint32_t level = texture->LevelCount; level-- > firstLevel;) {
+        const TextureStreamerLevel* fileLevel = &texture->Levels[level];
+        UploaderUploadImage(streamer->Uploader,
+                            image.Image,
+                            level - firstLevel,
+                            0,
+                            (VkExtent3D){
+                                TextureStreamerLevelDimension(texture->Width, level),
+                                TextureStreamerLevelDimension(texture->Height, level),
+                                1,
+                            },
+                            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                            texture->File.Data + fileLevel->Offset,
+                            fileLevel->Size);
+        bytes += fileLevel->Size;
+    }
+    texture->Pending      = image;
+    texture->PendingValue = 0;
+    if (firstLevel < texture->TailLevel) {
+        streamer->PendingBytes += image.Allocation->Size;
+    }
+    streamer->Stats.BytesUploaded += bytes;
+    return bytes;
+}
+
+// The budget shrinks with the highest pressure on any device local heap
+static VkDeviceSize TextureStreamerGetBudget(const TextureStreamer* streamer) {
+    MemoryPressure pressure = MemoryPressure_None;
+    for (uint32_t i = 0; i < VK_MAX_MEMORY_HEAPS; i++) {
+        pressure = streamer->HeapPressures[i] > pressure ? streamer->HeapPressures[i] : pressure;
+    }
+    return pressure == MemoryPressure_None ? streamer->Budget : pressure == MemoryPressure_Elevated ? streamer->Budget / 2 : 0;
+}
+
+// Drops the least recently used streamed images back to their tails until size more bytes fit the budget. Unless
+// memory is short, textures used by the last frame are kept, they'd only be streamed in again right away.
+static bool TextureStreamerMakeRoom(TextureStreamer* streamer, VkDeviceSize size, bool evictUsed) {
+    while (streamer->Stats.StreamedBytes + streamer->PendingBytes + size > TextureStreamerGetBudget(streamer)) {
+        TextureStreamerTexture* oldest = NULL;
+        for (uint32_t i = 0; i < streamer->TextureCount; i++) {
+            TextureStreamerTexture* texture = &streamer->Textures[i];
+            if (texture->Streamed.Image == VK_NULL_HANDLE || texture->Pending.Image != VK_NULL_HANDLE ||
+                (!evictUsed && texture->LastUsedFrame + 1 >= streamer->FrameNumber)) {
+                continue;
+            }
+            if (oldest == NULL || texture->LastUsedFrame < oldest->LastUsedFrame) {
+                oldest = texture;
+            }
+        }
+        if (oldest == NULL) {
+            return false;
+        }
+        streamer->Stats.StreamedBytes -= oldest->Streamed.Allocation->Size;
+        streamer->Stats.PressureEvictions += oldest->LastUsedFrame + 1 >= streamer->FrameNumber ? 1 : 0;
+        TextureStreamerRetire(streamer, &oldest->Streamed);
+        streamer->Stats.Evictions++;
+    }
+    return true;
+}
+
+TextureStreamer* TextureStreamerCreate(VkDevice device,
+                                       DeviceAllocator* deviceAllocator,
+                                       Uploader* uploader,
+                                       Bindless* bindless,
+                                       Timeline* graphicsTimeline,
+                                       VkDeviceSize budget,
+                                       VkDeviceSize uploadBytesPerUpdate,
+                                       uint32_t fallbackIndex,
+                                       const VkAllocationCallbacks* allocator) {
+    TextureStreamer* streamer = calloc(1, sizeof(TextureStreamer));
+    if (streamer == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate the texture streamer!\n");
+        exit(1);
+    }
+    streamer->Device               = device;
+    streamer->Allocator            = allocator;
+    streamer->DeviceAllocator      = deviceAllocator;
+    streamer->Uploader             = uploader;
+    streamer->Bindless             = bindless;
+    streamer->Timeline             = graphicsTimeline;
+    streamer->Budget               = budget;
+    streamer->UploadBytesPerUpdate = uploadBytesPerUpdate;
+    streamer->FallbackIndex        = fallbackIndex;
+    return streamer;
+}
+
+void TextureStreamerDestroy(TextureStreamer* streamer) {
+    for (uint32_t i = 0; i < streamer->RetiredCount; i++) {
+        TextureStreamerDestroyImage(streamer, &streamer->Retired[i].Image);
+    }
+    for (uint32_t i = 0; i < streamer->TextureCount; i++) {
+        TextureStreamerTexture* texture = &streamer->Textures[i];
+        if (texture->Pending.Image != VK_NULL_HANDLE) {
+            TextureStreamerDestroyImage(streamer, &texture->Pending);
+        }
+        if (texture->Streamed.Image != VK_NULL_HANDLE) {
+            BindlessRemove(streamer->Bindless, BindlessType_SampledImage, texture->Streamed.Index);
+            TextureStreamerDestroyImage(streamer, &texture->Streamed);
+        }
+        if (texture->Tail.Image != VK_NULL_HANDLE) {
+            BindlessRemove(streamer->Bindless, BindlessType_SampledImage, texture->Tail.Index);
+            TextureStreamerDestroyImage(streamer, &texture->Tail);
+        }
+        if (texture->InUse) {
+            SystemUnmapFile(&texture->File);
+        }
+    }
+    free(streamer);
+}
+
+uint32_t TextureStreamerAdd(TextureStreamer* streamer, const char* path) {
+    if (streamer->TextureCount == TextureStreamerMaxTextures) {
+        fflush(stdout);
+        fprintf(stderr, "More than %d textures added to the texture streamer!\n", TextureStreamerMaxTextures);
+        exit(1);
+    }
+    TextureStreamerTexture* texture = &streamer->Textures[streamer->TextureCount];
+    *texture                        = (TextureStreamerTexture){};
+    if (!SystemMapFile(path, &texture->File)) {
+        printf("Ignoring the texture at '%s' because it couldn't be mapped!\n", path);
+        return UINT32_MAX;
+    }
+    const char* rejectReason = TextureStreamerParseKtx2(texture, streamer->Uploader->StagingSize);
+    if (rejectReason) {
+        printf("Ignoring the texture at '%s' because %s!\n", path, rejectReason);
+        SystemUnmapFile(&texture->File);
+        return UINT32_MAX;
+    }
+    texture->InUse       = true;
+    texture->WantedLevel = texture->LevelCount;
+    // The tail is queued by the next update, so adding a whole set of textures never uploads anything
+    return streamer->TextureCount++;
+}
+
+void TextureStreamerUpdate(TextureStreamer* streamer) {
+    streamer->FrameNumber++;
+    uint64_t completedValue = TimelineGetCompletedValue(streamer->Timeline);
+    uint32_t kept           = 0;
+    for (uint32_t i = 0; i < streamer->RetiredCount; i++) {
+        if (streamer->Retired[i].Value <= completedValue) {
+            TextureStreamerDestroyImage(streamer, &streamer->Retired[i].Image);
+        } else {
+            streamer->Retired[kept++] = streamer->Retired[i];
+        }
+    }
+    streamer->RetiredCount = kept;
+
+    // Anything the uploader's timeline has passed is acquired by this frame's UploaderAcquire at the latest
+    uint32_t missingTails = 0;
+    for (uint32_t i = 0; i < streamer->TextureCount; i++) {
+        TextureStreamerTexture* texture = &streamer->Textures[i];
+        if (texture->Pending.Image != VK_NULL_HANDLE && TimelineIsComplete(streamer->Uploader->Timeline, texture->PendingValue)) {
+            texture->Pending.Index =
+                BindlessAddSampledImage(streamer->Bindless, texture->Pending.View, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+            if (texture->Tail.Image == VK_NULL_HANDLE) {
+                texture->Tail = texture->Pending;
+                streamer->Stats.TailBytes += texture->Tail.Allocation->Size;
+                streamer->Stats.TailLoads++;
+            } else {
+                if (texture->Streamed.Image != VK_NULL_HANDLE) {
+                    streamer->Stats.StreamedBytes -= texture->Streamed.Allocation->Size;
+                    TextureStreamerRetire(streamer, &texture->Streamed);
+                }
+                texture->Streamed = texture->Pending;
+                streamer->PendingBytes -= texture->Streamed.Allocation->Size;
+                streamer->Stats.StreamedBytes += texture->Streamed.Allocation->Size;
+                streamer->Stats.StreamIns++;
+            }
+            texture->Pending = (TextureStreamerImage){};
+        }
+        missingTails += texture->Tail.Image == VK_NULL_HANDLE ? 1 : 0;
+    }
+    if (streamer->Stats.StreamedBytes > streamer->Stats.PeakStreamedBytes) {
+        streamer->Stats.PeakStreamedBytes = streamer->Stats.StreamedBytes;
+    }
+    if (missingTails == 0 && streamer->TextureCount > 0 && streamer->Stats.TailFrames == 0) {
+        streamer->Stats.TailFrames = streamer->FrameNumber;
+    }
+    // Only does anything when memory pressure shrank the budget below what's resident
+    TextureStreamerMakeRoom(streamer, 0, true);
+
+    // Tails come first so every texture has something to draw with as early as possible
+    VkDeviceSize uploadBytes = 0;
+    uint32_t levelUploads    = 0;
+    for (uint32_t i = 0; i < streamer->TextureCount && missingTails > 0 && uploadBytes < streamer->UploadBytesPerUpdate; i++) {
+        TextureStreamerTexture* texture = &streamer->Textures[i];
+        if (texture->Tail.Image != VK_NULL_HANDLE || texture->Pending.Image != VK_NULL_HANDLE) {
+            continue;
+        }
+        if (levelUploads + texture->LevelCount - texture->TailLevel > TextureStreamerMaxLevelUploadsPerUpdate) {
+            break;
+        }
+        VkDeviceSize loaded = TextureStreamerLoad(streamer, i, texture->TailLevel);
+        levelUploads += loaded > 0 ? texture->LevelCount - texture->TailLevel : 0;
+        uploadBytes += loaded;
+    }
+    for (uint32_t n = 0; n < streamer->TextureCount && uploadBytes < streamer->UploadBytesPerUpdate; n++) {
+        uint32_t i                      = (streamer->NextStreamIn + n) % streamer->TextureCount;
+        TextureStreamerTexture* texture = &streamer->Textures[i];
+        if (texture->Tail.Image == VK_NULL_HANDLE || texture->Pending.Image != VK_NULL_HANDLE) {
+            continue;
+        }
+        uint32_t wanted   = texture->WantedLevel > texture->TopLevel ? texture->WantedLevel : texture->TopLevel;
+        uint32_t resident = texture->Streamed.Image != VK_NULL_HANDLE ? texture->Streamed.FirstLevel : texture->TailLevel;
+        if (wanted >= resident) {
+            continue;
+        }
+        if (levelUploads + texture->LevelCount - wanted > TextureStreamerMaxLevelUploadsPerUpdate) {
+            break;
+        }
+        // The image's real size is only known once it exists, the texels are close enough to decide on
+        VkDeviceSize size = 0;
+        for (uint32_t level = wanted; level < texture->LevelCount; level++) {
+            size += texture->Levels[level].Size;
+        }
+        VkDeviceSize loaded = TextureStreamerMakeRoom(streamer, size, false) ? TextureStreamerLoad(streamer, i, wanted) : 0;
+        if (loaded == 0) {
+            streamer->Stats.OverBudget++;
+        }
+        levelUploads += loaded > 0 ? texture->LevelCount - wanted : 0;
+        uploadBytes += loaded;
+    }
+    if (streamer->TextureCount > 0) {
+        streamer->NextStreamIn = (streamer->NextStreamIn + 1) % streamer->TextureCount;
+    }
+
+    if (uploadBytes > 0) {
+        UploaderFlush(streamer->Uploader);
+        for (uint32_t i = 0; i < streamer->TextureCount; i++) {
+            TextureStreamerTexture* texture = &streamer->Textures[i];
+            if (texture->Pending.Image != VK_NULL_HANDLE && texture->PendingValue == 0) {
+                texture->PendingValue = streamer->Uploader->Timeline->LastSubmittedValue;
+            }
+        }
+    }
+    for (uint32_t i = 0; i < streamer->TextureCount; i++) {
+        streamer->Textures[i].WantedLevel = streamer->Textures[i].LevelCount;
+    }
+}
+
+uint32_t TextureStreamerUse(TextureStreamer* streamer, uint32_t texture, float screenSize) {
+    assert(texture < streamer->TextureCount);
+    TextureStreamerTexture* entry = &streamer->Textures[texture];
+    entry->LastUsedFrame          = streamer->FrameNumber;
+
+    // The smallest level that still has a texel for every pixel
+    float size     = cast(float)(entry->Width > entry->Height ? entry->Width : entry->Height);
+    uint32_t level = 0;
+    while (level + 1 < entry->LevelCount && size * 0.5f >= screenSize) {
+        size *= 0.5f;
+        level++;
+    }
+    if (level < entry->WantedLevel) {
+        entry->WantedLevel = level;
+    }
+
+    if (entry->Streamed.Image != VK_NULL_HANDLE) {
+        return entry->Streamed.Index;
+    }
+    return entry->Tail.Image != VK_NULL_HANDLE ? entry->Tail.Index : streamer->FallbackIndex;
+}
+
+void TextureStreamerOnMemoryPressure(void* userData, uint32_t heapIndex, const MemoryBudgetHeap* heap) {
+    TextureStreamer* streamer = userData;
+    // Streamed images are always device local
+    if (heap->Flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+        streamer->HeapPressures[heapIndex] = heap->Pressure;
+    }
+}
+
+void TextureStreamerPrintStats(const TextureStreamer* streamer) {
+    const TextureStreamerStats* stats = &streamer->Stats;
+    printf("Streamed %u textures with %llu tail loads, %llu stream ins and %llu evictions, %llu stream ins didn't fit "
+           "and %llu images in use were evicted under memory pressure!\n",
+           streamer->TextureCount,
+           cast(unsigned long long) stats->TailLoads,
+           cast(unsigned long long) stats->StreamIns,
+           cast(unsigned long long) stats->Evictions,
+           cast(unsigned long long) stats->OverBudget,
+           cast(unsigned long long) stats->PressureEvictions);
+    printf("Uploaded %.1fMB of texels, tails take %.1fMB and were all resident after %llu frames, streamed images "
+           "peaked at %.1fMB of the %.1fMB budget!\n",
+           cast(double) stats->BytesUploaded / (1024.0 * 1024.0),
+           cast(double) stats->TailBytes / (1024.0 * 1024.0),
+           cast(unsigned long long) stats->TailFrames,
+           cast(double) stats->PeakStreamedBytes / (1024.0 * 1024.0),
+           cast(double) streamer->Budget / (1024.0 * 1024.0));
+}
+
+bool TextureStreamerWriteKtx2(const char* path, uint32_t width, uint32_t height, uint32_t levelCount, const uint8_t* const* levels) {
+    assert(levelCount > 0 && levelCount <= TextureStreamerMaxLevels);
+    // Basic data format descriptor of R8G8B8A8_UNORM, a block header followed by one sample per channel
+    const uint32_t Channels[4] = { 0, 1, 2, 15 };
+    uint32_t dfd[23]           = {
+        sizeof(dfd),
+        0,
+        2 | (sizeof(dfd) - 4) << 16,
+        // RGBSDA color model, BT.709 primaries, linear transfer
+        1 | 1 << 8 | 1 << 16,
+        0,
+        4,
+        0,
+    };
+    for (uint32_t i = 0; i < 4; i++) {
+        dfd[7 + i * 4]     = i * 8 | 7 << 16 | Channels[i] << 24;
+        dfd[7 + i * 4 + 3] = 255;
+    }
+
+    // Level data is stored smallest first, so the mip tail is at the front of the file
+    size_t levelsOffset = sizeof(TextureStreamerKtx2Header) + levelCount * sizeof(TextureStreamerKtx2Level);
+    size_t dataOffset   = levelsOffset + sizeof(dfd);
+    size_t size         = dataOffset;
+    TextureStreamerKtx2Level index[TextureStreamerMaxLevels];
+    for (uint32_t level = levelCount; level-- > 0;) {
+        uint64_t levelSize =
+            cast(uint64_t) TextureStreamerLevelDimension(width, level) * TextureStreamerLevelDimension(height, level) * 4;
+        index[level] = (TextureStreamerKtx2Level){
+            .ByteOffset             = size,
+            .ByteLength             = levelSize,
+            .UncompressedByteLength = levelSize,
+        };
+        size += levelSize;
+    }
+    uint8_t* data = malloc(size);
+    if (data == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate %zu bytes for writing a KTX2 file!\n", size);
+        return false;
+    }
+    TextureStreamerKtx2Header header = {
+        .VkFormat      = VK_FORMAT_R8G8B8A8_UNORM,
+        .TypeSize      = 1,
+        .PixelWidth    = width,
+        .PixelHeight   = height,
+        .FaceCount     = 1,
+        .LevelCount    = levelCount,
+        .DfdByteOffset = cast(uint32_t) levelsOffset,
+        .DfdByteLength = sizeof(dfd),
+    };
+    memcpy(header.Identifier, TextureStreamerKtx2Identifier, sizeof(TextureStreamerKtx2Identifier));
+    memcpy(data, &header, sizeof(header));
+    memcpy(data + sizeof(header), index, levelCount * sizeof(TextureStreamerKtx2Level));
+    memcpy(data + levelsOffset, dfd, sizeof(dfd));
+    for (uint32_t level = 0; level < levelCount; level++) {
+        memcpy(data + index[level].ByteOffset, levels[level], index[level].ByteLength);
+    }
+    bool written = SystemWriteFileAtomic(path, data, size);
+    free(data);
+    return written;
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "Common.h"
+#include "System.h"
+#include "Bindless.h"
+#include "DeviceAllocator.h"
+#include "MemoryBudget.h"
+#include "Timeline.h"
+#include "Uploader.h"
+
+#define TextureStreamerMaxTextures 1024
+#define TextureStreamerMaxLevels   16
+// Levels no bigger than this on either side are the mip tail, which is loaded when the texture is added and never
+// evicted
+#define TextureStreamerTailSize 32
+// Each level upload takes one of the uploader's batch barriers, so small levels are limited by count as well as by
+// bytes and one update never fills more than a couple of batches
+#define TextureStreamerMaxLevelUploadsPerUpdate (UploaderMaxBarriersPerBatch * 2)
+// Replaced images waiting for the frames that used them, beyond that TextureStreamerUpdate waits for the GPU
+#define TextureStreamerMaxRetired 256
+
+// One level of the file, Offset is from the start of the mapping
+typedef struct TextureStreamerLevel {
+    uint64_t Offset;
+    uint64_t Size;
+} TextureStreamerLevel;
+
+// A sampled image holding the file's levels from FirstLevel down to the smallest one
+typedef struct TextureStreamerImage {
+    VkImage Image;
+    VkImageView View;
+    DeviceAllocation* Allocation;
+    uint32_t FirstLevel;
+    // Bindless sampled image index
+    uint32_t Index;
+} TextureStreamerImage;
+
+typedef struct TextureStreamerTexture {
+    bool InUse;
+    SystemMappedFile File;
+    VkFormat Format;
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t LevelCount;
+    TextureStreamerLevel Levels[TextureStreamerMaxLevels];
+    uint32_t TailLevel;
+    // Finest level whose upload fits the staging ring, nothing above it is ever streamed in
+    uint32_t TopLevel;
+
+    // Image is VK_NULL_HANDLE while the level range isn't resident
+    TextureStreamerImage Tail;
+    TextureStreamerImage Streamed;
+    // Being uploaded, becomes the tail or the streamed image once the uploader's timeline passes PendingValue
+    TextureStreamerImage Pending;
+    uint64_t PendingValue;
+
+    // Finest level asked for since the last update, LevelCount if nobody asked
+    uint32_t WantedLevel;
+    uint64_t LastUsedFrame;
+} TextureStreamerTexture;
+
+typedef struct TextureStreamerRetired {
+    TextureStreamerImage Image;
+    // Graphics timeline value after which nothing samples the image anymore
+    uint64_t Value;
+} TextureStreamerRetired;
+
+typedef struct TextureStreamerStats {
+    uint64_t TailLoads;
+    uint64_t StreamIns;
+    uint64_t Evictions;
+    // Stream ins that didn't fit the budget even after evicting everything unused
+    uint64_t OverBudget;
+    // Images dropped back to their tail, even though they were in use, because device memory was short
+    uint64_t PressureEvictions;
+    uint64_t BytesUploaded;
+    VkDeviceSize TailBytes;
+    VkDeviceSize StreamedBytes;
+    VkDeviceSize PeakStreamedBytes;
+    // Frames until every added texture had its tail resident
+    uint64_t TailFrames;
+} TextureStreamerStats;
+
+// Streams mipmapped textures from KTX2 files of uncompressed 8 bit RGBA or BGRA texels. Files are mapped rather than
+// read, the uploader copies levels straight out of the mapping into its staging ring, so the only copy on the CPU is
+// the one into memory the GPU can see. The small levels of the mip tail are uploaded first and stay resident, so
+// every texture can be drawn soon after it's added while the large levels follow on demand. Callers report how big
+// each texture is on screen with TextureStreamerUse, and TextureStreamerUpdate streams in the levels that size needs.
+// Each stream in creates a new image with the full chain from the wanted level down, the old one is retired once the
+// graphics timeline shows no frame samples it. Images above the tail count against a fixed budget of device memory,
+// when a stream in doesn't fit, the textures used longest ago drop back to their tail. Uploads are limited per update
+// so a large set of textures loads over several frames instead of blocking. Under memory pressure on a device local
+// heap the budget shrinks, to half while elevated and to only the tails while critical, and the next update drops
+// streamed images until they fit again, whether or not they're in use. Only to be used from the thread that submits
+// graphics work.
+typedef struct TextureStreamer {
+    VkDevice Device;
+    const VkAllocationCallbacks* Allocator;
+    DeviceAllocator* DeviceAllocator;
+    Uploader* Uploader;
+    Bindless* Bindless;
+    Timeline* Timeline;
+    VkDeviceSize Budget;
+    MemoryPressure HeapPressures[VK_MAX_MEMORY_HEAPS];
+    VkDeviceSize UploadBytesPerUpdate;
+    // Returned for textures with nothing resident yet
+    uint32_t FallbackIndex;
+    uint64_t FrameNumber;
+    uint32_t TextureCount;
+    // Round robin start of the stream in pass, so textures far back in the array get their turn
+    uint32_t NextStreamIn;
+    VkDeviceSize PendingBytes;
+    TextureStreamerTexture Textures[TextureStreamerMaxTextures];
+    uint32_t RetiredCount;
+    TextureStreamerRetired Retired[TextureStreamerMaxRetired];
+    TextureStreamerStats Stats;
+} TextureStreamer;
+
+// budget is in bytes of streamed images on top of the tails, uploadBytesPerUpdate limits how much one update
+// queues. fallbackIndex is a bindless sampled image to draw with until a texture's tail has arrived.
+TextureStreamer* TextureStreamerCreate(VkDevice device,
+                                       DeviceAllocator* deviceAllocator,
+                                       Uploader* uploader,
+                                       Bindless* bindless,
+                                       Timeline* graphicsTimeline,
+                                       VkDeviceSize budget,
+                                       VkDeviceSize uploadBytesPerUpdate,
+                                       uint32_t fallbackIndex,
+                                       const VkAllocationCallbacks* allocator);
+// The device must be idle
+void TextureStreamerDestroy(TextureStreamer* streamer);
+
+// Maps the file and queues its mip tail, returns UINT32_MAX if it isn't a KTX2 file the streamer can handle
+uint32_t TextureStreamerAdd(TextureStreamer* streamer, const char* path);
+
+// Swaps in finished uploads, destroys images no frame uses anymore and queues the uploads asked for by the last
+// frame's TextureStreamerUse calls. Call it once per frame before UploaderAcquire, so everything it swaps in has
+// been acquired by the time the frame samples it.
+void TextureStreamerUpdate(TextureStreamer* streamer);
+// Records that texture is drawn screenSize pixels across this frame and returns the bindless index to sample it with
+uint32_t TextureStreamerUse(TextureStreamer* streamer, uint32_t texture, float screenSize);
+
+// A MemoryBudgetCallback, userData is the streamer
+void TextureStreamerOnMemoryPressure(void* userData, uint32_t heapIndex, const MemoryBudgetHeap* heap);
+
+void TextureStreamerPrintStats(const TextureStreamer* streamer);
+
+// Writes a KTX2 file of an R8G8B8A8_UNORM image with levelCount levels, levels[0] is the full size one and each
+// further level is half the size of the one before
+bool TextureStreamerWriteKtx2(const char* path, uint32_t width, uint32_t height, uint32_t levelCount, const uint8_t* const* levels);
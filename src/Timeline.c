@@ -0,0 +1,62 @@
+#include "Timeline.h"
+
+Timeline* TimelineCreate(VkDevice device, const VkAllocationCallbacks* allocator) {
+    Timeline* timeline = calloc(1, sizeof(Timeline));
+    if (timeline == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate a timeline!\n");
+        exit(1);
+    }
+    timeline->Device    = device;
+    timeline->Allocator = allocator;
+
+    VkResult semaphoreCreateResult = vkCreateSemaphore(device,
+                                                       &(VkSemaphoreCreateInfo){
+                                                           .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+                                                           .pNext =
+                                                               &(VkSemaphoreTypeCreateInfo){
+                                                                   .sType         = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+                                                                   .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+                                                                   .initialValue  = 0,
+                                                               },
+                                                       },
+                                                       allocator,
+                                                       &timeline->Semaphore);
+    if (semaphoreCreateResult != VK_SUCCESS || timeline->Semaphore == VK_NULL_HANDLE) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to create a timeline semaphore! %x\n", semaphoreCreateResult);
+        exit(1);
+    }
+
+    return timeline;
+}
+
+void TimelineDestroy(Timeline* timeline) {
+    vkDestroySemaphore(timeline->Device, timeline->Semaphore, timeline->Allocator);
+    free(timeline);
+}
+
+uint64_t TimelineNextValue(Timeline* timeline) {
+    return ++timeline->LastSubmittedValue;
+}
+
+uint64_t TimelineGetCompletedValue(Timeline* timeline) {
+    uint64_t value = 0;
+    VkCheck(vkGetSemaphoreCounterValue(timeline->Device, timeline->Semaphore, &value));
+    return value;
+}
+
+bool TimelineIsComplete(Timeline* timeline, uint64_t value) {
+    return TimelineGetCompletedValue(timeline) >= value;
+}
+
+void TimelineWait(Timeline* timeline, uint64_t value) {
+    VkCheck(vkWaitSemaphores(timeline->Device,
+                             &(VkSemaphoreWaitInfo){
+                                 .sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+                                 .semaphoreCount = 1,
+                                 .pSemaphores    = &timeline->Semaphore,
+                                 .pValues        = &value,
+                             },
+                             ~0ull));
+}
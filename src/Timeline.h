@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Common.h"
+
+// A timeline semaphore owned by one queue. Every submission to the queue signals the next value, so any point
+// in the queue's history can be waited on from the CPU or from another queue by its value alone.
+typedef struct Timeline {
+    VkDevice Device;
+    const VkAllocationCallbacks* Allocator;
+    VkSemaphore Semaphore;
+    // The value the most recent submission signals, 0 before anything was submitted
+    uint64_t LastSubmittedValue;
+} Timeline;
+
+Timeline* TimelineCreate(VkDevice device, const VkAllocationCallbacks* allocator);
+void TimelineDestroy(Timeline* timeline);
+
+// Reserves the value the next submission to the queue has to signal
+uint64_t TimelineNextValue(Timeline* timeline);
+uint64_t TimelineGetCompletedValue(Timeline* timeline);
+bool TimelineIsComplete(Timeline* timeline, uint64_t value);
+void TimelineWait(Timeline* timeline, uint64_t value);
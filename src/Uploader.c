@@ -0,0 +1,502 @@
+#include "Uploader.h"
+
+// Buffer to image copies need offsets aligned to the texel size, which is at most 16 bytes for color formats
+#define UploaderStagingAlignment 16
+
+static bool UploaderTransfersOwnership(const Uploader* uploader) {
+    return uploader->QueueFamilyIndex != uploader->GraphicsQueueFamilyIndex;
+}
+
+// Advances the staging tail past every batch whose copies have finished, in submission order
+static void UploaderRetireBatches(Uploader* uploader, bool waitForOldest) {
+    while (true) {
+        UploaderBatch* batch = &uploader->Batches[uploader->OldestBatch];
+        if (batch->State != UploaderBatchState_Submitted || batch->Completed) {
+            return;
+        }
+
+        if (!TimelineIsComplete(uploader->Timeline, batch->TimelineValue)) {
+            if (!waitForOldest) {
+                return;
+            }
+            uint64_t startTime = SystemGetTimeNanoseconds();
+            TimelineWait(uploader->Timeline, batch->TimelineValue);
+            uploader->Stats.StallCount++;
+            uploader->Stats.StallNanoseconds += SystemGetTimeNanoseconds() - startTime;
+            waitForOldest = false;
+        }
+
+        batch->Completed      = true;
+        uploader->StagingTail = batch->StagingEnd;
+        uploader->OldestBatch = (uploader->OldestBatch + 1) % UploaderMaxBatches;
+    }
+}
+
+// Grows the array to hold needed barriers, the arrays only ever grow
+static void* UploaderReserveBarriers(void* barriers, uint32_t* capacity, uint32_t needed, size_t barrierSize) {
+    if (needed <= *capacity) {
+        return barriers;
+    }
+    uint32_t newCapacity = *capacity > 0 ? *capacity : UploaderMaxBarriersPerBatch;
+    while (newCapacity < needed) {
+        newCapacity *= 2;
+    }
+    void* grown = realloc(barriers, newCapacity * barrierSize);
+    if (grown == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate the uploader's reclaimed barriers!\n");
+        exit(1);
+    }
+    *capacity = newCapacity;
+    return grown;
+}
+
+// Frees a submitted batch the graphics side hasn't acquired yet, waiting for its copies if they're still running.
+// Only the transfer timeline is waited on, which never depends on a frame being rendered.
+static void UploaderReclaimBatch(Uploader* uploader, UploaderBatch* batch) {
+    // Batches are used in order, so one that hasn't completed yet is the oldest one in flight
+    UploaderRetireBatches(uploader, false);
+    if (!batch->Completed) {
+        UploaderRetireBatches(uploader, true);
+    }
+    assert(batch->Completed);
+
+    if (UploaderTransfersOwnership(uploader)) {
+        uint32_t bufferBarrierCount       = uploader->ReclaimedBufferBarrierCount + batch->BufferBarrierCount;
+        uint32_t imageBarrierCount        = uploader->ReclaimedImageBarrierCount + batch->ImageBarrierCount;
+        uploader->ReclaimedBufferBarriers = UploaderReserveBarriers(
+            uploader->ReclaimedBufferBarriers, &uploader->ReclaimedBufferBarrierCapacity, bufferBarrierCount, sizeof(VkBufferMemoryBarrier));
+        uploader->ReclaimedImageBarriers = UploaderReserveBarriers(
+            uploader->ReclaimedImageBarriers, &uploader->ReclaimedImageBarrierCapacity, imageBarrierCount, sizeof(VkImageMemoryBarrier));
+        memcpy(uploader->ReclaimedBufferBarriers + uploader->ReclaimedBufferBarrierCount,
+               batch->BufferBarriers,
+               batch->BufferBarrierCount * sizeof(VkBufferMemoryBarrier));
+        memcpy(uploader->ReclaimedImageBarriers + uploader->ReclaimedImageBarrierCount,
+               batch->ImageBarriers,
+               batch->ImageBarrierCount * sizeof(VkImageMemoryBarrier));
+        uploader->ReclaimedBufferBarrierCount += batch->BufferBarrierCount;
+        uploader->ReclaimedImageBarrierCount += batch->ImageBarrierCount;
+    }
+    uploader->ReclaimedValue = batch->TimelineValue;
+    batch->State             = UploaderBatchState_Free;
+    uploader->Stats.BatchesReclaimed++;
+}
+
+static UploaderBatch* UploaderGetRecordingBatch(Uploader* uploader) {
+    if (uploader->RecordingBatch != UINT32_MAX) {
+        return &uploader->Batches[uploader->RecordingBatch];
+    }
+
+    // Batches are used in order, so the next one is the one that was submitted longest ago, it usually stays busy
+    // only until the graphics side acquires it
+    UploaderBatch* batch = &uploader->Batches[uploader->NextBatch];
+    if (batch->State == UploaderBatchState_Submitted) {
+        UploaderReclaimBatch(uploader, batch);
+    }
+
+    uploader->RecordingBatch  = uploader->NextBatch;
+    uploader->NextBatch       = (uploader->NextBatch + 1) % UploaderMaxBatches;
+    batch->State              = UploaderBatchState_Recording;
+    batch->Completed          = false;
+    batch->BufferBarrierCount = 0;
+    batch->ImageBarrierCount  = 0;
+    VkCheck(vkResetCommandPool(uploader->Device, batch->CommandPool, 0));
+    VkCheck(vkBeginCommandBuffer(batch->CommandBuffer,
+                                 &(VkCommandBufferBeginInfo){
+                                     .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                                     .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+                                 }));
+    return batch;
+}
+
+static void UploaderFlushLocked(Uploader* uploader) {
+    if (uploader->RecordingBatch == UINT32_MAX) {
+        return;
+    }
+    UploaderBatch* batch = &uploader->Batches[uploader->RecordingBatch];
+
+    if (UploaderTransfersOwnership(uploader) && (batch->BufferBarrierCount > 0 || batch->ImageBarrierCount > 0)) {
+        // Release half of the ownership transfer, the acquire half is recorded on the graphics queue
+        VkBufferMemoryBarrier bufferBarriers[UploaderMaxBarriersPerBatch];
+        VkImageMemoryBarrier imageBarriers[UploaderMaxBarriersPerBatch];
+        for (uint32_t i = 0; i < batch->BufferBarrierCount; i++) {
+            bufferBarriers[i]               = batch->BufferBarriers[i];
+            bufferBarriers[i].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            bufferBarriers[i].dstAccessMask = 0;
+        }
+        for (uint32_t i = 0; i < batch->ImageBarrierCount; i++) {
+            imageBarriers[i]               = batch->ImageBarriers[i];
+            imageBarriers[i].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            imageBarriers[i].dstAccessMask = 0;
+        }
+        vkCmdPipelineBarrier(batch->CommandBuffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                             0,
+                             0,
+                             NULL,
+                             batch->BufferBarrierCount,
+                             bufferBarriers,
+                             batch->ImageBarrierCount,
+                             imageBarriers);
+    } else if (batch->ImageBarrierCount > 0) {
+        // Same family, so the images can go straight to their final layout here
+        VkImageMemoryBarrier imageBarriers[UploaderMaxBarriersPerBatch];
+        for (uint32_t i = 0; i < batch->ImageBarrierCount; i++) {
+            imageBarriers[i]                     = batch->ImageBarriers[i];
+            imageBarriers[i].srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+            imageBarriers[i].dstAccessMask       = 0;
+            imageBarriers[i].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imageBarriers[i].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        }
+        vkCmdPipelineBarrier(batch->CommandBuffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                             0,
+                             0,
+                             NULL,
+                             0,
+                             NULL,
+                             batch->ImageBarrierCount,
+                             imageBarriers);
+        batch->ImageBarrierCount = 0;
+    }
+    VkCheck(vkEndCommandBuffer(batch->CommandBuffer));
+
+    batch->TimelineValue = TimelineNextValue(uploader->Timeline);
+    VkCheck(vkQueueSubmit(uploader->Queue,
+                          1,
+                          &(VkSubmitInfo){
+                              .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                              .pNext =
+                                  &(VkTimelineSemaphoreSubmitInfo){
+                                      .sType                     = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+                                      .signalSemaphoreValueCount = 1,
+                                      .pSignalSemaphoreValues    = &batch->TimelineValue,
+                                  },
+                              .commandBufferCount   = 1,
+                              .pCommandBuffers      = &batch->CommandBuffer,
+                              .signalSemaphoreCount = 1,
+                              .pSignalSemaphores    = &uploader->Timeline->Semaphore,
+                          },
+                          VK_NULL_HANDLE));
+    batch->State             = UploaderBatchState_Submitted;
+    batch->StagingEnd        = uploader->StagingHead;
+    uploader->RecordingBatch = UINT32_MAX;
+    uploader->Stats.BatchesSubmitted++;
+}
+
+// Returns the offset into the staging buffer, flushing and waiting for earlier batches if the ring is full
+static VkDeviceSize UploaderAllocateStaging(Uploader* uploader, VkDeviceSize size) {
+    assert(size <= uploader->StagingSize);
+    while (true) {
+        uint64_t start = (uploader->StagingHead + UploaderStagingAlignment - 1) / UploaderStagingAlignment * UploaderStagingAlignment;
+        if (start % uploader->StagingSize + size > uploader->StagingSize) {
+            // Doesn't fit before the end of the ring, skip to the start
+            start = (start / uploader->StagingSize + 1) * uploader->StagingSize;
+        }
+        if (start + size - uploader->StagingTail <= uploader->StagingSize) {
+            uploader->StagingHead = start + size;
+            return start % uploader->StagingSize;
+        }
+
+        UploaderRetireBatches(uploader, false);
+        if (start + size - uploader->StagingTail <= uploader->StagingSize) {
+            continue;
+        }
+        // The space is still owned by the batch being recorded, it has to be submitted before it can be waited on
+        UploaderFlushLocked(uploader);
+        UploaderRetireBatches(uploader, true);
+    }
+}
+
+static void UploaderWriteStaging(Uploader* uploader, VkDeviceSize offset, const void* data, VkDeviceSize size) {
+    memcpy(cast(uint8_t*) uploader->StagingAllocation->Mapped + offset, data, size);
+    VkCheck(DeviceAllocatorFlush(uploader->DeviceAllocator, uploader->StagingAllocation, offset, size));
+    uploader->Stats.BytesUploaded += size;
+}
+
+Uploader* UploaderCreate(VkDevice device,
+                         DeviceAllocator* deviceAllocator,
+                         VkQueue queue,
+                         uint32_t queueFamilyIndex,
+                         uint32_t graphicsQueueFamilyIndex,
+                         VkDeviceSize stagingSize,
+                         const VkAllocationCallbacks* allocator) {
+    Uploader* uploader = calloc(1, sizeof(Uploader));
+    if (uploader == NULL) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to allocate the uploader!\n");
+        exit(1);
+    }
+    uploader->Device                   = device;
+    uploader->Allocator                = allocator;
+    uploader->DeviceAllocator          = deviceAllocator;
+    uploader->Queue                    = queue;
+    uploader->Timeline                 = TimelineCreate(device, allocator);
+    uploader->QueueFamilyIndex         = queueFamilyIndex;
+    uploader->GraphicsQueueFamilyIndex = graphicsQueueFamilyIndex;
+    uploader->StagingSize              = stagingSize;
+    uploader->RecordingBatch           = UINT32_MAX;
+    SystemMutexInit(&uploader->Mutex);
+
+    VkResult stagingCreateResult = DeviceAllocatorCreateBuffer(deviceAllocator,
+                                                               &(VkBufferCreateInfo){
+                                                                   .sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+                                                                   .size        = stagingSize,
+                                                                   .usage       = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                                                   .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                                                               },
+                                                               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+                                                               VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                                               &uploader->StagingBuffer,
+                                                               &uploader->StagingAllocation);
+    if (stagingCreateResult != VK_SUCCESS) {
+        fflush(stdout);
+        fprintf(stderr, "Failed to create the staging buffer! %x\n", stagingCreateResult);
+        exit(1);
+    }
+
+    for (uint32_t i = 0; i < UploaderMaxBatches; i++) {
+        UploaderBatch* batch = &uploader->Batches[i];
+        VkCheck(vkCreateCommandPool(device,
+                                    &(VkCommandPoolCreateInfo){
+                                        .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                                        .flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+                                        .queueFamilyIndex = queueFamilyIndex,
+                                    },
+                                    allocator,
+                                    &batch->CommandPool));
+        VkCheck(vkAllocateCommandBuffers(device,
+                                         &(VkCommandBufferAllocateInfo){
+                                             .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                                             .commandPool        = batch->CommandPool,
+                                             .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                                             .commandBufferCount = 1,
+                                         },
+                                         &batch->CommandBuffer));
+    }
+
+    return uploader;
+}
+
+void UploaderDestroy(Uploader* uploader) {
+    for (uint32_t i = 0; i < UploaderMaxBatches; i++) {
+        UploaderBatch* batch = &uploader->Batches[i];
+        vkDestroyCommandPool(uploader->Device, batch->CommandPool, uploader->Allocator);
+    }
+    vkDestroyBuffer(uploader->Device, uploader->StagingBuffer, uploader->Allocator);
+    DeviceAllocatorFree(uploader->DeviceAllocator, uploader->StagingAllocation);
+    TimelineDestroy(uploader->Timeline);
+    SystemMutexDestroy(&uploader->Mutex);
+    free(uploader->ReclaimedBufferBarriers);
+    free(uploader->ReclaimedImageBarriers);
+    free(uploader);
+}
+
+void UploaderUploadBuffer(Uploader* uploader, VkBuffer buffer, VkDeviceSize offset, const void* data, VkDeviceSize size) {
+    SystemMutexLock(&uploader->Mutex);
+    const uint8_t* bytes      = data;
+    VkDeviceSize maxChunkSize = uploader->StagingSize / 2 < UploaderMaxChunkSize ? uploader->StagingSize / 2 : UploaderMaxChunkSize;
+    while (size > 0) {
+        VkDeviceSize chunkSize     = size < maxChunkSize ? size : maxChunkSize;
+        VkDeviceSize stagingOffset = UploaderAllocateStaging(uploader, chunkSize);
+        UploaderWriteStaging(uploader, stagingOffset, bytes, chunkSize);
+
+        UploaderBatch* batch = UploaderGetRecordingBatch(uploader);
+        vkCmdCopyBuffer(batch->CommandBuffer,
+                        uploader->StagingBuffer,
+                        buffer,
+                        1,
+                        &(VkBufferCopy){
+                            .srcOffset = stagingOffset,
+                            .dstOffset = offset,
+                            .size      = chunkSize,
+                        });
+        if (UploaderTransfersOwnership(uploader)) {
+            batch->BufferBarriers[batch->BufferBarrierCount++] = (VkBufferMemoryBarrier){
+                .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                .srcQueueFamilyIndex = uploader->QueueFamilyIndex,
+                .dstQueueFamilyIndex = uploader->GraphicsQueueFamilyIndex,
+                .buffer              = buffer,
+                .offset              = offset,
+                .size                = chunkSize,
+            };
+            if (batch->BufferBarrierCount == UploaderMaxBarriersPerBatch) {
+                UploaderFlushLocked(uploader);
+            }
+        }
+
+        bytes += chunkSize;
+        offset += chunkSize;
+        size -= chunkSize;
+    }
+    SystemMutexUnlock(&uploader->Mutex);
+}
+
+void UploaderUploadImage(Uploader* uploader,
+                         VkImage image,
+                         uint32_t mipLevel,
+                         uint32_t arrayLayer,
+                         VkExtent3D extent,
+                         VkImageLayout finalLayout,
+                         const void* data,
+                         VkDeviceSize size) {
+    if (size > uploader->StagingSize) {
+        fflush(stdout);
+        fprintf(stderr, "Image upload of %llu bytes does not fit in the staging ring!\n", cast(unsigned long long) size);
+        exit(1);
+    }
+
+    SystemMutexLock(&uploader->Mutex);
+    VkDeviceSize stagingOffset = UploaderAllocateStaging(uploader, size);
+    UploaderWriteStaging(uploader, stagingOffset, data, size);
+
+    UploaderBatch* batch                     = UploaderGetRecordingBatch(uploader);
+    VkImageSubresourceRange subresourceRange = {
+        .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+        .baseMipLevel   = mipLevel,
+        .levelCount     = 1,
+        .baseArrayLayer = arrayLayer,
+        .layerCount     = 1,
+    };
+    vkCmdPipelineBarrier(batch->CommandBuffer,
+                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0,
+                         0,
+                         NULL,
+                         0,
+                         NULL,
+                         1,
+                         &(VkImageMemoryBarrier){
+                             .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                             .srcAccessMask       = 0,
+                             .dstAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT,
+                             .oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED,
+                             .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                             .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                             .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                             .image               = image,
+                             .subresourceRange    = subresourceRange,
+                         });
+    vkCmdCopyBufferToImage(batch->CommandBuffer,
+                           uploader->StagingBuffer,
+                           image,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           1,
+                           &(VkBufferImageCopy){
+                               .bufferOffset = stagingOffset,
+                               .imageSubresource =
+                                   (VkImageSubresourceLayers){
+                                       .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+                                       .mipLevel       = mipLevel,
+                                       .baseArrayLayer = arrayLayer,
+                                       .layerCount     = 1,
+                                   },
+                               .imageExtent = extent,
+                           });
+
+    // The layout transition to the final layout happens as part of the ownership transfer, or at flush time
+    batch->ImageBarriers[batch->ImageBarrierCount++] = (VkImageMemoryBarrier){
+        .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .newLayout           = finalLayout,
+        .srcQueueFamilyIndex = uploader->QueueFamilyIndex,
+        .dstQueueFamilyIndex = uploader->GraphicsQueueFamilyIndex,
+        .image               = image,
+        .subresourceRange    = subresourceRange,
+    };
+    if (batch->ImageBarrierCount == UploaderMaxBarriersPerBatch) {
+        UploaderFlushLocked(uploader);
+    }
+    SystemMutexUnlock(&uploader->Mutex);
+}
+
+void UploaderFlush(Uploader* uploader) {
+    SystemMutexLock(&uploader->Mutex);
+    UploaderFlushLocked(uploader);
+    SystemMutexUnlock(&uploader->Mutex);
+}
+
+uint64_t UploaderAcquire(Uploader* uploader, VkCommandBuffer commandBuffer) {
+    SystemMutexLock(&uploader->Mutex);
+    UploaderRetireBatches(uploader, false);
+
+    // Reclaimed batches are older than any still waiting, so their acquires go first
+    uint64_t waitValue = uploader->ReclaimedValue;
+    if (uploader->ReclaimedBufferBarrierCount > 0 || uploader->ReclaimedImageBarrierCount > 0) {
+        for (uint32_t j = 0; j < uploader->ReclaimedBufferBarrierCount; j++) {
+            uploader->ReclaimedBufferBarriers[j].srcAccessMask = 0;
+            uploader->ReclaimedBufferBarriers[j].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+        }
+        for (uint32_t j = 0; j < uploader->ReclaimedImageBarrierCount; j++) {
+            uploader->ReclaimedImageBarriers[j].srcAccessMask = 0;
+            uploader->ReclaimedImageBarriers[j].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+        }
+        vkCmdPipelineBarrier(commandBuffer,
+                             VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                             VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                             0,
+                             0,
+                             NULL,
+                             uploader->ReclaimedBufferBarrierCount,
+                             uploader->ReclaimedBufferBarriers,
+                             uploader->ReclaimedImageBarrierCount,
+                             uploader->ReclaimedImageBarriers);
+    }
+    uploader->ReclaimedBufferBarrierCount = 0;
+    uploader->ReclaimedImageBarrierCount  = 0;
+    uploader->ReclaimedValue              = 0;
+    for (uint32_t i = 0; i < UploaderMaxBatches; i++) {
+        // Walk the batches oldest first so acquires happen in the order the uploads were made
+        UploaderBatch* batch = &uploader->Batches[(uploader->NextBatch + i) % UploaderMaxBatches];
+        if (batch->State != UploaderBatchState_Submitted || !batch->Completed) {
+            continue;
+        }
+
+        if (UploaderTransfersOwnership(uploader) && (batch->BufferBarrierCount > 0 || batch->ImageBarrierCount > 0)) {
+            VkBufferMemoryBarrier bufferBarriers[UploaderMaxBarriersPerBatch];
+            VkImageMemoryBarrier imageBarriers[UploaderMaxBarriersPerBatch];
+            for (uint32_t j = 0; j < batch->BufferBarrierCount; j++) {
+                bufferBarriers[j]               = batch->BufferBarriers[j];
+                bufferBarriers[j].srcAccessMask = 0;
+                bufferBarriers[j].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+            }
+            for (uint32_t j = 0; j < batch->ImageBarrierCount; j++) {
+                imageBarriers[j]               = batch->ImageBarriers[j];
+                imageBarriers[j].srcAccessMask = 0;
+                imageBarriers[j].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+            }
+            vkCmdPipelineBarrier(commandBuffer,
+                                 VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                                 VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                                 0,
+                                 0,
+                                 NULL,
+                                 batch->BufferBarrierCount,
+                                 bufferBarriers,
+                                 batch->ImageBarrierCount,
+                                 imageBarriers);
+        }
+
+        // The timeline is already past the value, waiting on it costs nothing but is what orders the acquire after
+        // the release. Nothing on the GPU refers to the batch anymore, so it can be reused straight away.
+        waitValue    = batch->TimelineValue;
+        batch->State = UploaderBatchState_Free;
+    }
+    SystemMutexUnlock(&uploader->Mutex);
+    return waitValue;
+}
+
+void UploaderPrintStats(Uploader* uploader) {
+    SystemMutexLock(&uploader->Mutex);
+    printf("Uploaded %.1fMB in %llu batches, %llu reused before being acquired, stalled %llu times for %.3fms waiting "
+           "for staging space or batches\n",
+           cast(double) uploader->Stats.BytesUploaded / (1024.0 * 1024.0),
+           cast(unsigned long long) uploader->Stats.BatchesSubmitted,
+           cast(unsigned long long) uploader->Stats.BatchesReclaimed,
+           cast(unsigned long long) uploader->Stats.StallCount,
+           cast(double) uploader->Stats.StallNanoseconds / 1e6);
+    SystemMutexUnlock(&uploader->Mutex);
+}
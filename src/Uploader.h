@@ -0,0 +1,111 @@
+#pragma once
+
+#include "Common.h"
+#include "System.h"
+#include "DeviceAllocator.h"
+#include "Timeline.h"
+
+#define UploaderMaxBatches          8
+#define UploaderMaxBarriersPerBatch 64
+// Buffer uploads bigger than this are split up so one upload can't hog the whole staging ring
+#define UploaderMaxChunkSize (4ull * 1024 * 1024)
+
+typedef enum UploaderBatchState {
+    UploaderBatchState_Free,
+    UploaderBatchState_Recording,
+    // Submitted to the transfer queue, waiting for the graphics side to acquire it
+    UploaderBatchState_Submitted,
+} UploaderBatchState;
+
+typedef struct UploaderBatch {
+    UploaderBatchState State;
+    bool Completed;
+    VkCommandPool CommandPool;
+    VkCommandBuffer CommandBuffer;
+    // The transfer timeline value the batch's submission signals
+    uint64_t TimelineValue;
+    uint64_t StagingEnd;
+    uint32_t BufferBarrierCount;
+    VkBufferMemoryBarrier BufferBarriers[UploaderMaxBarriersPerBatch];
+    uint32_t ImageBarrierCount;
+    VkImageMemoryBarrier ImageBarriers[UploaderMaxBarriersPerBatch];
+} UploaderBatch;
+
+typedef struct UploaderStats {
+    uint64_t BytesUploaded;
+    uint64_t BatchesSubmitted;
+    // Finished batches reused before the graphics side acquired them, because every batch was taken
+    uint64_t BatchesReclaimed;
+    uint64_t StallCount;
+    uint64_t StallNanoseconds;
+} UploaderStats;
+
+// Streams data to device local buffers and images through a persistently mapped staging ring on the transfer
+// queue. Copies are batched into one submission per UploaderFlush, and when the transfer queue belongs to a
+// different family the batch releases ownership of everything it wrote. The graphics side picks up finished
+// batches with UploaderAcquire, which only ever takes batches whose copies have already completed, so rendering
+// never waits on an upload that is still in flight. Batches and their staging space are recycled once the transfer
+// timeline has passed their value. When every batch is waiting to be acquired, like when a lot is uploaded before
+// the first frame, the oldest one is reused as soon as its copies are done and its acquires are kept for the next
+// UploaderAcquire, so uploading never depends on a frame being rendered. Uploads can be queued from any thread, but
+// if the transfer queue is shared with graphics they must come from the thread that submits graphics work.
+typedef struct Uploader {
+    VkDevice Device;
+    const VkAllocationCallbacks* Allocator;
+    DeviceAllocator* DeviceAllocator;
+    VkQueue Queue;
+    Timeline* Timeline;
+    uint32_t QueueFamilyIndex;
+    uint32_t GraphicsQueueFamilyIndex;
+    SystemMutex Mutex;
+
+    VkBuffer StagingBuffer;
+    DeviceAllocation* StagingAllocation;
+    VkDeviceSize StagingSize;
+    uint64_t StagingHead;
+    uint64_t StagingTail;
+
+    UploaderBatch Batches[UploaderMaxBatches];
+    uint32_t NextBatch;
+    uint32_t OldestBatch;
+    uint32_t RecordingBatch;
+    // Acquires of reclaimed batches, recorded ahead of the batches' own by the next UploaderAcquire
+    uint32_t ReclaimedBufferBarrierCount;
+    uint32_t ReclaimedBufferBarrierCapacity;
+    VkBufferMemoryBarrier* ReclaimedBufferBarriers;
+    uint32_t ReclaimedImageBarrierCount;
+    uint32_t ReclaimedImageBarrierCapacity;
+    VkImageMemoryBarrier* ReclaimedImageBarriers;
+    uint64_t ReclaimedValue;
+    UploaderStats Stats;
+} Uploader;
+
+Uploader* UploaderCreate(VkDevice device,
+                         DeviceAllocator* deviceAllocator,
+                         VkQueue queue,
+                         uint32_t queueFamilyIndex,
+                         uint32_t graphicsQueueFamilyIndex,
+                         VkDeviceSize stagingSize,
+                         const VkAllocationCallbacks* allocator);
+// The device must be idle
+void UploaderDestroy(Uploader* uploader);
+
+// Blocks only if the staging ring is full, until the oldest batch's copies have finished
+void UploaderUploadBuffer(Uploader* uploader, VkBuffer buffer, VkDeviceSize offset, const void* data, VkDeviceSize size);
+// Uploads one mip level of one layer of a color image and leaves it in finalLayout, size must fit in the staging ring
+void UploaderUploadImage(Uploader* uploader,
+                         VkImage image,
+                         uint32_t mipLevel,
+                         uint32_t arrayLayer,
+                         VkExtent3D extent,
+                         VkImageLayout finalLayout,
+                         const void* data,
+                         VkDeviceSize size);
+// Submits everything queued since the last flush
+void UploaderFlush(Uploader* uploader);
+
+// Records ownership acquires for every batch that has finished copying and returns the value of
+// uploader->Timeline the graphics submission has to wait for, or 0 if nothing was acquired
+uint64_t UploaderAcquire(Uploader* uploader, VkCommandBuffer commandBuffer);
+
+void UploaderPrintStats(Uploader* uploader);